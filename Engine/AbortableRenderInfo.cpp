@@ -30,6 +30,8 @@
 #include <string>
 #include <cassert>
 
+#include <boost/make_shared.hpp>
+
 #include <QtCore/QMutex>
 #include <QtCore/QAtomicInt>
 #include <QtCore/QTimer>
@@ -62,6 +64,8 @@ struct AbortableRenderInfoPrivate
     mutable QMutex timerMutex;
     bool timerStarted;
     QTimer* abortTimeoutTimer;
+    // Started when the render is aborted, protected by timerMutex
+    TimeLapsePtr abortedTimer;
     QThread* ownerThread;
 
     AbortableRenderInfoPrivate(AbortableRenderInfo* p,
@@ -76,6 +80,7 @@ struct AbortableRenderInfoPrivate
         , timerMutex()
         , timerStarted(false)
         , abortTimeoutTimer(new QTimer)
+        , abortedTimer()
         , ownerThread( QThread::currentThread() )
     {
         aborted.fetchAndStoreAcquire(0);
@@ -134,6 +139,7 @@ AbortableRenderInfo::setAborted()
     bool callInSeparateThread = false;
     {
         QMutexLocker k(&_imp->timerMutex);
+        _imp->abortedTimer = boost::make_shared<TimeLapse>();
         _imp->timerStarted = true;
         callInSeparateThread = QThread::currentThread() != _imp->ownerThread;
     }
@@ -146,6 +152,14 @@ AbortableRenderInfo::setAborted()
     }
 }
 
+double
+AbortableRenderInfo::getTimeSinceAbort() const
+{
+    QMutexLocker k(&_imp->timerMutex);
+
+    return _imp->abortedTimer ? _imp->abortedTimer->getTimeSinceCreation() : 0.;
+}
+
 void
 AbortableRenderInfo::registerThreadForRender(AbortableThread* thread)
 {
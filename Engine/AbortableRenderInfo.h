@@ -113,6 +113,12 @@ public:
      **/
     void setAborted();
 
+    /**
+     * @brief Returns the time in seconds elapsed since setAborted() was first called, or 0 if the render was not aborted.
+     * This measures how long the threads of a render keep running after it was aborted.
+     **/
+    double getTimeSinceAbort() const;
+
     /**
      * @brief Get the render age. The render age identifies one single frame render in the Viewer. The older a render is, the smaller its render age is.
      * This is used in the Viewer keep and order on the render requests, even though each request runs concurrently of another.
@@ -27,6 +27,7 @@
 
 #include <fstream>
 #include <list>
+#include <algorithm> // max
 #include <cassert>
 #include <stdexcept>
 #include <sstream> // stringstream
@@ -39,6 +40,7 @@
 #include <QtCore/QFileInfo>
 #include <QtCore/QEventLoop>
 #include <QtCore/QSettings>
+#include <QtCore/QThread>
 #include <QtNetwork/QNetworkReply>
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
@@ -71,6 +73,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/Project.h"
 #include "Engine/ProcessHandler.h"
 #include "Engine/ReadNode.h"
+#include "Engine/RenderCoordinator.h"
 #include "Engine/Settings.h"
 #include "Engine/WriteNode.h"
 
@@ -660,7 +663,14 @@ AppInstance::loadInternal(const CLArgs& cl,
         }
 
         ///launch renders
-        if ( !writersWork.empty() ) {
+        if ( cl.isRenderWorker() ) {
+            renderWorkerChunks(cl);
+        } else if (cl.getNumberOfRenderWorkers() > 1) {
+            if ( writersWork.empty() ) {
+                getWritersWorkFromNames( cl.areRenderStatsEnabled(), std::list<std::string>(), cl.getFrameRanges(), writersWork );
+            }
+            startWritersRenderingInWorkers(cl.getNumberOfRenderWorkers(), writersWork);
+        } else if ( !writersWork.empty() ) {
             startWritersRendering(false, writersWork);
         } else {
             std::list<std::string> writers;
@@ -1690,6 +1700,16 @@ AppInstance::startWritersRenderingFromNames(bool enableRenderStats,
 {
     std::list<RenderWork> renderers;
 
+    getWritersWorkFromNames(enableRenderStats, writers, frameRanges, renderers);
+    startWritersRendering(doBlockingRender, renderers);
+}
+
+void
+AppInstance::getWritersWorkFromNames(bool enableRenderStats,
+                                     const std::list<std::string>& writers,
+                                     const std::list<std::pair<int, std::pair<int, int> > >& frameRanges,
+                                     std::list<AppInstance::RenderWork>& renderers)
+{
     if ( !writers.empty() ) {
         for (std::list<std::string>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
             const std::string& writerName = *it;
@@ -1757,9 +1777,108 @@ AppInstance::startWritersRenderingFromNames(bool enableRenderStats,
     if ( renderers.empty() ) {
         throw std::invalid_argument("Project file is missing a writer node. This project cannot render anything.");
     }
+} // AppInstance::getWritersWorkFromNames
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// Returns the command-line of this process without the options that only make sense for the coordinator
+static QStringList
+getRenderWorkerArgs(int nWorkers)
+{
+    QStringList args = QCoreApplication::arguments();
+    QStringList workerArgs;
+    bool hasRenderThreadsSetting = false;
+
+    // Skip the executable
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if ( ( arg == QString::fromUtf8("-j") ) || ( arg == QString::fromUtf8("--workers") ) ||
+             ( arg == QString::fromUtf8("--IPCpipe") ) ||
+             ( arg == QString::fromUtf8("--" NATRON_BREAKPAD_PROCESS_PID) ) ||
+             ( arg == QString::fromUtf8("--" NATRON_BREAKPAD_PROCESS_EXEC) ) ||
+             ( arg == QString::fromUtf8("--" NATRON_BREAKPAD_CLIENT_FD_ARG) ) ||
+             ( arg == QString::fromUtf8("--" NATRON_BREAKPAD_PIPE_ARG) ) ||
+             ( arg == QString::fromUtf8("--" NATRON_BREAKPAD_COM_PIPE_ARG) ) ) {
+            // Skip the value too
+            ++i;
+            continue;
+        }
+        if ( arg == QString::fromUtf8("--clear-cache") ) {
+            // Already done by the coordinator, workers must not clear the cache of each other
+            continue;
+        }
+        if ( ( arg == QString::fromUtf8("--setting") ) && ( i + 1 < args.size() ) &&
+             args[i + 1].startsWith( QString::fromUtf8("noRenderThreads=") ) ) {
+            hasRenderThreadsSetting = true;
+        }
+        workerArgs.push_back(arg);
+    }
 
-    startWritersRendering(doBlockingRender, renderers);
-} // AppInstance::startWritersRenderingFromNames
+    if (!hasRenderThreadsSetting) {
+        // Share the cores between the workers instead of having each worker use all of them.
+        // Note that passing a setting also prevents the workers from saving the settings.
+        int nThreads = std::max(1, QThread::idealThreadCount() / nWorkers);
+        workerArgs.push_back( QString::fromUtf8("--setting") );
+        workerArgs.push_back( QString::fromUtf8("noRenderThreads=%1").arg(nThreads) );
+    }
+
+    return workerArgs;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+AppInstance::startWritersRenderingInWorkers(int nWorkers,
+                                            const std::list<RenderWork>& writers)
+{
+    std::list<RenderCoordinatorJob> jobs;
+
+    for (std::list<RenderWork>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        if (it->writer->getNode()->isNodeDisabled() || !it->writer->getNode()->isActivated()) {
+            continue;
+        }
+        RenderCoordinatorJob job;
+        if ( !_imp->validateRenderOptions(*it, &job.firstFrame, &job.lastFrame, &job.frameStep) ) {
+            continue;
+        }
+        job.writerName = it->writer->getNode()->getFullyQualifiedName();
+        // Video files cannot be written by several processes
+        job.ordered = it->writer->isVideoWriter() || (it->writer->getSequentialPreference() == eSequentialPreferenceOnlySequential);
+        jobs.push_back(job);
+    }
+    if ( jobs.empty() ) {
+        return;
+    }
+
+    RenderCoordinator coordinator( nWorkers, getRenderWorkerArgs(nWorkers) );
+    coordinator.render(jobs);
+}
+
+void
+AppInstance::renderWorkerChunks(const CLArgs& cl)
+{
+    // The project is loaded: tell the coordinator we can render
+    appPTR->writeToOutputPipe(QString(), QString::fromUtf8(kRenderWorkerReadyShort), false);
+
+    RenderWorkerChunk chunk;
+    while ( appPTR->waitForRenderWorkerChunk(&chunk) ) {
+        try {
+            NodePtr node = getNodeByFullySpecifiedName(chunk.writerName);
+            OutputEffectInstance* effect = node ? dynamic_cast<OutputEffectInstance*>( node->getEffectInstance().get() ) : 0;
+            if (!effect) {
+                throw std::invalid_argument( tr("%1 is not an output node! It cannot render anything.").arg( QString::fromUtf8( chunk.writerName.c_str() ) ).toStdString() );
+            }
+            std::list<RenderWork> work;
+            work.push_back( RenderWork( effect, chunk.firstFrame, chunk.lastFrame, chunk.frameStep, cl.areRenderStatsEnabled() ) );
+            startWritersRendering(true, work);
+        } catch (const std::exception& e) {
+            // Messages must fit on a single line
+            QString message = QString::fromUtf8( e.what() ).simplified();
+            appPTR->writeToOutputPipe(message, QString::fromUtf8(kRenderWorkerErrorShort) + message, true);
+        }
+        appPTR->writeToOutputPipe(QString(), QString::fromUtf8(kRenderWorkerReadyShort), false);
+    }
+}
 
 void
 AppInstance::startWritersRendering(bool doBlockingRender,
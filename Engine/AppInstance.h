@@ -464,6 +464,21 @@ private:
 
     void getWritersWorkForCL(const CLArgs& cl, std::list<AppInstance::RenderWork>& requests);
 
+    void getWritersWorkFromNames(bool enableRenderStats,
+                                 const std::list<std::string>& writers,
+                                 const std::list<std::pair<int, std::pair<int, int> > >& frameRanges,
+                                 std::list<AppInstance::RenderWork>& requests);
+
+    /**
+     * @brief Splits the given renders across nWorkers processes, @see RenderCoordinator. Blocks until all are done.
+     **/
+    void startWritersRenderingInWorkers(int nWorkers, const std::list<AppInstance::RenderWork>& writers);
+
+    /**
+     * @brief When this process is a render worker: renders the chunks of frames sent by the coordinator until it asks to quit.
+     **/
+    void renderWorkerChunks(const CLArgs& cl);
+
 
     NodePtr createNodeInternal(CreateNodeArgs& args);
 
@@ -1369,6 +1369,28 @@ AppManager::clearDiskCache()
     clearLastRenderedTextures();
     _imp->_viewerCache->clear();
     _imp->_diskCache->clear();
+
+    ///DiskCache nodes store their images in their own files
+    AppInstanceVec copy;
+    {
+        QMutexLocker k(&_imp->_appInstancesMutex);
+        copy = _imp->_appInstances;
+    }
+    for (AppInstanceVec::iterator it = copy.begin(); it != copy.end(); ++it) {
+        NodesList nodes;
+        (*it)->getProject()->getNodes_recursive(nodes, false);
+        for (NodesList::iterator it2 = nodes.begin(); it2 != nodes.end(); ++it2) {
+            DiskCacheNode* isDiskCache = dynamic_cast<DiskCacheNode*>( (*it2)->getEffectInstance().get() );
+            if (isDiskCache) {
+                isDiskCache->clearStorage();
+            }
+        }
+    }
+    QDir storageDir( DiskCacheNode::getStorageDirectoryPath() );
+    QStringList storageFiles = storageDir.entryList(QDir::Files);
+    Q_FOREACH(const QString &file, storageFiles) {
+        storageDir.remove(file);
+    }
 }
 
 void
@@ -1490,6 +1512,16 @@ AppManager::writeToOutputPipe(const QString & longMessage,
     return true;
 }
 
+bool
+AppManager::waitForRenderWorkerChunk(RenderWorkerChunk* chunk)
+{
+    if (!_imp->_backgroundIPC) {
+        return false;
+    }
+
+    return _imp->_backgroundIPC->waitForRenderChunk(chunk);
+}
+
 void
 AppManager::setApplicationsCachesMaximumMemoryPercent(double p)
 {
@@ -2625,6 +2657,7 @@ AppManager::registerEngineMetaTypes() const
     qRegisterMetaType<RectD>("RectD");
     qRegisterMetaType<RenderStatsPtr>("RenderStatsPtr");
     qRegisterMetaType<RenderStatsMap>("RenderStatsMap");
+    qRegisterMetaType<UpdateViewerParamsPtr>("UpdateViewerParamsPtr");
     qRegisterMetaType<ViewIdx>("ViewIdx");
     qRegisterMetaType<ViewSpec>("ViewSpec");
     qRegisterMetaType<NodePtr>("NodePtr");
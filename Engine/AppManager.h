@@ -274,6 +274,12 @@ public:
      **/
     bool writeToOutputPipe(const QString & longMessage, const QString & shortMessage, bool printIfNoChannel);
 
+    /**
+     * @brief If the current process is a render worker launched by a render coordinator, blocks until the coordinator
+     * sends a chunk of frames to render. Returns false when there is nothing left to render.
+     **/
+    bool waitForRenderWorkerChunk(RenderWorkerChunk* chunk);
+
     /**
      * @brief Abort any processing on all AppInstance. It is called in some very rare cases
      * such as when changing the number of threads used by the application or when a background render
@@ -0,0 +1,406 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "AsyncWriteQueue.h"
+
+#include <map>
+#include <list>
+#include <algorithm> // min, max
+#include <cassert>
+#include <stdexcept>
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/TLSHolder.h"
+
+// Render threads waiting for room in the queue wake-up at this interval to check whether the render was aborted
+#define NATRON_ASYNC_WRITE_QUEUE_ABORT_POLL_MS 50
+
+NATRON_NAMESPACE_ENTER
+
+
+U64
+AsyncWriteFrame::getMemorySize() const
+{
+    U64 ret = 0;
+
+    for (std::map<ViewIdx, AsyncWriteFrameView>::const_iterator it = views.begin(); it != views.end(); ++it) {
+        for (ImageList::const_iterator it2 = it->second.inputPlanes.begin(); it2 != it->second.inputPlanes.end(); ++it2) {
+            if (*it2) {
+                ret += (*it2)->size();
+            }
+        }
+    }
+
+    return ret;
+}
+
+class AsyncWriteThread
+    : public QThread
+    , public AbortableThread
+{
+public:
+
+    AsyncWriteThread(AsyncWriteQueue* queue)
+        : QThread()
+        , AbortableThread(this)
+        , _queue(queue)
+    {
+        setThreadName("Writer I/O thread");
+    }
+
+    virtual ~AsyncWriteThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    AsyncWriteQueue* _queue;
+};
+
+typedef std::list<AsyncWriteThread*> AsyncWriteThreads;
+
+// Frames waiting to be written, sorted by time
+typedef std::map<int, AsyncWriteFramePtr> AsyncWriteFramesMap;
+
+struct AsyncWriteQueuePrivate
+{
+    DefaultScheduler* scheduler;
+
+    // Protects all fields below
+    mutable QMutex queueMutex;
+
+    // Woken up when a frame is appended or when the threads must quit
+    QWaitCondition framesAvailableCond;
+
+    // Woken up when a frame was written, i.e: there may be room in the queue
+    QWaitCondition roomAvailableCond;
+
+    AsyncWriteThreads threads;
+    AsyncWriteFramesMap pendingFrames;
+
+    // Number of frames currently being written by I/O threads
+    int nFramesInFlight;
+
+    // Memory held by pendingFrames and frames in flight
+    U64 pendingBytes;
+
+    bool active;
+    bool mustQuit;
+    bool ordered;
+    int nextExpectedFrame;
+    int frameStep;
+    RenderDirectionEnum direction;
+    int maxPendingFrames;
+    U64 maxPendingBytes;
+    AsyncWriteQueueStats stats;
+
+    AsyncWriteQueuePrivate(DefaultScheduler* scheduler)
+        : scheduler(scheduler)
+        , queueMutex()
+        , framesAvailableCond()
+        , roomAvailableCond()
+        , threads()
+        , pendingFrames()
+        , nFramesInFlight(0)
+        , pendingBytes(0)
+        , active(false)
+        , mustQuit(false)
+        , ordered(false)
+        , nextExpectedFrame(0)
+        , frameStep(1)
+        , direction(eRenderDirectionForward)
+        , maxPendingFrames(1)
+        , maxPendingBytes(0)
+        , stats()
+    {
+    }
+
+    bool isFull(U64 frameBytes) const
+    {
+        // Private, should not lock
+        assert( !queueMutex.tryLock() );
+
+        int nFrames = (int)pendingFrames.size() + nFramesInFlight;
+        if (nFrames == 0) {
+            // Always accept at least 1 frame, even if it is bigger than the budget
+            return false;
+        }
+        if (nFrames >= maxPendingFrames) {
+            return true;
+        }
+
+        return pendingBytes + frameBytes > maxPendingBytes;
+    }
+
+    /**
+     * @brief Returns the next frame an I/O thread may write, or a NULL pointer if there is none yet.
+     **/
+    AsyncWriteFramePtr takeNextFrame()
+    {
+        // Private, should not lock
+        assert( !queueMutex.tryLock() );
+
+        if ( pendingFrames.empty() ) {
+            return AsyncWriteFramePtr();
+        }
+        AsyncWriteFramesMap::iterator found;
+        if (ordered && !mustQuit) {
+            found = pendingFrames.find(nextExpectedFrame);
+            if ( found == pendingFrames.end() ) {
+                return AsyncWriteFramePtr();
+            }
+        } else if (direction == eRenderDirectionForward) {
+            found = pendingFrames.begin();
+        } else {
+            found = pendingFrames.end();
+            --found;
+        }
+        AsyncWriteFramePtr ret = found->second;
+        pendingFrames.erase(found);
+        if (ordered) {
+            nextExpectedFrame = ret->time + (direction == eRenderDirectionForward ? frameStep : -frameStep);
+        }
+        ++nFramesInFlight;
+
+        return ret;
+    }
+
+    void notifyFrameWritten(const AsyncWriteFramePtr& frame,
+                            U64 frameBytes,
+                            double writeTime)
+    {
+        double latency = frame->enqueueTimer.getTimeElapsedReset();
+        QMutexLocker k(&queueMutex);
+
+        --nFramesInFlight;
+        pendingBytes -= std::min(pendingBytes, frameBytes);
+
+        if (stats.nFramesWritten == 0) {
+            stats.minWriteTime = stats.maxWriteTime = writeTime;
+        } else {
+            stats.minWriteTime = std::min(stats.minWriteTime, writeTime);
+            stats.maxWriteTime = std::max(stats.maxWriteTime, writeTime);
+        }
+        ++stats.nFramesWritten;
+        stats.totalWriteTime += writeTime;
+        stats.totalLatency += latency;
+        stats.maxLatency = std::max(stats.maxLatency, latency);
+
+        roomAvailableCond.wakeAll();
+        if (ordered) {
+            // The next frame in the sequence may already be waiting
+            framesAvailableCond.wakeAll();
+        }
+    }
+};
+
+void
+AsyncWriteThread::run()
+{
+    AsyncWriteQueuePrivate* imp = _queue->_imp.get();
+
+    for (;;) {
+        AsyncWriteFramePtr frame;
+        {
+            QMutexLocker k(&imp->queueMutex);
+            for (;;) {
+                frame = imp->takeNextFrame();
+                if (frame) {
+                    break;
+                }
+                if ( imp->mustQuit && imp->pendingFrames.empty() ) {
+                    break;
+                }
+                imp->framesAvailableCond.wait(&imp->queueMutex);
+            }
+        }
+        if (!frame) {
+            break;
+        }
+
+        U64 frameBytes = frame->getMemorySize();
+        appPTR->fetchAndAddNRunningThreads(1);
+        TimeLapse writeTimer;
+        imp->scheduler->writeAsyncFrame(frame);
+        double writeTime = writeTimer.getTimeElapsedReset();
+        appPTR->fetchAndAddNRunningThreads(-1);
+
+        // Release the images before waking-up render threads waiting for memory
+        frame->views.clear();
+        clearAbortInfo();
+        appPTR->getAppTLS()->cleanupTLSForThread();
+
+        imp->notifyFrameWritten(frame, frameBytes, writeTime);
+    }
+}
+
+AsyncWriteQueue::AsyncWriteQueue(DefaultScheduler* scheduler)
+    : _imp( new AsyncWriteQueuePrivate(scheduler) )
+{
+}
+
+AsyncWriteQueue::~AsyncWriteQueue()
+{
+    stop(true);
+}
+
+void
+AsyncWriteQueue::start(int nThreads,
+                       bool ordered,
+                       int firstFrame,
+                       int lastFrame,
+                       int frameStep,
+                       RenderDirectionEnum direction,
+                       int maxPendingFrames,
+                       U64 maxPendingBytes)
+{
+    stop(true);
+
+    QMutexLocker k(&_imp->queueMutex);
+    assert( _imp->threads.empty() );
+    _imp->active = true;
+    _imp->mustQuit = false;
+    _imp->ordered = ordered;
+    _imp->frameStep = std::max(1, frameStep);
+    _imp->direction = direction;
+    _imp->nextExpectedFrame = direction == eRenderDirectionForward ? firstFrame : lastFrame;
+    _imp->maxPendingFrames = std::max(1, maxPendingFrames);
+    _imp->maxPendingBytes = maxPendingBytes;
+    _imp->pendingBytes = 0;
+    _imp->nFramesInFlight = 0;
+    _imp->stats = AsyncWriteQueueStats();
+
+    // Sequential writers can only be fed by a single thread
+    if (ordered) {
+        nThreads = 1;
+    }
+    nThreads = std::max(1, nThreads);
+    for (int i = 0; i < nThreads; ++i) {
+        AsyncWriteThread* thread = new AsyncWriteThread(this);
+        _imp->threads.push_back(thread);
+        thread->start();
+    }
+}
+
+bool
+AsyncWriteQueue::isActive() const
+{
+    QMutexLocker k(&_imp->queueMutex);
+
+    return _imp->active;
+}
+
+bool
+AsyncWriteQueue::appendFrame(const AsyncWriteFramePtr& frame)
+{
+    assert(frame);
+    U64 frameBytes = frame->getMemorySize();
+    TimeLapse stallTimer;
+    bool stalled = false;
+
+    QMutexLocker k(&_imp->queueMutex);
+    for (;;) {
+        if (!_imp->active || _imp->mustQuit) {
+            return false;
+        }
+
+        // In ordered mode the I/O thread may be waiting for this very frame: never block it, otherwise
+        // render threads that have rendered ahead would fill the queue and dead-lock the sequence.
+        if (_imp->ordered && frame->time == _imp->nextExpectedFrame) {
+            break;
+        }
+        if ( !_imp->isFull(frameBytes) ) {
+            break;
+        }
+        stalled = true;
+        _imp->roomAvailableCond.wait(&_imp->queueMutex, NATRON_ASYNC_WRITE_QUEUE_ABORT_POLL_MS);
+        if ( _imp->scheduler->isBeingAborted() ) {
+            return false;
+        }
+    }
+
+    if (stalled) {
+        _imp->stats.totalStallTime += stallTimer.getTimeElapsedReset();
+    }
+
+    frame->enqueueTimer.reset();
+    _imp->pendingFrames[frame->time] = frame;
+    _imp->pendingBytes += frameBytes;
+    _imp->stats.peakPendingFrames = std::max( _imp->stats.peakPendingFrames, (int)_imp->pendingFrames.size() + _imp->nFramesInFlight );
+    _imp->stats.peakPendingBytes = std::max(_imp->stats.peakPendingBytes, _imp->pendingBytes);
+    _imp->framesAvailableCond.wakeAll();
+
+    return true;
+}
+
+void
+AsyncWriteQueue::stop(bool discardPendingFrames)
+{
+    AsyncWriteThreads threads;
+    {
+        QMutexLocker k(&_imp->queueMutex);
+        if (!_imp->active) {
+            return;
+        }
+        _imp->mustQuit = true;
+        if (discardPendingFrames) {
+            _imp->pendingFrames.clear();
+        }
+        threads = _imp->threads;
+        _imp->framesAvailableCond.wakeAll();
+        _imp->roomAvailableCond.wakeAll();
+    }
+
+    for (AsyncWriteThreads::iterator it = threads.begin(); it != threads.end(); ++it) {
+        (*it)->wait();
+        delete *it;
+    }
+
+    QMutexLocker k(&_imp->queueMutex);
+    _imp->threads.clear();
+    _imp->pendingFrames.clear();
+    _imp->pendingBytes = 0;
+    _imp->nFramesInFlight = 0;
+    _imp->active = false;
+}
+
+AsyncWriteQueueStats
+AsyncWriteQueue::getStats() const
+{
+    QMutexLocker k(&_imp->queueMutex);
+
+    return _imp->stats;
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,199 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_AsyncWriteQueue_h
+#define Engine_AsyncWriteQueue_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+#include <map>
+#include <list>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/ImagePlaneDesc.h"
+#include "Engine/OutputSchedulerThread.h" // RenderDirectionEnum
+#include "Engine/RectD.h"
+#include "Engine/RectI.h"
+#include "Engine/Timer.h"
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief The images produced by the input of a Writer for one view of a frame, along with what is needed
+ * to call the render action of the Writer on them.
+ **/
+struct AsyncWriteFrameView
+{
+    RectD rod;
+    RectI renderWindow;
+    std::list<ImagePlaneDesc> components; // the planes to request from the Writer
+    ImageList inputPlanes; // the images rendered by the input of the Writer
+};
+
+/**
+ * @brief A frame waiting to be encoded and written on disk by the AsyncWriteQueue.
+ **/
+struct AsyncWriteFrame
+{
+    int time;
+    EffectInstancePtr writer;
+    std::vector<ViewIdx> viewsToRender;
+    std::map<ViewIdx, AsyncWriteFrameView> views;
+    RenderStatsPtr stats;
+
+    // Reset by the queue when the frame is appended, used to compute the latency of the frame
+    TimeLapse enqueueTimer;
+
+    AsyncWriteFrame()
+        : time(0)
+        , writer()
+        , viewsToRender()
+        , views()
+        , stats()
+        , enqueueTimer()
+    {
+    }
+
+    /**
+     * @brief Returns the memory held by the images of this frame, in bytes
+     **/
+    U64 getMemorySize() const;
+};
+
+/**
+ * @brief Statistics gathered by the AsyncWriteQueue for the duration of a render, reported
+ * at the end of a render on disk.
+ **/
+struct AsyncWriteQueueStats
+{
+    // Number of frames that went through the queue
+    int nFramesWritten;
+
+    // Time spent by I/O threads in the Writer render action (encode + write), in seconds
+    double totalWriteTime, minWriteTime, maxWriteTime;
+
+    // Time between the moment the frame was appended and the moment it was written, in seconds
+    double totalLatency, maxLatency;
+
+    // Time spent by render threads blocked because the queue was full, in seconds
+    double totalStallTime;
+
+    // Maximum number of frames and bytes that were pending at the same time
+    int peakPendingFrames;
+    U64 peakPendingBytes;
+
+    AsyncWriteQueueStats()
+        : nFramesWritten(0)
+        , totalWriteTime(0)
+        , minWriteTime(0)
+        , maxWriteTime(0)
+        , totalLatency(0)
+        , maxLatency(0)
+        , totalStallTime(0)
+        , peakPendingFrames(0)
+        , peakPendingBytes(0)
+    {
+    }
+};
+
+/**
+ * @brief A bounded queue of frames to write, consumed by dedicated I/O threads so that the render threads
+ * can start rendering frame N+k while frame N is still being encoded and written by the Writer.
+ *
+ * When the Writer requires sequential rendering (e.g: a movie file), frames are handed out to a single I/O thread
+ * strictly in the render order. Otherwise frames are written as soon as an I/O thread is available.
+ *
+ * Back-pressure: appendFrame() blocks the calling render thread while the queue holds more than the allowed
+ * number of frames or bytes, so that render threads cannot run arbitrarily ahead of the disk.
+ **/
+struct AsyncWriteQueuePrivate;
+class AsyncWriteQueue
+{
+public:
+
+    AsyncWriteQueue(DefaultScheduler* scheduler);
+
+    ~AsyncWriteQueue();
+
+    /**
+     * @brief Starts the I/O threads for a new render.
+     * @param nThreads The number of I/O threads. Forced to 1 if ordered is true.
+     * @param ordered If true, frames are written in the sequence order given by firstFrame/lastFrame/frameStep/direction
+     * @param maxPendingFrames Maximum number of frames that can wait in the queue
+     * @param maxPendingBytes Maximum memory that images waiting in the queue can hold
+     **/
+    void start(int nThreads,
+               bool ordered,
+               int firstFrame,
+               int lastFrame,
+               int frameStep,
+               RenderDirectionEnum direction,
+               int maxPendingFrames,
+               U64 maxPendingBytes);
+
+    /**
+     * @brief Returns true if start() was called and the queue was not stopped since.
+     **/
+    bool isActive() const;
+
+    /**
+     * @brief Append a frame to write. This blocks while the queue is full.
+     * Returns false if the queue was stopped or the render aborted while waiting, in which case
+     * the frame will not be written.
+     **/
+    bool appendFrame(const AsyncWriteFramePtr& frame);
+
+    /**
+     * @brief Stops the I/O threads. If discardPendingFrames is false, this blocks until all frames in the queue
+     * are written, otherwise frames that were not yet handed to an I/O thread are dropped.
+     * Frames being written when this is called are always waited for.
+     **/
+    void stop(bool discardPendingFrames);
+
+    /**
+     * @brief Returns the statistics of the last (or current) render
+     **/
+    AsyncWriteQueueStats getStats() const;
+
+private:
+
+    friend class AsyncWriteThread;
+
+    boost::scoped_ptr<AsyncWriteQueuePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_AsyncWriteQueue_h
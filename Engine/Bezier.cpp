@@ -88,6 +88,11 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 // http://www.davidrevoy.com/article182/calibrating-wacom-stylus-pressure-on-krita
 #define ROTO_PRESSURE_LEVELS 512
 
+// Maximum distance in pixels between a Bezier segment and its polygon when the number of points is computed automatically.
+// Below a tenth of a pixel the difference is not visible once anti-aliased.
+#define BEZIER_FLATNESS_TOLERANCE 0.1
+#define BEZIER_MAX_POINTS_PER_SEGMENT 1000
+
 #ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi             */
 #endif
@@ -777,19 +782,17 @@ bezierSegmentEval(bool useGuiCurves,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
     if (nbPointsPerSegment == -1) {
         /*
-         * Approximate the necessary number of line segments, using http://antigrain.com/research/adaptive_bezier/
+         * Use the smallest number of line segments such that the polygon does not deviate from the curve by more
+         * than BEZIER_FLATNESS_TOLERANCE pixels at this mipmap level (Wang's formula): straight segments only need
+         * their end points whereas tight curves get more points.
          */
-        double dx1, dy1, dx2, dy2, dx3, dy3;
-        dx1 = p1.x - p0.x;
-        dy1 = p1.y - p0.y;
-        dx2 = p2.x - p1.x;
-        dy2 = p2.y - p1.y;
-        dx3 = p3.x - p2.x;
-        dy3 = p3.y - p2.y;
-        double length = std::sqrt(dx1 * dx1 + dy1 * dy1) +
-                        std::sqrt(dx2 * dx2 + dy2 * dy2) +
-                        std::sqrt(dx3 * dx3 + dy3 * dy3);
-        nbPointsPerSegment = (int)std::max(length * 0.25, 2.);
+        double ddx1 = p0.x - 2. * p1.x + p2.x;
+        double ddy1 = p0.y - 2. * p1.y + p2.y;
+        double ddx2 = p1.x - 2. * p2.x + p3.x;
+        double ddy2 = p1.y - 2. * p2.y + p3.y;
+        double dd = std::sqrt( std::max(ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2) );
+        double nbSegments = std::ceil( std::sqrt(0.75 * dd / BEZIER_FLATNESS_TOLERANCE) );
+        nbPointsPerSegment = (int)std::min(std::max(nbSegments + 1., 2.), (double)BEZIER_MAX_POINTS_PER_SEGMENT);
     }
 
     double incr = 1. / (double)(nbPointsPerSegment - 1);
@@ -1023,6 +1026,7 @@ Bezier::copyInternalPointsToGuiPoints()
     }
     _imp->guiIsClockwiseOriented = _imp->isClockwiseOriented;
     _imp->guiIsClockwiseOrientedStatic = _imp->isClockwiseOrientedStatic;
+    incrementShapeAge();
 }
 
 bool
@@ -2391,6 +2395,8 @@ Bezier::setKeyframe(double time)
             }
         }
     }
+    // Adding a keyframe may change the interpolation of the neighbouring keyframes
+    incrementShapeAge();
     // _imp->setMustCopyGuiBezier(true);
     Q_EMIT keyframeSet(time);
 }
@@ -2631,6 +2637,29 @@ Bezier::evaluateAtTime_DeCasteljau(bool useGuiPoints,
                                          0, pointsSingleList, bbox);
 }
 
+// Appends a flattened polygon to the output of the evaluateAtTime_DeCasteljau functions
+static void
+appendFlattenedPolygon(const BezierFlattenedPolygon& polygon,
+                       std::list<std::list<ParametricPoint> >* points,
+                       std::list<ParametricPoint >* pointsSingleList,
+                       RectD* bbox)
+{
+    if (points) {
+        points->insert( points->end(), polygon.segments.begin(), polygon.segments.end() );
+    } else {
+        // The segments do not share their end points, so concatenating them yields the polygon
+        for (std::list<std::list<ParametricPoint> >::const_iterator it = polygon.segments.begin(); it != polygon.segments.end(); ++it) {
+            pointsSingleList->insert( pointsSingleList->end(), it->begin(), it->end() );
+        }
+    }
+    if ( bbox && !polygon.segments.empty() ) {
+        bbox->x1 = std::min(bbox->x1, polygon.bbox.x1);
+        bbox->x2 = std::max(bbox->x2, polygon.bbox.x2);
+        bbox->y1 = std::min(bbox->y1, polygon.bbox.y1);
+        bbox->y2 = std::max(bbox->y2, polygon.bbox.y2);
+    }
+}
+
 void
 Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
                                             double time,
@@ -2645,17 +2674,41 @@ Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
                                             RectD* bbox) const
 {
     assert((points && !pointsSingleList) || (!points && pointsSingleList));
-    Transform::Matrix3x3 transform;
+    BezierFlattenedPolygonKey key;
 
-    getTransformAtTime(time, &transform);
-    QMutexLocker l(&itemMutex);
-    deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipMapLevel, _imp->finished,
+    // Read the age before the control points so that a concurrent edit can only make the polygon stale for the old age
+    key.shapeAge = getShapeAge();
+    key.time = time;
+    key.mipMapLevel = mipMapLevel;
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                nbPointsPerSegment,
+    key.precision = nbPointsPerSegment;
 #else
-                errorScale,
+    key.precision = errorScale;
 #endif
-                transform, points, pointsSingleList, bbox);
+    key.useGuiCurves = useGuiCurves;
+    key.feather = false;
+    key.evaluateIfEqual = true;
+    getTransformAtTime(time, &key.transform);
+
+    BezierFlattenedPolygonPtr polygon = _imp->findFlattenedPolygon(key);
+    if (!polygon) {
+        boost::shared_ptr<BezierFlattenedPolygon> newPolygon = boost::make_shared<BezierFlattenedPolygon>();
+        newPolygon->key = key;
+        newPolygon->bbox.setupInfinity();
+        {
+            QMutexLocker l(&itemMutex);
+            deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipMapLevel, _imp->finished,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                        nbPointsPerSegment,
+#else
+                        errorScale,
+#endif
+                        key.transform, &newPolygon->segments, 0, &newPolygon->bbox);
+        }
+        _imp->insertFlattenedPolygon(newPolygon);
+        polygon = newPolygon;
+    }
+    appendFlattenedPolygon(*polygon, points, pointsSingleList, bbox);
 }
 
 void
@@ -2712,6 +2765,32 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
 {
     assert((points && !pointsSingleList) || (!points && pointsSingleList));
     assert( useFeatherPoints() );
+    BezierFlattenedPolygonKey key;
+
+    key.shapeAge = getShapeAge();
+    key.time = time;
+    key.mipMapLevel = mipMapLevel;
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+    key.precision = nbPointsPerSegment;
+#else
+    key.precision = errorScale;
+#endif
+    key.useGuiCurves = useGuiPoints;
+    key.feather = true;
+    key.evaluateIfEqual = evaluateIfEqual;
+    getTransformAtTime(time, &key.transform);
+
+    BezierFlattenedPolygonPtr polygon = _imp->findFlattenedPolygon(key);
+    if (polygon) {
+        appendFlattenedPolygon(*polygon, points, pointsSingleList, bbox);
+
+        return;
+    }
+
+    boost::shared_ptr<BezierFlattenedPolygon> newPolygon = boost::make_shared<BezierFlattenedPolygon>();
+    newPolygon->key = key;
+    newPolygon->bbox.setupInfinity();
+
     QMutexLocker l(&itemMutex);
 
 
@@ -2728,9 +2807,6 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         ++nextCp;
     }
 
-    Transform::Matrix3x3 transform;
-    getTransformAtTime(time, &transform);
-
     for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end();
          ++it) {
         if ( next == _imp->featherPoints.end() ) {
@@ -2745,39 +2821,22 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         if ( !evaluateIfEqual && bezierSegmenEqual(useGuiPoints, time, ViewIdx(0), **itCp, **nextCp, **it, **next) ) {
             continue;
         }
-        if (points) {
-            std::list<ParametricPoint> segmentPoints;
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
+        std::list<ParametricPoint> segmentPoints;
+        bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
+                          nbPointsPerSegment,
 #else
-                              errorScale,
+                          errorScale,
 #endif
-                              transform, &segmentPoints, bbox);
+                          key.transform, &segmentPoints, &newPolygon->bbox);
 
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!segmentPoints.empty()) {
-                    segmentPoints.pop_back();
-                }
-            }
-            points->push_back(segmentPoints);
-        } else {
-            assert(pointsSingleList);
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
-#ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
-#else
-                              errorScale,
-#endif
-                              transform, pointsSingleList, bbox);
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!pointsSingleList->empty()) {
-                    pointsSingleList->pop_back();
-                }
+        // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
+        if (!isOpenBezier() || next != _imp->featherPoints.end()) {
+            if (!segmentPoints.empty()) {
+                segmentPoints.pop_back();
             }
         }
+        newPolygon->segments.push_back(segmentPoints);
 
         // increment for next iteration
         if ( itCp != _imp->featherPoints.end() ) {
@@ -2790,8 +2849,11 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
             ++nextCp;
         }
     } // for(it)
+    l.unlock();
 
-}
+    _imp->insertFlattenedPolygon(newPolygon);
+    appendFlattenedPolygon(*newPolygon, points, pointsSingleList, bbox);
+} // Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal
 
 void
 Bezier::evaluateFeatherPointsAtTime_DeCasteljau(bool useGuiPoints,
@@ -375,7 +375,10 @@ public:
 
     /**
      * @brief Evaluates the spline at the given time and returns the list of all the points on the curve.
-     * @param nbPointsPerSegment controls how many points are used to draw one Bezier segment
+     * @param nbPointsPerSegment controls how many points are used to draw one Bezier segment. If -1, it is computed
+     * for each segment from its curvature so that the polygon stays within a tenth of a pixel of the curve at the given mipmap level.
+     * The resulting polygons are cached per shape age, time, mipmap level and transform, so evaluating the same shape
+     * again (for another tile, the RoD or the overlay) does not flatten it again.
      **/
     void evaluateAtTime_DeCasteljau(bool useGuiCurves,
                                     double time,
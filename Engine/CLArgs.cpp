@@ -62,6 +62,8 @@ public:
     bool useDefaultSettings;
     bool clearCacheOnLaunch;
     QString ipcPipe;
+    int nRenderWorkers;
+    bool isRenderWorker;
     int error;
     bool isInterpreterMode;
     std::list<std::pair<int, std::pair<int, int> > > frameRanges;
@@ -89,6 +91,8 @@ public:
         , useDefaultSettings(false)
         , clearCacheOnLaunch(false)
         , ipcPipe()
+        , nRenderWorkers(0)
+        , isRenderWorker(false)
         , error(0)
         , isInterpreterMode(false)
         , frameRanges()
@@ -225,6 +229,8 @@ CLArgs::operator=(const CLArgs& other)
     _imp->settingCommands = other._imp->settingCommands;
     _imp->isBackground = other._imp->isBackground;
     _imp->ipcPipe = other._imp->ipcPipe;
+    _imp->nRenderWorkers = other._imp->nRenderWorkers;
+    _imp->isRenderWorker = other._imp->isRenderWorker;
     _imp->error = other._imp->error;
     _imp->isInterpreterMode = other._imp->isInterpreterMode;
     _imp->frameRanges = other._imp->frameRanges;
@@ -339,7 +345,14 @@ CLArgs::printUsage(const std::string& programName)
         "     breakdown contains information about each nodes, render times etc...\n"
         "     This option is useful for debugging purposes or to control that a render\n"
         "     is working correctly.\n"
-        "     **Please note** that it does not work when writing video files."
+        "     **Please note** that it does not work when writing video files.\n"
+        "  -j [ --workers ] <number of processes>\n"
+        "     Render using the given number of worker processes, each running its\n"
+        "     own instance of %1 on the same project. Frames of each Write node are\n"
+        "     split in interleaved chunks handed to the workers as they become idle.\n"
+        "     Write nodes that require frames in order (e.g: video files) are\n"
+        "     rendered entirely by a single worker. This is useful on machines with\n"
+        "     many cores where a single process cannot use all of them.\n"
         "Sample uses:\n"
         "  %1 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1 -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp\n"
@@ -347,6 +360,7 @@ CLArgs::printUsage(const std::string& programName)
         "  %1Renderer -w MyWriter /FastDisk/Pictures/sequence'###'.exr 1-100 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1Renderer -w MyWriter -w MySecondWriter 1-10 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1Renderer -w MyWriter 1-10 -l /Users/Me/Scripts/onProjectLoaded.py /Users/Me/MyNatronProjects/MyProject.ntp\n"
+        "  %1Renderer -j 8 -w MyWriter 1-1000 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "\n"
         /* Text must hold in 80 columns ************************************************/
         "Options for the execution of Python scripts:\n"
@@ -512,6 +526,18 @@ CLArgs::getIPCPipeName() const
     return _imp->ipcPipe;
 }
 
+int
+CLArgs::getNumberOfRenderWorkers() const
+{
+    return _imp->nRenderWorkers;
+}
+
+bool
+CLArgs::isRenderWorker() const
+{
+    return _imp->isRenderWorker;
+}
+
 bool
 CLArgs::areRenderStatsEnabled() const
 {
@@ -911,6 +937,36 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("workers"), QString::fromUtf8("j") );
+        if ( it != args.end() ) {
+            QStringList::iterator next = it;
+            ++next;
+            bool ok = false;
+            if ( next != args.end() ) {
+                nRenderWorkers = next->toInt(&ok);
+            }
+            if ( !ok || (nRenderWorkers < 1) ) {
+                std::cout << tr("You must specify a number of worker processes greater than 0 when using the --workers option").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+            // Remove the number too, otherwise it would be taken for a frame range
+            it = args.erase(it);
+            args.erase(it);
+        }
+    }
+
+    {
+        // Internal: set by the render coordinator on the command-line of its worker processes
+        QStringList::iterator it = hasToken( QString::fromUtf8(NATRON_RENDER_WORKER_ARG), QString() );
+        if ( it != args.end() ) {
+            isRenderWorker = true;
+            args.erase(it);
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("onload"), QString::fromUtf8("l") );
         if ( it != args.end() ) {
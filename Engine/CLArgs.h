@@ -135,6 +135,16 @@ public:
     const QString& getDefaultOnProjectLoadedScript() const;
     const QString& getIPCPipeName() const;
 
+    /**
+     * @brief The number of worker processes passed with --workers, or 0 to render in this process.
+     **/
+    int getNumberOfRenderWorkers() const;
+
+    /**
+     * @brief True if this process is a worker process launched by a render coordinator, @see RenderCoordinator
+     **/
+    bool isRenderWorker() const;
+
     bool isPythonScript() const;
 
     bool areRenderStatsEnabled() const;
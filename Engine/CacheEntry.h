@@ -65,6 +65,7 @@
 #include "Engine/CacheEntryHolder.h"
 #include "Engine/MemoryFile.h"
 #include "Engine/NonKeyParams.h"
+#include "Engine/NumaInfo.h"
 #include "Engine/Texture.h"
 #include "Engine/EngineFwd.h"
 #include "Global/GlobalDefines.h"
@@ -81,11 +82,15 @@ class RamBuffer
     T* data;
     U64 count;
 
+    // The NUMA node the buffer is accounted to, @see bindMemoryToCurrentThreadNumaNode
+    int numaNode;
+
 public:
 
     RamBuffer()
         : data(0)
         , count(0)
+        , numaNode(-1)
     {
     }
 
@@ -103,6 +108,7 @@ public:
     {
         std::swap(data, other.data);
         std::swap(count, other.count);
+        std::swap(numaNode, other.numaNode);
     }
 
     U64 size() const
@@ -115,36 +121,41 @@ public:
         if (size == 0) {
             return;
         }
-        count = size;
         if (data) {
-            free(data);
-            data = 0;
-        }
-        if (count == 0) {
-            return;
+            freeData();
         }
+        count = size;
         data = (T*)malloc( size * sizeof(T) );
         if (!data) {
             throw std::bad_alloc();
         }
+        numaNode = bindMemoryToCurrentThreadNumaNode( data, size * sizeof(T) );
     }
 
     void clear()
     {
-        count = 0;
         if (data) {
-            free(data);
-            data = 0;
+            freeData();
         }
+        count = 0;
     }
 
     ~RamBuffer()
     {
         if (data) {
-            free(data);
-            data = 0;
+            freeData();
         }
     }
+
+private:
+
+    void freeData()
+    {
+        notifyNumaMemoryFreed( numaNode, count * sizeof(T) );
+        numaNode = -1;
+        free(data);
+        data = 0;
+    }
 };
 
 // This is a cache file with a fixed size that is a multiple of the tileByteSize.
@@ -305,6 +305,7 @@ Curve::setPeriodic(bool periodic)
     QMutexLocker k(&_imp->_lock);
     _imp->isPeriodic = periodic;
     _imp->keyFrames.clear();
+    ++_imp->revision;
 }
 
 bool
@@ -317,6 +318,7 @@ void
 Curve::operator=(const Curve & other)
 {
     *_imp = *other._imp;
+    ++_imp->revision;
 }
 
 void
@@ -325,6 +327,7 @@ Curve::clearKeyFrames()
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    ++_imp->revision;
 }
 
 bool
@@ -445,6 +448,7 @@ Curve::addKeyFrame(KeyFrame key)
 std::pair<KeyFrameSet::iterator, bool> Curve::addKeyFrameNoUpdate(const KeyFrame & cp)
 {
     // PRIVATE - should not lock
+    ++_imp->revision;
     if (!_imp->isParametric) { //< if keyframes are clamped to integers
         std::pair<KeyFrameSet::iterator, bool> newKey = _imp->keyFrames.insert(cp);
         // keyframe at this time exists, erase and insert again
@@ -895,6 +899,27 @@ Curve::getValueAt(double t,
 {
     QMutexLocker l(&_imp->_lock);
 
+    return getValueAtInternal(t, doClamp);
+}
+
+void
+Curve::getValuesAt(const std::vector<double>& times,
+                   bool clamp,
+                   std::vector<double>* values) const
+{
+    QMutexLocker l(&_imp->_lock);
+
+    values->resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        (*values)[i] = getValueAtInternal(times[i], clamp);
+    }
+}
+
+double
+Curve::getValueAtInternal(double t,
+                          bool doClamp) const
+{
+    // PRIVATE - should not lock
     if ( _imp->keyFrames.empty() ) {
         //throw std::runtime_error("Curve has no control points!");
 
@@ -973,7 +998,7 @@ Curve::getValueAt(double t,
 
         return v;
     }
-} // getValueAt
+} // getValueAtInternal
 
 double
 Curve::getDerivativeAt(double t) const
@@ -1253,6 +1278,7 @@ Curve::setXRange(double a,
 
     _imp->xMin = a;
     _imp->xMax = b;
+    ++_imp->revision;
 }
 
 std::pair<double, double> Curve::getXRange() const
@@ -1278,6 +1304,14 @@ Curve::getKeyFrames_mt_safe() const
     return _imp->keyFrames;
 }
 
+U64
+Curve::getRevision() const
+{
+    QMutexLocker l(&_imp->_lock);
+
+    return _imp->revision;
+}
+
 KeyFrameSet::iterator
 Curve::setKeyFrameValueAndTimeNoUpdate(double value,
                                        double time,
@@ -1652,6 +1686,7 @@ Curve::refreshDerivatives(Curve::CurveChangedReasonEnum reason,
     newKey.setLeftDerivative(vcurDerivLeft);
     newKey.setRightDerivative(vcurDerivRight);
 
+    ++_imp->revision;
     std::pair<KeyFrameSet::iterator, bool> newKeyIt = _imp->keyFrames.insert(newKey);
 
     // keyframe at this time exists, erase and insert again
@@ -1818,6 +1853,7 @@ Curve::setYRange(double yMin,
 
     _imp->yMin = yMin;
     _imp->yMax = yMax;
+    ++_imp->revision;
 }
 
 bool
@@ -1831,6 +1867,7 @@ void
 Curve::onCurveChanged()
 {
     // PRIVATE - should not lock
+    ++_imp->revision;
     if (_imp->owner) {
         _imp->owner->clearExpressionsResults(_imp->dimensionInOwner);
     }
@@ -70,6 +70,7 @@ struct CurvePrivate
     mutable QMutex _lock; //< the plug-ins can call getValueAt at any moment and we must make sure the user is not playing around
     bool isParametric;
     bool isPeriodic;
+    U64 revision; //< incremented each time the curve changes, not copied by operator=
 
     CurvePrivate()
         : keyFrames()
@@ -86,11 +87,13 @@ struct CurvePrivate
         , _lock(QMutex::Recursive)
         , isParametric(false)
         , isPeriodic(false)
+        , revision(0)
     {
     }
 
     CurvePrivate(const CurvePrivate & other)
         : _lock(QMutex::Recursive)
+        , revision(0)
     {
         *this = other;
     }
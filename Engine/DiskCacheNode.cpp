@@ -27,33 +27,173 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <sstream>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QMutex>
+#include <QtCore/QDebug>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#endif
 
 #include "Engine/Node.h"
 #include "Engine/Image.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/DiskCacheNodeStorage.h"
+#include "Engine/Hash64.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/Project.h"
+#include "Engine/Settings.h"
 #include "Engine/TimeLine.h"
 #include "Engine/ViewIdx.h"
 
 NATRON_NAMESPACE_ENTER
 
+typedef boost::shared_ptr<DiskCacheNodeStorage> DiskCacheNodeStoragePtr;
+
 struct DiskCacheNodePrivate
 {
     KnobChoiceWPtr frameRange;
     KnobIntWPtr firstFrame;
     KnobIntWPtr lastFrame;
     KnobButtonWPtr preRender;
+    KnobBoolWPtr compress;
+    KnobButtonWPtr clearCache;
+
+    ///The file where the images of this node are stored, opened on the first render.
+    ///Renders hold a reference to it, so it may be replaced while they are using it
+    DiskCacheNodeStoragePtr storage;
+
+    ///Set when the storage at this path failed to open, so that it is not attempted for each render
+    std::string storageFailedPath;
+
+    ///Where the files of this node are, so that they are moved when the node is renamed or the project saved under another name
+    std::string storageFilePath;
+    QMutex storageMutex;
 
     DiskCacheNodePrivate()
+        : frameRange()
+        , firstFrame()
+        , lastFrame()
+        , preRender()
+        , compress()
+        , clearCache()
+        , storage()
+        , storageFailedPath()
+        , storageFilePath()
+        , storageMutex()
     {
     }
+
+    DiskCacheNodeStoragePtr getStorage(DiskCacheNode* node);
+
+    ///Must be called with storageMutex locked
+    void moveStorageFiles(const std::string& filePath);
 };
 
+/**
+ * @brief The storage of a node is named after the project file and the fully qualified name of the node,
+ * so that reopening the project finds the images rendered in a previous session.
+ **/
+static std::string
+getStorageFilePath(DiskCacheNode* node)
+{
+    Hash64 hash;
+    ProjectPtr project = node->getApp()->getProject();
+
+    Hash64_appendQString( &hash, project->getProjectPath() + project->getProjectFilename() );
+    Hash64_appendQString( &hash, QString::fromUtf8( node->getNode()->getFullyQualifiedName().c_str() ) );
+    hash.computeHash();
+
+    QString filePath = DiskCacheNode::getStorageDirectoryPath() + QLatin1Char('/') + QString::number(hash.value(), 16);
+
+    return filePath.toStdString();
+}
+
+/**
+ * @brief The storage used when the files of the node are opened by another process (e.g: the other processes of a
+ * multi-process render) or another project resolving to the same files (e.g: two unsaved projects).
+ **/
+static std::string
+getTemporaryStorageFilePath(const std::string& filePath)
+{
+    static QAtomicInt temporaryStoragesCount;
+    std::stringstream ss;
+
+    ss << filePath << '_' << (qint64)QCoreApplication::applicationPid() << '_' << temporaryStoragesCount.fetchAndAddRelaxed(1);
+
+    return ss.str();
+}
+
+DiskCacheNodeStoragePtr
+DiskCacheNodePrivate::getStorage(DiskCacheNode* node)
+{
+    std::string filePath = getStorageFilePath(node);
+    QMutexLocker k(&storageMutex);
+
+    moveStorageFiles(filePath);
+    if (storage) {
+        return storage;
+    }
+    if (storageFailedPath == filePath) {
+        return storage;
+    }
+
+    QDir().mkpath( DiskCacheNode::getStorageDirectoryPath() );
+    try {
+        storage = boost::make_shared<DiskCacheNodeStorage>(filePath);
+    } catch (const std::exception& e) {
+        qDebug() << "DiskCache: failed to open" << QString::fromUtf8( filePath.c_str() ) << ":" << e.what();
+        // Images are not shared with another writer: keep them in files of this process, removed with the storage
+        std::string temporaryFilePath = getTemporaryStorageFilePath(filePath);
+        try {
+            storage = boost::make_shared<DiskCacheNodeStorage>(temporaryFilePath, true);
+        } catch (const std::exception& e2) {
+            qDebug() << "DiskCache: failed to open" << QString::fromUtf8( temporaryFilePath.c_str() ) << ":" << e2.what();
+            storageFailedPath = filePath;
+        }
+    }
+
+    return storage;
+}
+
+void
+DiskCacheNodePrivate::moveStorageFiles(const std::string& filePath)
+{
+    if ( !storageFilePath.empty() && (storageFilePath != filePath) ) {
+        // The images are still valid for the same node hash, keep them rather than leaving the files behind.
+        // A temporary storage is not moved: the files at the new path may be available.
+        if ( storage && storage->isTemporary() ) {
+            storage.reset();
+        } else if (storage) {
+            if ( !storage->moveFiles(filePath) ) {
+                qDebug() << "DiskCache: failed to move" << QString::fromUtf8( storageFilePath.c_str() ) << "to" << QString::fromUtf8( filePath.c_str() );
+                storage.reset();
+                DiskCacheNodeStorage::removeFiles(storageFilePath);
+            }
+        } else if ( !DiskCacheNodeStorage::renameFiles(storageFilePath, filePath) ) {
+            DiskCacheNodeStorage::removeFiles(storageFilePath);
+        }
+        storageFailedPath.clear();
+    }
+    storageFilePath = filePath;
+}
+
 DiskCacheNode::DiskCacheNode(NodePtr node)
     : OutputEffectInstance(node)
     , _imp( new DiskCacheNodePrivate() )
 {
     setSupportsRenderScaleMaybe(eSupportsYes);
+    if (node) {
+        ProjectPtr project = node->getApp()->getProject();
+        QObject::connect( project.get(), SIGNAL(projectNameChanged(QString,bool)), this, SLOT(onStorageFilePathChanged()) );
+        QObject::connect( node.get(), SIGNAL(scriptNameChanged(QString)), this, SLOT(onStorageFilePathChanged()) );
+    }
 }
 
 DiskCacheNode::~DiskCacheNode()
@@ -131,6 +271,23 @@ DiskCacheNode::initializeKnobs()
     preRender->setHintToolTip( tr("Cache the frame range specified by rendering images at zoom-level 100% only.") );
     page->addKnob(preRender);
     _imp->preRender = preRender;
+
+    KnobBoolPtr compress = AppManager::createKnob<KnobBool>( this, tr("Compress") );
+    compress->setName("compress");
+    compress->setAnimationEnabled(false);
+    compress->setEvaluateOnChange(false);
+    compress->setDefaultValue(false);
+    compress->setHintToolTip( tr("When checked, the images are compressed (losslessly) before being written to the disk. "
+                                 "This saves disk space at the expense of slower caching and reading.") );
+    page->addKnob(compress);
+    _imp->compress = compress;
+
+    KnobButtonPtr clearCache = AppManager::createKnob<KnobButton>( this, tr("Clear Cache") );
+    clearCache->setName("clearCache");
+    clearCache->setEvaluateOnChange(false);
+    clearCache->setHintToolTip( tr("Remove all the images cached on disk by this node.") );
+    page->addKnob(clearCache);
+    _imp->clearCache = clearCache;
 }
 
 bool
@@ -167,6 +324,8 @@ DiskCacheNode::knobChanged(KnobI* k,
         std::list<AppInstance::RenderWork> works;
         works.push_back(w);
         getApp()->startWritersRendering(false, works);
+    } else if (_imp->clearCache.lock().get() == k) {
+        clearStorage();
     } else {
         ret = false;
     }
@@ -201,6 +360,34 @@ DiskCacheNode::getFrameRange(double *first,
     }
 }
 
+void
+DiskCacheNode::getRegionsOfInterest(double time,
+                                    const RenderScale & scale,
+                                    const RectD & outputRoD,
+                                    const RectD & renderWindow,
+                                    ViewIdx view,
+                                    RoIMap* ret)
+{
+    // When the image is in the storage, no region of the input is needed and the input branch is not rendered at all.
+    // If the image is removed from the storage before render() reads it, render() falls back to fetching the input.
+    DiskCacheNodeStoragePtr storage = _imp->getStorage(this);
+    if (storage) {
+        DiskCacheNodeStorageKey key;
+        key.nodeHash = getHash();
+        key.time = time;
+        key.view = view.value();
+        key.mipMapLevel = Image::getLevelFromScale(scale.x);
+        key.nComps = getMetadataNComps(-1);
+
+        RectI roi;
+        renderWindow.toPixelEnclosing(key.mipMapLevel, getAspectRatio(-1), &roi);
+        if ( storage->contains(key, roi) ) {
+            return;
+        }
+    }
+    EffectInstance::getRegionsOfInterest(time, scale, outputRoD, renderWindow, view, ret);
+}
+
 StatusEnum
 DiskCacheNode::render(const RenderActionArgs& args)
 {
@@ -211,27 +398,92 @@ DiskCacheNode::render(const RenderActionArgs& args)
         return eStatusFailed;
     }
 
-
-    const std::pair<ImagePlaneDesc, ImagePtr>& output = args.outputPlanes.front();
+    DiskCacheNodeStoragePtr storage = _imp->getStorage(this);
+    const bool compress = _imp->compress.lock()->getValue();
 
     for (std::list<std::pair<ImagePlaneDesc, ImagePtr> >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it) {
+        const ImagePtr& output = it->second;
+
+        // Images are stored only for the color plane, with the float bit depth
+        DiskCacheNodeStorageKey key;
+        key.nodeHash = getHash();
+        key.time = args.time;
+        key.view = args.view.value();
+        key.mipMapLevel = output->getMipMapLevel();
+        key.nComps = (int)output->getComponentsCount();
+        const bool useStorage = storage && it->first.isColorPlane() && (output->getBitDepth() == eImageBitDepthFloat);
+
+        if (useStorage) {
+            // If getRegionsOfInterest() found the image, the input branch was not rendered: read it from the storage
+            Image::WriteAccess acc = output->getWriteRights();
+            float* dst = reinterpret_cast<float*>( acc.pixelAt(args.roi.x1, args.roi.y1) );
+            if ( dst && storage->get(key, args.roi, dst, output->getRowElements()) ) {
+                continue;
+            }
+        }
+
         RectI roiPixel;
         ImagePtr srcImg = getImage(0, args.time, args.originalScale, args.view, NULL, &it->first, false /*mapToClipPrefs*/, true /*dontUpscale*/, eStorageModeRAM /*useOpenGL*/, 0 /*textureDepth*/,  &roiPixel);
         if (!srcImg) {
             return eStatusFailed;
         }
-        if ( srcImg->getMipMapLevel() != output.second->getMipMapLevel() ) {
+        if ( srcImg->getMipMapLevel() != output->getMipMapLevel() ) {
             throw std::runtime_error("Host gave image with wrong scale");
         }
-        if ( ( srcImg->getComponents() != output.second->getComponents() ) || ( srcImg->getBitDepth() != output.second->getBitDepth() ) ) {
+        if ( ( srcImg->getComponents() != output->getComponents() ) || ( srcImg->getBitDepth() != output->getBitDepth() ) ) {
             srcImg->convertToFormat( args.roi, getApp()->getDefaultColorSpaceForBitDepth( srcImg->getBitDepth() ),
-                                     getApp()->getDefaultColorSpaceForBitDepth( output.second->getBitDepth() ), 3, true, false, output.second.get() );
+                                     getApp()->getDefaultColorSpaceForBitDepth( output->getBitDepth() ), 3, true, false, output.get() );
         } else {
-            output.second->pasteFrom( *srcImg, args.roi, output.second->usesBitMap() && srcImg->usesBitMap() );
+            output->pasteFrom( *srcImg, args.roi, output->usesBitMap() && srcImg->usesBitMap() );
+        }
+
+        if (useStorage) {
+            Image::ReadAccess acc = output->getReadRights();
+            const float* src = reinterpret_cast<const float*>( acc.pixelAt(args.roi.x1, args.roi.y1) );
+            if (src) {
+                storage->put( key, args.roi, src, output->getRowElements(), compress, appPTR->getCurrentSettings()->getMaximumDiskCacheNodeSize() );
+            }
         }
     }
 
     return eStatusOK;
+} // DiskCacheNode::render
+
+void
+DiskCacheNode::clearStorage()
+{
+    std::string filePath = getStorageFilePath(this);
+    {
+        QMutexLocker k(&_imp->storageMutex);
+        if (_imp->storage) {
+            _imp->storage->clear();
+        }
+        _imp->storage.reset();
+        _imp->storageFailedPath.clear();
+        if ( !_imp->storageFilePath.empty() && (_imp->storageFilePath != filePath) ) {
+            DiskCacheNodeStorage::removeFiles(_imp->storageFilePath);
+        }
+        _imp->storageFilePath = filePath;
+    }
+    DiskCacheNodeStorage::removeFiles(filePath);
+}
+
+void
+DiskCacheNode::onStorageFilePathChanged()
+{
+    // While the project is loading, the nodes are renamed before the project path is set: the path is not final yet
+    if ( getApp()->getProject()->isLoadingProjectInternal() ) {
+        return;
+    }
+    std::string filePath = getStorageFilePath(this);
+    QMutexLocker k(&_imp->storageMutex);
+    _imp->moveStorageFiles(filePath);
+}
+
+QString
+DiskCacheNode::getStorageDirectoryPath()
+{
+    return appPTR->getDiskCacheLocation() + QLatin1Char('/') + QString::fromUtf8(NATRON_DISKCACHE_NODE_STORAGE_DIR);
 }
 
 bool
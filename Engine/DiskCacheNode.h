@@ -90,6 +90,8 @@ public:
         return tr("This node caches all images of the connected input node onto the disk with full 32bit floating point raw data. "
                   "When an image is found in the cache, %1 will then not request the input branch to render out that image. "
                   "The DiskCache node only caches full images and does not split up the images in chunks.  "
+                  "The images are kept in a single file per node which is reused when the project is opened again, as long as the input branch did not change. "
+                  "They may optionally be compressed to save disk space.  "
                   "The DiskCache node is useful if working with a large and complex node tree: this allows to break the tree into smaller "
                   "branches and cache any branch that you're no longer working on. The cached images are saved by default in the same directory that is used "
                   "for the viewer cache but you can set its location and size in the preferences. A solid state drive disk is recommended for efficiency of this node. "
@@ -143,6 +145,23 @@ public:
 
     virtual bool isHostChannelSelectorSupported(bool* defaultR, bool* defaultG, bool* defaultB, bool* defaultA) const OVERRIDE WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Removes all the images stored on disk by this node
+     **/
+    void clearStorage();
+
+    /**
+     * @brief Returns the directory where DiskCache nodes store their images
+     **/
+    static QString getStorageDirectoryPath();
+
+public Q_SLOTS:
+
+    /**
+     * @brief Moves the files of the storage when the node is renamed or the project saved under another name
+     **/
+    void onStorageFilePathChanged();
+
 private:
 
     virtual bool knobChanged(KnobI* k,
@@ -150,6 +169,12 @@ private:
                              ViewSpec view,
                              double time,
                              bool originatedFromMainThread) OVERRIDE FINAL;
+    virtual void getRegionsOfInterest(double time,
+                                      const RenderScale & scale,
+                                      const RectD & outputRoD, //!< full RoD in canonical coordinates
+                                      const RectD & renderWindow, //!< the region to be rendered in the output image, in Canonical Coordinates
+                                      ViewIdx view,
+                                      RoIMap* ret) OVERRIDE FINAL;
     virtual StatusEnum render(const RenderActionArgs& args) OVERRIDE WARN_UNUSED_RETURN;
     virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, double time, ViewIdx view, int visitsCount) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     boost::scoped_ptr<DiskCacheNodePrivate> _imp;
@@ -0,0 +1,764 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "DiskCacheNodeStorage.h"
+
+#ifdef __NATRON_WIN32__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h> // flock
+#include <unistd.h>
+#endif
+
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
+#include <QtCore/QByteArray>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QDebug>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/MemoryFile.h"
+#include "Global/StrUtils.h"
+
+// Identifies the index file, followed by the version of the format
+#define DISKCACHE_NODE_STORAGE_MAGIC 0x4E544443 // "NTDC"
+#define DISKCACHE_NODE_STORAGE_VERSION 1
+
+NATRON_NAMESPACE_ENTER
+
+bool
+DiskCacheNodeStorageKey::operator<(const DiskCacheNodeStorageKey& other) const
+{
+    if (nodeHash != other.nodeHash) {
+        return nodeHash < other.nodeHash;
+    }
+    if (time != other.time) {
+        return time < other.time;
+    }
+    if (view != other.view) {
+        return view < other.view;
+    }
+    if (mipMapLevel != other.mipMapLevel) {
+        return mipMapLevel < other.mipMapLevel;
+    }
+
+    return nComps < other.nComps;
+}
+
+///The location of an image in the data file
+struct DiskCacheNodeStorageEntry
+{
+    RectI bounds;
+    U64 offset;
+    U64 storedSize;
+    bool compressed;
+
+    DiskCacheNodeStorageEntry()
+        : bounds()
+        , offset(0)
+        , storedSize(0)
+        , compressed(false)
+    {
+    }
+
+    std::size_t getRawSize(int nComps) const
+    {
+        return (std::size_t)bounds.width() * bounds.height() * nComps * sizeof(float);
+    }
+};
+
+typedef std::map<DiskCacheNodeStorageKey, DiskCacheNodeStorageEntry> DiskCacheNodeStorageEntries;
+
+static QString
+getDataFilePath(const std::string& filePath)
+{
+    return QString::fromUtf8( filePath.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_DATA_FILE_EXT);
+}
+
+static QString
+getIndexFilePath(const std::string& filePath)
+{
+    return QString::fromUtf8( filePath.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_INDEX_FILE_EXT);
+}
+
+static QString
+getLockFilePath(const std::string& filePath)
+{
+    return QString::fromUtf8( filePath.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_LOCK_FILE_EXT);
+}
+
+/**
+ * @brief Exclusive lock of the files of a storage, held as long as the storage is opened. Several storages may resolve to
+ * the same files (the worker processes of a render load the same project, two unsaved projects have the same name...):
+ * without it they would append images at the same offsets.
+ * The lock is taken by the operating system on a file next to the storage, so it is released if the process exits.
+ * It is exclusive between storages of the same process as well.
+ **/
+class DiskCacheNodeStorageLock
+{
+public:
+
+    DiskCacheNodeStorageLock()
+#ifdef __NATRON_WIN32__
+        : _handle(INVALID_HANDLE_VALUE)
+#else
+        : _fd(-1)
+#endif
+    {
+    }
+
+    ~DiskCacheNodeStorageLock()
+    {
+        unlock();
+    }
+
+    /**
+     * @brief Returns false if the storage at filePath is opened elsewhere
+     **/
+    bool tryLock(const std::string& filePath)
+    {
+        unlock();
+        std::string lockFilePath = getLockFilePath(filePath).toStdString();
+#ifdef __NATRON_WIN32__
+        std::wstring wpath = StrUtils::utf8_to_utf16(lockFilePath);
+        // No sharing: opening the file again fails until it is closed
+        _handle = ::CreateFileW(wpath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+
+        return _handle != INVALID_HANDLE_VALUE;
+#else
+        _fd = ::open(lockFilePath.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (_fd == -1) {
+            return false;
+        }
+        // flock() locks are bound to the open file, so they are also exclusive within a process
+        if (::flock(_fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(_fd);
+            _fd = -1;
+
+            return false;
+        }
+
+        return true;
+#endif
+    }
+
+    ///The lock file is not removed: another storage may already have opened it and wait for the lock
+    void unlock()
+    {
+#ifdef __NATRON_WIN32__
+        if (_handle != INVALID_HANDLE_VALUE) {
+            ::CloseHandle(_handle);
+            _handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (_fd != -1) {
+            ::flock(_fd, LOCK_UN);
+            ::close(_fd);
+            _fd = -1;
+        }
+#endif
+    }
+
+private:
+
+#ifdef __NATRON_WIN32__
+    HANDLE _handle;
+#else
+    int _fd;
+#endif
+};
+
+static void
+writeIndexHeader(QDataStream& stream)
+{
+    stream << (quint32)DISKCACHE_NODE_STORAGE_MAGIC << (quint32)DISKCACHE_NODE_STORAGE_VERSION;
+}
+
+static void
+writeIndexEntry(QDataStream& stream,
+                const DiskCacheNodeStorageKey& key,
+                const DiskCacheNodeStorageEntry& entry)
+{
+    stream << (quint64)key.nodeHash << key.time << (qint32)key.view << (quint32)key.mipMapLevel << (qint32)key.nComps;
+    stream << (qint32)entry.bounds.x1 << (qint32)entry.bounds.y1 << (qint32)entry.bounds.x2 << (qint32)entry.bounds.y2;
+    stream << (quint64)entry.offset << (quint64)entry.storedSize << (quint8)entry.compressed;
+}
+
+static bool
+readIndexEntry(QDataStream& stream,
+               DiskCacheNodeStorageKey* key,
+               DiskCacheNodeStorageEntry* entry)
+{
+    quint64 nodeHash, offset, storedSize;
+    qint32 view, nComps, x1, y1, x2, y2;
+    quint32 mipMapLevel;
+    quint8 compressed;
+
+    stream >> nodeHash >> key->time >> view >> mipMapLevel >> nComps;
+    stream >> x1 >> y1 >> x2 >> y2;
+    stream >> offset >> storedSize >> compressed;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    key->nodeHash = nodeHash;
+    key->view = view;
+    key->mipMapLevel = mipMapLevel;
+    key->nComps = nComps;
+    entry->bounds.set(x1, y1, x2, y2);
+    entry->offset = offset;
+    entry->storedSize = storedSize;
+    entry->compressed = compressed != 0;
+
+    return true;
+}
+
+struct DiskCacheNodeStoragePrivate
+{
+    std::string filePath;
+
+    ///The images of the data file
+    DiskCacheNodeStorageEntries entries;
+
+    ///The first byte after the last image of the data file, including the space reserved by put() calls in progress.
+    ///The file is grown by larger chunks, up to the maximum size of the storage
+    U64 dataEnd;
+
+    ///Sum of the sizes of the images in entries. Replaced images are not counted
+    U64 usedSize;
+
+    ///Incremented whenever images are moved in the data file (or the file is replaced), so that a put() which
+    ///reserved space before that does not publish its image
+    U64 generation;
+
+    ///Closed (but not removed) when the files are moved
+    boost::scoped_ptr<MemoryFile> dataFile;
+
+    ///Held from the constructor to the destructor
+    boost::scoped_ptr<DiskCacheNodeStorageLock> fileLock;
+
+    ///The files are removed by the destructor
+    bool temporary;
+
+    ///Protects all the above. The data file may be remapped by put(), so reading its data requires the read lock
+    mutable QReadWriteLock lock;
+
+    DiskCacheNodeStoragePrivate(const std::string& filePath)
+        : filePath(filePath)
+        , entries()
+        , dataEnd(0)
+        , usedSize(0)
+        , generation(0)
+        , dataFile( new MemoryFile() )
+        , fileLock( new DiskCacheNodeStorageLock() )
+        , temporary(false)
+        , lock()
+    {
+    }
+
+    void load();
+
+    void reset();
+
+    bool appendIndexEntry(const DiskCacheNodeStorageKey& key, const DiskCacheNodeStorageEntry& entry);
+
+    void ensureDataFileSize(U64 size, U64 maxSize);
+
+    void compact(U64 nodeHash);
+};
+
+void
+DiskCacheNodeStoragePrivate::load()
+{
+    dataFile->open(getDataFilePath(filePath).toStdString(), MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate);
+
+    QFile indexFile( getIndexFilePath(filePath) );
+    if ( !indexFile.open(QIODevice::ReadOnly) ) {
+        reset();
+
+        return;
+    }
+
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_8);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if ( (stream.status() != QDataStream::Ok) || (magic != DISKCACHE_NODE_STORAGE_MAGIC) || (version != DISKCACHE_NODE_STORAGE_VERSION) ) {
+        indexFile.close();
+        reset();
+
+        return;
+    }
+
+    ///Entries are only appended to the index: a later entry for the same key replaces the former one.
+    ///The index is written after the data, if Natron exited while writing an image the entry is either missing or out of the file.
+    const U64 dataFileSize = dataFile->data() ? dataFile->size() : 0;
+    while ( !stream.atEnd() ) {
+        DiskCacheNodeStorageKey key;
+        DiskCacheNodeStorageEntry entry;
+        if ( !readIndexEntry(stream, &key, &entry) ) {
+            break;
+        }
+        if ( entry.bounds.isNull() || (key.nComps <= 0) || (entry.offset + entry.storedSize > dataFileSize) ||
+             ( !entry.compressed && (entry.storedSize != entry.getRawSize(key.nComps)) ) ||
+             ( entry.compressed && ( entry.storedSize > (U64)std::numeric_limits<int>::max() ) ) ) {
+            continue;
+        }
+        DiskCacheNodeStorageEntries::iterator found = entries.find(key);
+        if ( found != entries.end() ) {
+            usedSize -= found->second.storedSize;
+            found->second = entry;
+        } else {
+            entries.insert( std::make_pair(key, entry) );
+        }
+        usedSize += entry.storedSize;
+        dataEnd = std::max(dataEnd, entry.offset + entry.storedSize);
+    }
+} // DiskCacheNodeStoragePrivate::load
+
+void
+DiskCacheNodeStoragePrivate::reset()
+{
+    entries.clear();
+    dataEnd = 0;
+    usedSize = 0;
+    ++generation;
+
+    ///Removing the file also closes the mapping, it will be mapped again by the next resize()
+    dataFile->remove();
+    dataFile->open(getDataFilePath(filePath).toStdString(), MemoryFile::eFileOpenModeEnumIfExistsTruncateElseCreate);
+
+    QFile indexFile( getIndexFilePath(filePath) );
+    if ( !indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+        qDebug() << "DiskCacheNodeStorage: failed to create" << indexFile.fileName();
+
+        return;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_8);
+    writeIndexHeader(stream);
+}
+
+bool
+DiskCacheNodeStoragePrivate::appendIndexEntry(const DiskCacheNodeStorageKey& key,
+                                              const DiskCacheNodeStorageEntry& entry)
+{
+    QFile indexFile( getIndexFilePath(filePath) );
+
+    if ( !indexFile.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+        return false;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_8);
+    writeIndexEntry(stream, key, entry);
+
+    return stream.status() == QDataStream::Ok;
+}
+
+void
+DiskCacheNodeStoragePrivate::ensureDataFileSize(U64 size,
+                                                U64 maxSize)
+{
+    const U64 currentSize = dataFile->data() ? dataFile->size() : 0;
+
+    if (size <= currentSize) {
+        return;
+    }
+
+    ///Grow by at least half of the current size so that appending many images does not remap the file each time,
+    ///but never beyond the maximum size of the storage
+    dataFile->resize( std::max( size, std::min(currentSize + currentSize / 2, maxSize) ) );
+}
+
+void
+DiskCacheNodeStoragePrivate::compact(U64 nodeHash)
+{
+    ///The images kept, sorted by offset so that they can be moved towards the beginning of the file in place
+    std::map<U64, DiskCacheNodeStorageEntries::iterator> keptEntries;
+
+    for (DiskCacheNodeStorageEntries::iterator it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first.nodeHash == nodeHash) {
+            keptEntries[it->second.offset] = it;
+        }
+    }
+    ///Nothing to do if no image is removed and there is no unused space left by replaced images
+    if ( ( keptEntries.size() == entries.size() ) && (usedSize == dataEnd) ) {
+        return;
+    }
+    ++generation;
+
+    ///Empty the index first: if Natron exits while the images are moved, the index does not point to moved data
+    QFile indexFile( getIndexFilePath(filePath) );
+    if ( !indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+        reset();
+
+        return;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_8);
+    writeIndexHeader(stream);
+    indexFile.flush();
+
+    DiskCacheNodeStorageEntries compactedEntries;
+    U64 offset = 0;
+    for (std::map<U64, DiskCacheNodeStorageEntries::iterator>::iterator it = keptEntries.begin(); it != keptEntries.end(); ++it) {
+        DiskCacheNodeStorageEntry entry = it->second->second;
+        if (entry.offset != offset) {
+            std::memmove(dataFile->data() + offset, dataFile->data() + entry.offset, entry.storedSize);
+        }
+        entry.offset = offset;
+        offset += entry.storedSize;
+        compactedEntries.insert( std::make_pair(it->second->first, entry) );
+    }
+    if ( dataFile->data() ) {
+        dataFile->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+    }
+
+    for (DiskCacheNodeStorageEntries::const_iterator it = compactedEntries.begin(); it != compactedEntries.end(); ++it) {
+        writeIndexEntry(stream, it->first, it->second);
+    }
+    indexFile.close();
+    entries.swap(compactedEntries);
+    dataEnd = offset;
+    usedSize = offset;
+
+    ///Give the space back to the disk
+    if (offset == 0) {
+        reset();
+    } else if ( dataFile->data() && (dataFile->size() > offset) ) {
+        try {
+            dataFile->resize(offset);
+        } catch (const std::exception& e) {
+            qDebug() << "DiskCacheNodeStorage:" << e.what();
+            reset();
+        }
+    }
+} // DiskCacheNodeStoragePrivate::compact
+
+DiskCacheNodeStorage::DiskCacheNodeStorage(const std::string& filePath,
+                                           bool temporary)
+    : _imp( new DiskCacheNodeStoragePrivate(filePath) )
+{
+    if ( !_imp->fileLock->tryLock(filePath) ) {
+        throw std::runtime_error("DiskCacheNodeStorage: " + filePath + " is used by another process or project");
+    }
+    _imp->temporary = temporary;
+    _imp->load();
+}
+
+DiskCacheNodeStorage::~DiskCacheNodeStorage()
+{
+    if (_imp->temporary) {
+        _imp->dataFile->remove();
+        QFile::remove( getIndexFilePath(_imp->filePath) );
+        QFile::remove( getLockFilePath(_imp->filePath) );
+    } else if ( _imp->dataFile->data() ) {
+        _imp->dataFile->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+    }
+}
+
+bool
+DiskCacheNodeStorage::isTemporary() const
+{
+    return _imp->temporary;
+}
+
+const std::string&
+DiskCacheNodeStorage::getFilePath() const
+{
+    return _imp->filePath;
+}
+
+bool
+DiskCacheNodeStorage::contains(const DiskCacheNodeStorageKey& key,
+                               const RectI& roi) const
+{
+    QReadLocker k(&_imp->lock);
+    DiskCacheNodeStorageEntries::const_iterator found = _imp->entries.find(key);
+
+    return ( found != _imp->entries.end() ) && found->second.bounds.contains(roi) && !roi.isNull();
+}
+
+bool
+DiskCacheNodeStorage::get(const DiskCacheNodeStorageKey& key,
+                          const RectI& roi,
+                          float* dst,
+                          std::size_t dstRowElements) const
+{
+    QReadLocker k(&_imp->lock);
+    DiskCacheNodeStorageEntries::const_iterator found = _imp->entries.find(key);
+
+    if ( ( found == _imp->entries.end() ) || !found->second.bounds.contains(roi) || roi.isNull() ) {
+        return false;
+    }
+
+    const DiskCacheNodeStorageEntry& entry = found->second;
+    const char* storedData = _imp->dataFile->data() + entry.offset;
+
+    ///Uncompressed images are read straight from the mapped file
+    QByteArray uncompressed;
+    if (entry.compressed) {
+        if ( entry.storedSize > (U64)std::numeric_limits<int>::max() ) {
+            return false;
+        }
+        uncompressed = qUncompress( reinterpret_cast<const uchar*>(storedData), (int)entry.storedSize );
+        if ( (std::size_t)uncompressed.size() != entry.getRawSize(key.nComps) ) {
+            return false;
+        }
+        storedData = uncompressed.constData();
+    }
+
+    const float* src = reinterpret_cast<const float*>(storedData);
+    const std::size_t srcRowElements = (std::size_t)entry.bounds.width() * key.nComps;
+    src += (std::size_t)(roi.y1 - entry.bounds.y1) * srcRowElements + (std::size_t)(roi.x1 - entry.bounds.x1) * key.nComps;
+    const std::size_t rowBytes = (std::size_t)roi.width() * key.nComps * sizeof(float);
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        std::memcpy(dst, src, rowBytes);
+        src += srcRowElements;
+        dst += dstRowElements;
+    }
+
+    return true;
+} // DiskCacheNodeStorage::get
+
+bool
+DiskCacheNodeStorage::put(const DiskCacheNodeStorageKey& key,
+                          const RectI& roi,
+                          const float* src,
+                          std::size_t srcRowElements,
+                          bool compress,
+                          U64 maxSize)
+{
+    if ( roi.isNull() || (key.nComps <= 0) ) {
+        return false;
+    }
+
+    DiskCacheNodeStorageEntry entry;
+    entry.bounds = roi;
+    const std::size_t rowElements = (std::size_t)roi.width() * key.nComps;
+    const std::size_t rawSize = entry.getRawSize(key.nComps);
+
+    ///Compress before taking the lock, this is the expensive part. The compressed image is kept only if smaller.
+    QByteArray compressed;
+    if (compress) {
+        QByteArray raw;
+        raw.resize( (int)rawSize );
+        char* rawPtr = raw.data();
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            std::memcpy(rawPtr, src + (std::size_t)(y - roi.y1) * srcRowElements, rowElements * sizeof(float));
+            rawPtr += rowElements * sizeof(float);
+        }
+        compressed = qCompress(raw);
+        entry.compressed = (std::size_t)compressed.size() < rawSize;
+    }
+    entry.storedSize = entry.compressed ? compressed.size() : rawSize;
+
+    ///Reserve the space of the image at the end of the data file. Replaced images still use space until compact() runs,
+    ///so the end of the data (and not the size of the images) is bounded by maxSize
+    U64 generation;
+    {
+        QWriteLocker k(&_imp->lock);
+        if (_imp->dataEnd + entry.storedSize > maxSize) {
+            _imp->compact(key.nodeHash);
+            if (_imp->dataEnd + entry.storedSize > maxSize) {
+                return false;
+            }
+        }
+
+        entry.offset = _imp->dataEnd;
+        try {
+            _imp->ensureDataFileSize(entry.offset + entry.storedSize, maxSize);
+        } catch (const std::exception& e) {
+            qDebug() << "DiskCacheNodeStorage:" << e.what();
+
+            return false;
+        }
+        _imp->dataEnd = entry.offset + entry.storedSize;
+        generation = _imp->generation;
+    }
+
+    ///Copy the image to the reserved space: the read lock is enough since no other thread uses this space,
+    ///it only prevents the file from being remapped. Readers are not blocked while images are written.
+    {
+        QReadLocker k(&_imp->lock);
+        if (_imp->generation != generation) {
+            return false;
+        }
+        char* dst = _imp->dataFile->data() + entry.offset;
+        if (entry.compressed) {
+            std::memcpy(dst, compressed.constData(), entry.storedSize);
+        } else {
+            for (int y = roi.y1; y < roi.y2; ++y) {
+                std::memcpy(dst, src + (std::size_t)(y - roi.y1) * srcRowElements, rowElements * sizeof(float));
+                dst += rowElements * sizeof(float);
+            }
+        }
+        _imp->dataFile->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+    }
+
+    ///Publish the image, unless the space was reclaimed in the meantime
+    QWriteLocker k(&_imp->lock);
+    if ( (_imp->generation != generation) || !_imp->appendIndexEntry(key, entry) ) {
+        return false;
+    }
+
+    DiskCacheNodeStorageEntries::iterator found = _imp->entries.find(key);
+    if ( found != _imp->entries.end() ) {
+        _imp->usedSize -= found->second.storedSize;
+        found->second = entry;
+    } else {
+        _imp->entries.insert( std::make_pair(key, entry) );
+    }
+    _imp->usedSize += entry.storedSize;
+
+    return true;
+} // DiskCacheNodeStorage::put
+
+U64
+DiskCacheNodeStorage::getSize() const
+{
+    QReadLocker k(&_imp->lock);
+
+    return _imp->usedSize;
+}
+
+void
+DiskCacheNodeStorage::removeEntriesWithDifferentHash(U64 nodeHash)
+{
+    QWriteLocker k(&_imp->lock);
+
+    _imp->compact(nodeHash);
+}
+
+void
+DiskCacheNodeStorage::clear()
+{
+    QWriteLocker k(&_imp->lock);
+
+    _imp->reset();
+}
+
+bool
+DiskCacheNodeStorage::moveFiles(const std::string& filePath)
+{
+    QWriteLocker k(&_imp->lock);
+
+    if (filePath == _imp->filePath) {
+        return true;
+    }
+
+    ///The files at the new path must not be in use
+    boost::scoped_ptr<DiskCacheNodeStorageLock> newLock( new DiskCacheNodeStorageLock() );
+    if ( !newLock->tryLock(filePath) ) {
+        return false;
+    }
+
+    ///Close the mapping before renaming the file, this is required on Windows
+    _imp->dataFile.reset();
+    const bool moved = renameFilesInternal(_imp->filePath, filePath);
+    if (moved) {
+        _imp->filePath = filePath;
+        _imp->fileLock.swap(newLock);
+    }
+    ++_imp->generation;
+    try {
+        _imp->dataFile.reset( new MemoryFile(getDataFilePath(_imp->filePath).toStdString(), MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
+    } catch (const std::exception& e) {
+        qDebug() << "DiskCacheNodeStorage:" << e.what();
+        ///The storage is unusable: forget its images, put() fails until it is reopened
+        _imp->dataFile.reset( new MemoryFile() );
+        _imp->entries.clear();
+        _imp->dataEnd = 0;
+        _imp->usedSize = 0;
+
+        return false;
+    }
+
+    return moved;
+}
+
+bool
+DiskCacheNodeStorage::removeFiles(const std::string& filePath)
+{
+    DiskCacheNodeStorageLock fileLock;
+
+    if ( !fileLock.tryLock(filePath) ) {
+        return false;
+    }
+    QFile::remove( getDataFilePath(filePath) );
+    QFile::remove( getIndexFilePath(filePath) );
+
+    return true;
+}
+
+bool
+DiskCacheNodeStorage::renameFiles(const std::string& filePath,
+                                  const std::string& newFilePath)
+{
+    DiskCacheNodeStorageLock fileLock, newFileLock;
+
+    if ( !fileLock.tryLock(filePath) || !newFileLock.tryLock(newFilePath) ) {
+        return false;
+    }
+
+    return renameFilesInternal(filePath, newFilePath);
+}
+
+bool
+DiskCacheNodeStorage::renameFilesInternal(const std::string& filePath,
+                                          const std::string& newFilePath)
+{
+    const QString dataFilePath = getDataFilePath(filePath);
+    const QString indexFilePath = getIndexFilePath(filePath);
+    const QString newDataFilePath = getDataFilePath(newFilePath);
+    const QString newIndexFilePath = getIndexFilePath(newFilePath);
+
+    ///QFile::rename does not overwrite the destination
+    QFile::remove(newDataFilePath);
+    QFile::remove(newIndexFilePath);
+    if ( !QFile::rename(dataFilePath, newDataFilePath) ) {
+        return false;
+    }
+    if ( !QFile::rename(indexFilePath, newIndexFilePath) ) {
+        ///Do not leave a data file without its index
+        QFile::rename(newDataFilePath, dataFilePath);
+
+        return false;
+    }
+
+    return true;
+}
+
+NATRON_NAMESPACE_EXIT
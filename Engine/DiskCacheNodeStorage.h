@@ -0,0 +1,172 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_DISKCACHENODESTORAGE_H
+#define NATRON_ENGINE_DISKCACHENODESTORAGE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+#include <cstddef>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+#include "Engine/RectI.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Identifies an image stored by a DiskCache node. Images rendered with a different node hash
+ * (i.e: the upstream tree changed) are never returned.
+ **/
+struct DiskCacheNodeStorageKey
+{
+    U64 nodeHash;
+    double time;
+    int view;
+    unsigned int mipMapLevel;
+    int nComps;
+
+    DiskCacheNodeStorageKey()
+        : nodeHash(0)
+        , time(0.)
+        , view(0)
+        , mipMapLevel(0)
+        , nComps(0)
+    {
+    }
+
+    bool operator<(const DiskCacheNodeStorageKey& other) const;
+};
+
+struct DiskCacheNodeStoragePrivate;
+
+/**
+ * @brief The persistent storage of a DiskCache node: float images are appended to a single data file
+ * which is mapped to memory, so that they are read without any intermediate copy. A binary index file
+ * next to it lists the images with their key and bounds, so the storage is reopened across sessions
+ * without restoring a table of contents of the whole cache.
+ * Images may optionally be compressed (losslessly) with zlib.
+ * The data file never grows beyond the maximum size given to put() and shrinks when its images are compacted.
+ * The files are locked while the storage is opened, so that a single storage (of any process) writes them.
+ * This class is MT-safe: images may be read concurrently.
+ **/
+class DiskCacheNodeStorage
+{
+public:
+
+    /**
+     * @brief Opens the storage at the given path (without extension), creating its files if needed.
+     * The files are wiped if they were written with another version of the format.
+     * If temporary is true, the files are removed when the storage is destroyed.
+     * This might throw an exception upon failure to open the files, or if they are opened by another storage.
+     **/
+    DiskCacheNodeStorage(const std::string& filePath, bool temporary = false);
+
+    ~DiskCacheNodeStorage();
+
+    const std::string& getFilePath() const;
+
+    bool isTemporary() const;
+
+    /**
+     * @brief Returns true if an image with the given key containing roi is stored
+     **/
+    bool contains(const DiskCacheNodeStorageKey& key, const RectI& roi) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Copies the portion roi of the image stored for the given key to dst, which points to the pixel (roi.x1, roi.y1)
+     * of a buffer of dstRowElements floats per row.
+     * Returns false if no image with the given key containing roi is stored.
+     **/
+    bool get(const DiskCacheNodeStorageKey& key,
+             const RectI& roi,
+             float* dst,
+             std::size_t dstRowElements) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Stores the portion roi of the image src, which points to the pixel (roi.x1, roi.y1) of a buffer of
+     * srcRowElements floats per row. It replaces any image previously stored for the same key.
+     * If the data file would exceed maxSize bytes, the images rendered with another node hash and the space left by
+     * replaced images are reclaimed first and the image is not stored if this is not enough.
+     * The image is copied without blocking the readers of the storage.
+     * Returns false if the image was not stored.
+     **/
+    bool put(const DiskCacheNodeStorageKey& key,
+             const RectI& roi,
+             const float* src,
+             std::size_t srcRowElements,
+             bool compress,
+             U64 maxSize);
+
+    /**
+     * @brief Returns the number of bytes used by the images in the data file
+     **/
+    U64 getSize() const;
+
+    /**
+     * @brief Removes all images rendered with a node hash other than nodeHash
+     **/
+    void removeEntriesWithDifferentHash(U64 nodeHash);
+
+    /**
+     * @brief Removes all images and truncates the files
+     **/
+    void clear();
+
+    /**
+     * @brief Moves the files of the storage to the given path (without extension), replacing any storage there.
+     * The images are kept. Returns false if the files could not be moved, in which case the storage is left at its
+     * current path.
+     **/
+    bool moveFiles(const std::string& filePath);
+
+    /**
+     * @brief Removes the files of the storage at the given path (without extension).
+     * Returns false if they are opened by a storage.
+     **/
+    static bool removeFiles(const std::string& filePath);
+
+    /**
+     * @brief Renames the files of a storage which is not opened, replacing any storage at newFilePath.
+     * Returns false if there are no files at filePath, either storage is opened or the files could not be renamed.
+     **/
+    static bool renameFiles(const std::string& filePath, const std::string& newFilePath);
+
+private:
+
+    ///The caller must hold the locks of both paths
+    static bool renameFilesInternal(const std::string& filePath, const std::string& newFilePath);
+
+    boost::scoped_ptr<DiskCacheNodeStoragePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_DISKCACHENODESTORAGE_H
@@ -61,6 +61,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/ImageParams.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/KnobsSnapshot.h"
 #include "Engine/Log.h"
 #include "Engine/MemoryInfo.h" // printAsRAM
 #include "Engine/Node.h"
@@ -327,6 +328,10 @@ EffectInstance::setParallelRenderArgsTLS(double time,
     args->tilesSupported = getNode()->getCurrentSupportTiles();
     args->stats = stats;
     args->openGLContext = glContext;
+    // Children of multi-instance nodes (e.g: tracks) do not render, they only get the TLS for expressions
+    if ( !isAnalysis && ( QThread::currentThread() != qApp->thread() ) && !getNode()->getParentMultiInstance() ) {
+        args->knobsSnapshot = boost::make_shared<KnobsSnapshot>(*this, time);
+    }
     argsList.push_back(args);
 }
 
@@ -2156,6 +2161,12 @@ EffectInstance::Implementation::tiledRenderingFunctor(EffectInstance::Implementa
         appPTR->getAppTLS()->copyTLS(callingThread, curThread);
     }
 
+    // Tiles still waiting for a thread when the render gets aborted are not rendered at all
+    if ( _publicInterface->aborted() ) {
+        appPTR->getAppTLS()->cleanupTLSForThread();
+
+        return eRenderingFunctorRetAborted;
+    }
 
     EffectInstance::RenderingFunctorRetEnum ret = tiledRenderingFunctor(specificData,
                                                                         args.renderFullScaleThenDownscale,
@@ -2709,6 +2720,13 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
         }
 
         renderAborted = _publicInterface->aborted();
+        if (renderAborted && frameArgs->stats) {
+            // Record how long the render action kept running after the abort was requested
+            AbortableRenderInfoPtr abortInfo = frameArgs->abortInfo.lock();
+            if (abortInfo) {
+                frameArgs->stats->addAbortLatencyForNode( _publicInterface->getNode(), abortInfo->getTimeSinceAbort() );
+            }
+        }
 
         /*
          * Since new planes can have been allocated on the fly by allocateImagePlaneAndSetInThreadLocalStorage(), refresh
@@ -2824,9 +2842,10 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                 }
 
                 if (mappedOriginalInputImage) {
-                    it->second.tmpImage->copyUnProcessedChannels(renderMappedRectToRender, planes.outputPremult, originalImagePremultiplication, processChannels, mappedOriginalInputImage, true);
                     if (useMaskMix) {
-                        it->second.tmpImage->applyMaskMix(renderMappedRectToRender, maskImage.get(), mappedOriginalInputImage.get(), doMask, false, mix);
+                        it->second.tmpImage->copyUnProcessedChannelsAndApplyMaskMix(renderMappedRectToRender, planes.outputPremult, originalImagePremultiplication, processChannels, mappedOriginalInputImage, true, maskImage.get(), doMask, false, mix);
+                    } else {
+                        it->second.tmpImage->copyUnProcessedChannels(renderMappedRectToRender, planes.outputPremult, originalImagePremultiplication, processChannels, mappedOriginalInputImage, true);
                     }
                 }
                 if ( ( it->second.fullscaleImage->getComponents() != it->second.tmpImage->getComponents() ) ||
@@ -2901,9 +2920,10 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                     }
                 }
 
-                it->second.downscaleImage->copyUnProcessedChannels(actionArgs.roi, planes.outputPremult, originalImagePremultiplication, processChannels, originalInputImage, true, glContext);
                 if (useMaskMix) {
-                    it->second.downscaleImage->applyMaskMix(actionArgs.roi, maskImage.get(), originalInputImage.get(), doMask, false, mix, glContext);
+                    it->second.downscaleImage->copyUnProcessedChannelsAndApplyMaskMix(actionArgs.roi, planes.outputPremult, originalImagePremultiplication, processChannels, originalInputImage, true, maskImage.get(), doMask, false, mix, glContext);
+                } else {
+                    it->second.downscaleImage->copyUnProcessedChannels(actionArgs.roi, planes.outputPremult, originalImagePremultiplication, processChannels, originalInputImage, true, glContext);
                 }
             } // if (renderFullScaleThenDownscale) {
         } // if (it->second.isAllocatedOnTheFly) {
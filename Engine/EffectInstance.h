@@ -69,6 +69,7 @@
 #define PLUGINID_OFX_BLURCIMG     "net.sf.cimg.CImgBlur"
 #define PLUGINID_OFX_CORNERPIN    "net.sf.openfx.CornerPinPlugin"
 #define PLUGINID_OFX_CONSTANT     "net.sf.openfx.ConstantPlugin"
+#define PLUGINID_OFX_SOLID        "net.sf.openfx.Solid"
 #define PLUGINID_OFX_TIMEOFFSET   "net.sf.openfx.timeOffset"
 #define PLUGINID_OFX_FRAMEHOLD    "net.sf.openfx.FrameHold"
 #define PLUGINID_OFX_RETIME       "net.sf.openfx.Retime"
@@ -408,6 +409,15 @@ public:
         return false;
     }
 
+    /**
+     * @brief Returns true if all pixels of the images rendered by this effect have the same value (e.g: a solid colour).
+     * The rendered images are then marked constant without being scanned (@see Image::detectConstant).
+     **/
+    virtual bool isOutputConstant() const WARN_UNUSED_RETURN
+    {
+        return false;
+    }
+
     /**
      * @brief Is this node an OpenFX node?
      **/
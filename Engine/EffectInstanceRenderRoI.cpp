@@ -812,7 +812,8 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
     OSGLContextAttacherPtr glContextLocker;
 
     if ( dynamic_cast<DiskCacheNode*>(this) ) {
-        storage = eStorageModeDisk;
+        // DiskCache nodes persist their images in their own storage (see DiskCacheNode::render), only keep them in RAM here
+        storage = eStorageModeRAM;
     } else if ( glContext && ( (openGLSupport == ePluginOpenGLRenderSupportNeeded) ||
                              ( ( openGLSupport == ePluginOpenGLRenderSupportYes) && args.allowGPURendering) ) ) {
         // Enable GPU render if the plug-in cannot render another way or if all conditions are met
@@ -1334,6 +1335,12 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
                 it->rect.toCanonical(args.mipMapLevel, par, rod, &canonicalRoI);
             }
 
+            ///The inputs of a writer which is the root of a sequential render may have been rendered by the caller already
+            ///(see DefaultScheduler::writeAsyncFrame), in which case they are not rendered again
+            if ( isWriter() && frameArgs->isSequentialRender && (frameArgs->treeRoot == getNode()) ) {
+                it->imgs = args.inputImagesList;
+            }
+
             inputCode = renderInputImagesForRoI(requestPassData,
                                                 useTransforms,
                                                 storage,
@@ -1752,6 +1759,15 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
             }
         }
 
+        // Detect images that have a single value so that downstream operations only process that value
+        if ( hasSomethingToRender && (renderRetCode != eRenderRoIStatusRenderFailed) ) {
+            const ImagePtr& renderedImage = renderFullScaleThenDownscale ? it->second.fullscaleImage : it->second.downscaleImage;
+            // Images without a bitmap must have been entirely rendered by this call
+            if ( renderedImage && ( renderedImage->usesBitMap() || roi.contains( renderedImage->getBounds() ) ) ) {
+                renderedImage->detectConstant( isOutputConstant() );
+            }
+        }
+
         //We have to return the downscale image, so make sure it has been computed
         if ( (renderRetCode != eRenderRoIStatusRenderFailed) &&
              renderFullScaleThenDownscale &&
@@ -71,6 +71,7 @@ SOURCES += \
     AppInstance.cpp \
     AppManager.cpp \
     AppManagerPrivate.cpp \
+    AsyncWriteQueue.cpp \
     Backdrop.cpp \
     Bezier.cpp \
     BezierCP.cpp \
@@ -83,6 +84,7 @@ SOURCES += \
     CurveSerialization.cpp \
     DefaultShaders.cpp \
     DiskCacheNode.cpp \
+    DiskCacheNodeStorage.cpp \
     Dot.cpp \
     EffectInstance.cpp \
     EffectInstancePrivate.cpp \
@@ -117,6 +119,7 @@ SOURCES += \
     KnobFile.cpp \
     KnobSerialization.cpp \
     KnobTypes.cpp \
+    KnobsSnapshot.cpp \
     LibraryBinary.cpp \
     Log.cpp \
     Lut.cpp \
@@ -137,6 +140,7 @@ SOURCES += \
     Noise.cpp \
     NonKeyParams.cpp \
     NonKeyParamsSerialization.cpp \
+    NumaInfo.cpp \
     OSGLContext.cpp \
     OSGLContext_mac.cpp \
     OSGLContext_win.cpp \
@@ -168,8 +172,10 @@ SOURCES += \
     PySideCompat.cpp \
     PyTracker.cpp \
     ReadNode.cpp \
+    ReadNodePrefetcher.cpp \
     RectD.cpp \
     RectI.cpp \
+    RenderCoordinator.cpp \
     RenderStats.cpp \
     RotoContext.cpp \
     RotoDrawableItem.cpp \
@@ -177,6 +183,7 @@ SOURCES += \
     RotoLayer.cpp \
     RotoPaint.cpp \
     RotoPaintInteract.cpp \
+    RotoShapeRasterizer.cpp \
     RotoSmear.cpp \
     RotoStrokeItem.cpp \
     RotoUndoCommand.cpp \
@@ -263,6 +270,7 @@ HEADERS += \
     AppInstance.h \
     AppManager.h \
     AppManagerPrivate.h \
+    AsyncWriteQueue.h \
     Backdrop.h \
     Bezier.h \
     BezierCP.h \
@@ -284,6 +292,7 @@ HEADERS += \
     CurveSerialization.h \
     DefaultShaders.h \
     DiskCacheNode.h \
+    DiskCacheNodeStorage.h \
     DockablePanelI.h \
     Dot.h \
     EffectInstance.h \
@@ -327,6 +336,7 @@ HEADERS += \
     KnobImpl.h \
     KnobSerialization.h \
     KnobTypes.h \
+    KnobsSnapshot.h \
     LRUHashTable.h \
     LibraryBinary.h \
     Log.h \
@@ -349,6 +359,7 @@ HEADERS += \
     NoiseTables.h \
     NonKeyParams.h \
     NonKeyParamsSerialization.h \
+    NumaInfo.h \
     OSGLContext.h \
     OSGLContext_mac.h \
     OSGLContext_win.h \
@@ -384,10 +395,12 @@ HEADERS += \
     PyTracker.h \
     Pyside_Engine_Python.h \
     ReadNode.h \
+    ReadNodePrefetcher.h \
     RectD.h \
     RectDSerialization.h \
     RectI.h \
     RectISerialization.h \
+    RenderCoordinator.h \
     RenderStats.h \
     RotoContext.h \
     RotoContextPrivate.h \
@@ -401,6 +414,7 @@ HEADERS += \
     RotoPaint.h \
     RotoPaintInteract.h \
     RotoPoint.h \
+    RotoShapeRasterizer.h \
     RotoSmear.h \
     RotoStrokeItem.h \
     RotoStrokeItemSerialization.h \
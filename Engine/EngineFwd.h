@@ -124,6 +124,8 @@ class ActionsCache;
 class AfterQuitProcessingI;
 class AppInstance;
 class AppTLS;
+struct AsyncWriteFrame;
+class AsyncWriteQueue;
 class Bezier;
 class BezierCP;
 class BezierSerialization;
@@ -165,6 +167,7 @@ class Image;
 class ImageKey;
 class ImageParams;
 class ImagePlaneDesc;
+struct ImagePlaneDescIDCompare;
 class KeyFrame;
 class KnobBool;
 class KnobButton;
@@ -182,6 +185,7 @@ class KnobInt;
 class KnobLayers;
 class KnobOutputFile;
 class KnobPage;
+class KnobsSnapshot;
 class KnobParametric;
 class KnobPath;
 class KnobSeparator;
@@ -235,6 +239,7 @@ class RectD;
 class RectI;
 class RenderEngine;
 class RenderStats;
+struct RenderWorkerChunk;
 class RenderingFlagSetter;
 class RotoContext;
 class RotoDrawableItem;
@@ -262,6 +267,7 @@ class TrackSerialization;
 class TrackerContext;
 class TrackerContextSerialization;
 class TrackerFrameAccessor;
+class TrackerFrameAccessorCache;
 class TrackerNode;
 class TrackerNodeInteract;
 class UndoCommand;
@@ -326,6 +332,7 @@ typedef boost::shared_ptr<AbortableRenderInfo> AbortableRenderInfoPtr;
 typedef boost::shared_ptr<AbstractOfxEffectInstance> AbstractOfxEffectInstancePtr;
 typedef boost::shared_ptr<ActionsCache> ActionsCachePtr;
 typedef boost::shared_ptr<AppInstance> AppInstancePtr;
+typedef boost::shared_ptr<AsyncWriteFrame> AsyncWriteFramePtr;
 typedef boost::shared_ptr<Bezier> BezierPtr;
 typedef boost::shared_ptr<BezierCP> BezierCPPtr;
 typedef boost::shared_ptr<BezierSerialization> BezierSerializationPtr;
@@ -368,6 +375,7 @@ typedef boost::shared_ptr<KnobInt> KnobIntPtr;
 typedef boost::shared_ptr<KnobLayers> KnobLayersPtr;
 typedef boost::shared_ptr<KnobOutputFile> KnobOutputFilePtr;
 typedef boost::shared_ptr<KnobPage> KnobPagePtr;
+typedef boost::shared_ptr<KnobsSnapshot> KnobsSnapshotPtr;
 typedef boost::shared_ptr<KnobParametric> KnobParametricPtr;
 typedef boost::shared_ptr<KnobPath> KnobPathPtr;
 typedef boost::shared_ptr<KnobSeparator> KnobSeparatorPtr;
@@ -424,6 +432,7 @@ typedef boost::shared_ptr<TrackMarker> TrackMarkerPtr;
 typedef boost::shared_ptr<TrackMarkerAndOptions> TrackMarkerAndOptionsPtr;
 typedef boost::shared_ptr<TrackerContext> TrackerContextPtr;
 typedef boost::shared_ptr<TrackerFrameAccessor> TrackerFrameAccessorPtr;
+typedef boost::shared_ptr<TrackerFrameAccessorCache> TrackerFrameAccessorCachePtr;
 typedef boost::shared_ptr<TrackerNode> TrackerNodePtr;
 typedef boost::shared_ptr<TrackerNodeInteract> TrackerNodeInteractPtr;
 typedef boost::shared_ptr<UndoCommand> UndoCommandPtr;
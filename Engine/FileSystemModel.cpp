@@ -49,6 +49,7 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QDebug>
 #include <QtCore/QUrl>
 #include <QtCore/QMimeData>
+#include <QtCore/QHash>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
@@ -394,59 +395,95 @@ FileSystemItem::addChild(const FileSystemItemPtr& child)
 void
 FileSystemItem::addChild(const SequenceParsing::SequenceFromFilesPtr& sequence,
                          const QFileInfo& info)
+{
+    FileSequences sequences;
+
+    sequences.push_back( std::make_pair(sequence, info) );
+    addChildren(sequences);
+}
+
+void
+FileSystemItem::addChildren(const FileSequences& sequences)
 {
     FileSystemModelPtr model = _imp->getModel();
 
     if (!model) {
         return;
     }
-    QMutexLocker l(&_imp->childrenMutex);
-    ///Does the child exist already ?
-    QString filename;
-    QString userFriendlyFilename;
-    if (!sequence) {
-        filename = info.fileName();
-        userFriendlyFilename = filename;
-    } else {
-        std::string pattern = sequence->generateValidSequencePattern();
-        SequenceParsing::removePath(pattern);
-        filename = QString::fromUtf8( pattern.c_str() );
-        if ( !sequence->isSingleFile() ) {
-            pattern = sequence->generateUserFriendlySequencePatternFromValidPattern(pattern);
+
+    ///Create the children outside of the children mutex, mapping each filename to its index so that duplicates
+    ///are found in constant time
+    std::vector<FileSystemItemPtr> newChildren;
+    newChildren.reserve( sequences.size() );
+    QHash<QString, std::size_t> newChildrenIndexes;
+    newChildrenIndexes.reserve( (int)sequences.size() );
+
+    FileSystemItemPtr thisShared = shared_from_this();
+    for (FileSequences::const_iterator it = sequences.begin(); it != sequences.end(); ++it) {
+        const SequenceParsing::SequenceFromFilesPtr& sequence = it->first;
+        const QFileInfo& info = it->second;
+        QString filename;
+        QString userFriendlyFilename;
+        if (!sequence) {
+            filename = info.fileName();
+            userFriendlyFilename = filename;
+        } else {
+            std::string pattern = sequence->generateValidSequencePattern();
+            SequenceParsing::removePath(pattern);
+            filename = QString::fromUtf8( pattern.c_str() );
+            if ( !sequence->isSingleFile() ) {
+                pattern = sequence->generateUserFriendlySequencePatternFromValidPattern(pattern);
+            }
+            userFriendlyFilename = QString::fromUtf8( pattern.c_str() );
         }
-        userFriendlyFilename = QString::fromUtf8( pattern.c_str() );
-    }
 
+        bool isDir = sequence ? false : info.isDir();
+        qint64 size;
+        if (sequence) {
+            size = sequence->getEstimatedTotalSize();
+        } else {
+            size = isDir ? 0 : info.size();
+        }
 
-    for (std::vector<FileSystemItemPtr>::iterator it = _imp->children.begin(); it != _imp->children.end(); ++it) {
-        if ( (*it)->fileName() == filename ) {
-            _imp->children.erase(it);
-            break;
+        ///Create the child
+        FileSystemItemPtr child = boost::make_shared<FileSystemItem::MakeSharedEnabler>( model,
+                                                                                         isDir,
+                                                                                         filename,
+                                                                                         userFriendlyFilename,
+                                                                                         sequence,
+                                                                                         info.lastModified(),
+                                                                                         size,
+                                                                                         thisShared );
+        model->_imp->registerItem(child);
+
+        ///A later entry with the same filename replaces the previous one
+        QHash<QString, std::size_t>::iterator found = newChildrenIndexes.find(filename);
+        if ( found != newChildrenIndexes.end() ) {
+            newChildren[found.value()].reset();
+            found.value() = newChildren.size();
+        } else {
+            newChildrenIndexes.insert( filename, newChildren.size() );
         }
+        newChildren.push_back(child);
     }
 
+    QMutexLocker l(&_imp->childrenMutex);
 
-    bool isDir = sequence ? false : info.isDir();
-    qint64 size;
-    if (sequence) {
-        size = sequence->getEstimatedTotalSize();
-    } else {
-        size = isDir ? 0 : info.size();
+    ///Existing children with the same filename are replaced, the new children are appended after the remaining ones
+    std::vector<FileSystemItemPtr> children;
+    children.reserve( _imp->children.size() + newChildren.size() );
+    for (std::vector<FileSystemItemPtr>::iterator it = _imp->children.begin(); it != _imp->children.end(); ++it) {
+        if ( !newChildrenIndexes.contains( (*it)->fileName() ) ) {
+            children.push_back(*it);
+        }
     }
-
-
-    ///Create the child
-    FileSystemItemPtr child = boost::make_shared<FileSystemItem::MakeSharedEnabler>( model,
-                                                                                                    isDir,
-                                                                                                    filename,
-                                                                                                    userFriendlyFilename,
-                                                                                                    sequence,
-                                                                                                    info.lastModified(),
-                                                                                                    size,
-                                                                                                    shared_from_this() );
-    model->_imp->registerItem(child);
-    _imp->children.push_back(child);
-} // FileSystemItem::addChild
+    for (std::vector<FileSystemItemPtr>::iterator it = newChildren.begin(); it != newChildren.end(); ++it) {
+        if (*it) {
+            children.push_back(*it);
+        }
+    }
+    _imp->children.swap(children);
+} // FileSystemItem::addChildren
 
 void
 FileSystemItem::clearChildren()
@@ -1285,6 +1322,10 @@ FileSystemModel::onDirectoryLoadedByGatherer(const QString& directory)
 void
 FileSystemModel::onWatchedDirectoryChanged(const QString& directory)
 {
+    if (_imp->gatherer) {
+        _imp->gatherer->invalidateCachedListing(directory);
+    }
+
     FileSystemItemPtr item = _imp->getItemFromPath(directory);
 
     if (item) {
@@ -1321,6 +1362,11 @@ FileSystemModel::onWatchedFileChanged(const QString& file)
 {
     ///Get the item corresponding to the current directory
     QFileInfo info(file);
+
+    if (_imp->gatherer) {
+        _imp->gatherer->invalidateCachedListing( info.absolutePath() );
+    }
+
     FileSystemItemPtr parent = _imp->getItemFromPath( info.absolutePath() );
 
     if (parent) {
@@ -1364,6 +1410,25 @@ FileSystemModel::getItem(const QModelIndex &index) const
 
 ///////////////////////// FileGathererThread
 
+///The entries of a directory as returned by QDir::entryInfoList, with the parameters they were listed with
+struct DirectoryListing
+{
+    QDateTime lastModified;
+    QDir::Filters filters;
+    QDir::SortFlags sort;
+    QFileInfoList entries;
+
+    DirectoryListing()
+        : lastModified()
+        , filters()
+        , sort()
+        , entries()
+    {
+    }
+};
+
+typedef std::map<QString, DirectoryListing> DirectoryListingsMap;
+
 struct FileGathererThreadPrivate
 {
     FileSystemModelWPtr model;
@@ -1381,6 +1446,12 @@ struct FileGathererThreadPrivate
     FileSystemItemPtr requestedItem, itemBeingFetched;
     QMutex requestedDirMutex;
 
+    ///Listings of the directories visited recently, the most recently used is at the back of listingsUsage
+    DirectoryListingsMap listings;
+    std::list<QString> listingsUsage;
+    int listingsEntriesCount;
+    QMutex listingsMutex;
+
     FileGathererThreadPrivate(const FileSystemModelPtr& model)
         : model(model)
         , mustQuit(false)
@@ -1397,9 +1468,26 @@ struct FileGathererThreadPrivate
         , requestedItem()
         , itemBeingFetched()
         , requestedDirMutex()
+        , listings()
+        , listingsUsage()
+        , listingsEntriesCount(0)
+        , listingsMutex()
     {
     }
 
+    void removeListing(const QString& directory)
+    {
+        // listingsMutex must be locked
+        DirectoryListingsMap::iterator found = listings.find(directory);
+
+        if ( found == listings.end() ) {
+            return;
+        }
+        listingsEntriesCount -= found->second.entries.size();
+        listings.erase(found);
+        listingsUsage.remove(directory);
+    }
+
     bool checkForExit()
     {
         QMutexLocker l(&mustQuitMutex);
@@ -1574,7 +1662,28 @@ isVideoFileExtension(const std::string& ext)
     return false;
 }
 
-typedef std::list<std::pair<SequenceParsing::SequenceFromFilesPtr, QFileInfo > > FileSequences;
+QString
+FileSystemModel::getSequenceBucketKey(const QString& filename)
+{
+    QString key;
+
+    key.reserve( filename.size() );
+    bool previousIsDigit = false;
+    for (int i = 0; i < filename.size(); ++i) {
+        const QChar c = filename.at(i);
+        if ( c.isDigit() ) {
+            if (!previousIsDigit) {
+                key.append( QLatin1Char('#') );
+            }
+            previousIsDigit = true;
+        } else {
+            key.append(c);
+            previousIsDigit = false;
+        }
+    }
+
+    return key;
+}
 
 #define KERNEL_INCR() \
     switch (viewOrder) \
@@ -1622,10 +1731,16 @@ FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
     sort |= QDir::DirsFirst;
 
     ///All entries in the directory
-    QFileInfoList all = dir.entryInfoList(model->filter(), sort);
+    bool isCachedListing = false;
+    QFileInfoList all = getDirectoryEntries(dir, model->filter(), sort, &isCachedListing);
 
     ///List of all possible file sequences in the directory or directories
     FileSequences sequences;
+
+    ///The sequences indexed by their files name without digits: the files of a sequence only differ by their frame number,
+    ///so a file only needs to be tried against the sequences of its bucket instead of all the sequences of the directory
+    QHash<QString, std::vector<SequenceParsing::SequenceFromFilesPtr> > sequencesBuckets;
+    const bool sequenceModeEnabled = model->isSequenceModeEnabled();
     int start = 0;
     int end = 0;
     switch (viewOrder) {
@@ -1658,7 +1773,7 @@ FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
             }
 
             /// If file sequence fetching is disabled, accept it
-            if ( !model->isSequenceModeEnabled() ) {
+            if (!sequenceModeEnabled) {
                 sequences.push_back( std::make_pair(SequenceParsing::SequenceFromFilesPtr(), all[i]) );
                 KERNEL_INCR();
                 continue;
@@ -1670,11 +1785,13 @@ FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
             /// If we reach here, this is a valid file and we need to determine if it belongs to another sequence or we need
             /// to create a new one
             SequenceParsing::FileNameContent fileContent(absoluteFilePath);
+            std::vector<SequenceParsing::SequenceFromFilesPtr>* bucket = 0;
 
             if ( !isVideoFileExtension( fileContent.getExtension() ) ) {
+                bucket = &sequencesBuckets[FileSystemModel::getSequenceBucketKey(filename)];
                 ///Note that we use a reverse iterator because we have more chance to find a match in the last recently added entries
-                for (FileSequences::reverse_iterator it = sequences.rbegin(); it != sequences.rend(); ++it) {
-                    if ( it->first && it->first->tryInsertFile(fileContent, false) ) {
+                for (std::vector<SequenceParsing::SequenceFromFilesPtr>::reverse_iterator it = bucket->rbegin(); it != bucket->rend(); ++it) {
+                    if ( (*it)->tryInsertFile(fileContent, false) ) {
                         foundMatchingSequence = true;
                         break;
                     }
@@ -1684,19 +1801,95 @@ FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
             if (!foundMatchingSequence) {
                 SequenceParsing::SequenceFromFilesPtr newSequence = boost::make_shared<SequenceParsing::SequenceFromFiles>(fileContent, true);
                 sequences.push_back( std::make_pair(newSequence, all[i]) );
+                if (bucket) {
+                    bucket->push_back(newSequence);
+                }
             }
         }
         KERNEL_INCR();
     }
 
-    ///Now iterate through the sequences and create the children as necessary
-    for (FileSequences::iterator it = sequences.begin(); it != sequences.end(); ++it) {
-        item->addChild(it->first, it->second);
+    if ( _imp->checkForAbort() ) {
+        return;
+    }
+
+    ///A file overwritten in place does not change the modification date of its directory: the size and date of the
+    ///entries of a cached listing are read again, only for the children (sequences read the size of their files themselves)
+    if (isCachedListing) {
+        for (FileSequences::iterator it = sequences.begin(); it != sequences.end(); ++it) {
+            it->second.refresh();
+        }
     }
 
+    ///Now create the children
+    item->addChildren(sequences);
+
     Q_EMIT directoryLoaded( item->absoluteFilePath() );
 } // FileGathererThread::gatheringKernel
 
+QFileInfoList
+FileGathererThread::getDirectoryEntries(const QDir& dir,
+                                        QDir::Filters filters,
+                                        QDir::SortFlags sort,
+                                        bool* isCached)
+{
+    *isCached = false;
+
+    const QString path = dir.absolutePath();
+    const QDateTime scanStart = QDateTime::currentDateTime();
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+
+    {
+        QMutexLocker k(&_imp->listingsMutex);
+        DirectoryListingsMap::iterator found = _imp->listings.find(path);
+        if ( found != _imp->listings.end() ) {
+            const DirectoryListing& listing = found->second;
+            if ( (listing.lastModified == lastModified) && (listing.filters == filters) && (listing.sort == sort) ) {
+                _imp->listingsUsage.remove(path);
+                _imp->listingsUsage.push_back(path);
+                *isCached = true;
+
+                return listing.entries;
+            }
+            _imp->removeListing(path);
+        }
+    }
+
+    QFileInfoList entries = dir.entryInfoList(filters, sort);
+
+    ///The modification date has a resolution of a second (or more on some file systems): a directory modified
+    ///during the last seconds may still change without its modification date changing, so it is not cached
+    if ( !lastModified.isValid() || (lastModified.secsTo(scanStart) < 2) ) {
+        return entries;
+    }
+
+    QMutexLocker k(&_imp->listingsMutex);
+    _imp->removeListing(path);
+    DirectoryListing& listing = _imp->listings[path];
+    listing.lastModified = lastModified;
+    listing.filters = filters;
+    listing.sort = sort;
+    listing.entries = entries;
+    _imp->listingsUsage.push_back(path);
+    _imp->listingsEntriesCount += entries.size();
+
+    ///Evict the least recently used listings, but always keep the one we just added
+    while ( (_imp->listingsEntriesCount > NATRON_FILE_DIALOG_LISTINGS_CACHE_MAX_ENTRIES) && (_imp->listingsUsage.size() > 1) ) {
+        QString oldest = _imp->listingsUsage.front();
+        _imp->removeListing(oldest);
+    }
+
+    return entries;
+} // FileGathererThread::getDirectoryEntries
+
+void
+FileGathererThread::invalidateCachedListing(const QString& directory)
+{
+    QMutexLocker k(&_imp->listingsMutex);
+
+    _imp->removeListing( QDir(directory).absolutePath() );
+}
+
 void
 FileGathererThread::fetchDirectory(const FileSystemItemPtr& item)
 {
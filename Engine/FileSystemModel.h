@@ -29,6 +29,8 @@
 #include "Global/Macros.h"
 
 #include <map>
+#include <list>
+#include <utility>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -47,6 +49,9 @@
 
 NATRON_NAMESPACE_ENTER
 
+///The entries of a directory, a null sequence means the entry is a directory or a single file
+typedef std::list<std::pair<SequenceParsing::SequenceFromFilesPtr, QFileInfo > > FileSequences;
+
 class FileSystemModel;
 struct FileSystemItemPrivate;
 class FileSystemItem
@@ -122,6 +127,13 @@ public:
     void addChild(const SequenceParsing::SequenceFromFilesPtr& sequence,
                   const QFileInfo& info);
 
+    /**
+     * @brief Same as addChild() for all the given entries at once. Children that already exist
+     * with the same filename are replaced. This is linear in the number of children, whereas
+     * calling addChild() for each entry is quadratic.
+     **/
+    void addChildren(const FileSequences& sequences);
+
     /**
      * @brief Remove all children, MT-safe
      **/
@@ -162,6 +174,13 @@ public:
     void fetchDirectory(const FileSystemItemPtr& item);
 
     bool isWorking() const;
+
+    /**
+     * @brief Forget the cached listing of the given directory, so that the next fetch
+     * reads it again from the disk. MT-safe
+     **/
+    void invalidateCachedListing(const QString& directory);
+
 Q_SIGNALS:
 
     void directoryLoaded(QString);
@@ -172,6 +191,8 @@ private:
 
     void gatheringKernel(const FileSystemItemPtr& item);
 
+    QFileInfoList getDirectoryEntries(const QDir& dir, QDir::Filters filters, QDir::SortFlags sort, bool* isCached);
+
     boost::scoped_ptr<FileGathererThreadPrivate> _imp;
 };
 
@@ -244,6 +265,13 @@ public:
 
     static bool isDriveName(const QString& name);
     static bool startsWithDriveName(const QString& name);
+
+    /**
+     * @brief Returns the filename with each run of digits replaced by a single '#'. Two files may only belong
+     * to the same sequence if they have the same key, so files can be grouped in sequences by only trying
+     * the sequences with the same key.
+     **/
+    static QString getSequenceBucketKey(const QString& filename);
     virtual QVariant headerData(int section, Qt::Orientation orientation, int role) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual Qt::ItemFlags flags(const QModelIndex &index) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual int columnCount(const QModelIndex & parent) const OVERRIDE FINAL WARN_UNUSED_RETURN;
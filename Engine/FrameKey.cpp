@@ -105,11 +105,7 @@ FrameKey::fillHash(Hash64* hash) const
     hash->append(_textureRect.y2);
     hash->append(_textureRect.closestPo2);
     hash->append(_mipMapLevel);
-    Hash64_appendQString( hash, QString::fromUtf8( _layer.getPlaneID().c_str() ) );
-    const std::vector<std::string>& channels = _layer.getChannels();
-    for (std::size_t i = 0; i < channels.size(); ++i) {
-        Hash64_appendQString( hash, QString::fromUtf8( channels[i].c_str() ) );
-    }
+    _layer.appendToHash(hash);
     if ( !_alphaChannelFullName.empty() ) {
         Hash64_appendQString( hash, QString::fromUtf8( _alphaChannelFullName.c_str() ) );
     }
@@ -31,6 +31,12 @@
 
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#endif
 
 #ifdef DEBUG
 #include "Global/FloatingPointExceptions.h"
@@ -38,6 +44,12 @@
 #include "Engine/Image.h"
 #include "Engine/Smooth1D.h"
 
+// Above this number of pixels, the histogram is computed on a subsampled image
+#define NATRON_HISTOGRAM_MAX_PIXELS (1024 * 1024)
+
+// Number of rows of the image processed by each concurrent task
+#define NATRON_HISTOGRAM_ROWS_PER_TASK 64
+
 NATRON_NAMESPACE_ENTER
 
 struct HistogramRequest
@@ -267,31 +279,98 @@ struct pix_lum
 };
 
 
+/*
+ * @brief Returns the step between the pixels sampled in both directions, so that at most NATRON_HISTOGRAM_MAX_PIXELS
+ * are sampled. This is equivalent to computing the histogram on a lower mipmap level of the image.
+ */
+static int
+getHistogramSamplingStep(const RectI& rect)
+{
+    int step = 1;
+
+    while ( (double)rect.area() / ( (double)step * step ) > NATRON_HISTOGRAM_MAX_PIXELS ) {
+        ++step;
+    }
+
+    return step;
+}
+
+static int
+getHistogramSamplesCount(const RectI& rect,
+                         int step)
+{
+    int nx = (rect.width() + step - 1) / step;
+    int ny = (rect.height() + step - 1) / step;
+
+    return nx * ny;
+}
+
+/*
+ * @brief Computes the bins of the sampled pixels in the rows [y1, y1 + NATRON_HISTOGRAM_ROWS_PER_TASK * step) of the request.
+ * Each task fills its own bins, they are summed once all tasks are done.
+ */
+template <float pix_func(const float*)>
+std::vector<float>
+computeHistoRows(const HistogramRequest & request,
+                 int binsCount,
+                 int step,
+                 int y1)
+{
+    std::vector<float> histo(binsCount, 0.f);
+    double binSize = (request.vmax - request.vmin) / binsCount;
+    int nComps = request.image->getComponentsCount();
+    int y2 = std::min(request.rect.top(), y1 + NATRON_HISTOGRAM_ROWS_PER_TASK * step);
+    int xStride = nComps * step;
+    int width = request.rect.width();
+
+    Image::ReadAccess acc = request.image->getReadRights();
+
+    for (int y = y1; y < y2; y += step) {
+        const float *pix = (const float*)acc.pixelAt(request.rect.left(), y);
+        for (int x = 0; x < width; x += step, pix += xStride) {
+            float v = pix_func(pix);
+            if ( (request.vmin <= v) && (v < request.vmax) ) {
+                int index = (int)( (v - request.vmin) / binSize );
+                assert( 0 <= index && index < binsCount );
+                histo[index] += 1.f;
+            }
+        }
+    }
+
+    return histo;
+}
+
 template <float pix_func(const float*)>
 void
 computeHisto(const HistogramRequest & request,
              int upscale,
+             int step,
              std::vector<float> *histo)
 {
     assert(histo);
     histo->resize(request.binsCount * upscale);
     std::fill(histo->begin(), histo->end(), 0.f);
-    double binSize = (request.vmax - request.vmin) / histo->size();
 
     ///Images come from the viewer which is in float.
     assert(request.image->getBitDepth() == eImageBitDepthFloat);
 
-    Image::ReadAccess acc = request.image->getReadRights();
+    std::vector<int> rows;
+    for (int y = request.rect.bottom(); y < request.rect.top(); y += NATRON_HISTOGRAM_ROWS_PER_TASK * step) {
+        rows.push_back(y);
+    }
 
-    for (int y = request.rect.bottom(); y < request.rect.top(); ++y) {
-        for (int x = request.rect.left(); x < request.rect.right(); ++x) {
-            const float *pix = (const float*)acc.pixelAt(x, y);
-            float v = pix_func(pix);
-            if ( (request.vmin <= v) && (v < request.vmax) ) {
-                int index = (int)( (v - request.vmin) / binSize );
-                assert( 0 <= index && index < (int)histo->size() );
-                (*histo)[index] += 1.f;
-            }
+    QFuture<std::vector<float> > future = QtConcurrent::mapped( rows, boost::bind(&computeHistoRows<pix_func>,
+                                                                                  boost::cref(request),
+                                                                                  (int)histo->size(),
+                                                                                  step,
+                                                                                  _1) );
+    future.waitForFinished();
+
+    for (QFuture<std::vector<float> >::const_iterator it = future.begin(); it != future.end(); ++it) {
+        const std::vector<float>& partial = *it;
+        assert( partial.size() == histo->size() );
+        for (std::size_t i = 0; i < partial.size(); ++i) {
+            (*histo)[i] += partial[i];
         }
     }
 }
@@ -333,24 +412,25 @@ computeHistogramStatic(const HistogramRequest & request,
         mode = histogramIndex + 2;
     }
 
-    ret->pixelsCount = request.rect.area();
+    int step = getHistogramSamplingStep(request.rect);
+    ret->pixelsCount = getHistogramSamplesCount(request.rect, step);
     // a histogram with upscale more bins
     std::vector<float> histo_upscaled;
     switch (mode) {
     case 1:     //< A
-        computeHisto<&pix_alpha::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_alpha::val>(request, upscale, step, &histo_upscaled);
         break;
     case 2:     //<Y
-        computeHisto<&pix_lum::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_lum::val>(request, upscale, step, &histo_upscaled);
         break;
     case 3:     //< R
-        computeHisto<&pix_red::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_red::val>(request, upscale, step, &histo_upscaled);
         break;
     case 4:     //< G
-        computeHisto<&pix_green::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_green::val>(request, upscale, step, &histo_upscaled);
         break;
     case 5:     //< B
-        computeHisto<&pix_blue::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_blue::val>(request, upscale, step, &histo_upscaled);
         break;
 
     default:
@@ -686,6 +686,8 @@ Image::Image(const ImageKey & key,
              const CacheAPI* cache)
     : CacheEntryHelper<unsigned char, ImageKey, ImageParams>(key, params, cache)
     , _useBitmap(true)
+    , _isConstant()
+    , _constantPixelMutex()
 {
     _bitDepth = params->getBitDepth();
     _depthBytesSize = getSizeOfForBitDepth(_bitDepth);
@@ -701,6 +703,8 @@ Image::Image(const ImageKey & key,
              const ImageParamsPtr& params)
     : CacheEntryHelper<unsigned char, ImageKey, ImageParams>( key, params, NULL )
     , _useBitmap(false)
+    , _isConstant()
+    , _constantPixelMutex()
 {
     _bitDepth = params->getBitDepth();
     _depthBytesSize = getSizeOfForBitDepth(_bitDepth);
@@ -730,6 +734,8 @@ Image::Image(const ImagePlaneDesc& components,
              U32 textureTarget)
     : CacheEntryHelper<unsigned char, ImageKey, ImageParams>()
     , _useBitmap(useBitmap)
+    , _isConstant()
+    , _constantPixelMutex()
 {
     setCacheEntry(makeKey(0, 0, false, 0, ViewIdx(0), false, false),
 #ifdef BOOST_NO_CXX11_VARIADIC_TEMPLATES
@@ -786,6 +792,8 @@ Image::onMemoryAllocated(bool diskRestoration)
 
     if (diskRestoration) {
         _bitmap.setTo1();
+    } else {
+        invalidateConstant();
     }
 
 #ifdef DEBUG
@@ -952,6 +960,19 @@ Image::pasteFromForDepth(const Image & srcImg,
     }
     // now we're safe: both images contain the area in roi
 
+    unsigned char constantPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
+    if ( srcImg.getConstantPixel(constantPixel) ) {
+        // Do not read the source, replicate its value
+        if ( !hasConstantPixel(constantPixel) ) {
+            fillWithPixelInternal(roi, constantPixel);
+            if (roi == bounds) {
+                setConstantPixel(constantPixel);
+            }
+        }
+
+        return;
+    }
+
     int srcRowElements = _nbComponents * srcBounds.width();
     int dstRowElements = _nbComponents * bounds.width();
     const PIX* src = (const PIX*)srcImg.pixelAt(roi.x1, roi.y1);
@@ -1169,6 +1190,7 @@ Image::ensureBounds(const RectI& newBounds,
     if ( usesBitMap() ) {
         _bitmap.swap(tmpImg->_bitmap);
     }
+    invalidateConstant();
 
     return true;
 }
@@ -1420,20 +1442,23 @@ Image::fillForDepthForComponents(const RectI & roi_,
         return;
     }
 
-    int rowElems = (int)getComponentsCount() * _bounds.width();
     const float fillValue[4] = {
         nComps == 1 ? a * maxValue : r * maxValue, g * maxValue, b * maxValue, a * maxValue
     };
+    PIX fillPixel[4];
+    for (int k = 0; k < 4; ++k) {
+        fillPixel[k] = fillValue[k];
+    }
 
+    if ( hasConstantPixel( (const unsigned char*)fillPixel ) ) {
+        // Already filled with this colour
+        return;
+    }
 
     // now we're safe: the image contains the area in roi
-    PIX* dst = (PIX*)pixelAt(roi.x1, roi.y1);
-    for ( int i = 0; i < roi.height(); ++i, dst += (rowElems - roi.width() * nComps) ) {
-        for (int j = 0; j < roi.width(); ++j, dst += nComps) {
-            for (int k = 0; k < nComps; ++k) {
-                dst[k] = fillValue[k];
-            }
-        }
+    fillWithPixelInternal(roi, (const unsigned char*)fillPixel);
+    if (roi == _bounds) {
+        setConstantPixel( (const unsigned char*)fillPixel );
     }
 }
 
@@ -1575,6 +1600,11 @@ Image::fillZero(const RectI& roi,
         return;
     }
 
+    const unsigned char zeroPixel[NATRON_IMAGE_MAX_PIXEL_SIZE] = { 0 };
+    if ( hasConstantPixel(zeroPixel) ) {
+        return;
+    }
+
     std::size_t roiMemSize = rowSize * intersection.width();
     rowSize *= _bounds.width();
 
@@ -1583,6 +1613,9 @@ Image::fillZero(const RectI& roi,
     for (int y = intersection.y1; y < intersection.y2; ++y, dstPixels += rowSize) {
         std::memset(dstPixels, 0, roiMemSize);
     }
+    if (intersection == _bounds) {
+        setConstantPixel(zeroPixel);
+    }
 }
 
 void
@@ -1615,11 +1648,159 @@ Image::fillBoundsZero(const OSGLContextPtr& glContext)
         return;
     }
 
+    const unsigned char zeroPixel[NATRON_IMAGE_MAX_PIXEL_SIZE] = { 0 };
+    if ( hasConstantPixel(zeroPixel) ) {
+        return;
+    }
+
     std::size_t roiMemSize = rowSize * _bounds.width() * _bounds.height();
     char* dstPixels = (char*)pixelAt(_bounds.x1, _bounds.y1);
     std::memset(dstPixels, 0, roiMemSize);
+    setConstantPixel(zeroPixel);
 }
 
+void
+Image::fillWithPixelInternal(const RectI & roi,
+                             const unsigned char* pixel)
+{
+    assert( _bounds.contains(roi) );
+    if ( roi.isNull() ) {
+        return;
+    }
+    std::size_t pixelSize = getPixelSize();
+    std::size_t roiRowSize = pixelSize * roi.width();
+    std::size_t rowSize = pixelSize * _bounds.width();
+    unsigned char* firstRow = pixelAt(roi.x1, roi.y1);
+    assert(firstRow);
+
+    // Fill the first row by doubling the portion already written, then copy it to the other rows
+    std::memcpy(firstRow, pixel, pixelSize);
+    std::size_t filled = pixelSize;
+    while (filled < roiRowSize) {
+        std::size_t toCopy = std::min(filled, roiRowSize - filled);
+        std::memcpy(firstRow + filled, firstRow, toCopy);
+        filled += toCopy;
+    }
+    unsigned char* dst = firstRow + rowSize;
+    for (int y = roi.y1 + 1; y < roi.y2; ++y, dst += rowSize) {
+        std::memcpy(dst, firstRow, roiRowSize);
+    }
+}
+
+void
+Image::fillWithPixel(const RectI & roi,
+                     const unsigned char* pixel,
+                     bool markForRendered)
+{
+    QWriteLocker k(&_entryLock);
+    RectI intersection;
+
+    if ( !roi.intersect(_bounds, &intersection) ) {
+        return;
+    }
+    if ( !hasConstantPixel(pixel) ) {
+        fillWithPixelInternal(intersection, pixel);
+        if (intersection == _bounds) {
+            setConstantPixel(pixel);
+        }
+    }
+    if (markForRendered && _useBitmap) {
+        _bitmap.markForRendered(intersection);
+    }
+}
+
+bool
+Image::isConstant() const
+{
+    return (int)_isConstant != 0;
+}
+
+bool
+Image::getConstantPixel(unsigned char* pixel) const
+{
+    if ( !(int)_isConstant ) {
+        return false;
+    }
+    QMutexLocker k(&_constantPixelMutex);
+    if ( !(int)_isConstant ) {
+        return false;
+    }
+    std::memcpy( pixel, _constantPixel, getPixelSize() );
+
+    return true;
+}
+
+bool
+Image::hasConstantPixel(const unsigned char* pixel) const
+{
+    if ( !(int)_isConstant ) {
+        return false;
+    }
+    QMutexLocker k(&_constantPixelMutex);
+
+    return (int)_isConstant && std::memcmp( pixel, _constantPixel, getPixelSize() ) == 0;
+}
+
+void
+Image::setConstantPixel(const unsigned char* pixel)
+{
+    if (getStorageMode() == eStorageModeGLTex) {
+        return;
+    }
+    QMutexLocker k(&_constantPixelMutex);
+    std::memcpy( _constantPixel, pixel, getPixelSize() );
+    _isConstant.fetchAndStoreRelease(1);
+}
+
+bool
+Image::detectConstant(bool assumeConstant)
+{
+    if (getStorageMode() == eStorageModeGLTex) {
+        return false;
+    }
+    if ( isConstant() ) {
+        return true;
+    }
+
+    QReadLocker k(&_entryLock);
+    if ( _bounds.isNull() || (_nbComponents == 0) ) {
+        return false;
+    }
+    if ( _useBitmap && !_bitmap.minimalNonMarkedBbox(_bounds).isNull() ) {
+        // Some pixels are not rendered yet
+        return false;
+    }
+
+    // Do not use the non-const pixelAt: it would invalidate the constant state
+    const Image& constThis = *this;
+    const unsigned char* firstPixel = constThis.pixelAt(_bounds.x1, _bounds.y1);
+    if (!firstPixel) {
+        return false;
+    }
+
+    if (!assumeConstant) {
+        std::size_t pixelSize = getPixelSize();
+        std::size_t rowSize = pixelSize * _bounds.width();
+
+        // Compare the first row with the first pixel, then all rows with the first row
+        for (const unsigned char* pix = firstPixel + pixelSize; pix < firstPixel + rowSize; pix += pixelSize) {
+            if (std::memcmp(pix, firstPixel, pixelSize) != 0) {
+                return false;
+            }
+        }
+        const unsigned char* row = firstPixel + rowSize;
+        for (int y = _bounds.y1 + 1; y < _bounds.y2; ++y, row += rowSize) {
+            if (std::memcmp(row, firstPixel, rowSize) != 0) {
+                return false;
+            }
+        }
+    }
+
+    setConstantPixel(firstPixel);
+
+    return true;
+} // detectConstant
+
 unsigned char*
 Image::pixelAt(int x,
                int y)
@@ -1631,6 +1812,8 @@ Image::pixelAt(int x,
         if (!ret) {
             return 0;
         }
+        // The caller may write to the pixels
+        invalidateConstant();
         int compDataSize = _depthBytesSize * _nbComponents;
         ret = ret + (qint64)( y - _bounds.y1 ) * compDataSize * _bounds.width()
               + (qint64)( x - _bounds.x1 ) * compDataSize;
@@ -2091,6 +2274,15 @@ Image::downscaleMipMap(const RectD& dstRod,
     assert( !copyBitMap || _bitmap.getBitmap() );
 
     RectI dstRoI  = roi.downscalePowerOfTwoSmallestEnclosing(downscaleLvls);
+
+    unsigned char constantPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
+    if ( getConstantPixel(constantPixel) && ( !copyBitMap || getMinimalRect(roi).isNull() ) ) {
+        // All mipmap levels of a constant image have the same value: do not build the intermediate levels
+        output->fillWithPixel(dstRoI, constantPixel, copyBitMap);
+
+        return;
+    }
+
     ImagePtr tmpImg = boost::make_shared<Image>( getComponents(), dstRod, dstRoI, toLevel, par, getBitDepth(), getPremultiplication(), getFieldingOrder(), true);
 
     buildMipMapLevel( dstRod, roi, downscaleLvls, copyBitMap, tmpImg.get() );
@@ -2169,6 +2361,13 @@ Image::upscaleMipMapForDepth(const RectI & roi,
         return;
     }
 
+    unsigned char constantPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
+    if ( getConstantPixel(constantPixel) ) {
+        output->fillWithPixel(dstRoi, constantPixel, false);
+
+        return;
+    }
+
     QWriteLocker k1(&output->_entryLock);
     QReadLocker k2(&_entryLock);
     int srcRowSize = _bounds.width() * _nbComponents;
@@ -39,6 +39,8 @@ CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QHash>
 CLANG_DIAG_ON(deprecated)
 #include <QtCore/QReadWriteLock>
+#include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
 
 #include "Engine/ImageKey.h"
 #include "Engine/ImagePlaneDesc.h"
@@ -49,6 +51,8 @@ CLANG_DIAG_ON(deprecated)
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
 
+// Size in bytes of the largest pixel an Image can hold (4 float components)
+#define NATRON_IMAGE_MAX_PIXEL_SIZE (4 * sizeof(float))
 
 NATRON_NAMESPACE_ENTER
 
@@ -732,6 +736,32 @@ public:
 
     void fillBoundsZero( const OSGLContextPtr& glContext = OSGLContextPtr() );
 
+    /**
+     * @brief Returns true if all pixels of the image are known to have the same value.
+     * An image becomes constant when it is entirely filled with a single colour (@see fill),
+     * pasted from a constant image or when detectConstant() finds it constant.
+     * Any write access to the pixels (through the non-const pixelAt) clears this state.
+     * Host operations (pasteFrom, convertToFormat, applyMaskMix, mipmapping) on a constant
+     * image only process its single pixel value.
+     * OpenGL textures are never constant.
+     **/
+    bool isConstant() const;
+
+    /**
+     * @brief If the image is constant, copies its pixel value (getComponentsCount() components
+     * of the image bit depth) to pixel, which must hold NATRON_IMAGE_MAX_PIXEL_SIZE bytes, and returns true.
+     **/
+    bool getConstantPixel(unsigned char* pixel) const;
+
+    /**
+     * @brief Checks whether all pixels of the image have the same value and marks it constant if so.
+     * The image must be entirely rendered: if it uses a bitmap, this returns false if some pixels are not marked rendered.
+     * If assumeConstant is true, the image is known to be constant (e.g: the output of an effect that declares
+     * a constant output) and only the first pixel is read.
+     * Returns true if the image is constant.
+     **/
+    bool detectConstant(bool assumeConstant = false);
+
     /**
      * @brief Same as fill(const RectI&,float,float,float,float) but fills the R,G and B
      * components with the same value.
@@ -831,6 +861,19 @@ private:
                                bool requiresUnpremult,
                                Image* dstImg) const;
 
+    /**
+     * @brief Implementation of convertToFormatCommon when this image is constant with the given pixel value
+     **/
+    void convertConstantToFormat(const RectI & renderWindow,
+                                 const unsigned char* constantPixel,
+                                 ViewerColorSpaceEnum srcColorSpace,
+                                 ViewerColorSpaceEnum dstColorSpace,
+                                 int channelForAlpha,
+                                 bool useAlpha0,
+                                 bool copyBitMap,
+                                 bool requiresUnpremult,
+                                 Image* dstImg) const;
+
     template <typename PIX, bool doPremult>
     void premultInternal(const RectI& roi);
     template <bool doPremult>
@@ -875,6 +918,22 @@ public:
                        float mix,
                        const OSGLContextPtr& glContext = OSGLContextPtr() );
 
+    /**
+     * @brief Same as copyUnProcessedChannels() followed by applyMaskMix() with originalImage as the original image,
+     * but reads and writes the pixels only once when both operations are needed.
+     **/
+    void copyUnProcessedChannelsAndApplyMaskMix( const RectI& roi,
+                                                 ImagePremultiplicationEnum outputPremult,
+                                                 ImagePremultiplicationEnum originalImagePremult,
+                                                 std::bitset<4> processChannels,
+                                                 const ImagePtr& originalImage,
+                                                 bool ignorePremult,
+                                                 const Image* maskImg,
+                                                 bool masked,
+                                                 bool maskInvert,
+                                                 float mix,
+                                                 const OSGLContextPtr& glContext = OSGLContextPtr() );
+
     /**
      * @brief Eeturns true if image contains NaNs or infinite values, and fix them.
      * Currently, no OpenGL implementation is provided.
@@ -936,6 +995,40 @@ private:
                                       bool maskInvert,
                                       float mix);
 
+    template<typename PIX, int maxValue, int srcNComps, int dstNComps, bool masked, bool maskInvert>
+    void copyUnProcessedChannelsAndApplyMaskMixForMaskInvert(const RectI& roi,
+                                                             const bool copyChannels[4],
+                                                             const Image* originalImg,
+                                                             const Image* maskImg,
+                                                             float mix);
+
+    template<typename PIX, int maxValue, int srcNComps, int dstNComps>
+    void copyUnProcessedChannelsAndApplyMaskMixForComponents(const RectI& roi,
+                                                             const bool copyChannels[4],
+                                                             const Image* originalImg,
+                                                             const Image* maskImg,
+                                                             bool masked,
+                                                             bool maskInvert,
+                                                             float mix);
+
+    template<typename PIX, int maxValue, int srcNComps>
+    void copyUnProcessedChannelsAndApplyMaskMixForSrcComponents(const RectI& roi,
+                                                                const bool copyChannels[4],
+                                                                const Image* originalImg,
+                                                                const Image* maskImg,
+                                                                bool masked,
+                                                                bool maskInvert,
+                                                                float mix);
+
+    template<typename PIX, int maxValue>
+    void copyUnProcessedChannelsAndApplyMaskMixForDepth(const RectI& roi,
+                                                        const bool copyChannels[4],
+                                                        const Image* originalImg,
+                                                        const Image* maskImg,
+                                                        bool masked,
+                                                        bool maskInvert,
+                                                        float mix);
+
     template <typename PIX, int maxValue, int srcNComps, int dstNComps, bool doR, bool doG, bool doB, bool doA, bool premult, bool originalPremult, bool ignorePremult>
     void copyUnProcessedChannelsForPremult(std::bitset<4> processChannels,
                                            const RectI& roi,
@@ -1026,6 +1119,39 @@ private:
     template<typename PIX>
     void scaleBoxForDepth(const RectI & roi, Image* output) const;
 
+    /**
+     * @brief Writes pixel to all pixels of roi, which must be contained in the bounds of the image.
+     * The image lock must be taken by the caller.
+     **/
+    void fillWithPixelInternal(const RectI & roi, const unsigned char* pixel);
+
+    /**
+     * @brief Same as fillWithPixelInternal but takes the image lock, clips roi to the bounds of the image
+     * and marks the image constant if it is entirely filled.
+     * If markForRendered is true, the filled portion of the bitmap is marked rendered.
+     **/
+    void fillWithPixel(const RectI & roi, const unsigned char* pixel, bool markForRendered);
+
+    void setConstantPixel(const unsigned char* pixel);
+
+    void invalidateConstant()
+    {
+        // Cheap test first: this is called for every write access to the pixels
+        if ( (int)_isConstant ) {
+            _isConstant.fetchAndStoreRelaxed(0);
+        }
+    }
+
+    /**
+     * @brief Returns true if the image is constant with the given pixel value
+     **/
+    bool hasConstantPixel(const unsigned char* pixel) const;
+
+    std::size_t getPixelSize() const
+    {
+        return (std::size_t)_nbComponents * _depthBytesSize;
+    }
+
 private:
     ImageBitDepthEnum _bitDepth;
     int _depthBytesSize;
@@ -1037,6 +1163,13 @@ private:
     ImagePremultiplicationEnum _premult;
     bool _useBitmap;
     int _nbComponents;
+
+    // Non-zero if all pixels of the image are equal to _constantPixel
+    QAtomicInt _isConstant;
+
+    // Protects _constantPixel
+    mutable QMutex _constantPixelMutex;
+    unsigned char _constantPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
 };
 
 //template <> inline unsigned char clamp(unsigned char v) { return v; }
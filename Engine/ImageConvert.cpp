@@ -33,6 +33,7 @@
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <boost/math/special_functions/fpclassify.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#include <boost/make_shared.hpp>
 #endif
 
 #include <QtCore/QDebug>
@@ -679,6 +680,13 @@ Image::convertToFormatCommon(const RectI & renderWindow,
                              bool requiresUnpremult,
                              Image* dstImg) const
 {
+    unsigned char constantPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
+    if ( !renderWindow.isNull() && getConstantPixel(constantPixel) ) {
+        convertConstantToFormat(renderWindow, constantPixel, srcColorSpace, dstColorSpace, channelForAlpha, useAlpha0, copyBitmap, requiresUnpremult, dstImg);
+
+        return;
+    }
+
     QWriteLocker k(&dstImg->_entryLock);
     QReadLocker k2(&_entryLock);
 
@@ -884,6 +892,36 @@ Image::convertToFormatCommon(const RectI & renderWindow,
     }
 } // Image::convertToFormatCommon
 
+void
+Image::convertConstantToFormat(const RectI & renderWindow,
+                               const unsigned char* constantPixel,
+                               ViewerColorSpaceEnum srcColorSpace,
+                               ViewerColorSpaceEnum dstColorSpace,
+                               int channelForAlpha,
+                               bool useAlpha0,
+                               bool copyBitmap,
+                               bool requiresUnpremult,
+                               Image* dstImg) const
+{
+    // Convert a single pixel with the regular code path, then replicate it in the render window.
+    // Note that 8-bit output is not dithered in that case.
+    RectI pixelBounds(renderWindow.x1, renderWindow.y1, renderWindow.x1 + 1, renderWindow.y1 + 1);
+    ImagePtr srcPixel = boost::make_shared<Image>( getComponents(), getRoD(), pixelBounds, getMipMapLevel(), getPixelAspectRatio(), getBitDepth(), getPremultiplication(), getFieldingOrder() );
+    ImagePtr dstPixel = boost::make_shared<Image>( dstImg->getComponents(), dstImg->getRoD(), pixelBounds, dstImg->getMipMapLevel(), dstImg->getPixelAspectRatio(), dstImg->getBitDepth(), dstImg->getPremultiplication(), dstImg->getFieldingOrder() );
+
+    // The 1x1 images are not marked constant, so this does not recurse
+    srcPixel->fillWithPixelInternal(pixelBounds, constantPixel);
+    srcPixel->convertToFormatCommon(pixelBounds, srcColorSpace, dstColorSpace, channelForAlpha, useAlpha0, false, requiresUnpremult, dstPixel.get() );
+
+    const Image& constDstPixel = *dstPixel;
+    dstImg->fillWithPixel( renderWindow, constDstPixel.pixelAt(pixelBounds.x1, pixelBounds.y1), false );
+    if ( copyBitmap && dstImg->usesBitMap() && usesBitMap() ) {
+        QWriteLocker k(&dstImg->_entryLock);
+        QReadLocker k2(&_entryLock);
+        dstImg->copyBitmapPortion(renderWindow, *this);
+    }
+}
+
 void
 Image::convertToFormat(const RectI & renderWindow,
                        ViewerColorSpaceEnum srcColorSpace,
@@ -32,6 +32,42 @@
 
 NATRON_NAMESPACE_ENTER
 
+/*
+ * @brief A constant mask is the same as a mix: fold it into the mix value so that the mask is not read for each pixel
+ */
+static void
+foldConstantMask(const RectI& roi,
+                 bool maskInvert,
+                 const Image** maskImg,
+                 bool* masked,
+                 float* mix)
+{
+    if ( !*masked || !*maskImg || ( (*maskImg)->getStorageMode() == eStorageModeGLTex ) || !(*maskImg)->getBounds().contains(roi) ) {
+        return;
+    }
+    unsigned char maskPixel[NATRON_IMAGE_MAX_PIXEL_SIZE];
+    if ( !(*maskImg)->getConstantPixel(maskPixel) ) {
+        return;
+    }
+    float maskScale = 0.f;
+    switch ( (*maskImg)->getBitDepth() ) {
+    case eImageBitDepthByte:
+        maskScale = *(const unsigned char*)maskPixel * (1.f / 255);
+        break;
+    case eImageBitDepthShort:
+        maskScale = *(const unsigned short*)maskPixel * (1.f / 65535);
+        break;
+    case eImageBitDepthFloat:
+        maskScale = *(const float*)maskPixel;
+        break;
+    default:
+        break;
+    }
+    *mix *= maskInvert ? 1.f - maskScale : maskScale;
+    *masked = false;
+    *maskImg = 0;
+}
+
 template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked, bool maskInvert>
 void
 Image::applyMaskMixForMaskInvert(const RectI& roi,
@@ -194,6 +230,8 @@ Image::applyMaskMix(const RectI& roi,
                     float mix,
                     const OSGLContextPtr& glContext)
 {
+    foldConstantMask(roi, maskInvert, &maskImg, &masked, &mix);
+
     ///!masked && mix == 1 has nothing to do
     if ( !masked && (mix == 1) ) {
         return;
@@ -298,4 +336,234 @@ Image::applyMaskMix(const RectI& roi,
     }
 } // applyMaskMix
 
+/*
+ * @brief Single pass equivalent of copyUnProcessedChannels() followed by applyMaskMix(): for each pixel the unprocessed channels
+ * are copied from the original image, then the result is dissolved to the original image.
+ * copyChannels[c] is true if channel c of this image (in its own layout) is not processed and must be copied.
+ */
+template<typename PIX, int maxValue, int srcNComps, int dstNComps, bool masked, bool maskInvert>
+void
+Image::copyUnProcessedChannelsAndApplyMaskMixForMaskInvert(const RectI& roi,
+                                                           const bool copyChannels[4],
+                                                           const Image* originalImg,
+                                                           const Image* maskImg,
+                                                           float mix)
+{
+    assert(originalImg);
+    const RectI& srcBounds = originalImg->getBounds();
+    const RectI maskBounds = maskImg ? maskImg->getBounds() : RectI();
+    const bool copyC[4] = { copyChannels[0], copyChannels[1], copyChannels[2], copyChannels[3] };
+    // Index of the alpha channel in this image, which is copied from the alpha of the original image
+    const int dstAlphaIndex = (dstNComps == 1 || dstNComps == 4) ? dstNComps - 1 : -1;
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        PIX* dst_pixels = (PIX*)pixelAt(roi.x1, y);
+        const PIX* srcRow = (y >= srcBounds.y1 && y < srcBounds.y2) ? (const PIX*)originalImg->pixelAt(srcBounds.x1, y) : 0;
+        const PIX* maskRow = (masked && maskImg && y >= maskBounds.y1 && y < maskBounds.y2) ? (const PIX*)maskImg->pixelAt(maskBounds.x1, y) : 0;
+
+        for (int x = roi.x1; x < roi.x2; ++x, dst_pixels += dstNComps) {
+            const PIX* src_pixels = (srcRow && x >= srcBounds.x1 && x < srcBounds.x2) ? srcRow + (x - srcBounds.x1) * srcNComps : 0;
+
+            // Copy the unprocessed channels
+            for (int c = 0; c < dstNComps; ++c) {
+                if (!copyC[c]) {
+                    continue;
+                }
+                if (c == dstAlphaIndex) {
+                    // be opaque for anything that doesn't contain alpha
+                    PIX srcA = src_pixels ? maxValue : 0;
+                    if ( ( (srcNComps == 1) || (srcNComps == 4) ) && src_pixels ) {
+                        srcA = src_pixels[srcNComps - 1];
+                    }
+                    dst_pixels[c] = srcA;
+                } else {
+                    dst_pixels[c] = (!src_pixels || c >= srcNComps) ? 0 : src_pixels[c];
+                }
+            }
+
+            // Mask and mix
+            float alpha = mix;
+            if (masked) {
+                const PIX* maskPixels = (maskRow && x >= maskBounds.x1 && x < maskBounds.x2) ? maskRow + (x - maskBounds.x1) : 0;
+                float maskScale;
+                if (maskPixels == 0) {
+                    maskScale = maskInvert ? 1.f : 0.f;
+                } else {
+                    maskScale = *maskPixels * (1.f / maxValue);
+                    if (maskInvert) {
+                        maskScale = 1.f - maskScale;
+                    }
+                }
+                alpha *= maskScale;
+            }
+            if (src_pixels) {
+                for (int c = 0; c < dstNComps; ++c) {
+                    if (c < srcNComps) {
+                        float v = float(dst_pixels[c]) * alpha + (1.f - alpha) * float(src_pixels[c]);
+                        dst_pixels[c] = clampIfInt<PIX>(v);
+                    }
+                }
+            } else {
+                for (int c = 0; c < dstNComps; ++c) {
+                    float v = float(dst_pixels[c]) * alpha;
+                    dst_pixels[c] = clampIfInt<PIX>(v);
+                }
+            }
+        }
+    }
+} // Image::copyUnProcessedChannelsAndApplyMaskMixForMaskInvert
+
+template<typename PIX, int maxValue, int srcNComps, int dstNComps>
+void
+Image::copyUnProcessedChannelsAndApplyMaskMixForComponents(const RectI& roi,
+                                                           const bool copyChannels[4],
+                                                           const Image* originalImg,
+                                                           const Image* maskImg,
+                                                           bool masked,
+                                                           bool maskInvert,
+                                                           float mix)
+{
+    if (masked) {
+        if (maskInvert) {
+            copyUnProcessedChannelsAndApplyMaskMixForMaskInvert<PIX, maxValue, srcNComps, dstNComps, true, true>(roi, copyChannels, originalImg, maskImg, mix);
+        } else {
+            copyUnProcessedChannelsAndApplyMaskMixForMaskInvert<PIX, maxValue, srcNComps, dstNComps, true, false>(roi, copyChannels, originalImg, maskImg, mix);
+        }
+    } else {
+        copyUnProcessedChannelsAndApplyMaskMixForMaskInvert<PIX, maxValue, srcNComps, dstNComps, false, false>(roi, copyChannels, originalImg, maskImg, mix);
+    }
+}
+
+template<typename PIX, int maxValue, int srcNComps>
+void
+Image::copyUnProcessedChannelsAndApplyMaskMixForSrcComponents(const RectI& roi,
+                                                              const bool copyChannels[4],
+                                                              const Image* originalImg,
+                                                              const Image* maskImg,
+                                                              bool masked,
+                                                              bool maskInvert,
+                                                              float mix)
+{
+    switch ( getComponentsCount() ) {
+    case 1:
+        copyUnProcessedChannelsAndApplyMaskMixForComponents<PIX, maxValue, srcNComps, 1>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 2:
+        copyUnProcessedChannelsAndApplyMaskMixForComponents<PIX, maxValue, srcNComps, 2>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 3:
+        copyUnProcessedChannelsAndApplyMaskMixForComponents<PIX, maxValue, srcNComps, 3>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 4:
+        copyUnProcessedChannelsAndApplyMaskMixForComponents<PIX, maxValue, srcNComps, 4>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+template<typename PIX, int maxValue>
+void
+Image::copyUnProcessedChannelsAndApplyMaskMixForDepth(const RectI& roi,
+                                                      const bool copyChannels[4],
+                                                      const Image* originalImg,
+                                                      const Image* maskImg,
+                                                      bool masked,
+                                                      bool maskInvert,
+                                                      float mix)
+{
+    switch ( originalImg->getComponentsCount() ) {
+    case 1:
+        copyUnProcessedChannelsAndApplyMaskMixForSrcComponents<PIX, maxValue, 1>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 2:
+        copyUnProcessedChannelsAndApplyMaskMixForSrcComponents<PIX, maxValue, 2>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 3:
+        copyUnProcessedChannelsAndApplyMaskMixForSrcComponents<PIX, maxValue, 3>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    case 4:
+        copyUnProcessedChannelsAndApplyMaskMixForSrcComponents<PIX, maxValue, 4>(roi, copyChannels, originalImg, maskImg, masked, maskInvert, mix);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+void
+Image::copyUnProcessedChannelsAndApplyMaskMix(const RectI& roi,
+                                              const ImagePremultiplicationEnum outputPremult,
+                                              const ImagePremultiplicationEnum originalImagePremult,
+                                              const std::bitset<4> processChannels,
+                                              const ImagePtr& originalImage,
+                                              bool ignorePremult,
+                                              const Image* maskImg,
+                                              bool masked,
+                                              bool maskInvert,
+                                              float mix,
+                                              const OSGLContextPtr& glContext)
+{
+    foldConstantMask(roi, maskInvert, &maskImg, &masked, &mix);
+
+    const bool mustMix = masked || (mix != 1);
+    const bool mustCopy = canCallCopyUnProcessedChannels(processChannels) &&
+                          ( !originalImage || getMipMapLevel() == originalImage->getMipMapLevel() );
+
+    // Without an original image applyMaskMix() does nothing, and if only one of the operations is needed there is nothing to fuse.
+    // OpenGL textures use the shaders of each operation.
+    if ( !originalImage || !mustMix || !mustCopy || (getStorageMode() == eStorageModeGLTex) ) {
+        copyUnProcessedChannels(roi, outputPremult, originalImagePremult, processChannels, originalImage, ignorePremult, glContext);
+        if (mustMix) {
+            applyMaskMix(roi, maskImg, originalImage.get(), masked, maskInvert, mix, glContext);
+        }
+
+        return;
+    }
+
+    QWriteLocker k(&_entryLock);
+    QReadLocker originalLock(&originalImage->_entryLock);
+    boost::scoped_ptr<QReadLocker> maskLock;
+    if (maskImg) {
+        maskLock.reset( new QReadLocker(&maskImg->_entryLock) );
+    }
+
+    assert( getBitDepth() == originalImage->getBitDepth() );
+    assert( !masked || !maskImg || maskImg->getComponents() == ImagePlaneDesc::getAlphaComponents() );
+
+    RectI realRoI;
+    if ( !roi.intersect(_bounds, &realRoI) ) {
+        return;
+    }
+
+    // The channels of this image that are not processed, in its own layout (the single channel of an alpha image is alpha)
+    int dstNComps = getComponentsCount();
+    bool copyChannels[4];
+    if (dstNComps == 1) {
+        copyChannels[0] = !processChannels[3];
+        copyChannels[1] = copyChannels[2] = copyChannels[3] = false;
+    } else {
+        copyChannels[0] = !processChannels[0];
+        copyChannels[1] = !processChannels[1];
+        copyChannels[2] = !processChannels[2] && (dstNComps >= 3);
+        copyChannels[3] = !processChannels[3] && (dstNComps == 4);
+    }
+
+    switch ( getBitDepth() ) {
+    case eImageBitDepthByte:
+        copyUnProcessedChannelsAndApplyMaskMixForDepth<unsigned char, 255>(realRoI, copyChannels, originalImage.get(), maskImg, masked, maskInvert, mix);
+        break;
+    case eImageBitDepthShort:
+        copyUnProcessedChannelsAndApplyMaskMixForDepth<unsigned short, 65535>(realRoI, copyChannels, originalImage.get(), maskImg, masked, maskInvert, mix);
+        break;
+    case eImageBitDepthFloat:
+        copyUnProcessedChannelsAndApplyMaskMixForDepth<float, 1>(realRoI, copyChannels, originalImage.get(), maskImg, masked, maskInvert, mix);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+} // copyUnProcessedChannelsAndApplyMaskMix
+
 NATRON_NAMESPACE_EXIT
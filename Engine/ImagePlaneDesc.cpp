@@ -30,8 +30,14 @@
 #include <cassert>
 #include <stdexcept>
 #include <cstring>
+#include <map>
 #include <sstream>
 
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QString>
+
+#include "Engine/Hash64.h"
+
 NATRON_NAMESPACE_ENTER
 
 static const char* rgbaComps[4] = {"R", "G", "B", "A"};
@@ -41,35 +47,203 @@ static const char* motionComps[2] = {"U", "V"};
 static const char* disparityComps[2] = {"X", "Y"};
 static const char* xyComps[2] = {"X", "Y"};
 
+// Maximum number of OpenFX plane strings remembered by mapOFXPlaneStringToPlane()
+#define NATRON_OFX_PLANES_CACHE_MAX_ENTRIES 1024
 
-ImagePlaneDesc::ImagePlaneDesc()
-: _planeID("none")
 
-, _planeLabel("none")
-, _channels()
-, _channelsLabel("none")
+/**
+ * @brief The layout of a plane: its identifier, labels and channels.
+ * Each distinct layout is created once by the ImagePlaneDescRegistry and is never destroyed, so an ImagePlaneDesc
+ * only points to it: copying a plane does not allocate and comparing planes does not compare strings.
+ **/
+struct ImagePlaneDescData
+{
+    std::string planeID, planeLabel, channelsLabel;
+    std::vector<std::string> channels;
+
+    // Equal for all the layouts of the same plane ID
+    int planeIndex;
+
+    // Equal for the layouts that are equal for ImagePlaneDesc::operator==, i.e: same plane ID and same number of channels
+    int equivalenceIndex;
+
+    // The plane ID followed by the channels in UTF-16, as they are appended to cache keys hashes
+    std::vector<unsigned short> hashCodes;
+
+    // The plane encoded with the Natron multi-plane extension
+    std::string ofxPlaneString;
+
+    ImagePlaneDescData()
+        : planeID()
+        , planeLabel()
+        , channelsLabel()
+        , channels()
+        , planeIndex(0)
+        , equivalenceIndex(0)
+        , hashCodes()
+        , ofxPlaneString()
+    {
+    }
+};
+
+static std::string
+natronCustomCompToOfxComp(const std::string& planeID,
+                          const std::string& planeLabel,
+                          const std::string& channelsLabel,
+                          const std::vector<std::string>& channels)
+{
+    std::stringstream ss;
+    ss << kNatronOfxImageComponentsPlaneName << planeID;
+    if (!planeLabel.empty()) {
+        ss << kNatronOfxImageComponentsPlaneLabel << planeLabel;
+    }
+    if (!channelsLabel.empty()) {
+        ss << kNatronOfxImageComponentsPlaneChannelsLabel << channelsLabel;
+    }
+    for (std::size_t i = 0; i < channels.size(); ++i) {
+        ss << kNatronOfxImageComponentsPlaneChannel << channels[i];
+    }
+
+    return ss.str();
+} // natronCustomCompToOfxComp
+
+static void
+appendHashCodes(const std::string& str,
+                std::vector<unsigned short>* codes)
 {
+    QString qstr = QString::fromUtf8( str.c_str() );
+    for (int i = 0; i < qstr.size(); ++i) {
+        codes->push_back( qstr[i].unicode() );
+    }
 }
 
-ImagePlaneDesc::ImagePlaneDesc(const std::string& planeID,
-                               const std::string& planeLabel,
-                               const std::string& channelsLabel,
-                               const std::vector<std::string>& channels)
-: _planeID(planeID)
-, _planeLabel(planeLabel)
-, _channels(channels)
-, _channelsLabel(channelsLabel)
-{
-    if (planeLabel.empty()) {
-        // Plane label is the ID if empty
-        _planeLabel = _planeID;
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Interning table of the plane layouts, shared by the whole application.
+ **/
+class ImagePlaneDescRegistry
+{
+    // planeID, planeLabel, channelsLabel followed by the channels
+    typedef std::vector<std::string> LayoutKey;
+    typedef std::map<LayoutKey, const ImagePlaneDescData*> LayoutsMap;
+
+    // Layouts are only inserted once: lookups of existing layouts only share the lock
+    mutable QReadWriteLock _lock;
+    LayoutsMap _layouts;
+    std::map<std::string, int> _planeIndices;
+    std::map<std::pair<int, std::size_t>, int> _equivalenceIndices;
+
+    // Planes already decoded from an OpenFX string, at most NATRON_OFX_PLANES_CACHE_MAX_ENTRIES
+    std::map<std::string, const ImagePlaneDescData*> _ofxPlanes;
+
+public:
+
+    ImagePlaneDescRegistry()
+        : _lock()
+        , _layouts()
+        , _planeIndices()
+        , _equivalenceIndices()
+        , _ofxPlanes()
+    {
     }
-    if ( channelsLabel.empty() ) {
-        // Channels label is the concatenation of all channels
+
+    const ImagePlaneDescData* getLayout(const std::string& planeID,
+                                        const std::string& planeLabel,
+                                        const std::string& channelsLabel,
+                                        const std::vector<std::string>& channels)
+    {
+        LayoutKey key;
+
+        key.reserve(3 + channels.size());
+        key.push_back(planeID);
+        key.push_back(planeLabel);
+        key.push_back(channelsLabel);
+        key.insert( key.end(), channels.begin(), channels.end() );
+
+        {
+            QReadLocker k(&_lock);
+            LayoutsMap::const_iterator found = _layouts.find(key);
+            if ( found != _layouts.end() ) {
+                return found->second;
+            }
+        }
+
+        QWriteLocker k(&_lock);
+        // Another thread may have inserted it in-between
+        LayoutsMap::const_iterator found = _layouts.find(key);
+        if ( found != _layouts.end() ) {
+            return found->second;
+        }
+
+        ImagePlaneDescData* data = new ImagePlaneDescData;
+        data->planeID = planeID;
+        data->planeLabel = planeLabel;
+        data->channelsLabel = channelsLabel;
+        data->channels = channels;
+        data->planeIndex = _planeIndices.insert( std::make_pair( planeID, (int)_planeIndices.size() ) ).first->second;
+        data->equivalenceIndex = _equivalenceIndices.insert( std::make_pair( std::make_pair( data->planeIndex, channels.size() ), (int)_equivalenceIndices.size() ) ).first->second;
+        appendHashCodes(planeID, &data->hashCodes);
         for (std::size_t i = 0; i < channels.size(); ++i) {
-            _channelsLabel.append(channels[i]);
+            appendHashCodes(channels[i], &data->hashCodes);
         }
+        data->ofxPlaneString = natronCustomCompToOfxComp(planeID, planeLabel, channelsLabel, channels);
+        _layouts.insert( std::make_pair(key, data) );
+
+        return data;
+    }
+
+    const ImagePlaneDescData* findOFXPlane(const std::string& ofxPlane) const
+    {
+        QReadLocker k(&_lock);
+        std::map<std::string, const ImagePlaneDescData*>::const_iterator found = _ofxPlanes.find(ofxPlane);
+
+        return found == _ofxPlanes.end() ? 0 : found->second;
     }
+
+    void insertOFXPlane(const std::string& ofxPlane,
+                        const ImagePlaneDescData* data)
+    {
+        QWriteLocker k(&_lock);
+
+        // The layouts themselves are kept, so forgetting the strings only costs decoding them again
+        if (_ofxPlanes.size() >= NATRON_OFX_PLANES_CACHE_MAX_ENTRIES) {
+            _ofxPlanes.clear();
+        }
+        _ofxPlanes.insert( std::make_pair(ofxPlane, data) );
+    }
+};
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+static ImagePlaneDescRegistry&
+getPlaneRegistry()
+{
+    static ImagePlaneDescRegistry registry;
+
+    return registry;
+}
+
+static const ImagePlaneDescData*
+getNoneLayout()
+{
+    static const ImagePlaneDescData* data = getPlaneRegistry().getLayout( "none", "none", "none", std::vector<std::string>() );
+
+    return data;
+}
+
+ImagePlaneDesc::ImagePlaneDesc()
+    : _data( getNoneLayout() )
+{
+}
+
+ImagePlaneDesc::ImagePlaneDesc(const std::string& planeID,
+                               const std::string& planeLabel,
+                               const std::string& channelsLabel,
+                               const std::vector<std::string>& channels)
+    : _data(0)
+{
+    init(planeID, planeLabel, channelsLabel, channels);
 }
 
 ImagePlaneDesc::ImagePlaneDesc(const std::string& planeName,
@@ -77,40 +251,24 @@ ImagePlaneDesc::ImagePlaneDesc(const std::string& planeName,
                                const std::string& channelsLabel,
                                const char** channels,
                                int count)
-: _planeID(planeName)
-, _planeLabel(planeLabel)
-, _channels()
-, _channelsLabel(channelsLabel)
+    : _data(0)
 {
-    _channels.resize(count);
+    std::vector<std::string> channelsVec(count);
     for (int i = 0; i < count; ++i) {
-        _channels[i] = channels[i];
-    }
-
-    if (planeLabel.empty()) {
-        // Plane label is the ID if empty
-        _planeLabel = _planeID;
-    }
-    if ( channelsLabel.empty() ) {
-        // Channels label is the concatenation of all channels
-        for (std::size_t i = 0; i < _channels.size(); ++i) {
-            _channelsLabel.append(channels[i]);
-        }
+        channelsVec[i] = channels[i];
     }
+    init(planeName, planeLabel, channelsLabel, channelsVec);
 }
 
 ImagePlaneDesc::ImagePlaneDesc(const ImagePlaneDesc& other)
+    : _data(other._data)
 {
-    *this = other;
 }
 
 ImagePlaneDesc&
 ImagePlaneDesc::operator=(const ImagePlaneDesc& other)
 {
-    _planeID = other._planeID;
-    _planeLabel = other._planeLabel;
-    _channels = other._channels;
-    _channelsLabel = other._channelsLabel;
+    _data = other._data;
     return *this;
 }
 
@@ -118,6 +276,27 @@ ImagePlaneDesc::~ImagePlaneDesc()
 {
 }
 
+void
+ImagePlaneDesc::init(const std::string& planeID,
+                     const std::string& planeLabel,
+                     const std::string& channelsLabel,
+                     const std::vector<std::string>& channels)
+{
+    // Plane label is the ID if empty
+    const std::string& label = planeLabel.empty() ? planeID : planeLabel;
+
+    if ( !channelsLabel.empty() ) {
+        _data = getPlaneRegistry().getLayout(planeID, label, channelsLabel, channels);
+    } else {
+        // Channels label is the concatenation of all channels
+        std::string concatenatedChannels;
+        for (std::size_t i = 0; i < channels.size(); ++i) {
+            concatenatedChannels.append(channels[i]);
+        }
+        _data = getPlaneRegistry().getLayout(planeID, label, concatenatedChannels, channels);
+    }
+}
+
 bool
 ImagePlaneDesc::isColorPlane(const std::string& planeID)
 {
@@ -127,7 +306,9 @@ ImagePlaneDesc::isColorPlane(const std::string& planeID)
 bool
 ImagePlaneDesc::isColorPlane() const
 {
-    return ImagePlaneDesc::isColorPlane(_planeID);
+    static const int colorPlaneIndex = getRGBAComponents()._data->planeIndex;
+
+    return _data->planeIndex == colorPlaneIndex;
 }
 
 
@@ -135,46 +316,54 @@ ImagePlaneDesc::isColorPlane() const
 bool
 ImagePlaneDesc::operator==(const ImagePlaneDesc& other) const
 {
-    if ( _channels.size() != other._channels.size() ) {
-        return false;
-    }
-    return _planeID == other._planeID;
+    return _data->equivalenceIndex == other._data->equivalenceIndex;
 }
 
 bool
 ImagePlaneDesc::operator<(const ImagePlaneDesc& other) const
 {
-    return _planeID < other._planeID;
+    // Interned planes are ordered by their index, which is stable during the session but not across sessions
+    return _data->planeIndex < other._data->planeIndex;
 }
 
 int
 ImagePlaneDesc::getNumComponents() const
 {
-    return (int)_channels.size();
+    return (int)_data->channels.size();
 }
 
 const std::string&
 ImagePlaneDesc::getPlaneID() const
 {
-    return _planeID;
+    return _data->planeID;
 }
 
 const std::string&
 ImagePlaneDesc::getPlaneLabel() const
 {
-    return _planeLabel;
+    return _data->planeLabel;
 }
 
 const std::string&
 ImagePlaneDesc::getChannelsLabel() const
 {
-    return _channelsLabel;
+    return _data->channelsLabel;
 }
 
 const std::vector<std::string>&
 ImagePlaneDesc::getChannels() const
 {
-    return _channels;
+    return _data->channels;
+}
+
+void
+ImagePlaneDesc::appendToHash(Hash64* hash) const
+{
+    const std::vector<unsigned short>& codes = _data->hashCodes;
+
+    for (std::size_t i = 0; i < codes.size(); ++i) {
+        hash->append(codes[i]);
+    }
 }
 
 const ImagePlaneDesc&
@@ -253,13 +442,13 @@ ImagePlaneDesc::getDisparityRightComponents()
 ChoiceOption
 ImagePlaneDesc::getChannelOption(int channelIndex) const
 {
-    if (channelIndex < 0 || channelIndex >= (int)_channels.size()) {
+    if (channelIndex < 0 || channelIndex >= (int)_data->channels.size()) {
         assert(false);
         return ChoiceOption("","","");
     }
     std::string optionID, optionLabel;
-    optionLabel += _planeLabel;
-    optionID += _planeID;
+    optionLabel += _data->planeLabel;
+    optionID += _data->planeID;
     if ( !optionLabel.empty() ) {
         optionLabel += '.';
     }
@@ -268,8 +457,8 @@ ImagePlaneDesc::getChannelOption(int channelIndex) const
     }
 
     // For the option label, append the name of the channel
-    optionLabel += _channels[channelIndex];
-    optionID += _channels[channelIndex];
+    optionLabel += _data->channels[channelIndex];
+    optionID += _data->channels[channelIndex];
 
     return ChoiceOption(optionID, optionLabel, "");
 }
@@ -277,11 +466,11 @@ ImagePlaneDesc::getChannelOption(int channelIndex) const
 ChoiceOption
 ImagePlaneDesc::getPlaneOption() const
 {
-    std::string optionLabel = _planeLabel + "." + _channelsLabel;
+    std::string optionLabel = _data->planeLabel + "." + _data->channelsLabel;
 
     // The option ID is always the name of the layer, this ensures for the Color plane that even if the components type changes, the choice stays
     // the same in the parameter.
-    return ChoiceOption(_planeID, optionLabel, "");
+    return ChoiceOption(_data->planeID, optionLabel, "");
 
 }
 
@@ -405,16 +594,28 @@ extractOFXEncodedCustomPlane(const std::string& comp, std::string* layerName, st
     return true;
 } // extractOFXEncodedCustomPlane
 
-static ImagePlaneDesc
-ofxCustomCompToNatronComp(const std::string& comp)
+ImagePlaneDesc
+ImagePlaneDesc::ofxCustomCompToNatronComp(const std::string& comp)
 {
+    // Plugins pass the same strings over and over, only decode them once
+    ImagePlaneDescRegistry& registry = getPlaneRegistry();
+    const ImagePlaneDescData* data = registry.findOFXPlane(comp);
+    if (data) {
+        ImagePlaneDesc ret;
+        ret._data = data;
+
+        return ret;
+    }
+
     std::string planeID, planeLabel, channelsLabel;
     std::vector<std::string> channels;
-    if (!extractOFXEncodedCustomPlane(comp, &planeID, &planeLabel, &channelsLabel, &channels)) {
-        return ImagePlaneDesc::getNoneComponents();
+    ImagePlaneDesc ret;
+    if ( extractOFXEncodedCustomPlane(comp, &planeID, &planeLabel, &channelsLabel, &channels) ) {
+        ret = ImagePlaneDesc(planeID, planeLabel, channelsLabel, channels);
     }
+    registry.insertOFXPlane(comp, ret._data);
 
-    return ImagePlaneDesc(planeID, planeLabel, channelsLabel, channels);
+    return ret;
 }
 
 ImagePlaneDesc
@@ -460,29 +661,6 @@ ImagePlaneDesc::mapOFXComponentsTypeStringToPlanes(const std::string& ofxCompone
 } // mapOFXComponentsTypeStringToPlanes
 
 
-static std::string
-natronCustomCompToOfxComp(const ImagePlaneDesc &comp)
-{
-    std::stringstream ss;
-    const std::vector<std::string>& channels = comp.getChannels();
-    const std::string& planeID = comp.getPlaneID();
-    const std::string& planeLabel = comp.getPlaneLabel();
-    const std::string& channelsLabel = comp.getChannelsLabel();
-    ss << kNatronOfxImageComponentsPlaneName << planeID;
-    if (!planeLabel.empty()) {
-        ss << kNatronOfxImageComponentsPlaneLabel << planeLabel;
-    }
-    if (!channelsLabel.empty()) {
-        ss << kNatronOfxImageComponentsPlaneChannelsLabel << channelsLabel;
-    }
-    for (std::size_t i = 0; i < channels.size(); ++i) {
-        ss << kNatronOfxImageComponentsPlaneChannel << channels[i];
-    }
-
-    return ss.str();
-} // natronCustomCompToOfxComp
-
-
 std::string
 ImagePlaneDesc::mapPlaneToOFXPlaneString(const ImagePlaneDesc& plane)
 {
@@ -497,7 +675,7 @@ ImagePlaneDesc::mapPlaneToOFXPlaneString(const ImagePlaneDesc& plane)
     } else if ( plane == ImagePlaneDesc::getDisparityRightComponents() ) {
         return kFnOfxImagePlaneStereoDisparityRight;
     } else {
-        return natronCustomCompToOfxComp(plane);
+        return plane._data->ofxPlaneString;
     }
 
 }
@@ -522,7 +700,7 @@ ImagePlaneDesc::mapPlaneToOFXComponentsTypeString(const ImagePlaneDesc& plane)
                plane == ImagePlaneDesc::getDisparityRightComponents()) {
         return kFnOfxImageComponentStereoDisparity;
     } else {
-        return natronCustomCompToOfxComp(plane);
+        return plane._data->ofxPlaneString;
     }
 }
 NATRON_NAMESPACE_EXIT
@@ -70,6 +70,12 @@ GCC_DIAG_ON(unused-parameter)
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief Description of a plane (or layer) and its channels.
+ * Each distinct layout is stored once in an application-wide table and an ImagePlaneDesc only refers to it:
+ * copies, comparisons and hashing do not touch the strings, which are only kept for the UI, OpenFX and serialization.
+ **/
+struct ImagePlaneDescData;
 class ImagePlaneDesc
 {
 public:
@@ -127,6 +133,11 @@ public:
      **/
     const std::string& getChannelsLabel() const;
 
+    /**
+     * @brief Appends the plane ID and the channels to the hash, without any allocation.
+     **/
+    void appendToHash(Hash64* hash) const;
+
 
     bool operator==(const ImagePlaneDesc& other) const;
 
@@ -249,15 +260,35 @@ public:
     void load(Archive & ar, const unsigned int version);
 
 private:
-    std::string _planeID, _planeLabel;
-    std::vector<std::string> _channels;
-    std::string _channelsLabel;
-    
+
+    void init(const std::string& planeID,
+              const std::string& planeLabel,
+              const std::string& channelsLabel,
+              const std::vector<std::string>& channels);
+
+    static ImagePlaneDesc ofxCustomCompToNatronComp(const std::string& comp);
+
+    // Never null, owned by the table of layouts
+    const ImagePlaneDescData* _data;
+
     friend class boost::serialization::access;
 
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
+/**
+ * @brief Orders planes by plane ID. ImagePlaneDesc::operator< orders them by their interning order, which is not
+ * suitable for lists displayed to the user.
+ **/
+struct ImagePlaneDescIDCompare
+{
+    bool operator()(const ImagePlaneDesc& lhs,
+                    const ImagePlaneDesc& rhs) const
+    {
+        return lhs.getPlaneID() < rhs.getPlaneID();
+    }
+};
+
 NATRON_NAMESPACE_EXIT
 
 BOOST_CLASS_VERSION(NATRON_NAMESPACE::ImagePlaneDesc, IMAGEPLANEDESC_SERIALIZATION_VERSION)
@@ -0,0 +1,275 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "KnobsSnapshot.h"
+
+#include <algorithm> // max
+#include <cassert>
+#include <map>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+#endif
+
+#include <QtCore/QMutex>
+
+#include "Engine/Curve.h"
+#include "Engine/Knob.h"
+#include "Engine/ViewIdx.h"
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// Returns false if the dimension must be read from the knob
+bool
+canCaptureDimension(const KnobI& knob,
+                    int dimension)
+{
+    return knob.getExpression(dimension).empty() && !knob.getMaster(dimension).second;
+}
+
+CurvePtr
+getAnimationCurve(const KnobI& knob,
+                  int dimension)
+{
+    if ( !knob.canAnimate() ) {
+        return CurvePtr();
+    }
+    CurvePtr curve = knob.getCurve(ViewIdx(0), dimension);
+    if ( !curve || !curve->isAnimated() ) {
+        return CurvePtr();
+    }
+
+    return curve;
+}
+
+struct SharedCurveCopy
+{
+    // The curve the copy was made from: the address alone may be reused by another curve
+    boost::weak_ptr<Curve> source;
+    U64 revision;
+    CurvePtr copy;
+
+    SharedCurveCopy()
+        : source()
+        , revision(0)
+        , copy()
+    {
+    }
+};
+
+// Copies of the animation curves shared by all the snapshots made while the curves are not edited,
+// so that launching a render does not copy every animated curve again
+struct SharedCurveCopies
+{
+    QMutex mutex;
+    std::map<const Curve*, SharedCurveCopy> copies;
+
+    // Number of copies after the last removal of the copies of deleted curves
+    std::size_t nCopiesAfterSweep;
+
+    SharedCurveCopies()
+        : mutex()
+        , copies()
+        , nCopiesAfterSweep(0)
+    {
+    }
+};
+
+static SharedCurveCopies sharedCurveCopies;
+
+// Returns an immutable copy of the curve, shared with the other snapshots as long as the curve does not change
+CurvePtr
+getSharedCurveCopy(const CurvePtr& curve)
+{
+    // Read the revision before copying: if the curve is edited in-between, the copy is newer than its
+    // revision and is only made again by the next snapshot.
+    U64 revision = curve->getRevision();
+    QMutexLocker k(&sharedCurveCopies.mutex);
+    SharedCurveCopy& entry = sharedCurveCopies.copies[curve.get()];
+
+    if ( entry.copy && (entry.revision == revision) && (entry.source.lock() == curve) ) {
+        return entry.copy;
+    }
+    entry.source = curve;
+    entry.revision = revision;
+    entry.copy = boost::make_shared<Curve>(*curve);
+    CurvePtr ret = entry.copy;
+
+    if ( sharedCurveCopies.copies.size() > std::max( (std::size_t)64, sharedCurveCopies.nCopiesAfterSweep * 2 ) ) {
+        for (std::map<const Curve*, SharedCurveCopy>::iterator it = sharedCurveCopies.copies.begin(); it != sharedCurveCopies.copies.end();) {
+            if ( it->second.source.expired() ) {
+                sharedCurveCopies.copies.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+        sharedCurveCopies.nCopiesAfterSweep = sharedCurveCopies.copies.size();
+    }
+
+    return ret;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+template <typename T>
+void
+KnobsSnapshot::captureKnob(Knob<T>* knob,
+                           KnobSnapshot* snapshot) const
+{
+    int nDims = knob->getDimension();
+
+    snapshot->resize(nDims);
+    for (int i = 0; i < nDims; ++i) {
+        if ( !canCaptureDimension(*knob, i) ) {
+            continue;
+        }
+        DimensionSnapshot& dim = (*snapshot)[i];
+        CurvePtr curve = getAnimationCurve(*knob, i);
+        if (curve) {
+            // Copy the keyframes: the curve of the knob may be edited during the render
+            dim.curve = getSharedCurveCopy(curve);
+        }
+        dim.value = (double)knob->getValueAtTime(_time, i, ViewIdx(0), true /*clamp*/);
+        dim.captured = true;
+    }
+}
+
+template <>
+void
+KnobsSnapshot::captureKnob(Knob<std::string>* knob,
+                           KnobSnapshot* snapshot) const
+{
+    int nDims = knob->getDimension();
+
+    snapshot->resize(nDims);
+    for (int i = 0; i < nDims; ++i) {
+        if ( !canCaptureDimension(*knob, i) || getAnimationCurve(*knob, i) ) {
+            continue;
+        }
+        DimensionSnapshot& dim = (*snapshot)[i];
+        dim.stringValue = knob->getRawValue(i);
+        dim.captured = true;
+    }
+}
+
+KnobsSnapshot::KnobsSnapshot(const KnobHolder& holder,
+                             double time)
+    : _time(time)
+    , _knobs()
+{
+    KnobsVec knobs = holder.getKnobs_mt_safe();
+
+    for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        KnobI* knob = it->get();
+        if (Knob<double>* isDouble = dynamic_cast<Knob<double>*>(knob)) {
+            captureKnob(isDouble, &_knobs[knob]);
+        } else if (Knob<int>* isInt = dynamic_cast<Knob<int>*>(knob)) {
+            captureKnob(isInt, &_knobs[knob]);
+        } else if (Knob<bool>* isBool = dynamic_cast<Knob<bool>*>(knob)) {
+            captureKnob(isBool, &_knobs[knob]);
+        } else if (Knob<std::string>* isString = dynamic_cast<Knob<std::string>*>(knob)) {
+            captureKnob(isString, &_knobs[knob]);
+        }
+    }
+}
+
+KnobsSnapshot::~KnobsSnapshot()
+{
+}
+
+const KnobsSnapshot::DimensionSnapshot*
+KnobsSnapshot::findDimension(const KnobI* knob,
+                             int dimension) const
+{
+    KnobSnapshotMap::const_iterator found = _knobs.find(knob);
+
+    if ( ( found == _knobs.end() ) || (dimension < 0) || ( dimension >= (int)found->second.size() ) ) {
+        return 0;
+    }
+    const DimensionSnapshot& dim = found->second[dimension];
+
+    return dim.captured ? &dim : 0;
+}
+
+bool
+KnobsSnapshot::getValue(const KnobI* knob,
+                        int dimension,
+                        double* value) const
+{
+    const DimensionSnapshot* dim = findDimension(knob, dimension);
+
+    if (!dim) {
+        return false;
+    }
+    if (!dim->curve) {
+        *value = dim->value;
+
+        return true;
+    }
+
+    // The knob may be read while rendering at a different time than the one the render was launched at
+    return getValueAtTime(knob, dimension, knob->getCurrentTime(), value);
+}
+
+bool
+KnobsSnapshot::getValueAtTime(const KnobI* knob,
+                              int dimension,
+                              double time,
+                              double* value) const
+{
+    const DimensionSnapshot* dim = findDimension(knob, dimension);
+
+    if (!dim) {
+        return false;
+    }
+    if ( !dim->curve || (time == _time) ) {
+        *value = dim->value;
+    } else {
+        *value = dim->curve->getValueAt(time, true /*clamp*/);
+    }
+
+    return true;
+}
+
+bool
+KnobsSnapshot::getStringValue(const KnobI* knob,
+                              int dimension,
+                              std::string* value) const
+{
+    const DimensionSnapshot* dim = findDimension(knob, dimension);
+
+    if (!dim) {
+        return false;
+    }
+    *value = dim->stringValue;
+
+    return true;
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+#ifndef Engine_KnobsSnapshot_h
+#define Engine_KnobsSnapshot_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+template <typename T>
+class Knob;
+
+/**
+ * @brief An immutable copy of the parameter values and animation curves of an effect, made when a render
+ * is launched (@see ParallelRenderArgs).
+ * Render threads read the parameters from the snapshot instead of the knobs, so that they do not contend
+ * on the knobs locks with each other and with the GUI thread, and see the same values for the whole render
+ * even if the user edits the parameters in the meantime.
+ * Dimensions driven by an expression or slaved to another knob are not captured: they must be read
+ * from the knob as usual.
+ **/
+class KnobsSnapshot
+{
+public:
+
+    /**
+     * @brief Captures the values at the given time of all the knobs of the holder.
+     **/
+    KnobsSnapshot(const KnobHolder& holder,
+                  double time);
+
+    ~KnobsSnapshot();
+
+    /**
+     * @brief If the given dimension of the knob was captured, sets value to its value at the time of the render
+     * (clamped to the knob range, as Knob::getValue() does) and returns true.
+     **/
+    bool getValue(const KnobI* knob, int dimension, double* value) const;
+
+    /**
+     * @brief Same as getValue() at the given time. Times other than the time of the render are evaluated
+     * on the copy of the animation curve.
+     **/
+    bool getValueAtTime(const KnobI* knob, int dimension, double time, double* value) const;
+
+    /**
+     * @brief Same as getValue() for string knobs. Animated strings are not captured.
+     **/
+    bool getStringValue(const KnobI* knob, int dimension, std::string* value) const;
+
+private:
+
+    struct DimensionSnapshot
+    {
+        // False if the dimension is driven by an expression or slaved to another knob
+        bool captured;
+
+        // Value at the time of the render
+        double value;
+        std::string stringValue;
+
+        // Copy of the animation curve, NULL if the dimension is not animated.
+        // It is shared with the other snapshots made while the curve is not edited and must not be modified.
+        CurvePtr curve;
+
+        DimensionSnapshot()
+            : captured(false)
+            , value(0.)
+            , stringValue()
+            , curve()
+        {
+        }
+    };
+
+    typedef std::vector<DimensionSnapshot> KnobSnapshot;
+
+    typedef std::map<const KnobI*, KnobSnapshot> KnobSnapshotMap;
+
+    template <typename T>
+    void captureKnob(Knob<T>* knob, KnobSnapshot* snapshot) const;
+
+    const DimensionSnapshot* findDimension(const KnobI* knob, int dimension) const;
+
+    double _time;
+    KnobSnapshotMap _knobs;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_KnobsSnapshot_h
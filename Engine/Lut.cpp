@@ -29,6 +29,14 @@
 #include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
+#include <vector>
+
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#endif
 
 #include "Engine/RectI.h"
 
@@ -345,6 +353,358 @@ Lut::fillTables() const
     }
 }
 
+// Conversions of rectangles with at least this number of pixels are split in bands of rows converted in parallel
+#define NATRON_LUT_PARALLEL_MIN_PIXELS (256 * 256)
+#define NATRON_LUT_ROWS_PER_TASK 32
+
+// Seed of the pseudo-random start of the error diffusion of each row
+#define NATRON_LUT_ERROR_DIFFUSION_SEED 0x9e3779b9u
+
+/**
+ * @brief The parameters of a conversion between two packed buffers, shared by all the bands of rows.
+ **/
+struct PackedConversionArgs
+{
+    const void* from;
+    void* to;
+    RectI srcBounds;
+    RectI dstBounds;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    bool invertY;
+
+    PackedConversionArgs(const void* from_,
+                         void* to_,
+                         const RectI & srcBounds_,
+                         const RectI & dstBounds_,
+                         PixelPackingEnum inputPacking,
+                         PixelPackingEnum outputPacking,
+                         bool invertY_)
+        : from(from_)
+        , to(to_)
+        , srcBounds(srcBounds_)
+        , dstBounds(dstBounds_)
+        , invertY(invertY_)
+    {
+        getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+        getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+    }
+};
+
+typedef void (*PackedConversionRowsFunction)(const Lut* lut, const PackedConversionArgs & args, const RectI & band);
+
+/**
+ * @brief Returns the instance of Kernel::rows for the given packings: the row loops are specialized so that
+ * the alpha handling and the size of the pixels are resolved at compile time.
+ **/
+template <typename Kernel>
+static PackedConversionRowsFunction
+getPackedConversionRowsFunction(bool inputHasAlpha,
+                                bool outputHasAlpha,
+                                bool premult)
+{
+    if (inputHasAlpha && premult) {
+        if (outputHasAlpha) {
+            return &Kernel::template rows<true, true, true>;
+        }
+
+        return &Kernel::template rows<true, false, true>;
+    } else if (inputHasAlpha) {
+        if (outputHasAlpha) {
+            return &Kernel::template rows<true, true, false>;
+        }
+
+        return &Kernel::template rows<true, false, false>;
+    }
+    // premultiplication needs an alpha channel
+    if (outputHasAlpha) {
+        return &Kernel::template rows<false, true, false>;
+    }
+
+    return &Kernel::template rows<false, false, false>;
+}
+
+/**
+ * @brief Converts the rows of rect with the given Kernel. Large rectangles are split in bands of rows
+ * that are converted concurrently: each band only writes to its own rows of the output buffer.
+ **/
+template <typename Kernel>
+static void
+convertPackedRows(const Lut* lut,
+                  const PackedConversionArgs & args,
+                  const RectI & rect,
+                  PixelPackingEnum inputPacking,
+                  PixelPackingEnum outputPacking,
+                  bool premult)
+{
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    PackedConversionRowsFunction func = getPackedConversionRowsFunction<Kernel>(inputHasAlpha, outputHasAlpha, premult);
+
+    if ( (std::size_t)rect.width() * rect.height() < NATRON_LUT_PARALLEL_MIN_PIXELS ) {
+        func(lut, args, rect);
+
+        return;
+    }
+    std::vector<RectI> bands;
+    for (int y = rect.y1; y < rect.y2; y += NATRON_LUT_ROWS_PER_TASK) {
+        bands.push_back( RectI( rect.x1, y, rect.x2, std::min(y + NATRON_LUT_ROWS_PER_TASK, rect.y2) ) );
+    }
+    QtConcurrent::blockingMap( bands, boost::bind(func, lut, boost::cref(args), _1) );
+}
+
+/**
+ * @brief Returns the pixel of the row y of [x1, x2) where the error diffusion starts. It is pseudo-random but only depends
+ * on the row, so that the result does not depend on the band or thread that converts it.
+ **/
+static inline int
+getErrorDiffusionStart(int y,
+                       int x1,
+                       int x2)
+{
+    // Integer hash of Thomas Wang, with a fixed seed
+    unsigned int h = (unsigned int)y ^ NATRON_LUT_ERROR_DIFFUSION_SEED;
+
+    h = (h ^ 61) ^ (h >> 16);
+    h *= 9;
+    h ^= h >> 4;
+    h *= 0x27d4eb2d;
+    h ^= h >> 15;
+
+    return x1 + (int)( h % (unsigned int)(x2 - x1) );
+}
+
+/// Linear float to 8-bit in the Lut color-space, with error diffusion
+struct ToBytePackedKernel
+{
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void pixel(const Lut* lut,
+                      const PackedConversionArgs & args,
+                      const float* src,
+                      unsigned char* dst,
+                      unsigned* error_r,
+                      unsigned* error_g,
+                      unsigned* error_b)
+    {
+        float a = premult ? src[args.inAOffset] : 1.f;
+
+        *error_r = (*error_r & 0xff) + lut->toColorSpaceUint8xxFromLinearFloatFast(src[args.inROffset] * a);
+        *error_g = (*error_g & 0xff) + lut->toColorSpaceUint8xxFromLinearFloatFast(src[args.inGOffset] * a);
+        *error_b = (*error_b & 0xff) + lut->toColorSpaceUint8xxFromLinearFloatFast(src[args.inBOffset] * a);
+        assert(*error_r < 0x10000 && *error_g < 0x10000 && *error_b < 0x10000);
+        dst[args.outROffset] = (unsigned char)(*error_r >> 8);
+        dst[args.outGOffset] = (unsigned char)(*error_g >> 8);
+        dst[args.outBOffset] = (unsigned char)(*error_b >> 8);
+        if (outputHasAlpha) {
+            // alpha is linear and should not be dithered
+            dst[args.outAOffset] = floatToInt<256>(a);
+        }
+    }
+
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void rows(const Lut* lut,
+                     const PackedConversionArgs & args,
+                     const RectI & band)
+    {
+        const int inPackingSize = inputHasAlpha ? 4 : 3;
+        const int outPackingSize = outputHasAlpha ? 4 : 3;
+
+        for (int y = band.y1; y < band.y2; ++y) {
+            int start = getErrorDiffusionStart(y, band.x1, band.x2);
+            unsigned error_r, error_g, error_b;
+            error_r = error_g = error_b = 0x80;
+            int srcY = y;
+            if (!args.invertY) {
+                srcY = args.srcBounds.y2 - y - 1;
+            }
+            int dstY = args.dstBounds.y2 - y - 1;
+            const float *src_pixels = (const float*)args.from + (srcY * (args.srcBounds.x2 - args.srcBounds.x1) * inPackingSize);
+            unsigned char *dst_pixels = (unsigned char*)args.to + (dstY * (args.dstBounds.x2 - args.dstBounds.x1) * outPackingSize);
+            /* go forwards from starting point to end of line: */
+            for (int x = start; x < band.x2; ++x) {
+                pixel<inputHasAlpha, outputHasAlpha, premult>(lut, args, src_pixels + x * inPackingSize, dst_pixels + x * outPackingSize, &error_r, &error_g, &error_b);
+            }
+            /* go backwards from starting point to start of line: */
+            error_r = error_g = error_b = 0x80;
+            for (int x = start - 1; x >= band.x1; --x) {
+                pixel<inputHasAlpha, outputHasAlpha, premult>(lut, args, src_pixels + x * inPackingSize, dst_pixels + x * outPackingSize, &error_r, &error_g, &error_b);
+            }
+        }
+    }
+};
+
+/// Linear float to 16-bit in the Lut color-space. 16 bits are precise enough not to need error diffusion.
+struct ToShortPackedKernel
+{
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void rows(const Lut* lut,
+                     const PackedConversionArgs & args,
+                     const RectI & band)
+    {
+        const int inPackingSize = inputHasAlpha ? 4 : 3;
+        const int outPackingSize = outputHasAlpha ? 4 : 3;
+
+        for (int y = band.y1; y < band.y2; ++y) {
+            int srcY = y;
+            if (args.invertY) {
+                srcY = args.srcBounds.y2 - y - 1;
+            }
+            int dstY = args.dstBounds.y2 - y - 1;
+            const float *src_pixels = (const float*)args.from + (srcY * (args.srcBounds.x2 - args.srcBounds.x1) * inPackingSize);
+            unsigned short *dst_pixels = (unsigned short*)args.to + (dstY * (args.dstBounds.x2 - args.dstBounds.x1) * outPackingSize);
+            for (int x = band.x1; x < band.x2; ++x) {
+                const float* src = src_pixels + x * inPackingSize;
+                unsigned short* dst = dst_pixels + x * outPackingSize;
+                float a = premult ? src[args.inAOffset] : 1.f;
+                dst[args.outROffset] = lut->toColorSpaceUint16FromLinearFloatFast(src[args.inROffset] * a);
+                dst[args.outGOffset] = lut->toColorSpaceUint16FromLinearFloatFast(src[args.inGOffset] * a);
+                dst[args.outBOffset] = lut->toColorSpaceUint16FromLinearFloatFast(src[args.inBOffset] * a);
+                if (outputHasAlpha) {
+                    // alpha is linear
+                    dst[args.outAOffset] = floatToInt<65536>(a);
+                }
+            }
+        }
+    }
+};
+
+/// Linear float to float in the Lut color-space, using the transfer function
+struct ToFloatPackedKernel
+{
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void rows(const Lut* lut,
+                     const PackedConversionArgs & args,
+                     const RectI & band)
+    {
+        const int inPackingSize = inputHasAlpha ? 4 : 3;
+        const int outPackingSize = outputHasAlpha ? 4 : 3;
+
+        for (int y = band.y1; y < band.y2; ++y) {
+            int srcY = y;
+            if (args.invertY) {
+                srcY = args.srcBounds.y2 - y - 1;
+            }
+            int dstY = args.dstBounds.y2 - y - 1;
+            const float *src_pixels = (const float*)args.from + (srcY * (args.srcBounds.x2 - args.srcBounds.x1) * inPackingSize);
+            float *dst_pixels = (float*)args.to + (dstY * (args.dstBounds.x2 - args.dstBounds.x1) * outPackingSize);
+            for (int x = band.x1; x < band.x2; ++x) {
+                const float* src = src_pixels + x * inPackingSize;
+                float* dst = dst_pixels + x * outPackingSize;
+                float a = premult ? src[args.inAOffset] : 1.f;
+                dst[args.outROffset] = lut->toColorSpaceFloatFromLinearFloat(src[args.inROffset] * a);
+                dst[args.outGOffset] = lut->toColorSpaceFloatFromLinearFloat(src[args.inGOffset] * a);
+                dst[args.outBOffset] = lut->toColorSpaceFloatFromLinearFloat(src[args.inBOffset] * a);
+                if (outputHasAlpha) {
+                    // alpha is linear and should not be dithered
+                    dst[args.outAOffset] = a;
+                }
+            }
+        }
+    }
+};
+
+/// 8-bit or 16-bit in the Lut color-space to linear float
+static inline float
+fromColorSpaceFast(const Lut* lut,
+                   unsigned char v)
+{
+    return lut->fromColorSpaceUint8ToLinearFloatFast(v);
+}
+
+static inline float
+fromColorSpaceFast(const Lut* lut,
+                   unsigned short v)
+{
+    return lut->fromColorSpaceUint16ToLinearFloatFast(v);
+}
+
+template <typename PIX, int numvals>
+struct FromIntPackedKernel
+{
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void rows(const Lut* lut,
+                     const PackedConversionArgs & args,
+                     const RectI & band)
+    {
+        const int inPackingSize = inputHasAlpha ? 4 : 3;
+        const int outPackingSize = outputHasAlpha ? 4 : 3;
+
+        for (int y = band.y1; y < band.y2; ++y) {
+            int srcY = y;
+            if (args.invertY) {
+                srcY = args.srcBounds.y2 - y - 1;
+            }
+            const PIX *src_pixels = (const PIX*)args.from + (srcY * (args.srcBounds.x2 - args.srcBounds.x1) * inPackingSize);
+            float *dst_pixels = (float*)args.to + (y * (args.dstBounds.x2 - args.dstBounds.x1) * outPackingSize);
+            for (int x = band.x1; x < band.x2; ++x) {
+                const PIX* src = src_pixels + x * inPackingSize;
+                float* dst = dst_pixels + x * outPackingSize;
+                // alpha is linear
+                float a = inputHasAlpha ? Color::intToFloat<numvals>(src[args.inAOffset]) : 1.f;
+                if (premult) {
+                    float rf = 0., gf = 0., bf = 0.;
+                    if (a > 0) {
+                        rf = Color::intToFloat<numvals>(src[args.inROffset]) / a;
+                        gf = Color::intToFloat<numvals>(src[args.inGOffset]) / a;
+                        bf = Color::intToFloat<numvals>(src[args.inBOffset]) / a;
+                    }
+                    // the unpremultiplied values are quantized again to use the look-up tables
+                    dst[args.outROffset] = fromColorSpaceFast( lut, (PIX)Color::floatToInt<numvals>(rf) ) * a;
+                    dst[args.outGOffset] = fromColorSpaceFast( lut, (PIX)Color::floatToInt<numvals>(gf) ) * a;
+                    dst[args.outBOffset] = fromColorSpaceFast( lut, (PIX)Color::floatToInt<numvals>(bf) ) * a;
+                } else {
+                    dst[args.outROffset] = fromColorSpaceFast(lut, src[args.inROffset]);
+                    dst[args.outGOffset] = fromColorSpaceFast(lut, src[args.inGOffset]);
+                    dst[args.outBOffset] = fromColorSpaceFast(lut, src[args.inBOffset]);
+                }
+                if (outputHasAlpha) {
+                    dst[args.outAOffset] = a;
+                }
+            }
+        }
+    }
+};
+
+/// Float in the Lut color-space to linear float, using the transfer function
+struct FromFloatPackedKernel
+{
+    template <bool inputHasAlpha, bool outputHasAlpha, bool premult>
+    static void rows(const Lut* lut,
+                     const PackedConversionArgs & args,
+                     const RectI & band)
+    {
+        const int inPackingSize = inputHasAlpha ? 4 : 3;
+        const int outPackingSize = outputHasAlpha ? 4 : 3;
+
+        for (int y = band.y1; y < band.y2; ++y) {
+            int srcY = y;
+            if (args.invertY) {
+                srcY = args.srcBounds.y2 - y - 1;
+            }
+            const float *src_pixels = (const float*)args.from + (srcY * (args.srcBounds.x2 - args.srcBounds.x1) * inPackingSize);
+            float *dst_pixels = (float*)args.to + (y * (args.dstBounds.x2 - args.dstBounds.x1) * outPackingSize);
+            for (int x = band.x1; x < band.x2; ++x) {
+                const float* src = src_pixels + x * inPackingSize;
+                float* dst = dst_pixels + x * outPackingSize;
+                float a = premult ? src[args.inAOffset] : 1.f;
+                float rf = 0., gf = 0., bf = 0.;
+                if (a > 0.) {
+                    rf = src[args.inROffset] / a;
+                    gf = src[args.inGOffset] / a;
+                    bf = src[args.inBOffset] / a;
+                }
+                dst[args.outROffset] = lut->fromColorSpaceFloatToLinearFloat(rf) * a;
+                dst[args.outGOffset] = lut->fromColorSpaceFloatToLinearFloat(gf) * a;
+                dst[args.outBOffset] = lut->fromColorSpaceFloatToLinearFloat(bf) * a;
+                if (outputHasAlpha) {
+                    // alpha is linear
+                    dst[args.outAOffset] = a;
+                }
+            }
+        }
+    }
+};
+
 #ifdef DEAD_CODE
 void
 Lut::to_byte_planar(unsigned char* to,
@@ -399,20 +759,26 @@ Lut::to_byte_planar(unsigned char* to,
 
 #endif // DEAD_CODE
 
-#ifdef DEAD_CODE
 void
-Lut::to_short_planar(unsigned short* /*to*/,
-                     const float* /*from*/,
-                     int /*W*/,
-                     const float* /*alpha*/,
-                     int /*inDelta*/,
-                     int /*outDelta*/) const
+Lut::to_short_planar(unsigned short* to,
+                     const float* from,
+                     int W,
+                     const float* alpha,
+                     int inDelta,
+                     int outDelta) const
 {
-    throw std::runtime_error("Lut::to_short_planar not implemented yet.");
+    validate();
+    if (!alpha) {
+        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
+            to[t] = toColorSpaceUint16FromLinearFloatFast(from[f]);
+        }
+    } else {
+        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
+            to[t] = toColorSpaceUint16FromLinearFloatFast(from[f] * alpha[f]);
+        }
+    }
 }
 
-#endif // DEAD_CODE
-
 void
 Lut::to_float_planar(float* to,
                      const float* from,
@@ -451,89 +817,37 @@ Lut::to_byte_packed(unsigned char* to,
         return;
     }
 
-
-    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
-    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
-    int inROffset, inGOffset, inBOffset, inAOffset;
-    int outROffset, outGOffset, outBOffset, outAOffset;
-    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
-    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
-
-    int inPackingSize, outPackingSize;
-    inPackingSize = inputHasAlpha ? 4 : 3;
-    outPackingSize = outputHasAlpha ? 4 : 3;
-
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
     validate();
+    convertPackedRows<ToBytePackedKernel>(this, args, rect, inputPacking, outputPacking, premult);
+}
 
-    for (int y = rect.y1; y < rect.y2; ++y) {
-        // coverity[dont_call]
-        int start = rand() % (rect.x2 - rect.x1) + rect.x1;
-        unsigned error_r, error_g, error_b;
-        error_r = error_g = error_b = 0x80;
-        int srcY = y;
-        if (!invertY) {
-            srcY = srcBounds.y2 - y - 1;
-        }
-
+void
+Lut::to_short_packed(unsigned short* to,
+                     const float* from,
+                     const RectI & conversionRect,
+                     const RectI & srcBounds,
+                     const RectI & dstBounds,
+                     PixelPackingEnum inputPacking,
+                     PixelPackingEnum outputPacking,
+                     bool invertY,
+                     bool premult) const
+{
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
 
-        int dstY = dstBounds.y2 - y - 1;
-        const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
-        unsigned char *dst_pixels = to + (dstY * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
-        /* go forwards from starting point to end of line: */
-        for (int x = start; x < rect.x2; ++x) {
-            int inCol = x * inPackingSize;
-            int outCol = x * outPackingSize;
-            float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;
-            error_r = (error_r & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inROffset] * a)];
-            error_g = (error_g & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inGOffset] * a)];
-            error_b = (error_b & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inBOffset] * a)];
-            assert(error_r < 0x10000 && error_g < 0x10000 && error_b < 0x10000);
-            dst_pixels[outCol + outROffset] = (unsigned char)(error_r >> 8);
-            dst_pixels[outCol + outGOffset] = (unsigned char)(error_g >> 8);
-            dst_pixels[outCol + outBOffset] = (unsigned char)(error_b >> 8);
-            if (outputHasAlpha) {
-                // alpha is linear and should not be dithered
-                dst_pixels[outCol + outAOffset] = floatToInt<256>(a);
-            }
-        }
-        /* go backwards from starting point to start of line: */
-        error_r = error_g = error_b = 0x80;
-        for (int x = start - 1; x >= rect.x1; --x) {
-            int inCol = x * inPackingSize;
-            int outCol = x * outPackingSize;
-            float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;
-            error_r = (error_r & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inROffset] * a)];
-            error_g = (error_g & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inGOffset] * a)];
-            error_b = (error_b & 0xff) + toFunc_hipart_to_uint8xx[hipart(src_pixels[inCol + inBOffset] * a)];
-            assert(error_r < 0x10000 && error_g < 0x10000 && error_b < 0x10000);
-            dst_pixels[outCol + outROffset] = (unsigned char)(error_r >> 8);
-            dst_pixels[outCol + outGOffset] = (unsigned char)(error_g >> 8);
-            dst_pixels[outCol + outBOffset] = (unsigned char)(error_b >> 8);
-            if (outputHasAlpha) {
-                // alpha is linear and should not be dithered
-                dst_pixels[outCol + outAOffset] = floatToInt<256>(a);
-            }
-        }
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect, srcBounds) || !clip(&rect, dstBounds) ) {
+        return;
     }
-} // to_byte_packed
 
-#ifdef DEAD_CODE
-void
-Lut::to_short_packed(unsigned short* /*to*/,
-                     const float* /*from*/,
-                     const RectI & /*conversionRect*/,
-                     const RectI & /*srcBounds*/,
-                     const RectI & /*dstBounds*/,
-                     PixelPackingEnum /*inputPacking*/,
-                     PixelPackingEnum /*outputPacking*/,
-                     bool /*invertY*/,
-                     bool /*premult*/) const
-{
-    throw std::runtime_error("Lut::to_short_packed not implemented yet.");
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
+    validate();
+    convertPackedRows<ToShortPackedKernel>(this, args, rect, inputPacking, outputPacking, premult);
 }
 
-#endif // DEAD_CODE
-
 void
 Lut::to_float_packed(float* to,
                      const float* from,
@@ -552,42 +866,9 @@ Lut::to_float_packed(float* to,
         return;
     }
 
-    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
-    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
-    int inROffset, inGOffset, inBOffset, inAOffset;
-    int outROffset, outGOffset, outBOffset, outAOffset;
-    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
-    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
-
-    int inPackingSize, outPackingSize;
-    inPackingSize = inputHasAlpha ? 4 : 3;
-    outPackingSize = outputHasAlpha ? 4 : 3;
-
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
     validate();
-
-    for (int y = rect.y1; y < rect.y2; ++y) {
-        int srcY = y;
-        if (invertY) {
-            srcY = srcBounds.y2 - y - 1;
-        }
-
-        int dstY = dstBounds.y2 - y - 1;
-        const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
-        float *dst_pixels = to + (dstY * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
-        /* go forwards from starting point to end of line: */
-        for (int x = rect.x1; x < rect.x2; ++x) {
-            int inCol = x * inPackingSize;
-            int outCol = x * outPackingSize;
-            float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;;
-            dst_pixels[outCol + outROffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inROffset] * a);
-            dst_pixels[outCol + outGOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inGOffset] * a);
-            dst_pixels[outCol + outBOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inBOffset] * a);
-            if (outputHasAlpha) {
-                // alpha is linear and should not be dithered
-                dst_pixels[outCol + outAOffset] = a;
-            }
-        }
-    }
+    convertPackedRows<ToFloatPackedKernel>(this, args, rect, inputPacking, outputPacking, premult);
 }
 
 void
@@ -611,14 +892,29 @@ Lut::from_byte_planar(float* to,
 }
 
 void
-Lut::from_short_planar(float* /*to*/,
-                       const unsigned short* /*from*/,
-                       int /*W*/,
-                       const unsigned short*/* alpha*/,
-                       int /*inDelta*/,
-                       int /* outDelta*/) const
+Lut::from_short_planar(float* to,
+                       const unsigned short* from,
+                       int W,
+                       const unsigned short* alpha,
+                       int inDelta,
+                       int outDelta) const
 {
-    throw std::runtime_error("Lut::from_short_planar not implemented yet.");
+    validate();
+    if (!alpha) {
+        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
+            to[t] = fromColorSpaceUint16ToLinearFloatFast(from[f]);
+        }
+    } else {
+        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
+            float a = Color::intToFloat<65536>(alpha[f]);
+            if (a <= 0) {
+                to[t] = 0.f;
+            } else {
+                float v = Color::intToFloat<65536>(from[f]) / a;
+                to[t] = fromColorSpaceUint16ToLinearFloatFast( (unsigned short)Color::floatToInt<65536>(v) ) * a;
+            }
+        }
+    }
 }
 
 void
@@ -663,77 +959,36 @@ Lut::from_byte_packed(float* to,
         return;
     }
 
-
-    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
-    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
-    int inROffset, inGOffset, inBOffset, inAOffset;
-    int outROffset, outGOffset, outBOffset, outAOffset;
-    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
-    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
-
-    int inPackingSize, outPackingSize;
-    inPackingSize = inputHasAlpha ? 4 : 3;
-    outPackingSize = outputHasAlpha ? 4 : 3;
-
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
     validate();
-    for (int y = rect.y1; y < rect.y2; ++y) {
-        int srcY = y;
-        if (invertY) {
-            srcY = srcBounds.y2 - y - 1;
-        }
-
-        const unsigned char *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
-        float *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
-        for (int x = rect.x1; x < rect.x2; ++x) {
-            int inCol = x * inPackingSize;
-            int outCol = x * outPackingSize;
-            if (inputHasAlpha && premult) {
-                float rf = 0., gf = 0., bf = 0.;
-                float a = Color::intToFloat<256>(src_pixels[inCol + inAOffset]);
-                if (a > 0) {
-                    rf = Color::intToFloat<256>(src_pixels[inCol + inROffset]) / a;
-                    gf = Color::intToFloat<256>(src_pixels[inCol + inGOffset]) / a;
-                    bf = Color::intToFloat<256>(src_pixels[inCol + inBOffset]) / a;
-                }
-                // we may lose a bit of information, but hey, it's 8-bits anyway, who cares?
-                dst_pixels[outCol + outROffset] = fromColorSpaceUint8ToLinearFloatFast( Color::floatToInt<256>(rf) ) * a;
-                dst_pixels[outCol + outGOffset] = fromColorSpaceUint8ToLinearFloatFast( Color::floatToInt<256>(gf) ) * a;
-                dst_pixels[outCol + outBOffset] = fromColorSpaceUint8ToLinearFloatFast( Color::floatToInt<256>(bf) ) * a;
-                if (outputHasAlpha) {
-                    // alpha is linear
-                    dst_pixels[outCol + outAOffset] = a;
-                }
-            } else {
-                int r8 = 0, g8 = 0, b8 = 0;
-                r8 = src_pixels[inCol + inROffset];
-                g8 = src_pixels[inCol + inGOffset];
-                b8 = src_pixels[inCol + inBOffset];
-                assert(r8 >= 0 && r8 < 256 && g8 >= 0 && g8 < 256 && b8 >= 0 && b8 < 256);
-                dst_pixels[outCol + outROffset] = fromFunc_uint8_to_float[r8];
-                dst_pixels[outCol + outGOffset] = fromFunc_uint8_to_float[g8];
-                dst_pixels[outCol + outBOffset] = fromFunc_uint8_to_float[b8];
-                if (outputHasAlpha) {
-                    // alpha is linear
-                    float a = Color::intToFloat<256>(src_pixels[inCol + inAOffset]);
-                    dst_pixels[outCol + outAOffset] = a;
-                }
-            }
-        }
-    }
-} // from_byte_packed
+    // we may lose a bit of information when unpremultiplying, but hey, it's 8-bits anyway, who cares?
+    convertPackedRows<FromIntPackedKernel<unsigned char, 256> >(this, args, rect, inputPacking, outputPacking, premult);
+}
 
 void
-Lut::from_short_packed(float* /*to*/,
-                       const unsigned short* /*from*/,
-                       const RectI & /*conversionRect*/,
-                       const RectI & /*srcBounds*/,
-                       const RectI & /*dstBounds*/,
-                       PixelPackingEnum /*inputPacking*/,
-                       PixelPackingEnum /*outputPacking*/,
-                       bool /*invertY*/,
-                       bool /*premult*/) const
+Lut::from_short_packed(float* to,
+                       const unsigned short* from,
+                       const RectI & conversionRect,
+                       const RectI & srcBounds,
+                       const RectI & dstBounds,
+                       PixelPackingEnum inputPacking,
+                       PixelPackingEnum outputPacking,
+                       bool invertY,
+                       bool premult) const
 {
-    throw std::runtime_error("Lut::from_short_packed not implemented yet.");
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect, srcBounds) || !clip(&rect, dstBounds) ) {
+        return;
+    }
+
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
+    validate();
+    convertPackedRows<FromIntPackedKernel<unsigned short, 65536> >(this, args, rect, inputPacking, outputPacking, premult);
 }
 
 void
@@ -757,46 +1012,9 @@ Lut::from_float_packed(float* to,
         return;
     }
 
-
-    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
-    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
-    int inROffset, inGOffset, inBOffset, inAOffset;
-    int outROffset, outGOffset, outBOffset, outAOffset;
-    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
-    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
-
-    int inPackingSize, outPackingSize;
-    inPackingSize = inputHasAlpha ? 4 : 3;
-    outPackingSize = outputHasAlpha ? 4 : 3;
-
+    PackedConversionArgs args(from, to, srcBounds, dstBounds, inputPacking, outputPacking, invertY);
     validate();
-
-    for (int y = rect.y1; y < rect.y2; ++y) {
-        int srcY = y;
-        if (invertY) {
-            srcY = srcBounds.y2 - y - 1;
-        }
-        const float *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
-        float *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
-        for (int x = rect.x1; x < rect.x2; ++x) {
-            int inCol = x * inPackingSize;
-            int outCol = x * outPackingSize;
-            float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;;
-            float rf = 0., gf = 0., bf = 0.;
-            if (a > 0.) {
-                rf = src_pixels[inCol + inROffset] / a;
-                gf = src_pixels[inCol + inGOffset] / a;
-                bf = src_pixels[inCol + inBOffset] / a;
-            }
-            dst_pixels[outCol + outROffset] = fromColorSpaceFloatToLinearFloat(rf) * a;
-            dst_pixels[outCol + outGOffset] = fromColorSpaceFloatToLinearFloat(gf) * a;
-            dst_pixels[outCol + outBOffset] = fromColorSpaceFloatToLinearFloat(bf) * a;
-            if (outputHasAlpha) {
-                // alpha is linear
-                dst_pixels[outCol + outAOffset] = a;
-            }
-        }
-    }
+    convertPackedRows<FromFloatPackedKernel>(this, args, rect, inputPacking, outputPacking, premult);
 } // from_float_packed
 
 ///////////////////////
@@ -905,16 +1123,60 @@ from_byte_packed(float *to,
 }
 
 void
-from_short_packed(float */*to*/,
-                  const unsigned short */*from*/,
-                  const RectI & /*rect*/,
-                  const RectI & /*srcRod*/,
-                  const RectI & /*rod*/,
-                  PixelPackingEnum /*inputFormat*/,
-                  PixelPackingEnum /*format*/,
-                  bool /*invertY*/)
-{
-    throw std::runtime_error("Linear::from_short_packed not yet implemented.");
+from_short_packed(float *to,
+                  const unsigned short *from,
+                  const RectI &conversionRect,
+                  const RectI &srcBounds,
+                  const RectI &dstBounds,
+                  PixelPackingEnum inputPacking,
+                  PixelPackingEnum outputPacking,
+                  bool invertY)
+
+{
+    if ( ( inputPacking == ePixelPackingPLANAR) || ( outputPacking == ePixelPackingPLANAR) ) {
+        throw std::runtime_error("Invalid pixel format.");
+    }
+
+    ///clip the conversion rect to srcBounds and dstBounds
+    RectI rect = conversionRect;
+    if ( !clip(&rect, srcBounds) || !clip(&rect, dstBounds) ) {
+        return;
+    }
+
+
+    bool inputHasAlpha = inputPacking == ePixelPackingBGRA || inputPacking == ePixelPackingRGBA;
+    bool outputHasAlpha = outputPacking == ePixelPackingBGRA || outputPacking == ePixelPackingRGBA;
+    int inROffset, inGOffset, inBOffset, inAOffset;
+    int outROffset, outGOffset, outBOffset, outAOffset;
+    getOffsetsForPacking(inputPacking, &inROffset, &inGOffset, &inBOffset, &inAOffset);
+    getOffsetsForPacking(outputPacking, &outROffset, &outGOffset, &outBOffset, &outAOffset);
+
+
+    int inPackingSize, outPackingSize;
+    inPackingSize = inputHasAlpha ? 4 : 3;
+    outPackingSize = outputHasAlpha ? 4 : 3;
+
+
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        int srcY = y;
+        if (invertY) {
+            srcY = srcBounds.y2 - y - 1;
+        }
+        const unsigned short *src_pixels = from + (srcY * (srcBounds.x2 - srcBounds.x1) * inPackingSize);
+        float *dst_pixels = to + (y * (dstBounds.x2 - dstBounds.x1) * outPackingSize);
+        for (int x = rect.x1; x < rect.x2; ++x) {
+            int inCol = x * inPackingSize;
+            int outCol = x * outPackingSize;
+            unsigned short a = inputHasAlpha ? src_pixels[inCol + inAOffset] : 65535;
+            dst_pixels[outCol + outROffset] = Color::intToFloat<65536>(src_pixels[inCol + inROffset]);
+            dst_pixels[outCol + outGOffset] = Color::intToFloat<65536>(src_pixels[inCol + inGOffset]);
+            dst_pixels[outCol + outBOffset] = Color::intToFloat<65536>(src_pixels[inCol + inBOffset]);
+            if (outputHasAlpha) {
+                // alpha is linear
+                dst_pixels[outCol + outAOffset] = Color::intToFloat<65536>(a);
+            }
+        }
+    }
 }
 
 void
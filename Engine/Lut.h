@@ -239,7 +239,7 @@ public:
      * array of destination lut values, with error diffusion to avoid posterizing
      * artifacts.
      *
-     * \a W is the number of pixels to convert.
+     * \a W is the number of elements of the input buffer: W / inDelta pixels are converted.
      * \a inDelta is the distance between the input elements
      * \a outDelta is the distance between the output elements
      * The delta parameters are useful for:
@@ -251,8 +251,8 @@ public:
      **/
     //void to_byte_planar(unsigned char* to, const float* from,int W,const float* alpha = NULL,
     //                    int inDelta = 1, int outDelta = 1) const;
-    //void to_short_planar(unsigned short* to, const float* from,int W,const float* alpha = NULL,
-    //                     int inDelta = 1, int outDelta = 1) const;
+    void to_short_planar(unsigned short* to, const float* from, int W, const float* alpha = NULL,
+                         int inDelta = 1, int outDelta = 1) const;
     void to_float_planar(float* to, const float* from, int W, const float* alpha = NULL,
                          int inDelta = 1, int outDelta = 1) const;
 
@@ -281,13 +281,15 @@ public:
        should be converted with the scan-line (srcRoD.y2 - y - 1) of the
        input buffer.
 
+       Large rectangles are converted by bands of rows in parallel.
+
      **/
     void to_byte_packed(unsigned char* to, const float* from, const RectI & conversionRect,
                         const RectI & srcRoD, const RectI & dstRoD,
                         PixelPackingEnum inputPacking, PixelPackingEnum outputPacking, bool invertY, bool premult) const; // used by QtWriter
-    //void to_short_packed(unsigned short* to, const float* from,const RectI & conversionRect,
-    //                     const RectI & srcRoD,const RectI & dstRoD,
-    //                     PixelPackingEnum inputPacking,PixelPackingEnum outputPacking,bool invertY,bool premult) const;
+    void to_short_packed(unsigned short* to, const float* from, const RectI & conversionRect,
+                         const RectI & srcRoD, const RectI & dstRoD,
+                         PixelPackingEnum inputPacking, PixelPackingEnum outputPacking, bool invertY, bool premult) const;
     void to_float_packed(float* to, const float* from, const RectI & conversionRect,
                          const RectI & srcRoD, const RectI & dstRoD,
                          PixelPackingEnum inputPacking, PixelPackingEnum outputPacking, bool invertY, bool premult) const;
@@ -298,7 +300,7 @@ public:
     /**
      * @brief Convert from a buffer in the input color-space to the output color-space.
      *
-     * \a W is the number of pixels to convert.
+     * \a W is the number of elements of the input buffer: W / inDelta pixels are converted.
      * \a inDelta is the distance between the input elements
      * \a outDelta is the distance between the output elements
      * The delta parameters are useful for:
@@ -2813,6 +2813,11 @@ Node::deactivate(const std::list<NodePtr> & outputsToDisconnect,
         _imp->abortPreview_non_blocking();
     }
 
+    ///The images converted for tracking are kept across track operations, free them
+    if (_imp->trackContext) {
+        _imp->trackContext->clearFrameAccessorCache();
+    }
+
     NodeCollectionPtr parentCol = getGroup();
 
 
@@ -0,0 +1,390 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Engine/NumaInfo.h"
+
+#include <map>
+#include <algorithm> // min, max
+#include <cassert>
+#include <stdexcept>
+
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+#  define NATRON_NUMA_LINUX
+#  include <sched.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+// Memory policy of mbind(2): allocate on the given node if possible, fall back on other nodes otherwise.
+// Defined here to avoid depending on libnuma (numaif.h) at build time.
+#define NATRON_NUMA_MPOL_PREFERRED 1
+
+// Maximum number of nodes handled by the node mask passed to mbind(2)
+#define NATRON_NUMA_MAX_NODES 1024
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct NumaNode
+{
+    // Index of the node as known by the operating system, nodes may not be numbered contiguously
+    int osIndex;
+    std::vector<int> cpus;
+};
+
+struct NumaState
+{
+    QMutex topologyMutex;
+    bool topologyInitialized;
+    std::vector<NumaNode> nodes;
+
+#ifdef NATRON_NUMA_LINUX
+    // Affinity of the process before any thread was bound, restored when a thread is unbound
+    bool hasProcessAffinity;
+    cpu_set_t processAffinity;
+#endif
+
+    // Threads bound to a node, by node index
+    QMutex threadsMutex;
+    std::map<QThread*, int> threadNodes;
+
+    // Number of entries in threadNodes, read without locking so that unbound threads pay nothing
+    QAtomicInt nBoundThreads;
+
+    QMutex memoryMutex;
+    std::vector<NumaNodeMemoryUsage> memory;
+
+    NumaState()
+        : topologyMutex()
+        , topologyInitialized(false)
+        , nodes()
+#ifdef NATRON_NUMA_LINUX
+        , hasProcessAffinity(false)
+        , processAffinity()
+#endif
+        , threadsMutex()
+        , threadNodes()
+        , nBoundThreads()
+        , memoryMutex()
+        , memory()
+    {
+    }
+};
+
+static NumaState numaState;
+
+#ifdef NATRON_NUMA_LINUX
+// Parses a cpu list as found in /sys/devices/system/node/nodeX/cpulist, e.g: "0-7,16-23"
+static void
+parseCpuList(const QString& str,
+             std::vector<int>* cpus)
+{
+    QStringList ranges = str.trimmed().split( QLatin1Char(','), QString::SkipEmptyParts );
+
+    for (QStringList::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        QStringList bounds = it->split( QLatin1Char('-') );
+        bool ok1 = false, ok2 = true;
+        int first = bounds[0].toInt(&ok1);
+        int last = first;
+        if (bounds.size() > 1) {
+            last = bounds[1].toInt(&ok2);
+        }
+        if (!ok1 || !ok2) {
+            continue;
+        }
+        for (int i = first; i <= last; ++i) {
+            cpus->push_back(i);
+        }
+    }
+}
+
+#endif
+
+static const std::vector<NumaNode>&
+getNumaTopology()
+{
+    QMutexLocker k(&numaState.topologyMutex);
+
+    if (numaState.topologyInitialized) {
+        return numaState.nodes;
+    }
+    numaState.topologyInitialized = true;
+
+#ifdef NATRON_NUMA_LINUX
+    // Threads are only bound once the topology is known, so this is the affinity the process was started with
+    CPU_ZERO(&numaState.processAffinity);
+    numaState.hasProcessAffinity = sched_getaffinity(getpid(), sizeof(numaState.processAffinity), &numaState.processAffinity) == 0;
+
+    QDir nodesDir( QString::fromUtf8("/sys/devices/system/node") );
+    QStringList entries = nodesDir.entryList(QStringList( QString::fromUtf8("node*") ), QDir::Dirs | QDir::NoDotAndDotDot);
+    std::map<int, NumaNode> sortedNodes;
+    for (QStringList::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        bool ok = false;
+        int osIndex = it->mid(4).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        QFile cpuListFile( nodesDir.absoluteFilePath(*it) + QString::fromUtf8("/cpulist") );
+        if ( !cpuListFile.open(QIODevice::ReadOnly) ) {
+            continue;
+        }
+        NumaNode node;
+        node.osIndex = osIndex;
+        parseCpuList(QString::fromUtf8( cpuListFile.readAll().constData() ), &node.cpus);
+        // Memory-only nodes cannot run threads
+        if ( !node.cpus.empty() && (osIndex < NATRON_NUMA_MAX_NODES) ) {
+            sortedNodes[osIndex] = node;
+        }
+    }
+    for (std::map<int, NumaNode>::const_iterator it = sortedNodes.begin(); it != sortedNodes.end(); ++it) {
+        numaState.nodes.push_back(it->second);
+    }
+#endif
+
+    if ( numaState.nodes.empty() ) {
+        // Not a NUMA machine or not supported on this system: everything is on a single node
+        NumaNode node;
+        node.osIndex = 0;
+        numaState.nodes.push_back(node);
+    }
+
+    {
+        QMutexLocker k2(&numaState.memoryMutex);
+        numaState.memory.resize( numaState.nodes.size() );
+    }
+
+    return numaState.nodes;
+} // getNumaTopology
+
+static bool
+setCurrentThreadAffinity(const std::vector<int>& cpus)
+{
+#ifdef NATRON_NUMA_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if ( cpus.empty() ) {
+        // Restore the affinity of the process as it was before any thread was bound: the main thread
+        // may itself be bound to a node by now.
+        getNumaTopology();
+        if (!numaState.hasProcessAffinity) {
+            return false;
+        }
+        set = numaState.processAffinity;
+    } else {
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            if (cpus[i] < CPU_SETSIZE) {
+                CPU_SET(cpus[i], &set);
+            }
+        }
+    }
+
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    Q_UNUSED(cpus);
+
+    return false;
+#endif
+}
+
+static int
+getThreadNumaNode(QThread* thread)
+{
+    if ( (int)numaState.nBoundThreads == 0 ) {
+        return -1;
+    }
+    QMutexLocker k(&numaState.threadsMutex);
+    std::map<QThread*, int>::const_iterator found = numaState.threadNodes.find(thread);
+
+    return found == numaState.threadNodes.end() ? -1 : found->second;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
+int
+getNumaNodesCount()
+{
+    return (int)getNumaTopology().size();
+}
+
+bool
+bindCurrentThreadToNumaNode(int node)
+{
+    const std::vector<NumaNode>& nodes = getNumaTopology();
+
+    if ( (node < 0) || ( node >= (int)nodes.size() ) || nodes[node].cpus.empty() ) {
+        return false;
+    }
+    QThread* curThread = QThread::currentThread();
+    if (getThreadNumaNode(curThread) == node) {
+        // Already running on the CPUs of the node
+        return true;
+    }
+    if ( !setCurrentThreadAffinity(nodes[node].cpus) ) {
+        return false;
+    }
+
+    QMutexLocker k(&numaState.threadsMutex);
+    std::pair<std::map<QThread*, int>::iterator, bool> ret = numaState.threadNodes.insert( std::make_pair(curThread, node) );
+    if (ret.second) {
+        numaState.nBoundThreads.fetchAndAddRelaxed(1);
+    } else {
+        ret.first->second = node;
+    }
+
+    return true;
+}
+
+void
+unbindCurrentThreadFromNumaNode()
+{
+    QThread* curThread = QThread::currentThread();
+    {
+        QMutexLocker k(&numaState.threadsMutex);
+        std::map<QThread*, int>::iterator found = numaState.threadNodes.find(curThread);
+        if ( found == numaState.threadNodes.end() ) {
+            return;
+        }
+        numaState.threadNodes.erase(found);
+        numaState.nBoundThreads.fetchAndAddRelaxed(-1);
+    }
+    setCurrentThreadAffinity( std::vector<int>() );
+}
+
+int
+getCurrentThreadNumaNode()
+{
+    return getThreadNumaNode( QThread::currentThread() );
+}
+
+void
+inheritNumaNodeFromThread(QThread* spawnerThread)
+{
+    if ( (int)numaState.nBoundThreads == 0 ) {
+        return;
+    }
+    int spawnerNode, curNode;
+    {
+        QMutexLocker k(&numaState.threadsMutex);
+        std::map<QThread*, int>::const_iterator found = numaState.threadNodes.find(spawnerThread);
+        spawnerNode = found == numaState.threadNodes.end() ? -1 : found->second;
+        found = numaState.threadNodes.find( QThread::currentThread() );
+        curNode = found == numaState.threadNodes.end() ? -1 : found->second;
+    }
+    // This is called each time the thread-local render args are copied: only touch the affinity
+    // when the thread is not already on the node of the spawner thread.
+    if (spawnerNode == curNode) {
+        return;
+    }
+    if (spawnerNode == -1) {
+        unbindCurrentThreadFromNumaNode();
+    } else {
+        bindCurrentThreadToNumaNode(spawnerNode);
+    }
+}
+
+int
+bindMemoryToCurrentThreadNumaNode(void* ptr,
+                                  std::size_t bytes)
+{
+    int node = getCurrentThreadNumaNode();
+
+    if ( (node == -1) || !ptr || (bytes == 0) ) {
+        return -1;
+    }
+
+#if defined(NATRON_NUMA_LINUX) && defined(SYS_mbind)
+    // The buffer may be touched first by threads of the thread-pool running on another node: make sure its pages
+    // land on the node of the render thread that allocated it. mbind requires a page aligned range, pages shared
+    // with other allocations at both ends are left untouched.
+    std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+    std::size_t start = ( (std::size_t)ptr + pageSize - 1 ) & ~(pageSize - 1);
+    std::size_t end = ( (std::size_t)ptr + bytes ) & ~(pageSize - 1);
+    if (end > start) {
+        const int bitsPerLong = (int)sizeof(unsigned long) * 8;
+        unsigned long nodeMask[NATRON_NUMA_MAX_NODES / (sizeof(unsigned long) * 8)] = {0};
+        int osIndex = getNumaTopology()[node].osIndex;
+        nodeMask[osIndex / bitsPerLong] |= 1UL << (osIndex % bitsPerLong);
+        // Failure is not an error: the pages are then simply placed by the first-touch policy
+        syscall(SYS_mbind, (void*)start, end - start, NATRON_NUMA_MPOL_PREFERRED, nodeMask, (unsigned long)NATRON_NUMA_MAX_NODES, 0);
+    }
+#endif
+
+    QMutexLocker k(&numaState.memoryMutex);
+    if ( node >= (int)numaState.memory.size() ) {
+        return -1;
+    }
+    NumaNodeMemoryUsage& usage = numaState.memory[node];
+    usage.current += bytes;
+    usage.peak = std::max(usage.peak, usage.current);
+
+    return node;
+}
+
+void
+notifyNumaMemoryFreed(int node,
+                      std::size_t bytes)
+{
+    if (node < 0) {
+        return;
+    }
+    QMutexLocker k(&numaState.memoryMutex);
+    if ( node >= (int)numaState.memory.size() ) {
+        return;
+    }
+    NumaNodeMemoryUsage& usage = numaState.memory[node];
+    usage.current -= std::min(usage.current, (U64)bytes);
+}
+
+void
+getNumaNodesMemoryUsage(std::vector<NumaNodeMemoryUsage>* usage)
+{
+    // Make sure the topology is known so that all nodes are reported
+    getNumaTopology();
+
+    QMutexLocker k(&numaState.memoryMutex);
+    *usage = numaState.memory;
+}
+
+void
+resetNumaPeakMemoryUsage()
+{
+    getNumaTopology();
+
+    QMutexLocker k(&numaState.memoryMutex);
+    for (std::size_t i = 0; i < numaState.memory.size(); ++i) {
+        numaState.memory[i].peak = numaState.memory[i].current;
+    }
+}
+
+NATRON_NAMESPACE_EXIT
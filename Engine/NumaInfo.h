@@ -0,0 +1,106 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_NumaInfo_h
+#define Engine_NumaInfo_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef> // std::size_t
+#include <vector>
+
+#include "Global/GlobalDefines.h"
+
+class QThread;
+
+NATRON_NAMESPACE_ENTER
+
+// NUMA utility functions (thread and memory placement on multi-socket machines).
+// Placement is only implemented on Linux: on other systems a single node is reported
+// and the binding functions do nothing.
+
+/**
+ * @brief Returns the number of NUMA nodes of the machine, this is at least 1.
+ **/
+int getNumaNodesCount();
+
+/**
+ * @brief Restricts the calling thread to the CPUs of the given node. Images allocated by this thread
+ * afterwards are placed in the memory of that node, @see bindMemoryToCurrentThreadNumaNode.
+ * Returns false if the thread could not be bound.
+ **/
+bool bindCurrentThreadToNumaNode(int node);
+
+/**
+ * @brief Lets the calling thread run on any CPU again.
+ **/
+void unbindCurrentThreadFromNumaNode();
+
+/**
+ * @brief Returns the node the calling thread is bound to, or -1 if it is not bound.
+ **/
+int getCurrentThreadNumaNode();
+
+/**
+ * @brief Binds the calling thread to the node of the given thread, or unbinds it if that thread is not bound.
+ * This is used by threads of the thread-pool processing tiles on behalf of a render thread.
+ **/
+void inheritNumaNodeFromThread(QThread* spawnerThread);
+
+/**
+ * @brief If the calling thread is bound to a node, asks the kernel to place the pages of the given buffer on that
+ * node and accounts the buffer in the memory usage of the node.
+ * Returns the node the buffer was accounted to, or -1. The return value must be passed to notifyNumaMemoryFreed
+ * when the buffer is freed.
+ **/
+int bindMemoryToCurrentThreadNumaNode(void* ptr, std::size_t bytes);
+
+void notifyNumaMemoryFreed(int node, std::size_t bytes);
+
+struct NumaNodeMemoryUsage
+{
+    U64 current;
+    U64 peak;
+
+    NumaNodeMemoryUsage()
+        : current(0)
+        , peak(0)
+    {
+    }
+};
+
+/**
+ * @brief Returns for each node the memory held by buffers allocated by threads bound to that node.
+ **/
+void getNumaNodesMemoryUsage(std::vector<NumaNodeMemoryUsage>* usage);
+
+/**
+ * @brief Resets the peak memory usage of each node to its current usage.
+ **/
+void resetNumaPeakMemoryUsage();
+
+NATRON_NAMESPACE_EXIT
+
+#endif // ifndef Engine_NumaInfo_h
@@ -827,6 +827,14 @@ OfxEffectInstance::isReader() const
     return _imp->context == eContextReader;
 }
 
+bool
+OfxEffectInstance::isOutputConstant() const
+{
+    std::string pluginID = getPluginID();
+
+    return pluginID == PLUGINID_OFX_CONSTANT || pluginID == PLUGINID_OFX_SOLID;
+}
+
 bool
 OfxEffectInstance::isVideoReader() const
 {
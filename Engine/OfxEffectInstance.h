@@ -144,6 +144,7 @@ public:
     virtual bool isVideoWriter() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isOutput() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isFilter() const OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual bool isOutputConstant() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isTrackerNodePlugin() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isOpenFX() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
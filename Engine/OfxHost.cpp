@@ -1214,6 +1214,7 @@ threadFunctionWrapper(OfxThreadFunctionV1 func,
                       unsigned int threadIndex,
                       unsigned int threadMax,
                       QThread* spawnerThread,
+                      const EffectInstancePtr& effect,
                       void *customArg)
 {
 #ifdef DEBUG
@@ -1231,12 +1232,15 @@ threadFunctionWrapper(OfxThreadFunctionV1 func,
     }
 
     OfxStatus ret = kOfxStatOK;
-    try {
-        func(threadIndex, threadMax, customArg);
-    } catch (const std::bad_alloc & ba) {
-        ret =  kOfxStatErrMemory;
-    } catch (...) {
-        ret =  kOfxStatFailed;
+    // If the render was aborted while this thread was waiting to start, skip its work: the result is discarded anyway
+    if ( !effect || !effect->aborted() ) {
+        try {
+            func(threadIndex, threadMax, customArg);
+        } catch (const std::bad_alloc & ba) {
+            ret =  kOfxStatErrMemory;
+        } catch (...) {
+            ret =  kOfxStatFailed;
+        }
     }
 
     ///reset back the index otherwise it could mess up the indexes if the same thread is re-used
@@ -1258,6 +1262,7 @@ public:
               unsigned int threadIndex,
               unsigned int threadMax,
               QThread* spawnerThread,
+              const EffectInstancePtr& effect,
               void *customArg,
               OfxStatus *stat)
         : QThread()
@@ -1266,6 +1271,7 @@ public:
         , _threadIndex(threadIndex)
         , _threadMax(threadMax)
         , _spawnerThread(spawnerThread)
+        , _effect(effect)
         , _customArg(customArg)
         , _stat(stat)
     {
@@ -1286,12 +1292,17 @@ public:
         appPTR->getAppTLS()->softCopy(_spawnerThread, this);
 
         assert(*_stat == kOfxStatFailed);
-        try {
-            _func(_threadIndex, _threadMax, _customArg);
+        if ( _effect && _effect->aborted() ) {
+            // The render was aborted before this thread started, the result is discarded anyway
             *_stat = kOfxStatOK;
-        } catch (const std::bad_alloc & ba) {
-            *_stat = kOfxStatErrMemory;
-        } catch (...) {
+        } else {
+            try {
+                _func(_threadIndex, _threadMax, _customArg);
+                *_stat = kOfxStatOK;
+            } catch (const std::bad_alloc & ba) {
+                *_stat = kOfxStatErrMemory;
+            } catch (...) {
+            }
         }
 
         ///reset back the index otherwise it could mess up the indexes if the same thread is re-used
@@ -1305,6 +1316,7 @@ private:
     unsigned int _threadIndex;
     unsigned int _threadMax;
     QThread* _spawnerThread;
+    EffectInstancePtr _effect;
     void *_customArg;
     OfxStatus *_stat;
 };
@@ -1354,6 +1366,15 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
     QThread* spawnerThread = QThread::currentThread();
     bool useThreadPool = appPTR->getUseThreadPool();
 
+    // The effect whose action called multiThread, used to stop the threads that did not start yet when its render is aborted
+    EffectInstancePtr effect;
+    {
+        OfxHostDataTLSPtr tls = _imp->tlsData->getTLSData();
+        if (tls && tls->lastEffectCallingMainEntry) {
+            effect = tls->lastEffectCallingMainEntry->getOfxEffectInstance();
+        }
+    }
+
     if (useThreadPool) {
         std::vector<unsigned int> threadIndexes(nThreads);
         for (unsigned int i = 0; i < nThreads; ++i) {
@@ -1362,7 +1383,7 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
 
         /// DON'T set the maximum thread count, this is a global application setting, and see the documentation excerpt above
         //QThreadPool::globalInstance()->setMaxThreadCount(nThreads);
-        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(threadFunctionWrapper, func, _1, nThreads, spawnerThread, customArg) );
+        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(threadFunctionWrapper, func, _1, nThreads, spawnerThread, effect, customArg) );
         future.waitForFinished();
         ///DON'T reset back to the original value the maximum thread count
         //QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
@@ -1380,7 +1401,7 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
             // at most maxConcurrentThread should be running at the same time
             QVector<OfxThread*> threads(nThreads);
             for (unsigned int i = 0; i < nThreads; ++i) {
-                threads[i] = new OfxThread(func, i, nThreads, spawnerThread, customArg, &status[i]);
+                threads[i] = new OfxThread(func, i, nThreads, spawnerThread, effect, customArg, &status[i]);
             }
             unsigned int i = 0; // index of next thread to launch
             unsigned int running = 0; // number of running threads
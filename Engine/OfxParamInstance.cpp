@@ -48,12 +48,14 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/KnobFactory.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/KnobsSnapshot.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxClipInstance.h"
 #include "Engine/OfxImageEffectInstance.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/Curve.h"
 #include "Engine/OfxOverlayInteract.h"
+#include "Engine/ParallelRenderArgs.h"
 #include "Engine/Format.h"
 #include "Engine/Project.h"
 #include "Engine/AppInstance.h"
@@ -81,6 +83,92 @@ struct OfxKeyFrames_compare
 
 typedef std::set<double, OfxKeyFrames_compare> OfxKeyFramesSet;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Returns the snapshot of the parameters made for the render running on this thread, if any.
+ **/
+static KnobsSnapshotPtr
+getRenderKnobsSnapshot(const KnobI* knob)
+{
+    EffectInstance* effect = dynamic_cast<EffectInstance*>( knob->getHolder() );
+
+    if (!effect) {
+        return KnobsSnapshotPtr();
+    }
+    ParallelRenderArgsPtr frameArgs = effect->getParallelRenderArgsTLS();
+
+    return frameArgs ? frameArgs->knobsSnapshot : KnobsSnapshotPtr();
+}
+
+/**
+ * @brief Reads the value of the knob from the render snapshot without locking the knob,
+ * or from the knob itself if the dimension was not captured.
+ **/
+template <typename KNOB>
+typename KNOB::DataType
+getKnobValue(const boost::shared_ptr<KNOB>& knob,
+             int dimension = 0)
+{
+    KnobsSnapshotPtr snapshot = getRenderKnobsSnapshot( knob.get() );
+    double value;
+
+    if ( snapshot && snapshot->getValue(knob.get(), dimension, &value) ) {
+        return (typename KNOB::DataType)value;
+    }
+
+    return knob->getValue(dimension);
+}
+
+template <typename KNOB>
+typename KNOB::DataType
+getKnobValueAtTime(const boost::shared_ptr<KNOB>& knob,
+                   double time,
+                   int dimension = 0)
+{
+    KnobsSnapshotPtr snapshot = getRenderKnobsSnapshot( knob.get() );
+    double value;
+
+    if ( snapshot && snapshot->getValueAtTime(knob.get(), dimension, time, &value) ) {
+        return (typename KNOB::DataType)value;
+    }
+
+    return knob->getValueAtTime(time, dimension);
+}
+
+template <typename KNOB>
+std::string
+getKnobStringValue(const boost::shared_ptr<KNOB>& knob)
+{
+    KnobsSnapshotPtr snapshot = getRenderKnobsSnapshot( knob.get() );
+    std::string value;
+
+    if ( snapshot && snapshot->getStringValue(knob.get(), 0, &value) ) {
+        return value;
+    }
+
+    return knob->getValue();
+}
+
+template <typename KNOB>
+std::string
+getKnobStringValueAtTime(const boost::shared_ptr<KNOB>& knob,
+                         double time)
+{
+    KnobsSnapshotPtr snapshot = getRenderKnobsSnapshot( knob.get() );
+    std::string value;
+
+    // Animated strings are not captured: a captured string has the same value at any time
+    if ( snapshot && snapshot->getStringValue(knob.get(), 0, &value) ) {
+        return value;
+    }
+
+    return knob->getValueAtTime(time);
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
 static void
 getOfxKeyFrames(KnobI* knob,
                 OfxKeyFramesSet &keyframes,
@@ -711,7 +799,7 @@ OfxIntegerInstance::get(int & v)
 {
     KnobIntPtr knob = _knob.lock();
 
-    v = knob->getValue();
+    v = getKnobValue(knob);
 
     return kOfxStatOK;
 }
@@ -722,7 +810,7 @@ OfxIntegerInstance::get(OfxTime time,
 {
     KnobIntPtr knob = _knob.lock();
 
-    v = knob->getValueAtTime(time);
+    v = getKnobValueAtTime(knob, time);
 
     return kOfxStatOK;
 }
@@ -987,7 +1075,7 @@ OfxDoubleInstance::get(double & v)
 {
     KnobDoublePtr knob = _knob.lock();
 
-    v = knob->getValue();
+    v = getKnobValue(knob);
 
     return kOfxStatOK;
 }
@@ -998,7 +1086,7 @@ OfxDoubleInstance::get(OfxTime time,
 {
     KnobDoublePtr knob = _knob.lock();
 
-    v = knob->getValueAtTime(time);
+    v = getKnobValueAtTime(knob, time);
 
     return kOfxStatOK;
 }
@@ -1248,7 +1336,7 @@ OfxBooleanInstance::get(bool & b)
 {
     KnobBoolPtr knob = _knob.lock();
 
-    b = knob->getValue();
+    b = getKnobValue(knob);
 
     return kOfxStatOK;
 }
@@ -1259,7 +1347,7 @@ OfxBooleanInstance::get(OfxTime time,
 {
     assert( KnobBool::canAnimateStatic() );
     KnobBoolPtr knob = _knob.lock();
-    b = knob->getValueAtTime(time);
+    b = getKnobValueAtTime(knob, time);
 
     return kOfxStatOK;
 }
@@ -1480,7 +1568,7 @@ OfxChoiceInstance::get(int & v)
 {
     KnobChoicePtr knob = _knob.lock();
 
-    v = knob->getValue();
+    v = getKnobValue(knob);
 
     return kOfxStatOK;
 }
@@ -1491,7 +1579,7 @@ OfxChoiceInstance::get(OfxTime time,
 {
     assert( KnobChoice::canAnimateStatic() );
     KnobChoicePtr knob = _knob.lock();
-    v = knob->getValueAtTime(time);
+    v = getKnobValueAtTime(knob, time);
 
     return kOfxStatOK;
 }
@@ -1770,10 +1858,10 @@ OfxRGBAInstance::get(double & r,
 {
     KnobColorPtr color = _knob.lock();
 
-    r = color->getValue(0);
-    g = color->getValue(1);
-    b = color->getValue(2);
-    a = color->getValue(3);
+    r = getKnobValue(color, 0);
+    g = getKnobValue(color, 1);
+    b = getKnobValue(color, 2);
+    a = getKnobValue(color, 3);
 
     return kOfxStatOK;
 }
@@ -1787,10 +1875,10 @@ OfxRGBAInstance::get(OfxTime time,
 {
     KnobColorPtr color = _knob.lock();
 
-    r = color->getValueAtTime( time, 0, ViewSpec::current() );
-    g = color->getValueAtTime( time, 1, ViewSpec::current() );
-    b = color->getValueAtTime( time, 2, ViewSpec::current() );
-    a = color->getValueAtTime( time, 3, ViewSpec::current() );
+    r = getKnobValueAtTime(color, time, 0);
+    g = getKnobValueAtTime(color, time, 1);
+    b = getKnobValueAtTime(color, time, 2);
+    a = getKnobValueAtTime(color, time, 3);
 
     return kOfxStatOK;
 }
@@ -2085,9 +2173,9 @@ OfxRGBInstance::get(double & r,
 {
     KnobColorPtr color = _knob.lock();
 
-    r = color->getValue(0);
-    g = color->getValue(1);
-    b = color->getValue(2);
+    r = getKnobValue(color, 0);
+    g = getKnobValue(color, 1);
+    b = getKnobValue(color, 2);
 
     return kOfxStatOK;
 }
@@ -2100,9 +2188,9 @@ OfxRGBInstance::get(OfxTime time,
 {
     KnobColorPtr color = _knob.lock();
 
-    r = color->getValueAtTime(time, 0);
-    g = color->getValueAtTime(time, 1);
-    b = color->getValueAtTime(time, 2);
+    r = getKnobValueAtTime(color, time, 0);
+    g = getKnobValueAtTime(color, time, 1);
+    b = getKnobValueAtTime(color, time, 2);
 
     return kOfxStatOK;
 }
@@ -2465,8 +2553,8 @@ OfxDouble2DInstance::get(double & x1,
 {
     KnobDoublePtr dblKnob = _knob.lock();
 
-    x1 = dblKnob->getValue(_startIndex);
-    x2 = dblKnob->getValue(_startIndex + 1);
+    x1 = getKnobValue(dblKnob, _startIndex);
+    x2 = getKnobValue(dblKnob, _startIndex + 1);
 
     return kOfxStatOK;
 }
@@ -2478,8 +2566,8 @@ OfxDouble2DInstance::get(OfxTime time,
 {
     KnobDoublePtr dblKnob = _knob.lock();
 
-    x1 = dblKnob->getValueAtTime(time, _startIndex);
-    x2 = dblKnob->getValueAtTime(time, _startIndex + 1);
+    x1 = getKnobValueAtTime(dblKnob, time, _startIndex);
+    x2 = getKnobValueAtTime(dblKnob, time, _startIndex + 1);
 
     return kOfxStatOK;
 }
@@ -2789,8 +2877,8 @@ OfxInteger2DInstance::get(int & x1,
 {
     KnobIntPtr iKnob = _knob.lock();
 
-    x1 = iKnob->getValue(_startIndex);
-    x2 = iKnob->getValue(_startIndex + 1);
+    x1 = getKnobValue(iKnob, _startIndex);
+    x2 = getKnobValue(iKnob, _startIndex + 1);
 
     return kOfxStatOK;
 }
@@ -2802,8 +2890,8 @@ OfxInteger2DInstance::get(OfxTime time,
 {
     KnobIntPtr iKnob = _knob.lock();
 
-    x1 = iKnob->getValueAtTime(time, _startIndex);
-    x2 = iKnob->getValueAtTime(time, _startIndex + 1);
+    x1 = getKnobValueAtTime(iKnob, time, _startIndex);
+    x2 = getKnobValueAtTime(iKnob, time, _startIndex + 1);
 
     return kOfxStatOK;
 }
@@ -3082,9 +3170,9 @@ OfxDouble3DInstance::get(double & x1,
 {
     KnobDoublePtr knob = _knob.lock();
 
-    x1 = knob->getValue(0 + _startIndex);
-    x2 = knob->getValue(1 + _startIndex);
-    x3 = knob->getValue(2 + _startIndex);
+    x1 = getKnobValue(knob, 0 + _startIndex);
+    x2 = getKnobValue(knob, 1 + _startIndex);
+    x3 = getKnobValue(knob, 2 + _startIndex);
 
     return kOfxStatOK;
 }
@@ -3097,9 +3185,9 @@ OfxDouble3DInstance::get(OfxTime time,
 {
     KnobDoublePtr knob = _knob.lock();
 
-    x1 = knob->getValueAtTime(time, 0 + _startIndex);
-    x2 = knob->getValueAtTime(time, 1 + _startIndex);
-    x3 = knob->getValueAtTime(time, 2 + _startIndex);
+    x1 = getKnobValueAtTime(knob, time, 0 + _startIndex);
+    x2 = getKnobValueAtTime(knob, time, 1 + _startIndex);
+    x3 = getKnobValueAtTime(knob, time, 2 + _startIndex);
 
     return kOfxStatOK;
 }
@@ -3389,9 +3477,9 @@ OfxInteger3DInstance::get(int & x1,
 {
     KnobIntPtr knob = _knob.lock();
 
-    x1 = knob->getValue(0);
-    x2 = knob->getValue(1);
-    x3 = knob->getValue(2);
+    x1 = getKnobValue(knob, 0);
+    x2 = getKnobValue(knob, 1);
+    x3 = getKnobValue(knob, 2);
 
     return kOfxStatOK;
 }
@@ -3404,9 +3492,9 @@ OfxInteger3DInstance::get(OfxTime time,
 {
     KnobIntPtr knob = _knob.lock();
 
-    x1 = knob->getValueAtTime(time, 0);
-    x2 = knob->getValueAtTime(time, 1);
-    x3 = knob->getValueAtTime(time, 2);
+    x1 = getKnobValueAtTime(knob, time, 0);
+    x2 = getKnobValueAtTime(knob, time, 1);
+    x3 = getKnobValueAtTime(knob, time, 2);
 
     return kOfxStatOK;
 }
@@ -3912,9 +4000,9 @@ OfxStringInstance::get(std::string &str)
         str = outputFileKnob->generateFileNameAtTime( outputFileKnob->getCurrentTime(), outputFileKnob->getCurrentView() ).toStdString();
         projectEnvVar_getProxy(str);
     } else if (strknob) {
-        str = strknob->getValue();
+        str = getKnobStringValue(strknob);
     } else if (pathKnob) {
-        str = pathKnob->getValue();
+        str = getKnobStringValue(pathKnob);
         projectEnvVar_getProxy(str);
     }
 
@@ -3937,9 +4025,9 @@ OfxStringInstance::get(OfxTime time,
         str = outputFileKnob->generateFileNameAtTime( std::floor(time + 0.5), outputFileKnob->getCurrentView() ).toStdString();
         projectEnvVar_getProxy(str);
     } else if (strknob) {
-        str = strknob->getValueAtTime( std::floor(time + 0.5) );
+        str = getKnobStringValueAtTime(strknob, std::floor(time + 0.5) );
     } else if (pathKnob) {
-        str = pathKnob->getValueAtTime( std::floor(time + 0.5) );
+        str = getKnobStringValueAtTime(pathKnob, std::floor(time + 0.5) );
         projectEnvVar_getProxy(str);
     }
 
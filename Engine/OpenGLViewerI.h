@@ -97,6 +97,12 @@ public:
      **/
     virtual RectD getUserRegionOfInterest() const = 0;
 
+    /**
+     * @brief Returns in canonical coordinates the point of the image the user is looking at: the cursor if it is
+     * over the viewer, otherwise the center of the viewport. This may be called from any thread.
+     **/
+    virtual void getRenderFocusPoint(double* x, double* y) const = 0;
+
     /**
      * @brief Should clear any partial texture overlayed previously transferred with transferBufferFromRAMtoGPU
      **/
@@ -52,13 +52,17 @@
 #include "Engine/AbortableRenderInfo.h"
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AsyncWriteQueue.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
 #include "Engine/KnobFile.h"
+#include "Engine/MemoryInfo.h"
 #include "Engine/Node.h"
+#include "Engine/NumaInfo.h"
 #include "Engine/OpenGLViewerI.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
 #include "Engine/Project.h"
+#include "Engine/ReadNodePrefetcher.h"
 #include "Engine/RenderStats.h"
 #include "Engine/RotoContext.h"
 #include "Engine/Settings.h"
@@ -91,6 +95,18 @@
 
 #define NATRON_SCHEDULER_ABORT_AFTER_X_UNSUCCESSFUL_ITERATIONS 5000
 
+// Number of I/O threads used by the asynchronous write queue when the user setting is 0 ("guess")
+#define NATRON_ASYNC_WRITE_DEFAULT_N_THREADS 2
+
+// Fraction of the RAM cache budget that images waiting in the asynchronous write queue may hold
+#define NATRON_ASYNC_WRITE_QUEUE_MAX_CACHE_FRACTION 0.25
+
+// Number of I/O threads decoding Read nodes ahead of the render
+#define NATRON_READ_PREFETCH_N_THREADS 2
+
+// Maximum number of frames decoded ahead of the render, the memory budget usually kicks-in before
+#define NATRON_READ_PREFETCH_MAX_FRAMES_AHEAD 24
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -133,6 +149,7 @@ struct RenderThread
 {
     RenderThreadTask* thread;
     bool active;
+    int numaNode; // -1 if the thread is not bound to a NUMA node
 };
 
 typedef std::list<RenderThread> RenderThreads;
@@ -243,6 +260,9 @@ struct OutputSchedulerThreadPrivate
     QMutex bufferedOutputMutex;
     int lastBufferedOutputSize;
 
+    // Decodes Read nodes upstream ahead of the render
+    boost::scoped_ptr<ReadNodePrefetcher> readPrefetcher;
+
 
     OutputSchedulerThreadPrivate(RenderEngine* engine,
                                  const OutputEffectInstancePtr& effect,
@@ -282,6 +302,7 @@ struct OutputSchedulerThreadPrivate
 #endif
         , bufferedOutputMutex()
         , lastBufferedOutputSize(0)
+        , readPrefetcher( new ReadNodePrefetcher() )
     {
     }
 
@@ -391,6 +412,11 @@ struct OutputSchedulerThreadPrivate
         RenderThread r;
         r.thread = runnable;
         r.active = true;
+        r.numaNode = -1;
+#ifndef NATRON_PLAYBACK_USES_THREAD_POOL
+        r.numaNode = pickNumaNodeForNewThread();
+        runnable->setNumaNode(r.numaNode);
+#endif
         renderThreads.push_back(r);
 #ifndef NATRON_PLAYBACK_USES_THREAD_POOL
         runnable->start();
@@ -399,6 +425,30 @@ struct OutputSchedulerThreadPrivate
 #endif
     }
 
+#ifndef NATRON_PLAYBACK_USES_THREAD_POOL
+    /**
+     * @brief In NUMA-aware mode, returns the node running the least parallel renders, otherwise -1
+     **/
+    int pickNumaNodeForNewThread() const
+    {
+        ///Private shouldn't lock
+        assert( !renderThreadsMutex.tryLock() );
+        int nNodes = getNumaNodesCount();
+        if ( (nNodes <= 1) || !appPTR->getCurrentSettings()->isNumaAwareRenderingEnabled() ) {
+            return -1;
+        }
+        std::vector<int> nThreadsPerNode(nNodes, 0);
+        for (RenderThreads::const_iterator it = renderThreads.begin(); it != renderThreads.end(); ++it) {
+            if ( (it->numaNode >= 0) && (it->numaNode < nNodes) ) {
+                ++nThreadsPerNode[it->numaNode];
+            }
+        }
+
+        return (int)( std::min_element( nThreadsPerNode.begin(), nThreadsPerNode.end() ) - nThreadsPerNode.begin() );
+    }
+
+#endif
+
     RenderThreads::iterator getRunnableIterator(RenderThreadTask* runnable)
     {
         ///Private shouldn't lock
@@ -844,6 +894,11 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread,
         }
     }
 
+    ///The prefetch window follows the frames picked by the render threads
+    if (gotFrame) {
+        _imp->readPrefetcher->notifyFrameReached(frame);
+    }
+
     // thread is quitting, make sure we notified the application it is no longer running
     if (!gotFrame) {
         thread->notifyIsRunning(false);
@@ -1057,6 +1112,28 @@ OutputSchedulerThread::startRender()
     ///Notify everyone that the render is started
     _imp->engine->s_renderStarted(forward);
 
+    ///Start decoding the Read nodes upstream ahead of the render
+    double prefetchCacheShare = appPTR->getCurrentSettings()->getReadPrefetchCachePercent();
+    if (prefetchCacheShare > 0.) {
+        ReadNodePrefetchArgs prefetchArgs;
+        ReadNodePrefetcher::getReadersUpstream(_imp->outputEffect.lock()->getNode(), &prefetchArgs.readers);
+        if ( !prefetchArgs.readers.empty() ) {
+            prefetchArgs.currentFrame = startingFrame;
+            prefetchArgs.firstFrame = firstFrame;
+            prefetchArgs.lastFrame = lastFrame;
+            prefetchArgs.frameStep = frameStep;
+            prefetchArgs.direction = args->pushTimelineDirection;
+            prefetchArgs.loop = _imp->engine->getPlaybackMode() == ePlaybackModeLoop;
+            prefetchArgs.mipMapLevel = getReadPrefetchMipMapLevel();
+            prefetchArgs.views = args->viewsToRender;
+            prefetchArgs.nThreads = NATRON_READ_PREFETCH_N_THREADS;
+            prefetchArgs.maxFramesAhead = NATRON_READ_PREFETCH_MAX_FRAMES_AHEAD;
+            U64 cacheBudget = (U64)( getSystemTotalRAM() * appPTR->getCurrentSettings()->getRamMaximumPercent() );
+            prefetchArgs.maxBytes = (U64)(cacheBudget * prefetchCacheShare);
+            _imp->readPrefetcher->start(prefetchArgs);
+        }
+    }
+
 #ifndef NATRON_PLAYBACK_USES_THREAD_POOL
     int nThreads;
     {
@@ -1139,6 +1216,9 @@ OutputSchedulerThread::stopRender()
 {
     _imp->timer.playState = ePlayStatePause;
 
+    ///Abort frames being decoded ahead, they are no longer relevant (e.g: the user seeked)
+    _imp->readPrefetcher->cancel();
+
 #ifdef NATRON_SCHEDULER_SPAWN_THREADS_WITH_TIMER
     QMutexLocker k(&_imp->lastRecordedFPSMutex);
     _imp->lastRecordedFPS = _imp->timer.getActualFrameRate();
@@ -1161,6 +1241,8 @@ OutputSchedulerThread::stopRender()
 #endif
     _imp->waitForRenderThreadsToQuit();
 
+    onRenderThreadsQuit( isBeingAborted() );
+
     ///If the output effect is sequential (only WriteFFMPEG for now)
     EffectInstancePtr effect = _imp->outputEffect.lock();
     WriteNode* isWriteNode = dynamic_cast<WriteNode*>( effect.get() );
@@ -1986,6 +2068,7 @@ struct RenderThreadTaskPrivate
     bool hasQuit;
     QMutex runningMutex;
     bool running;
+    int numaNode;
 #else
     int time;
     bool useRenderStats;
@@ -2010,6 +2093,7 @@ struct RenderThreadTaskPrivate
         , hasQuit(false)
         , runningMutex()
         , running(false)
+        , numaNode(-1)
 #else
         , time(time)
         , useRenderStats(useRenderStats)
@@ -2057,6 +2141,10 @@ RenderThreadTask::run()
 #ifndef NATRON_PLAYBACK_USES_THREAD_POOL
     notifyIsRunning(true);
 
+    if (_imp->numaNode != -1) {
+        bindCurrentThreadToNumaNode(_imp->numaNode);
+    }
+
     for (;; ) {
         bool enableRenderStats;
         std::vector<ViewIdx> viewsToRender;
@@ -2078,6 +2166,10 @@ RenderThreadTask::run()
         }
     }
 
+    if (_imp->numaNode != -1) {
+        unbindCurrentThreadFromNumaNode();
+    }
+
     {
         QMutexLocker l(&_imp->mustQuitMutex);
         _imp->hasQuit = true;
@@ -2130,6 +2222,18 @@ RenderThreadTask::notifyIsRunning(bool running)
     appPTR->fetchAndAddNRunningThreads(running ? 1 : -1);
 }
 
+void
+RenderThreadTask::setNumaNode(int node)
+{
+    _imp->numaNode = node;
+}
+
+int
+RenderThreadTask::getNumaNode() const
+{
+    return _imp->numaNode;
+}
+
 #endif
 
 ////////////////////////////////////////////////////////////
@@ -2143,12 +2247,14 @@ DefaultScheduler::DefaultScheduler(RenderEngine* engine,
     , _effect(effect)
     , _currentTimeMutex()
     , _currentTime(0)
+    , _writeQueue( new AsyncWriteQueue(this) )
 {
     engine->setPlaybackMode(ePlaybackModeOnce);
 }
 
 DefaultScheduler::~DefaultScheduler()
 {
+    _writeQueue->stop(true);
 }
 
 class DefaultRenderFrameRunnable
@@ -2271,6 +2377,20 @@ private:
             const bool isRenderDueToRenderInteraction = false;
             const bool isSequentialRender = true;
 
+            // When the asynchronous write queue is enabled, this thread only renders the input of the Writer:
+            // the Writer itself is called by the I/O threads of the queue so that we can start rendering the next frame
+            // while this one is being encoded and written.
+            DefaultScheduler* isDefaultScheduler = dynamic_cast<DefaultScheduler*>(_imp->scheduler);
+            EffectInstancePtr writerInput = activeInputToRender->getInput(0);
+            AsyncWriteFramePtr asyncFrame;
+            if ( isDefaultScheduler && writerInput && isDefaultScheduler->isAsyncWriteEnabled() ) {
+                asyncFrame = boost::make_shared<AsyncWriteFrame>();
+                asyncFrame->time = time;
+                asyncFrame->writer = activeInputToRender;
+                asyncFrame->viewsToRender = viewsToRender;
+                asyncFrame->stats = stats;
+            }
+
             for (std::size_t view = 0; view < viewsToRender.size(); ++view) {
                 StatusEnum stat = activeInputToRender->getRegionOfDefinition_public(activeInputToRenderHash, time, scale, viewsToRender[view], &rod, &isProjectFormat);
                 if (stat == eStatusFailed) {
@@ -2334,6 +2454,49 @@ private:
                     }
                     frameRenderArgs.updateNodesRequest(request);
                 }
+
+                if (asyncFrame) {
+                    std::list<ImagePlaneDesc> inputComponents;
+                    EffectInstance::ComponentsNeededMap::iterator foundInput = neededComps.find(0);
+                    if ( foundInput != neededComps.end() ) {
+                        inputComponents = foundInput->second;
+                    }
+                    RenderingFlagSetter flagIsRendering( writerInput->getNode() );
+                    std::map<ImagePlaneDesc, ImagePtr> inputPlanes;
+                    boost::scoped_ptr<EffectInstance::RenderRoIArgs> inputArgs( new EffectInstance::RenderRoIArgs(time,
+                                                                                                                  scale,
+                                                                                                                  mipMapLevel,
+                                                                                                                  viewsToRender[view],
+                                                                                                                  false,
+                                                                                                                  renderWindow,
+                                                                                                                  RectD(),
+                                                                                                                  inputComponents,
+                                                                                                                  activeInputToRender->getBitDepth(0),
+                                                                                                                  false,
+                                                                                                                  activeInputToRender.get(),
+                                                                                                                  eStorageModeRAM,
+                                                                                                                  time) );
+                    EffectInstance::RenderRoIRetCode retCode = writerInput->renderRoI(*inputArgs, &inputPlanes);
+                    if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
+                        if (retCode == EffectInstance::eRenderRoIRetCodeAborted) {
+                            _imp->scheduler->notifyRenderFailure("Render aborted");
+                        } else {
+                            _imp->scheduler->notifyRenderFailure("Error caught while rendering");
+                        }
+
+                        return;
+                    }
+
+                    AsyncWriteFrameView& frameView = asyncFrame->views[viewsToRender[view]];
+                    frameView.rod = rod;
+                    frameView.renderWindow = renderWindow;
+                    frameView.components = components;
+                    for (std::map<ImagePlaneDesc, ImagePtr>::iterator it = inputPlanes.begin(); it != inputPlanes.end(); ++it) {
+                        frameView.inputPlanes.push_back(it->second);
+                    }
+                    continue;
+                }
+
                 RenderingFlagSetter flagIsRendering( activeInputToRender->getNode() );
                 std::map<ImagePlaneDesc, ImagePtr> planes;
                 boost::scoped_ptr<EffectInstance::RenderRoIArgs> renderArgs( new EffectInstance::RenderRoIArgs(time, //< the time at which to render
@@ -2370,6 +2533,12 @@ private:
                 _imp->scheduler->notifyFrameRendered(time, viewsToRender[view], viewsToRender, stats, eSchedulingPolicyFFA);
                 //}
             }
+
+            // The I/O threads of the write queue will notify the frame is rendered once written. If the queue
+            // refused the frame, the render is being aborted.
+            if (asyncFrame) {
+                ignore_result( isDefaultScheduler->appendToWriteQueue(asyncFrame) );
+            }
         } catch (const std::exception& e) {
             _imp->scheduler->notifyRenderFailure( std::string("Error while rendering: ") + e.what() );
         }
@@ -2485,6 +2654,97 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
     }
 } // DefaultScheduler::processFrame
 
+bool
+DefaultScheduler::isAsyncWriteEnabled() const
+{
+    return _writeQueue->isActive();
+}
+
+bool
+DefaultScheduler::appendToWriteQueue(const AsyncWriteFramePtr& frame)
+{
+    return _writeQueue->appendFrame(frame);
+}
+
+void
+DefaultScheduler::writeAsyncFrame(const AsyncWriteFramePtr& frame)
+{
+    assert(frame && frame->writer);
+    OutputEffectInstancePtr output = _effect.lock();
+    if (!output) {
+        return;
+    }
+
+    AbortableThread* isAbortableThread = dynamic_cast<AbortableThread*>( QThread::currentThread() );
+    const EffectInstancePtr& writer = frame->writer;
+    NodePtr writerNode = writer->getNode();
+    RenderScale scale(1.);
+    const bool isRenderDueToRenderInteraction = false;
+    const bool isSequentialRender = true;
+
+    for (std::vector<ViewIdx>::const_iterator it = frame->viewsToRender.begin(); it != frame->viewsToRender.end(); ++it) {
+        std::map<ViewIdx, AsyncWriteFrameView>::const_iterator foundView = frame->views.find(*it);
+        if ( foundView == frame->views.end() ) {
+            continue;
+        }
+        const AsyncWriteFrameView& frameView = foundView->second;
+
+        AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(true, 0);
+        if (isAbortableThread) {
+            isAbortableThread->setAbortInfo(isRenderDueToRenderInteraction, abortInfo, writer);
+        }
+
+        ParallelRenderArgsSetter frameRenderArgs(frame->time,
+                                                 *it,
+                                                 isRenderDueToRenderInteraction,  // is this render due to user interaction ?
+                                                 isSequentialRender, // is this sequential ?
+                                                 abortInfo, //abortInfo
+                                                 writerNode, //tree root
+                                                 0, //texture index
+                                                 output->getApp()->getTimeLine().get(),
+                                                 NodePtr(),
+                                                 false,
+                                                 false,
+                                                 frame->stats);
+        RenderingFlagSetter flagIsRendering(writerNode);
+
+        EffectInstance::InputImagesMap inputImages;
+        inputImages[0] = frameView.inputPlanes;
+        boost::scoped_ptr<EffectInstance::RenderRoIArgs> renderArgs( new EffectInstance::RenderRoIArgs(frame->time,
+                                                                                                       scale, 0,
+                                                                                                       *it,
+                                                                                                       false, // the queued input images are used, the writer itself never looks up the cache in a sequential render
+                                                                                                       frameView.renderWindow,
+                                                                                                       frameView.rod,
+                                                                                                       frameView.components,
+                                                                                                       writer->getBitDepth(-1),
+                                                                                                       false,
+                                                                                                       writer.get(),
+                                                                                                       eStorageModeRAM,
+                                                                                                       frame->time,
+                                                                                                       inputImages) );
+        try {
+            std::map<ImagePlaneDesc, ImagePtr> planes;
+            EffectInstance::RenderRoIRetCode retCode = writer->renderRoI(*renderArgs, &planes);
+            if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
+                if (retCode == EffectInstance::eRenderRoIRetCodeAborted) {
+                    notifyRenderFailure("Render aborted");
+                } else {
+                    notifyRenderFailure("Error caught while rendering");
+                }
+
+                return;
+            }
+        } catch (const std::exception& e) {
+            notifyRenderFailure( std::string("Error while rendering: ") + e.what() );
+
+            return;
+        }
+
+        notifyFrameRendered(frame->time, *it, frame->viewsToRender, frame->stats, eSchedulingPolicyFFA);
+    }
+} // DefaultScheduler::writeAsyncFrame
+
 void
 DefaultScheduler::timelineStepOne(RenderDirectionEnum direction)
 {
@@ -2567,8 +2827,38 @@ DefaultScheduler::aboutToStartRender()
 
     // Activate the internal writer node for a write node
     WriteNode* isWriter = dynamic_cast<WriteNode*>( effect.get() );
+    EffectInstancePtr writer = effect;
     if (isWriter) {
         isWriter->onSequenceRenderStarted();
+        NodePtr embeddedWriter = isWriter->getEmbeddedWriter();
+        if (embeddedWriter) {
+            writer = embeddedWriter->getEffectInstance();
+        }
+    }
+
+    if ( appPTR->getCurrentSettings()->isNumaAwareRenderingEnabled() ) {
+        resetNumaPeakMemoryUsage();
+    }
+
+    // Start the I/O threads of the asynchronous write queue
+    int nIOThreads = appPTR->getCurrentSettings()->getNumberOfWriterIOThreads();
+    if ( (nIOThreads >= 0) && writer && writer->getInput(0) ) {
+        if (nIOThreads == 0) {
+            nIOThreads = NATRON_ASYNC_WRITE_DEFAULT_N_THREADS;
+        }
+        SequentialPreferenceEnum pref = writer->getSequentialPreference();
+        bool ordered = (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential);
+        U64 cacheBudget = (U64)( getSystemTotalRAM() * appPTR->getCurrentSettings()->getRamMaximumPercent() );
+        U64 maxPendingBytes = (U64)(cacheBudget * NATRON_ASYNC_WRITE_QUEUE_MAX_CACHE_FRACTION);
+        int maxPendingFrames = std::max( 2, appPTR->getHardwareIdealThreadCount() );
+        _writeQueue->start(nIOThreads,
+                           ordered,
+                           args->firstFrame,
+                           args->lastFrame,
+                           args->frameStep,
+                           args->pushTimelineDirection,
+                           maxPendingFrames,
+                           maxPendingBytes);
     }
 
     std::string cb = effect->getNode()->getBeforeRenderCallback();
@@ -2613,6 +2903,13 @@ DefaultScheduler::aboutToStartRender()
     }
 } // DefaultScheduler::aboutToStartRender
 
+void
+DefaultScheduler::onRenderThreadsQuit(bool aborted)
+{
+    // Render threads are done: wait for the frames they produced to be written before the sequence render is ended
+    _writeQueue->stop(aborted);
+}
+
 void
 DefaultScheduler::onRenderStopped(bool aborted)
 {
@@ -2623,6 +2920,39 @@ DefaultScheduler::onRenderStopped(bool aborted)
         effect->setKnobsFrozen(false);
     }
 
+    // Report the per-frame write latency measured by the asynchronous write queue
+    AsyncWriteQueueStats writeStats = _writeQueue->getStats();
+    if ( isBackGround && (writeStats.nFramesWritten > 0) ) {
+        double avgWriteMs = writeStats.totalWriteTime * 1000. / writeStats.nFramesWritten;
+        double avgLatencyMs = writeStats.totalLatency * 1000. / writeStats.nFramesWritten;
+        QString message = tr("%1 ==> Write queue: %2 frame(s) written, write time: avg %3 ms, min %4 ms, max %5 ms, "
+                             "latency: avg %6 ms, max %7 ms, render threads stalled %8 s, peak %9 frame(s) pending")
+                          .arg( QString::fromUtf8( effect->getScriptName_mt_safe().c_str() ) )
+                          .arg(writeStats.nFramesWritten)
+                          .arg(avgWriteMs, 0, 'f', 1)
+                          .arg(writeStats.minWriteTime * 1000., 0, 'f', 1)
+                          .arg(writeStats.maxWriteTime * 1000., 0, 'f', 1)
+                          .arg(avgLatencyMs, 0, 'f', 1)
+                          .arg(writeStats.maxLatency * 1000., 0, 'f', 1)
+                          .arg(writeStats.totalStallTime, 0, 'f', 2)
+                          .arg(writeStats.peakPendingFrames);
+        std::cout << message.toStdString() << std::endl;
+    }
+
+    // Report the memory held by images allocated by render threads on each NUMA node
+    if ( isBackGround && appPTR->getCurrentSettings()->isNumaAwareRenderingEnabled() && (getNumaNodesCount() > 1) ) {
+        std::vector<NumaNodeMemoryUsage> numaUsage;
+        getNumaNodesMemoryUsage(&numaUsage);
+        for (std::size_t i = 0; i < numaUsage.size(); ++i) {
+            QString message = tr("%1 ==> NUMA node %2: %3 in use, peak %4")
+                              .arg( QString::fromUtf8( effect->getScriptName_mt_safe().c_str() ) )
+                              .arg(i)
+                              .arg( printAsRAM(numaUsage[i].current) )
+                              .arg( printAsRAM(numaUsage[i].peak) );
+            std::cout << message.toStdString() << std::endl;
+        }
+    }
+
     {
         QString longText = QString::fromUtf8( effect->getScriptName_mt_safe().c_str() ) + tr(" ==> Rendering finished");
         appPTR->writeToOutputPipe(longText, QString::fromUtf8(kRenderingFinishedStringShort), true);
@@ -2932,6 +3262,19 @@ ViewerDisplayScheduler::getLastRenderedTime() const
     return _viewer.lock()->getLastRenderedTime();
 }
 
+unsigned int
+ViewerDisplayScheduler::getReadPrefetchMipMapLevel() const
+{
+    ViewerInstancePtr viewer = _viewer.lock();
+
+    if (!viewer) {
+        return 0;
+    }
+
+    // Same as what the viewer does in getViewerArgsAndRenderViewer: the proxy level is bounded by the zoom level
+    return (unsigned int)std::max( viewer->getMipMapLevel(), viewer->getMipMapLevelFromZoomFactor() );
+}
+
 ////////////////////////// RenderEngine
 
 struct RenderEnginePrivate
@@ -3391,6 +3734,8 @@ public:
     RotoStrokeItemWPtr strokeItem;
     ViewerArgsPtr args[2];
     bool isRotoNeatRender;
+    // If true, the render is not started if a more recent request was made while it was waiting for a thread
+    bool canSkipIfStale;
 
     CurrentFrameFunctorArgs()
         : GenericThreadStartArgs()
@@ -3406,6 +3751,7 @@ public:
         , strokeItem()
         , args()
         , isRotoNeatRender(false)
+        , canSkipIfStale(false)
     {
     }
 
@@ -3432,6 +3778,7 @@ public:
         , strokeItem(strokeItem)
         , args()
         , isRotoNeatRender(isRotoNeatRender)
+        , canSkipIfStale(false)
     {
         if (isRotoPaintRequest && isRotoNeatRender) {
             isRotoPaintRequest->getRotoContext()->setIsDoingNeatRender(true);
@@ -3470,6 +3817,10 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     // Used to attribute an age to each renderCurrentFrameRequest
     U64 ageCounter;
 
+    // Age of the most recent request, read by the render threads to drop requests that became stale
+    mutable QMutex latestRequestAgeMutex;
+    U64 latestRequestAge;
+
     ViewerCurrentFrameRequestSchedulerPrivate(ViewerInstance* viewer)
         : viewer(viewer)
         , threadPool( QThreadPool::globalInstance() )
@@ -3480,9 +3831,25 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
         , currentFrameRenderTasksCond()
         , currentFrameRenderTasks()
         , ageCounter(0)
+        , latestRequestAgeMutex()
+        , latestRequestAge(0)
     {
     }
 
+    void setLatestRequestAge(U64 age)
+    {
+        QMutexLocker k(&latestRequestAgeMutex);
+
+        latestRequestAge = age;
+    }
+
+    bool isStaleRequest(U64 age) const
+    {
+        QMutexLocker k(&latestRequestAgeMutex);
+
+        return age != latestRequestAge;
+    }
+
     void appendRunnableTask(RenderCurrentFrameFunctorRunnable* task)
     {
         {
@@ -3561,6 +3928,15 @@ public:
         ViewerInstance::ViewerRenderRetCode stat = ViewerInstance::eViewerRenderRetCodeFail;
         BufferableObjectPtrList ret;
 
+        // The latest request wins: if the user changed something again while this render was waiting for a thread,
+        // do not start it. The scheduler still waits for a frame of this age, so produce an empty one.
+        if ( _args->request && _args->canSkipIfStale && _args->scheduler->isStaleRequest(_args->request->age) ) {
+            _args->scheduler->notifyFrameProduced(ret, RenderStatsPtr(), _args->request->age);
+            _args->scheduler->removeRunnableTask(this);
+
+            return;
+        }
+
         try {
             if (!_args->isRotoPaintRequest || _args->isRotoNeatRender) {
                 stat = _args->viewer->renderViewer(_args->view, QThread::currentThread() == qApp->thread(), false, _args->viewerHash, _args->canAbort,
@@ -3756,6 +4132,11 @@ ViewerCurrentFrameRequestSchedulerPrivate::processProducedFrame(const RenderStat
 
     if ( !frames.empty() ) {
         viewer->aboutToUpdateTextures();
+    } else if (stats) {
+        // The render was aborted: still report its stats so that the nodes slow to abort show up
+        double timeSpent;
+        std::map<NodePtr, NodeRenderStats > ret = stats->getStats(&timeSpent);
+        viewer->reportStats(0, ViewIdx(0), timeSpent, ret);
     }
 
     //bool hasDoneSomething = false;
@@ -3974,9 +4355,13 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats,
             ++_imp->ageCounter;
         }
 
+        _imp->setLatestRequestAge(request->age);
         startTask(request);
         functorArgs->request = request;
 
+        // Strokes and tracks must render every request, in order
+        functorArgs->canSkipIfStale = !rotoUse1Thread && !isTracking;
+
         /*
          * Let at least 1 free thread in the thread-pool to allow the renderer to use the thread pool if we use the thread-pool
          */
@@ -132,6 +132,14 @@ public:
     bool hasQuit() const;
 
     void notifyIsRunning(bool running);
+
+    /**
+     * @brief Set the NUMA node the thread binds itself to when it starts, or -1 to let it run on any CPU.
+     * Must be called before the thread is started.
+     **/
+    void setNumaNode(int node);
+
+    int getNumaNode() const;
 #endif
 
 protected:
@@ -392,6 +400,12 @@ protected:
      **/
     virtual SchedulingPolicyEnum getSchedulingPolicy() const = 0;
 
+    /**
+     * @brief Returns the mipmap level at which Read nodes upstream will be requested, so that they can be
+     * decoded ahead of the render at the right scale.
+     **/
+    virtual unsigned int getReadPrefetchMipMapLevel() const { return 0; }
+
     /**
      * @brief Returns the last successful render time.
      * This makes sense only for Viewers to keep the timeline in sync with what is displayed.
@@ -403,6 +417,11 @@ protected:
      **/
     virtual void aboutToStartRender() {}
 
+    /**
+     * @brief Callback when all render threads have quit in stopRender(), before the sequence render is ended
+     **/
+    virtual void onRenderThreadsQuit(bool /*aborted*/) {}
+
     /**
      * @brief Callback when stopRender() is called
      **/
@@ -484,6 +503,24 @@ public:
 
     virtual ~DefaultScheduler();
 
+    /**
+     * @brief Returns true if render threads should only render the input of the Writer and
+     * hand the resulting images to appendToWriteQueue() instead of calling the Writer themselves.
+     **/
+    bool isAsyncWriteEnabled() const;
+
+    /**
+     * @brief Append a frame to the asynchronous write queue. This blocks while the queue is full.
+     * Returns false if the frame could not be appended because the render was aborted.
+     **/
+    bool appendToWriteQueue(const AsyncWriteFramePtr& frame);
+
+    /**
+     * @brief Called by the I/O threads of the write queue: calls the render action of the Writer on the
+     * images rendered by its input and notifies that the frame is rendered.
+     **/
+    void writeAsyncFrame(const AsyncWriteFramePtr& frame);
+
 private:
 
     virtual void processFrame(const BufferedFrames& frames) OVERRIDE FINAL;
@@ -501,10 +538,12 @@ private:
     virtual void handleRenderFailure(const std::string& errorMessage) OVERRIDE FINAL;
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL;
     virtual void aboutToStartRender() OVERRIDE FINAL;
+    virtual void onRenderThreadsQuit(bool aborted) OVERRIDE FINAL;
     virtual void onRenderStopped(bool aborted) OVERRIDE FINAL;
     OutputEffectInstanceWPtr _effect;
     mutable QMutex _currentTimeMutex;
     int _currentTime;
+    boost::scoped_ptr<AsyncWriteQueue> _writeQueue;
 };
 
 
@@ -539,6 +578,7 @@ private:
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL { return eSchedulingPolicyOrdered; }
 
     virtual int getLastRenderedTime() const OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual unsigned int getReadPrefetchMipMapLevel() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual void onRenderStopped(bool aborted) OVERRIDE FINAL;
     ViewerInstanceWPtr _viewer;
 };
@@ -154,6 +154,9 @@ EffectInstance::treeRecurseFunctor(bool isRenderFunctor,
                 std::pair<InputImagesMap::iterator, bool> ret = inputImages->insert( std::make_pair( inputNb, ImageList() ) );
                 inputImagesList = &ret.first->second;
                 assert(ret.second);
+            } else if ( !foundInputImages->second.empty() ) {
+                ///The images of this input were given by the caller of renderRoI
+                continue;
             }
         }
 
@@ -884,6 +887,7 @@ ParallelRenderArgs::ParallelRenderArgs()
     , visitsCount(0)
     , rotoPaintNodes()
     , stats()
+    , knobsSnapshot()
     , openGLContext()
     , textureIndex(0)
     , currentThreadSafety(eRenderSafetyInstanceSafe)
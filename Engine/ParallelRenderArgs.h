@@ -118,6 +118,10 @@ public:
     ///Various stats local to the render of a frame
     RenderStatsPtr stats;
 
+    ///The values of the parameters of the node when the render was launched, read by the render threads instead of the knobs.
+    ///NULL for analysis and for renders launched from the main thread.
+    KnobsSnapshotPtr knobsSnapshot;
+
     ///The OpenGL context to use for the render of this frame
     OSGLContextWPtr openGLContext;
 
@@ -49,6 +49,35 @@
 
 NATRON_NAMESPACE_ENTER
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// A chunk is encoded as: <firstFrame> <lastFrame> <frameStep> <writerName>
+static QString
+encodeRenderWorkerChunk(const RenderWorkerChunk& chunk)
+{
+    return QString::fromUtf8("%1 %2 %3 %4")
+           .arg(chunk.firstFrame)
+           .arg(chunk.lastFrame)
+           .arg(chunk.frameStep)
+           .arg( QString::fromUtf8( chunk.writerName.c_str() ) );
+}
+
+static bool
+decodeRenderWorkerChunk(const QString& str,
+                        RenderWorkerChunk* chunk)
+{
+    bool ok1 = false, ok2 = false, ok3 = false;
+
+    chunk->firstFrame = str.section(QLatin1Char(' '), 0, 0).toInt(&ok1);
+    chunk->lastFrame = str.section(QLatin1Char(' '), 1, 1).toInt(&ok2);
+    chunk->frameStep = str.section(QLatin1Char(' '), 2, 2).toInt(&ok3);
+    chunk->writerName = str.section(QLatin1Char(' '), 3).toStdString();
+
+    return ok1 && ok2 && ok3 && !chunk->writerName.empty();
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 ProcessHandler::ProcessHandler(const QString & projectPath,
                                OutputEffectInstance* writer)
     : _process(new QProcess)
@@ -59,6 +88,40 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
     , _earlyCancel(false)
     , _processLog()
     , _processArgs()
+    , _isRenderWorker(false)
+    , _pendingInputMessages()
+{
+    QString serverName = initIPCServer();
+
+    _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8( writer->getScriptName_mt_safe().c_str() );
+    _processArgs << QString::fromUtf8("--IPCpipe") <<  serverName;
+    _processArgs << projectPath;
+
+    connectProcessSignals();
+}
+
+ProcessHandler::ProcessHandler(const QStringList & workerArgs)
+    : _process(new QProcess)
+    , _writer(0)
+    , _ipcServer(0)
+    , _bgProcessOutputSocket(0)
+    , _bgProcessInputSocket(0)
+    , _earlyCancel(false)
+    , _processLog()
+    , _processArgs(workerArgs)
+    , _isRenderWorker(true)
+    , _pendingInputMessages()
+{
+    QString serverName = initIPCServer();
+
+    _processArgs << QString::fromUtf8("--" NATRON_RENDER_WORKER_ARG);
+    _processArgs << QString::fromUtf8("--IPCpipe") <<  serverName;
+
+    connectProcessSignals();
+}
+
+QString
+ProcessHandler::initIPCServer()
 {
     ///setup the server used to listen the output of the background process
     _ipcServer = new QLocalServer();
@@ -94,11 +157,12 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
     }
     _ipcServer->listen(tmpFileName);
 
+    return tmpFileName;
+}
 
-    _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8( writer->getScriptName_mt_safe().c_str() );
-    _processArgs << QString::fromUtf8("--IPCpipe") <<  tmpFileName;
-    _processArgs << projectPath;
-
+void
+ProcessHandler::connectProcessSignals()
+{
     ///connect the useful slots of the process
     QObject::connect( _process, SIGNAL(readyReadStandardOutput()), this, SLOT(onStandardOutputBytesWritten()) );
     QObject::connect( _process, SIGNAL(readyReadStandardError()), this, SLOT(onStandardErrorBytesWritten()) );
@@ -161,10 +225,21 @@ ProcessHandler::onDataWrittenToSocket()
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QString str = QString::fromUtf8( _bgProcessOutputSocket->readLine() );
-    while ( str.endsWith( QLatin1Char('\n') ) ) {
-        str.chop(1);
-    }
+    // Several messages may have been written since the last call
+    do {
+        QString str = QString::fromUtf8( _bgProcessOutputSocket->readLine() );
+        while ( str.endsWith( QLatin1Char('\n') ) ) {
+            str.chop(1);
+        }
+        if ( !str.isEmpty() ) {
+            onMessageReceived(str);
+        }
+    } while ( _bgProcessOutputSocket->canReadLine() );
+}
+
+void
+ProcessHandler::onMessageReceived(QString str)
+{
     _processLog.append( QString::fromUtf8("Message received: ") + str + QLatin1Char('\n') );
     if ( str.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
         str = str.remove( QString::fromUtf8(kFrameRenderedStringShort) );
@@ -199,6 +274,11 @@ ProcessHandler::onDataWrittenToSocket()
             _earlyCancel = false;
             onProcessCanceled();
         }
+    } else if ( str.startsWith( QString::fromUtf8(kRenderWorkerReadyShort) ) ) {
+        Q_EMIT workerReady();
+    } else if ( str.startsWith( QString::fromUtf8(kRenderWorkerErrorShort) ) ) {
+        str = str.remove( 0, QString::fromUtf8(kRenderWorkerErrorShort).size() );
+        Q_EMIT workerError(str);
     } else {
         _processLog.append( QString::fromUtf8("Error: Unable to interpret message.\n") );
         throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
@@ -212,6 +292,39 @@ ProcessHandler::onInputPipeConnectionMade()
     assert( QThread::currentThread() == qApp->thread() );
 
     _processLog.append( QString::fromUtf8("The input channel (the one the bg process listens to) was successfully created and connected.\n") );
+
+    QStringList pendingMessages;
+    pendingMessages.swap(_pendingInputMessages);
+    for (QStringList::const_iterator it = pendingMessages.begin(); it != pendingMessages.end(); ++it) {
+        writeToInputChannel(*it);
+    }
+}
+
+void
+ProcessHandler::writeToInputChannel(const QString& message)
+{
+    if ( !_bgProcessInputSocket || (_bgProcessInputSocket->state() != QLocalSocket::ConnectedState) ) {
+        // Sent when the connection is made, see onInputPipeConnectionMade
+        _pendingInputMessages.push_back(message);
+
+        return;
+    }
+    _bgProcessInputSocket->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    _bgProcessInputSocket->flush();
+}
+
+void
+ProcessHandler::sendRenderChunk(const RenderWorkerChunk& chunk)
+{
+    assert(_isRenderWorker);
+    writeToInputChannel( QString::fromUtf8(kRenderWorkerChunkShort) + encodeRenderWorkerChunk(chunk) );
+}
+
+void
+ProcessHandler::sendQuit()
+{
+    assert(_isRenderWorker);
+    writeToInputChannel( QString::fromUtf8(kRenderWorkerQuitShort) );
 }
 
 void
@@ -253,7 +366,13 @@ void
 ProcessHandler::onProcessError(QProcess::ProcessError err)
 {
     if (err == QProcess::FailedToStart) {
-        Dialogs::errorDialog( _writer->getScriptName(), tr("The render process failed to start.").toStdString() );
+        if (_isRenderWorker) {
+            // finished() is not emitted in this case
+            Q_EMIT workerError( tr("The render process failed to start.") );
+            Q_EMIT processFinished(1);
+        } else {
+            Dialogs::errorDialog( _writer->getScriptName(), tr("The render process failed to start.").toStdString() );
+        }
     } else if (err == QProcess::Crashed) {
         //@TODO: find out a way to get the backtrace
     }
@@ -283,6 +402,10 @@ ProcessInputChannel::ProcessInputChannel(const QString & mainProcessServerName)
     , _mustQuitMutex()
     , _mustQuitCond()
     , _mustQuit(false)
+    , _renderChunksMutex()
+    , _renderChunksCond()
+    , _renderChunks()
+    , _renderChunksEnded(false)
 {
     initialize();
     _backgroundIPCServer->moveToThread(this);
@@ -313,6 +436,32 @@ ProcessInputChannel::writeToOutputChannel(const QString & message)
     }
 }
 
+bool
+ProcessInputChannel::waitForRenderChunk(RenderWorkerChunk* chunk)
+{
+    QMutexLocker k(&_renderChunksMutex);
+
+    while ( _renderChunks.empty() && !_renderChunksEnded ) {
+        _renderChunksCond.wait(&_renderChunksMutex);
+    }
+    if ( _renderChunks.empty() ) {
+        return false;
+    }
+    *chunk = _renderChunks.front();
+    _renderChunks.pop_front();
+
+    return true;
+}
+
+void
+ProcessInputChannel::endRenderChunks()
+{
+    QMutexLocker k(&_renderChunksMutex);
+
+    _renderChunksEnded = true;
+    _renderChunksCond.wakeAll();
+}
+
 void
 ProcessInputChannel::onNewConnectionPending()
 {
@@ -335,6 +484,23 @@ ProcessInputChannel::onInputChannelMessageReceived()
     if ( str.startsWith( QString::fromUtf8(kAbortRenderingStringShort) ) ) {
         qDebug() << "Aborting render!";
         appPTR->abortAnyProcessing();
+        endRenderChunks();
+
+        return true;
+    } else if ( str.startsWith( QString::fromUtf8(kRenderWorkerChunkShort) ) ) {
+        RenderWorkerChunk chunk;
+        if ( !decodeRenderWorkerChunk(str.mid( QString::fromUtf8(kRenderWorkerChunkShort).size() ), &chunk) ) {
+            std::cerr << "Error: Unable to interpret render chunk: " << str.toStdString() << std::endl;
+
+            return false;
+        }
+        QMutexLocker k(&_renderChunksMutex);
+        _renderChunks.push_back(chunk);
+        _renderChunksCond.wakeAll();
+
+        return false;
+    } else if ( str.startsWith( QString::fromUtf8(kRenderWorkerQuitShort) ) ) {
+        endRenderChunks();
 
         return true;
     } else {
@@ -355,17 +521,26 @@ ProcessInputChannel::run()
 #endif
     for (;; ) {
         if ( _backgroundInputPipe->waitForReadyRead(100) ) {
-            if ( onInputChannelMessageReceived() ) {
+            // Several messages may have been written since the last call
+            bool mustClose = false;
+            do {
+                mustClose = onInputChannelMessageReceived();
+            } while ( !mustClose && _backgroundInputPipe->canReadLine() );
+            if (mustClose) {
                 qDebug() << "Background process now closing the input channel...";
 
                 return;
             }
+        } else if (_backgroundInputPipe->state() == QLocalSocket::UnconnectedState) {
+            // The main process went away: a render worker has nothing left to do
+            endRenderChunks();
         }
 
         QMutexLocker l(&_mustQuitMutex);
         if (_mustQuit) {
             _mustQuit = false;
             _mustQuitCond.wakeOne();
+            endRenderChunks();
 
             return;
         }
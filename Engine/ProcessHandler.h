@@ -28,6 +28,9 @@
 
 #include "Global/Macros.h"
 
+#include <list>
+#include <string>
+
 CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QProcess>
 #include <QtCore/QThread>
@@ -43,6 +46,27 @@ CLANG_DIAG_ON(deprecated)
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief A range of frames of a Write node, sent by the render coordinator to one of its render worker processes.
+ * @see RenderCoordinator
+ **/
+struct RenderWorkerChunk
+{
+    // Fully qualified script name of the Write node
+    std::string writerName;
+    int firstFrame;
+    int lastFrame;
+    int frameStep;
+
+    RenderWorkerChunk()
+        : writerName()
+        , firstFrame(0)
+        , lastFrame(0)
+        , frameStep(1)
+    {
+    }
+};
+
 /**
  * @brief This class represents a background render process. It starts a render and reports progress via a
  * progress dialog. This class encaspulates an IPC server (a named pipe) where the render process can write to
@@ -97,6 +121,8 @@ class ProcessHandler
     bool _earlyCancel; //< true if the user pressed cancel but the _bgProcessInput socket was not created yet
     QString _processLog; //< used to record the log of the process
     QStringList _processArgs;
+    bool _isRenderWorker; //< true if the process is a worker of a RenderCoordinator
+    QStringList _pendingInputMessages; //< messages to write to the input channel once it is connected
 
 public:
 
@@ -107,8 +133,31 @@ public:
     ProcessHandler(const QString & projectPath,
                    OutputEffectInstance* writer);
 
+    /**
+     * @brief Starts a render worker process with the given command-line arguments (which must contain the project
+     * and the options it was launched with) to which the IPC arguments are appended.
+     * Once the worker loaded the project it emits workerReady() and waits for chunks of frames to render,
+     * sent with sendRenderChunk(), until sendQuit() is called.
+     **/
+    ProcessHandler(const QStringList & workerArgs);
+
     virtual ~ProcessHandler();
 
+    bool isRenderWorker() const
+    {
+        return _isRenderWorker;
+    }
+
+    /**
+     * @brief Asks the worker process to render the given frames. The worker emits workerReady() when done.
+     **/
+    void sendRenderChunk(const RenderWorkerChunk& chunk);
+
+    /**
+     * @brief Asks the worker process to quit once its current chunk is rendered.
+     **/
+    void sendQuit();
+
     const QString & getProcessLog() const;
     OutputEffectInstance* getWriter() const
     {
@@ -166,6 +215,19 @@ public Q_SLOTS:
      **/
     void startProcess();
 
+private:
+
+    /**
+     * @brief Creates the server the background process connects to and returns its name.
+     **/
+    QString initIPCServer();
+
+    void connectProcessSignals();
+
+    void writeToInputChannel(const QString& message);
+
+    void onMessageReceived(QString str);
+
 Q_SIGNALS:
 
     void deleted();
@@ -181,6 +243,16 @@ Q_SIGNALS:
      * 2: Crash.
      **/
     void processFinished(int);
+
+    /**
+     * @brief Emitted by render workers when they are idle: after loading the project and after each chunk.
+     **/
+    void workerReady();
+
+    /**
+     * @brief Emitted by render workers when rendering a chunk failed.
+     **/
+    void workerError(QString message);
 };
 
 /**
@@ -212,6 +284,12 @@ public:
      **/
     void writeToOutputChannel(const QString & message);
 
+    /**
+     * @brief For render worker processes: blocks until the main process sends a chunk of frames to render.
+     * Returns false if the main process asked the worker to quit or closed the channel.
+     **/
+    bool waitForRenderChunk(RenderWorkerChunk* chunk);
+
 public Q_SLOTS:
 
     /**
@@ -245,6 +323,11 @@ private:
      **/
     void initialize();
 
+    /**
+     * @brief Wakes up waitForRenderChunk() for good.
+     **/
+    void endRenderChunks();
+
     QString _mainProcessServerName;
     mutable QMutex _backgroundOutputPipeMutex;
     QLocalSocket* _backgroundOutputPipe; //< if the process is background but managed by a gui process then this
@@ -255,6 +338,12 @@ private:
     mutable QMutex _mustQuitMutex;
     QWaitCondition _mustQuitCond;
     bool _mustQuit;
+
+    // Chunks received from the render coordinator, protected by _renderChunksMutex
+    mutable QMutex _renderChunksMutex;
+    QWaitCondition _renderChunksCond;
+    std::list<RenderWorkerChunk> _renderChunks;
+    bool _renderChunksEnded; //< true once the coordinator asked to quit or the channel was closed
 };
 
 NATRON_NAMESPACE_EXIT
@@ -0,0 +1,515 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ReadNodePrefetcher.h"
+
+#include <bitset>
+#include <set>
+#include <map>
+#include <algorithm> // find
+#include <cassert>
+#include <stdexcept>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/AbortableRenderInfo.h"
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/Node.h"
+#include "Engine/ParallelRenderArgs.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/TimeLine.h"
+#include "Engine/TLSHolder.h"
+
+NATRON_NAMESPACE_ENTER
+
+
+class ReadNodePrefetchThread
+    : public QThread
+    , public AbortableThread
+{
+public:
+
+    ReadNodePrefetchThread(ReadNodePrefetcher* prefetcher)
+        : QThread()
+        , AbortableThread(this)
+        , _prefetcher(prefetcher)
+    {
+        setThreadName("Read prefetch thread");
+    }
+
+    virtual ~ReadNodePrefetchThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    /**
+     * @brief Decode all readers at the given frame. Returns false if the decode failed or was aborted.
+     **/
+    bool prefetchFrame(int frame,
+                       const ReadNodePrefetchArgs& args,
+                       const AbortableRenderInfoPtr& abortInfo,
+                       U64* bytes);
+
+    ReadNodePrefetcher* _prefetcher;
+};
+
+typedef std::list<ReadNodePrefetchThread*> ReadNodePrefetchThreads;
+
+struct ReadNodePrefetcherPrivate
+{
+    // Protects all fields below
+    mutable QMutex lock;
+
+    // Woken up when the prefetch window moved, a session started or threads must quit
+    QWaitCondition workAvailableCond;
+
+    // Woken up when a thread finished decoding a frame
+    QWaitCondition threadIdleCond;
+
+    ReadNodePrefetchThreads threads;
+    ReadNodePrefetchArgs args;
+    bool active;
+    bool mustQuit;
+
+    // Incremented for each session so that decodes finishing after a cancel() are not accounted
+    U64 generation;
+
+    // The frames of the window that are decoded or being decoded
+    std::set<int> scheduledFrames;
+
+    // Memory held by each decoded frame of the window
+    std::map<int, U64> prefetchedBytes;
+    U64 totalBytes;
+
+    // Abort infos of the decodes in progress, so that cancel() can abort them
+    std::list<AbortableRenderInfoPtr> inFlightDecodes;
+    int nBusyThreads;
+    int nFramesPrefetched;
+
+    ReadNodePrefetcherPrivate()
+        : lock()
+        , workAvailableCond()
+        , threadIdleCond()
+        , threads()
+        , args()
+        , active(false)
+        , mustQuit(false)
+        , generation(0)
+        , scheduledFrames()
+        , prefetchedBytes()
+        , totalBytes(0)
+        , inFlightDecodes()
+        , nBusyThreads(0)
+        , nFramesPrefetched(0)
+    {
+    }
+
+    /**
+     * @brief Returns in frame the k'th frame following the current frame in the render direction.
+     **/
+    bool getFrameAhead(int k,
+                       int* frame) const
+    {
+        int range = args.lastFrame - args.firstFrame + 1;
+        int offset = k * args.frameStep * (args.direction == eRenderDirectionForward ? 1 : -1);
+        int f = args.currentFrame + offset;
+
+        if ( (f < args.firstFrame) || (f > args.lastFrame) ) {
+            if ( !args.loop || (range <= 0) ) {
+                return false;
+            }
+            f = args.firstFrame + ( ( (f - args.firstFrame) % range ) + range ) % range;
+        }
+        if (f == args.currentFrame) {
+            return false;
+        }
+        *frame = f;
+
+        return true;
+    }
+
+    bool isInWindow(int frame) const
+    {
+        for (int k = 1; k <= args.maxFramesAhead; ++k) {
+            int f;
+            if ( !getFrameAhead(k, &f) ) {
+                return false;
+            }
+            if (f == frame) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Returns the nearest frame of the window that was not decoded yet, if the memory budget allows it.
+     **/
+    bool pickFrameToPrefetch(int* frame)
+    {
+        // Private, should not lock
+        assert( !lock.tryLock() );
+
+        if ( !active || ( (args.maxBytes > 0) && (totalBytes >= args.maxBytes) ) ) {
+            return false;
+        }
+        for (int k = 1; k <= args.maxFramesAhead; ++k) {
+            int f;
+            if ( !getFrameAhead(k, &f) ) {
+                return false;
+            }
+            if ( scheduledFrames.find(f) == scheduledFrames.end() ) {
+                scheduledFrames.insert(f);
+                *frame = f;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void removeFramesOutOfWindow()
+    {
+        // Private, should not lock
+        assert( !lock.tryLock() );
+
+        for (std::set<int>::iterator it = scheduledFrames.begin(); it != scheduledFrames.end();) {
+            if ( isInWindow(*it) ) {
+                ++it;
+                continue;
+            }
+            std::map<int, U64>::iterator foundBytes = prefetchedBytes.find(*it);
+            if ( foundBytes != prefetchedBytes.end() ) {
+                totalBytes -= std::min(totalBytes, foundBytes->second);
+                prefetchedBytes.erase(foundBytes);
+            }
+            scheduledFrames.erase(it++);
+        }
+    }
+
+    void abortInFlightDecodes()
+    {
+        // Private, should not lock
+        assert( !lock.tryLock() );
+
+        for (std::list<AbortableRenderInfoPtr>::iterator it = inFlightDecodes.begin(); it != inFlightDecodes.end(); ++it) {
+            (*it)->setAborted();
+        }
+    }
+};
+
+bool
+ReadNodePrefetchThread::prefetchFrame(int frame,
+                                      const ReadNodePrefetchArgs& args,
+                                      const AbortableRenderInfoPtr& abortInfo,
+                                      U64* bytes)
+{
+    *bytes = 0;
+
+    const bool isRenderDueToRenderInteraction = false;
+    RenderScale scale( Image::getScaleFromMipMapLevel(args.mipMapLevel) );
+
+    for (std::list<NodePtr>::const_iterator it = args.readers.begin(); it != args.readers.end(); ++it) {
+        EffectInstancePtr effect = (*it)->getEffectInstance();
+        if ( !effect || !(*it)->isActivated() ) {
+            continue;
+        }
+        U64 hash = effect->getHash();
+        const double par = effect->getAspectRatio(-1);
+
+        for (std::vector<ViewIdx>::const_iterator view = args.views.begin(); view != args.views.end(); ++view) {
+            if ( abortInfo->isAborted() ) {
+                return false;
+            }
+            setAbortInfo(isRenderDueToRenderInteraction, abortInfo, effect);
+
+            ParallelRenderArgsSetter frameRenderArgs(frame,
+                                                     *view,
+                                                     isRenderDueToRenderInteraction,
+                                                     false, // isSequential
+                                                     abortInfo,
+                                                     *it, // tree root
+                                                     0, // texture index
+                                                     effect->getApp()->getTimeLine().get(),
+                                                     NodePtr(),
+                                                     false, // isAnalysis
+                                                     false, // draftMode
+                                                     RenderStatsPtr() );
+            RectD rod;
+            bool isProjectFormat;
+            StatusEnum stat = effect->getRegionOfDefinition_public(hash, frame, scale, *view, &rod, &isProjectFormat);
+            if ( (stat == eStatusFailed) || rod.isNull() ) {
+                return false;
+            }
+            {
+                FrameRequestMap request;
+                stat = EffectInstance::computeRequestPass(frame, *view, args.mipMapLevel, rod, *it, request);
+                if (stat == eStatusFailed) {
+                    return false;
+                }
+                frameRenderArgs.updateNodesRequest(request);
+            }
+
+            // Request the planes the reader produces by default, which is what downstream nodes will request as well
+            std::list<ImagePlaneDesc> components;
+            {
+                EffectInstance::ComponentsNeededMap neededComps;
+                std::list<ImagePlaneDesc> passThroughPlanes;
+                bool processAll;
+                double ptTime;
+                int ptView;
+                std::bitset<4> processChannels;
+                int ptInput;
+                effect->getComponentsNeededAndProduced_public(hash, frame, *view, &neededComps, &passThroughPlanes, &processAll, &ptTime, &ptView, &processChannels, &ptInput);
+                EffectInstance::ComponentsNeededMap::iterator foundOutput = neededComps.find(-1);
+                if ( foundOutput != neededComps.end() ) {
+                    components = foundOutput->second;
+                }
+            }
+            if ( components.empty() ) {
+                continue;
+            }
+
+            RectI renderWindow;
+            rod.toPixelEnclosing(args.mipMapLevel, par, &renderWindow);
+
+            RenderingFlagSetter flagIsRendering(*it);
+            std::map<ImagePlaneDesc, ImagePtr> planes;
+            boost::scoped_ptr<EffectInstance::RenderRoIArgs> renderArgs( new EffectInstance::RenderRoIArgs(frame,
+                                                                                                           scale,
+                                                                                                           args.mipMapLevel,
+                                                                                                           *view,
+                                                                                                           false, // byPassCache: the purpose is to fill the cache
+                                                                                                           renderWindow,
+                                                                                                           rod,
+                                                                                                           components,
+                                                                                                           effect->getBitDepth(-1),
+                                                                                                           false,
+                                                                                                           effect.get(),
+                                                                                                           eStorageModeRAM,
+                                                                                                           frame) );
+            EffectInstance::RenderRoIRetCode retCode;
+            try {
+                retCode = effect->renderRoI(*renderArgs, &planes);
+            } catch (const std::exception& /*e*/) {
+                return false;
+            }
+            if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
+                return false;
+            }
+            for (std::map<ImagePlaneDesc, ImagePtr>::iterator it2 = planes.begin(); it2 != planes.end(); ++it2) {
+                if (it2->second) {
+                    *bytes += it2->second->size();
+                }
+            }
+        }
+    }
+
+    return true;
+} // ReadNodePrefetchThread::prefetchFrame
+
+void
+ReadNodePrefetchThread::run()
+{
+    ReadNodePrefetcherPrivate* imp = _prefetcher->_imp.get();
+
+    for (;;) {
+        int frame = 0;
+        U64 generation;
+        ReadNodePrefetchArgs args;
+        AbortableRenderInfoPtr abortInfo;
+        {
+            QMutexLocker k(&imp->lock);
+            while ( !imp->mustQuit && !imp->pickFrameToPrefetch(&frame) ) {
+                imp->workAvailableCond.wait(&imp->lock);
+            }
+            if (imp->mustQuit) {
+                break;
+            }
+            generation = imp->generation;
+            args = imp->args;
+            abortInfo = AbortableRenderInfo::create(true, 0);
+            imp->inFlightDecodes.push_back(abortInfo);
+            ++imp->nBusyThreads;
+        }
+
+        U64 bytes;
+        bool ok = prefetchFrame(frame, args, abortInfo, &bytes);
+
+        clearAbortInfo();
+        appPTR->getAppTLS()->cleanupTLSForThread();
+
+        QMutexLocker k(&imp->lock);
+        std::list<AbortableRenderInfoPtr>::iterator found = std::find(imp->inFlightDecodes.begin(), imp->inFlightDecodes.end(), abortInfo);
+        if ( found != imp->inFlightDecodes.end() ) {
+            imp->inFlightDecodes.erase(found);
+        }
+        --imp->nBusyThreads;
+
+        // If the decode failed, the frame stays in scheduledFrames so that it is not attempted again
+        if ( ok && (generation == imp->generation) && imp->isInWindow(frame) ) {
+            imp->prefetchedBytes[frame] = bytes;
+            imp->totalBytes += bytes;
+            ++imp->nFramesPrefetched;
+        }
+        imp->threadIdleCond.wakeAll();
+    }
+} // ReadNodePrefetchThread::run
+
+ReadNodePrefetcher::ReadNodePrefetcher()
+    : _imp( new ReadNodePrefetcherPrivate() )
+{
+}
+
+ReadNodePrefetcher::~ReadNodePrefetcher()
+{
+    ReadNodePrefetchThreads threads;
+    {
+        QMutexLocker k(&_imp->lock);
+        _imp->mustQuit = true;
+        _imp->active = false;
+        _imp->abortInFlightDecodes();
+        threads = _imp->threads;
+        _imp->threads.clear();
+        _imp->workAvailableCond.wakeAll();
+    }
+    for (ReadNodePrefetchThreads::iterator it = threads.begin(); it != threads.end(); ++it) {
+        (*it)->wait();
+        delete *it;
+    }
+}
+
+static void
+getReadersUpstreamInternal(const NodePtr& node,
+                           std::list<NodePtr>* readers,
+                           std::list<Node*>* marked)
+{
+    if ( std::find(marked->begin(), marked->end(), node.get()) != marked->end() ) {
+        return;
+    }
+    marked->push_back( node.get() );
+
+    EffectInstancePtr effect = node->getEffectInstance();
+    if ( effect && effect->isReader() && !effect->isVideoReader() ) {
+        readers->push_back(node);
+    }
+
+    int nInputs = node->getNInputs();
+    for (int i = 0; i < nInputs; ++i) {
+        NodePtr input = node->getInput(i);
+        if (input) {
+            getReadersUpstreamInternal(input, readers, marked);
+        }
+    }
+}
+
+void
+ReadNodePrefetcher::getReadersUpstream(const NodePtr& output,
+                                       std::list<NodePtr>* readers)
+{
+    std::list<Node*> marked;
+
+    if (output) {
+        getReadersUpstreamInternal(output, readers, &marked);
+    }
+}
+
+void
+ReadNodePrefetcher::start(const ReadNodePrefetchArgs& args)
+{
+    cancel();
+
+    if ( args.readers.empty() || args.views.empty() || (args.maxFramesAhead <= 0) ) {
+        return;
+    }
+
+    QMutexLocker k(&_imp->lock);
+    _imp->args = args;
+    _imp->args.frameStep = std::max(1, args.frameStep);
+    _imp->active = true;
+    _imp->nFramesPrefetched = 0;
+
+    // Threads are kept alive across sessions
+    int nThreads = std::max(1, args.nThreads);
+    while ( (int)_imp->threads.size() < nThreads ) {
+        ReadNodePrefetchThread* thread = new ReadNodePrefetchThread(this);
+        _imp->threads.push_back(thread);
+        // Decoding ahead must never compete with the threads rendering the current frame
+        thread->start(QThread::LowestPriority);
+    }
+    _imp->workAvailableCond.wakeAll();
+}
+
+void
+ReadNodePrefetcher::notifyFrameReached(int frame)
+{
+    QMutexLocker k(&_imp->lock);
+
+    if ( !_imp->active || (_imp->args.currentFrame == frame) ) {
+        return;
+    }
+    _imp->args.currentFrame = frame;
+    _imp->removeFramesOutOfWindow();
+    _imp->workAvailableCond.wakeAll();
+}
+
+void
+ReadNodePrefetcher::cancel()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->active = false;
+    ++_imp->generation;
+    _imp->abortInFlightDecodes();
+    _imp->scheduledFrames.clear();
+    _imp->prefetchedBytes.clear();
+    _imp->totalBytes = 0;
+
+    while (_imp->nBusyThreads > 0) {
+        _imp->threadIdleCond.wait(&_imp->lock);
+    }
+}
+
+int
+ReadNodePrefetcher::getNFramesPrefetched() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->nFramesPrefetched;
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,149 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_ReadNodePrefetcher_h
+#define Engine_ReadNodePrefetcher_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <list>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/OutputSchedulerThread.h" // RenderDirectionEnum
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Arguments of a prefetch session, @see ReadNodePrefetcher::start
+ **/
+struct ReadNodePrefetchArgs
+{
+    // The readers to prefetch, @see ReadNodePrefetcher::getReadersUpstream
+    std::list<NodePtr> readers;
+
+    // The frame currently being rendered: prefetch starts at the frame following it in the given direction
+    int currentFrame;
+    int firstFrame, lastFrame, frameStep;
+    RenderDirectionEnum direction;
+
+    // If true, the frame following lastFrame is firstFrame (and vice versa when going backward)
+    bool loop;
+
+    // Mipmap level at which the readers will be requested by the render
+    unsigned int mipMapLevel;
+    std::vector<ViewIdx> views;
+
+    // Number of I/O threads decoding frames
+    int nThreads;
+
+    // Maximum number of frames to decode ahead of the current frame
+    int maxFramesAhead;
+
+    // Maximum memory held by images decoded ahead of the current frame
+    U64 maxBytes;
+
+    ReadNodePrefetchArgs()
+        : readers()
+        , currentFrame(0)
+        , firstFrame(0)
+        , lastFrame(0)
+        , frameStep(1)
+        , direction(eRenderDirectionForward)
+        , loop(false)
+        , mipMapLevel(0)
+        , views()
+        , nThreads(1)
+        , maxFramesAhead(1)
+        , maxBytes(0)
+    {
+    }
+};
+
+/**
+ * @brief Decodes frames of Read nodes ahead of the render so that file I/O and decompression are no longer
+ * on the critical path of every frame.
+ *
+ * The prefetcher renders the Read nodes found upstream of an output (Viewer or Writer) for the next frames
+ * in the playback/render direction, using its own low priority I/O threads. The decoded images land in the node cache
+ * where the actual render will find them.
+ * The amount of memory held by frames decoded ahead of the current frame is bounded: when the budget is reached,
+ * the I/O threads wait for the render to catch up (notifyFrameReached). Calling cancel() aborts all decodes
+ * in progress, this should be done whenever the user seeks or the render is stopped.
+ **/
+struct ReadNodePrefetcherPrivate;
+class ReadNodePrefetcher
+{
+public:
+
+    ReadNodePrefetcher();
+
+    ~ReadNodePrefetcher();
+
+    /**
+     * @brief Returns all reader nodes (excluding video readers which can only decode sequentially)
+     * found upstream of the given node.
+     **/
+    static void getReadersUpstream(const NodePtr& output, std::list<NodePtr>* readers);
+
+    /**
+     * @brief Cancels any prefetch in progress and starts prefetching with the given arguments.
+     **/
+    void start(const ReadNodePrefetchArgs& args);
+
+    /**
+     * @brief Notify the prefetcher that the render reached the given frame: frames up to this one are no longer
+     * accounted in the prefetch budget and the prefetch window moves forward.
+     **/
+    void notifyFrameReached(int frame);
+
+    /**
+     * @brief Abort all decodes in progress and stop prefetching. This blocks until I/O threads are idle.
+     **/
+    void cancel();
+
+    /**
+     * @brief Returns the number of frames that were fully decoded ahead of the render since start() was called.
+     **/
+    int getNFramesPrefetched() const;
+
+private:
+
+    friend class ReadNodePrefetchThread;
+
+    boost::scoped_ptr<ReadNodePrefetcherPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_ReadNodePrefetcher_h
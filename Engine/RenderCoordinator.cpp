@@ -0,0 +1,445 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderCoordinator.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm> // min, max
+#include <cassert>
+#include <stdexcept>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
+#include <QtCore/QString>
+
+#include "Engine/AppManager.h"
+#include "Engine/ProcessHandler.h"
+#include "Engine/Timer.h"
+
+// Number of chunks each job is split into per worker: more chunks balance the load better when frames do not
+// all take the same time to render, but each chunk costs a round-trip between the processes.
+#define NATRON_RENDER_COORDINATOR_CHUNKS_PER_WORKER 4
+
+// Number of times a chunk is started again when the worker rendering it crashes
+#define NATRON_RENDER_COORDINATOR_MAX_CHUNK_ATTEMPTS 3
+
+NATRON_NAMESPACE_ENTER
+
+struct RenderCoordinatorChunk
+{
+    RenderWorkerChunk frames;
+    int nFrames;
+    int nAttempts;
+
+    // Frames reported as rendered by the worker(s)
+    std::set<int> framesRendered;
+
+    // Set when the chunk is done (successfully or not)
+    bool finished;
+
+    RenderCoordinatorChunk()
+        : frames()
+        , nFrames(0)
+        , nAttempts(0)
+        , framesRendered()
+        , finished(false)
+    {
+    }
+};
+
+struct RenderCoordinatorWorker
+{
+    // Index of the chunk being rendered or -1 if idle
+    int chunkIndex;
+
+    // True once the worker loaded the project
+    bool hasBeenReady;
+    bool quitSent;
+
+    RenderCoordinatorWorker()
+        : chunkIndex(-1)
+        , hasBeenReady(false)
+        , quitSent(false)
+    {
+    }
+};
+
+typedef std::map<ProcessHandler*, RenderCoordinatorWorker> RenderCoordinatorWorkersMap;
+
+struct RenderCoordinatorPrivate
+{
+    RenderCoordinator* _publicInterface;
+    int nWorkers;
+    QStringList workerArgs;
+    std::vector<RenderCoordinatorChunk> chunks;
+
+    // Chunks not yet given to a worker, ordered chunks come first since they are the longest
+    std::list<int> pendingChunks;
+    RenderCoordinatorWorkersMap workers;
+
+    // Number of workers started, including the ones replacing crashed workers
+    int nWorkersStarted;
+    int totalFrames;
+    int nFramesRendered;
+    std::list<std::string> errors;
+    boost::scoped_ptr<TimeLapse> timer;
+    QEventLoop loop;
+
+    RenderCoordinatorPrivate(RenderCoordinator* publicInterface,
+                             int nWorkers,
+                             const QStringList& workerArgs)
+        : _publicInterface(publicInterface)
+        , nWorkers( std::max(1, nWorkers) )
+        , workerArgs(workerArgs)
+        , chunks()
+        , pendingChunks()
+        , workers()
+        , nWorkersStarted(0)
+        , totalFrames(0)
+        , nFramesRendered(0)
+        , errors()
+        , timer()
+        , loop()
+    {
+    }
+
+    void addJob(const RenderCoordinatorJob& job);
+
+    void startWorker();
+
+    void giveWorkToWorker(ProcessHandler* process, RenderCoordinatorWorker& worker);
+
+    void finishChunk(int chunkIndex);
+
+    void abandonWriter(const std::string& writerName);
+
+    RenderCoordinatorWorker* getWorker(QObject* sender, ProcessHandler** process);
+};
+
+RenderCoordinator::RenderCoordinator(int nWorkers,
+                                     const QStringList& workerArgs)
+    : QObject()
+    , _imp( new RenderCoordinatorPrivate(this, nWorkers, workerArgs) )
+{
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    for (RenderCoordinatorWorkersMap::iterator it = _imp->workers.begin(); it != _imp->workers.end(); ++it) {
+        QObject::disconnect(it->first, 0, this, 0);
+        delete it->first;
+    }
+}
+
+void
+RenderCoordinatorPrivate::addJob(const RenderCoordinatorJob& job)
+{
+    if ( (job.frameStep == 0) || ( (job.lastFrame - job.firstFrame) / job.frameStep < 0 ) ) {
+        return;
+    }
+    int nFrames = (job.lastFrame - job.firstFrame) / job.frameStep + 1;
+    totalFrames += nFrames;
+
+    if (job.ordered) {
+        RenderCoordinatorChunk chunk;
+        chunk.frames.writerName = job.writerName;
+        chunk.frames.firstFrame = job.firstFrame;
+        chunk.frames.lastFrame = job.firstFrame + (nFrames - 1) * job.frameStep;
+        chunk.frames.frameStep = job.frameStep;
+        chunk.nFrames = nFrames;
+        pendingChunks.push_front( (int)chunks.size() );
+        chunks.push_back(chunk);
+
+        return;
+    }
+
+    // Chunk i renders frames i, i + nChunks, i + 2 * nChunks... so that all chunks roughly take the same time
+    // even if the cost of frames varies along the sequence
+    int nChunks = std::min(nFrames, nWorkers * NATRON_RENDER_COORDINATOR_CHUNKS_PER_WORKER);
+    for (int i = 0; i < nChunks; ++i) {
+        RenderCoordinatorChunk chunk;
+        chunk.nFrames = (nFrames - i + nChunks - 1) / nChunks;
+        chunk.frames.writerName = job.writerName;
+        chunk.frames.firstFrame = job.firstFrame + i * job.frameStep;
+        chunk.frames.frameStep = job.frameStep * nChunks;
+        chunk.frames.lastFrame = chunk.frames.firstFrame + (chunk.nFrames - 1) * chunk.frames.frameStep;
+        pendingChunks.push_back( (int)chunks.size() );
+        chunks.push_back(chunk);
+    }
+}
+
+void
+RenderCoordinatorPrivate::startWorker()
+{
+    ProcessHandler* process = new ProcessHandler(workerArgs);
+
+    QObject::connect( process, SIGNAL(workerReady()), _publicInterface, SLOT(onWorkerReady()) );
+    QObject::connect( process, SIGNAL(workerError(QString)), _publicInterface, SLOT(onWorkerError(QString)) );
+    QObject::connect( process, SIGNAL(frameRendered(int,double)), _publicInterface, SLOT(onWorkerFrameRendered(int,double)) );
+    QObject::connect( process, SIGNAL(processFinished(int)), _publicInterface, SLOT(onWorkerFinished(int)) );
+    workers.insert( std::make_pair( process, RenderCoordinatorWorker() ) );
+    ++nWorkersStarted;
+    process->startProcess();
+}
+
+void
+RenderCoordinatorPrivate::giveWorkToWorker(ProcessHandler* process,
+                                           RenderCoordinatorWorker& worker)
+{
+    assert(worker.chunkIndex == -1);
+    if ( pendingChunks.empty() ) {
+        if (!worker.quitSent) {
+            worker.quitSent = true;
+            process->sendQuit();
+        }
+
+        return;
+    }
+    worker.chunkIndex = pendingChunks.front();
+    pendingChunks.pop_front();
+
+    RenderCoordinatorChunk& chunk = chunks[worker.chunkIndex];
+    ++chunk.nAttempts;
+    process->sendRenderChunk(chunk.frames);
+}
+
+void
+RenderCoordinatorPrivate::finishChunk(int chunkIndex)
+{
+    RenderCoordinatorChunk& chunk = chunks[chunkIndex];
+
+    if (chunk.finished) {
+        return;
+    }
+    chunk.finished = true;
+    if ( (int)chunk.framesRendered.size() < chunk.nFrames ) {
+        errors.push_back( QCoreApplication::translate("RenderCoordinator", "%1: %2 frame(s) out of %3 were not rendered in the range %4-%5 (step %6).")
+                          .arg( QString::fromUtf8( chunk.frames.writerName.c_str() ) )
+                          .arg(chunk.nFrames - (int)chunk.framesRendered.size() )
+                          .arg(chunk.nFrames)
+                          .arg(chunk.frames.firstFrame)
+                          .arg(chunk.frames.lastFrame)
+                          .arg(chunk.frames.frameStep).toStdString() );
+    }
+}
+
+void
+RenderCoordinatorPrivate::abandonWriter(const std::string& writerName)
+{
+    // The other chunks of a writer that failed would most likely fail the same way
+    for (std::list<int>::iterator it = pendingChunks.begin(); it != pendingChunks.end(); ) {
+        if (chunks[*it].frames.writerName == writerName) {
+            chunks[*it].finished = true;
+            it = pendingChunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+RenderCoordinatorWorker*
+RenderCoordinatorPrivate::getWorker(QObject* sender,
+                                    ProcessHandler** process)
+{
+    *process = qobject_cast<ProcessHandler*>(sender);
+    if (!*process) {
+        return 0;
+    }
+    RenderCoordinatorWorkersMap::iterator found = workers.find(*process);
+    if ( found == workers.end() ) {
+        return 0;
+    }
+
+    return &found->second;
+}
+
+void
+RenderCoordinator::render(const std::list<RenderCoordinatorJob>& jobs)
+{
+    assert( _imp->workers.empty() );
+    for (std::list<RenderCoordinatorJob>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        _imp->addJob(*it);
+    }
+    if ( _imp->pendingChunks.empty() ) {
+        return;
+    }
+
+    int nWorkers = std::min( _imp->nWorkers, (int)_imp->pendingChunks.size() );
+    appPTR->writeToOutputPipe(tr("Rendering %1 frame(s) with %2 processes...").arg(_imp->totalFrames).arg(nWorkers),
+                              QString::fromUtf8(kRenderingStartedShort), true);
+
+    _imp->timer.reset(new TimeLapse);
+    for (int i = 0; i < nWorkers; ++i) {
+        _imp->startWorker();
+    }
+
+    // Returns when the last worker exits, see onWorkerFinished
+    _imp->loop.exec();
+
+    appPTR->writeToOutputPipe(tr("Rendering finished: %1 frame(s) out of %2 rendered in %3.")
+                              .arg(_imp->nFramesRendered)
+                              .arg(_imp->totalFrames)
+                              .arg( Timer::printAsTime(_imp->timer->getTimeSinceCreation(), false) ),
+                              QString::fromUtf8(kRenderingFinishedStringShort), true);
+
+    if ( !_imp->errors.empty() ) {
+        std::string message;
+        for (std::list<std::string>::const_iterator it = _imp->errors.begin(); it != _imp->errors.end(); ++it) {
+            if ( !message.empty() ) {
+                message += '\n';
+            }
+            message += *it;
+        }
+        throw std::runtime_error(message);
+    }
+}
+
+void
+RenderCoordinator::onWorkerReady()
+{
+    ProcessHandler* process;
+    RenderCoordinatorWorker* worker = _imp->getWorker(sender(), &process);
+
+    if (!worker) {
+        return;
+    }
+    worker->hasBeenReady = true;
+    if (worker->chunkIndex != -1) {
+        _imp->finishChunk(worker->chunkIndex);
+        worker->chunkIndex = -1;
+    }
+    _imp->giveWorkToWorker(process, *worker);
+}
+
+void
+RenderCoordinator::onWorkerError(QString message)
+{
+    ProcessHandler* process;
+    RenderCoordinatorWorker* worker = _imp->getWorker(sender(), &process);
+
+    if (!worker) {
+        return;
+    }
+    if (worker->chunkIndex != -1) {
+        RenderCoordinatorChunk& chunk = _imp->chunks[worker->chunkIndex];
+        chunk.finished = true;
+        _imp->errors.push_back( chunk.frames.writerName + ": " + message.toStdString() );
+        _imp->abandonWriter(chunk.frames.writerName);
+        // The worker sends kRenderWorkerReadyShort right after, the chunk must not be checked again
+        worker->chunkIndex = -1;
+    } else {
+        _imp->errors.push_back( message.toStdString() );
+    }
+}
+
+void
+RenderCoordinator::onWorkerFrameRendered(int frame,
+                                         double /*progress*/)
+{
+    ProcessHandler* process;
+    RenderCoordinatorWorker* worker = _imp->getWorker(sender(), &process);
+
+    if ( !worker || (worker->chunkIndex == -1) ) {
+        return;
+    }
+    RenderCoordinatorChunk& chunk = _imp->chunks[worker->chunkIndex];
+    // A frame rendered again after a crash is only accounted once
+    if ( !chunk.framesRendered.insert(frame).second ) {
+        return;
+    }
+    ++_imp->nFramesRendered;
+
+    double fractionDone = _imp->totalFrames > 0 ? (double)_imp->nFramesRendered / _imp->totalFrames : 1.;
+    double timeSpentSinceStartSec = _imp->timer->getTimeSinceCreation();
+    double estimatedFps = timeSpentSinceStartSec > 0 ? (double)_imp->nFramesRendered / timeSpentSinceStartSec : 0.;
+    double timeRemaining = fractionDone > 0 ? timeSpentSinceStartSec / fractionDone - timeSpentSinceStartSec : -1.;
+    QString frameStr = QString::number(frame);
+    QString longMessage = tr("%1 ==> Frame: %2, Progress: %3%, %4 Fps, Time Remaining: %5")
+                          .arg( QString::fromUtf8( chunk.frames.writerName.c_str() ) )
+                          .arg(frameStr)
+                          .arg( QString::number(fractionDone * 100, 'f', 1) )
+                          .arg( QString::number(estimatedFps, 'f', 1) )
+                          .arg( timeRemaining < 0 ? tr("unknown") : Timer::printAsTime(timeRemaining, true) );
+    QString shortMessage = QString::fromUtf8(kFrameRenderedStringShort) + frameStr + QString::fromUtf8(kProgressChangedStringShort) + QString::number(fractionDone);
+
+    appPTR->writeToOutputPipe(longMessage, shortMessage, true);
+}
+
+void
+RenderCoordinator::onWorkerFinished(int returnCode)
+{
+    ProcessHandler* process;
+    RenderCoordinatorWorker* worker = _imp->getWorker(sender(), &process);
+
+    if (!worker) {
+        return;
+    }
+
+    bool mustReplace = false;
+    if (worker->chunkIndex != -1) {
+        // The worker exited while rendering: render the chunk again in another worker
+        RenderCoordinatorChunk& chunk = _imp->chunks[worker->chunkIndex];
+        if (chunk.nAttempts < NATRON_RENDER_COORDINATOR_MAX_CHUNK_ATTEMPTS) {
+            _imp->pendingChunks.push_front(worker->chunkIndex);
+            mustReplace = worker->hasBeenReady;
+        } else {
+            chunk.finished = true;
+            _imp->errors.push_back( tr("%1: The render process rendering frames %2-%3 (step %4) exited unexpectedly %5 times.")
+                                    .arg( QString::fromUtf8( chunk.frames.writerName.c_str() ) )
+                                    .arg(chunk.frames.firstFrame)
+                                    .arg(chunk.frames.lastFrame)
+                                    .arg(chunk.frames.frameStep)
+                                    .arg(chunk.nAttempts).toStdString() );
+        }
+    } else if (!worker->hasBeenReady) {
+        // Most likely the project could not be loaded, any other worker would fail the same way
+        _imp->errors.push_back( tr("A render process exited with code %1 before starting to render.").arg(returnCode).toStdString() );
+    } else if (!worker->quitSent) {
+        mustReplace = true;
+    }
+
+    QObject::disconnect(process, 0, this, 0);
+    _imp->workers.erase(process);
+    process->deleteLater();
+
+    if ( mustReplace && !_imp->pendingChunks.empty() && (_imp->nWorkersStarted < _imp->nWorkers * NATRON_RENDER_COORDINATOR_MAX_CHUNK_ATTEMPTS) ) {
+        _imp->startWorker();
+    }
+
+    if ( _imp->workers.empty() ) {
+        for (std::list<int>::const_iterator it = _imp->pendingChunks.begin(); it != _imp->pendingChunks.end(); ++it) {
+            _imp->finishChunk(*it);
+        }
+        _imp->pendingChunks.clear();
+        _imp->loop.quit();
+    }
+}
+
+NATRON_NAMESPACE_EXIT
+
+NATRON_NAMESPACE_USING
+#include "moc_RenderCoordinator.cpp"
@@ -0,0 +1,126 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_RenderCoordinator_h
+#define Engine_RenderCoordinator_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <list>
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief The frames of a Write node to render with the RenderCoordinator.
+ **/
+struct RenderCoordinatorJob
+{
+    // Fully qualified script name of the Write node
+    std::string writerName;
+    int firstFrame;
+    int lastFrame;
+    int frameStep;
+
+    // If true, the Write node requires frames in order (e.g: video files): all its frames are rendered by a single worker
+    bool ordered;
+
+    RenderCoordinatorJob()
+        : writerName()
+        , firstFrame(0)
+        , lastFrame(0)
+        , frameStep(1)
+        , ordered(false)
+    {
+    }
+};
+
+/**
+ * @brief Renders Write nodes using several worker processes, each of them running its own instance of the application
+ * on the same project, so that renders are not limited by the locks that are global to a process.
+ *
+ * Worker processes are started with the command-line of the coordinator and communicate with it using the same
+ * IPC pipes as background renders launched from the GUI (@see ProcessHandler and ProcessInputChannel).
+ * The frames of each job are split in interleaved chunks (chunk i of n renders frames i, i+n, i+2n...) that are
+ * handed to the workers as they become idle, so that all workers stay busy until the end of the render.
+ * A job with ordered output is a single chunk.
+ * If a worker crashes, the chunk it was rendering is given to a new worker.
+ **/
+struct RenderCoordinatorPrivate;
+class RenderCoordinator
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @param nWorkers The maximum number of worker processes to run at the same time
+     * @param workerArgs The command-line arguments of the worker processes, i.e: the project and the options
+     * it should be loaded with.
+     **/
+    RenderCoordinator(int nWorkers,
+                      const QStringList& workerArgs);
+
+    virtual ~RenderCoordinator();
+
+    /**
+     * @brief Renders all jobs and returns once all worker processes quit.
+     * Progress is reported on the standard output (or to the output pipe of this process if it has one).
+     * Throws std::runtime_error if some frames could not be rendered.
+     **/
+    void render(const std::list<RenderCoordinatorJob>& jobs);
+
+public Q_SLOTS:
+
+    void onWorkerReady();
+
+    void onWorkerError(QString message);
+
+    void onWorkerFrameRendered(int frame, double progress);
+
+    void onWorkerFinished(int returnCode);
+
+private:
+
+    boost::scoped_ptr<RenderCoordinatorPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_RenderCoordinator_h
@@ -25,6 +25,7 @@
 
 #include "RenderStats.h"
 
+#include <algorithm> // max
 #include <bitset>
 #include <cassert>
 #include <stdexcept>
@@ -78,6 +79,10 @@ struct NodeRenderStatsPrivate
     //Premultiplication of the output imge
     ImagePremultiplicationEnum outputPremult;
 
+    //The longest time the render action ran after the render was aborted, and the number of aborted render actions
+    double maxAbortLatency;
+    int nbAbortedRenders;
+
     NodeRenderStatsPrivate()
         : totalTimeSpentRendering(0)
         , rod()
@@ -93,6 +98,8 @@ struct NodeRenderStatsPrivate
         , renderScaleSupportEnabled(false)
         , channelsEnabled()
         , outputPremult(eImagePremultiplicationOpaque)
+        , maxAbortLatency(0)
+        , nbAbortedRenders(0)
     {
         for (int i = 0; i < 4; ++i) {
             channelsEnabled[i] = false;
@@ -134,6 +141,8 @@ NodeRenderStats::operator=(const NodeRenderStats& other)
         _imp->channelsEnabled[i] = other._imp->channelsEnabled[i];
     }
     _imp->outputPremult = other._imp->outputPremult;
+    _imp->maxAbortLatency = other._imp->maxAbortLatency;
+    _imp->nbAbortedRenders = other._imp->nbAbortedRenders;
 }
 
 void
@@ -302,6 +311,25 @@ NodeRenderStats::getOutputPremult() const
     return _imp->outputPremult;
 }
 
+void
+NodeRenderStats::addAbortLatency(double time)
+{
+    _imp->maxAbortLatency = std::max(_imp->maxAbortLatency, time);
+    ++_imp->nbAbortedRenders;
+}
+
+double
+NodeRenderStats::getMaxAbortLatency() const
+{
+    return _imp->maxAbortLatency;
+}
+
+int
+NodeRenderStats::getNbAbortedRenders() const
+{
+    return _imp->nbAbortedRenders;
+}
+
 struct RenderStatsPrivate
 {
     mutable QMutex lock;
@@ -436,6 +464,16 @@ RenderStats::addRenderInfosForNode(const NodePtr& node,
     stats.addPlaneRendered(plane);
 }
 
+void
+RenderStats::addAbortLatencyForNode(const NodePtr& node,
+                                    double timeSinceAbort)
+{
+    QMutexLocker k(&_imp->lock);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addAbortLatency(timeSinceAbort);
+}
+
 std::map<NodePtr, NodeRenderStats >
 RenderStats::getStats(double *totalTimeSpent) const
 {
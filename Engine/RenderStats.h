@@ -100,6 +100,10 @@ public:
     void setOutputPremult(ImagePremultiplicationEnum premult);
     ImagePremultiplicationEnum getOutputPremult() const;
 
+    void addAbortLatency(double time);
+    double getMaxAbortLatency() const;
+    int getNbAbortedRenders() const;
+
 private:
 
     boost::scoped_ptr<NodeRenderStatsPrivate> _imp;
@@ -143,6 +147,13 @@ public:
                                const RectI& rectangle,
                                double timeSpent);
 
+    /**
+     * @brief Records that the render action of the node returned timeSinceAbort seconds after the render was aborted.
+     * Nodes with a large latency are likely not checking for abort while rendering.
+     **/
+    void addAbortLatencyForNode(const NodePtr& node,
+                                double timeSinceAbort);
+
     std::map<NodePtr, NodeRenderStats > getStats(double *totalTimeSpent) const;
 
 private:
@@ -97,6 +97,9 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 //This will enable correct evaluation of beziers
 //#define ROTO_USE_MESH_PATTERN_ONLY
 
+// Render closed beziers with cairo mesh patterns instead of the RotoShapeRasterizer
+//#define ROTO_RENDER_BEZIER_CAIRO
+
 // The number of pressure levels is 256 on an old Wacom Graphire 4, and 512 on an entry-level Wacom Bamboo
 // 512 should be OK, see:
 // http://www.davidrevoy.com/article182/calibrating-wacom-stylus-pressure-on-krita
@@ -2895,6 +2898,15 @@ RotoDrawableItem::renderMaskInternal(const RectI & roi,
 
     double opacity = getOpacity(time);
 
+#ifndef ROTO_RENDER_BEZIER_CAIRO
+    if ( isBezier && !isBezier->isOpenBezier() ) {
+        // Closed beziers are rendered directly to the image, in parallel
+        RotoContextPrivate::rasterizeBezier(isBezier, roi, shapeColor, opacity, time, startTime, endTime, timeStep, mipmapLevel, inverted, image.get());
+
+        return image;
+    }
+#endif
+
     ////Allocate the cairo temporary buffer
     CairoImageWrapper imgWrapper;
 
@@ -3309,19 +3321,12 @@ RotoContextPrivate::renderBezier(cairo_t* cr,
 } // RotoContextPrivate::renderBezier
 
 void
-RotoContextPrivate::renderFeather(const Bezier* bezier,
-                                  double time,
-                                  unsigned int mipmapLevel,
-                                  double shapeColor[3],
-                                  double /*opacity*/,
-                                  double featherDist,
-                                  double fallOff,
-                                  cairo_pattern_t* mesh)
+RotoContextPrivate::computeFeatherQuads(const Bezier* bezier,
+                                        double time,
+                                        unsigned int mipmapLevel,
+                                        double featherDist,
+                                        std::vector<RotoFeatherQuad>* quads)
 {
-    ///Note that we do not use the opacity when rendering the bezier, it is rendered with correct floating point opacity/color when converting
-    ///to the Natron image.
-
-    double fallOffInverse = 1. / fallOff;
     /*
      * We descretize the feather control points to obtain a polygon so that the feather distance will be of the same thickness around all the shape.
      * If we were to extend only the end points, the resulting bezier interpolation would create a feather with different thickness around the shape,
@@ -3355,8 +3360,7 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
 
     assert( !featherPolygon.empty() && !bezierPolygon.empty() );
 
-
-    std::list<Point> featherContour;
+    quads->reserve( featherPolygon.size() );
 
     // prepare iterators
     std::list<ParametricPoint>::iterator next = featherPolygon.begin();
@@ -3389,11 +3393,7 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
     }
 
 
-    double innerOpacity = 1.;
-    double outterOpacity = 0.;
-
     Point origin = p1;
-    featherContour.push_back(p1);
 
 
     // increment for first iteration
@@ -3445,7 +3445,7 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
             continue;
         }*/
 
-        Point p0, p0p1, p1p0, p2, p2p3, p3p2, p3;
+        Point p0, p2, p3;
         p0.x = prevBez->x;
         p0.y = prevBez->y;
         p3.x = bezIT->x;
@@ -3474,7 +3474,63 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
             p2.x = origin.x;
             p2.y = origin.y;
         }
-        featherContour.push_back(p2);
+
+        RotoFeatherQuad quad;
+        quad.p0 = p0;
+        quad.p1 = p1;
+        quad.p2 = p2;
+        quad.p3 = p3;
+        quads->push_back(quad);
+
+        if (mustStop) {
+            break;
+        }
+
+        p1 = p2;
+
+        // increment for next iteration
+        // ++prev, ++next, ++bezIT, ++prevBez
+        if ( prev != featherPolygon.end() ) {
+            ++prev;
+        }
+        if ( next != featherPolygon.end() ) {
+            ++next;
+        }
+        if ( bezIT != bezierPolygon.end() ) {
+            ++bezIT;
+        }
+        if ( prevBez != bezierPolygon.end() ) {
+            ++prevBez;
+        }
+    }  // for each point in polygon
+} // RotoContextPrivate::computeFeatherQuads
+
+void
+RotoContextPrivate::renderFeather(const Bezier* bezier,
+                                  double time,
+                                  unsigned int mipmapLevel,
+                                  double shapeColor[3],
+                                  double /*opacity*/,
+                                  double featherDist,
+                                  double fallOff,
+                                  cairo_pattern_t* mesh)
+{
+    ///Note that we do not use the opacity when rendering the bezier, it is rendered with correct floating point opacity/color when converting
+    ///to the Natron image.
+
+    double fallOffInverse = 1. / fallOff;
+    double innerOpacity = 1.;
+    double outterOpacity = 0.;
+    std::vector<RotoFeatherQuad> quads;
+
+    computeFeatherQuads(bezier, time, mipmapLevel, featherDist, &quads);
+
+    for (std::vector<RotoFeatherQuad>::const_iterator it = quads.begin(); it != quads.end(); ++it) {
+        const Point& p0 = it->p0;
+        const Point& p1 = it->p1;
+        const Point& p2 = it->p2;
+        const Point& p3 = it->p3;
+        Point p0p1, p1p0, p2p3, p3p2;
 
         ///linear interpolation
         p0p1.x = (p0.x * fallOff * 2. + fallOffInverse * p1.x) / (fallOff * 2. + fallOffInverse);
@@ -3516,31 +3572,68 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
         assert(cairo_pattern_status(mesh) == CAIRO_STATUS_SUCCESS);
 
         cairo_mesh_pattern_end_patch(mesh);
+    }
+} // RotoContextPrivate::renderFeather
 
-        if (mustStop) {
-            break;
-        }
+void
+RotoContextPrivate::buildShapeSample(const Bezier* bezier,
+                                     double time,
+                                     unsigned int mipmapLevel,
+                                     RotoShapeSample* sample)
+{
+    std::list<ParametricPoint> contour;
 
-        //std::swap(innerOpacity, outterOpacity);
+    // The number of points is computed from the flatness of each segment at this mipmap level
+    bezier->evaluateAtTime_DeCasteljau(false, time, mipmapLevel, -1, &contour, NULL);
+    sample->contour.clear();
+    sample->contour.reserve( contour.size() );
+    for (std::list<ParametricPoint>::const_iterator it = contour.begin(); it != contour.end(); ++it) {
+        Point p;
+        p.x = it->x;
+        p.y = it->y;
+        sample->contour.push_back(p);
+    }
 
-        p1 = p2;
+    sample->fallOff = bezier->getFeatherFallOff(time);
 
-        // increment for next iteration
-        // ++prev, ++next, ++bezIT, ++prevBez
-        if ( prev != featherPolygon.end() ) {
-            ++prev;
-        }
-        if ( next != featherPolygon.end() ) {
-            ++next;
-        }
-        if ( bezIT != bezierPolygon.end() ) {
-            ++bezIT;
-        }
-        if ( prevBez != bezierPolygon.end() ) {
-            ++prevBez;
+    ///Adjust the feather distance so it takes the mipmap level into account
+    double featherDist = bezier->getFeatherDistance(time);
+    if (mipmapLevel != 0) {
+        featherDist /= (1 << mipmapLevel);
+    }
+    sample->feather.clear();
+    if (featherDist != 0) {
+        computeFeatherQuads(bezier, time, mipmapLevel, featherDist, &sample->feather);
+    }
+}
+
+void
+RotoContextPrivate::rasterizeBezier(const Bezier* bezier,
+                                    const RectI& roi,
+                                    double shapeColor[3],
+                                    double opacity,
+                                    double time,
+                                    double startTime,
+                                    double endTime,
+                                    double mbFrameStep,
+                                    unsigned int mipmapLevel,
+                                    bool inverted,
+                                    Image* image)
+{
+    std::list<RotoShapeSample> samples;
+
+    ///render the bezier only if finished (closed) and activated
+    if ( bezier->isCurveFinished() && bezier->isActivated(time) && ( bezier->getControlPointsCount() > 1 ) ) {
+        for (double t = startTime; t <= endTime; t += mbFrameStep) {
+            samples.push_back( RotoShapeSample() );
+            buildShapeSample(bezier, t, mipmapLevel, &samples.back());
         }
-    }  // for each point in polygon
-} // RotoContextPrivate::renderFeather
+    }
+
+    // Even without samples, the image must be filled (with the inverted mask if needed)
+    RotoShapeRasterizer rasterizer(samples);
+    rasterizer.renderToImage(roi, shapeColor, opacity, true, inverted, image);
+}
 
 void
 RotoContextPrivate::renderFeather_cairo(const std::list<RotoFeatherVertex>& vertices, double shapeColor[3], double fallOff, cairo_pattern_t * mesh)
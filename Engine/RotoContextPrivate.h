@@ -43,6 +43,7 @@
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QCoreApplication>
@@ -57,6 +58,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Global/GlobalDefines.h"
 
 #include "Engine/AppManager.h"
+#include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/Curve.h"
 #include "Engine/EffectInstance.h"
@@ -64,8 +66,10 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/KnobTypes.h"
 #include "Engine/MergingEnum.h"
 #include "Engine/Node.h"
+#include "Engine/RectD.h"
 #include "Engine/RotoContext.h"
 #include "Engine/RotoPaint.h"
+#include "Engine/RotoShapeRasterizer.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
@@ -397,6 +401,48 @@ struct RotoTriangles
     std::list<Point> vertices;
 };
 
+// Number of flattened polygons kept by each Bezier: enough for the motion blur samples of a render and the overlay
+#define BEZIER_FLATTENED_POLYGONS_CACHE_SIZE 16
+
+/**
+ * @brief The parameters a Bezier (or its feather) was flattened with.
+ * The shape age identifies the state of the control points.
+ **/
+struct BezierFlattenedPolygonKey
+{
+    int shapeAge;
+    double time;
+    unsigned int mipMapLevel;
+    double precision; //< the number of points per segment or the error scale
+    bool useGuiCurves;
+    bool feather;
+    bool evaluateIfEqual;
+    Transform::Matrix3x3 transform;
+
+    bool operator==(const BezierFlattenedPolygonKey& other) const
+    {
+        return shapeAge == other.shapeAge && time == other.time && mipMapLevel == other.mipMapLevel &&
+               precision == other.precision && useGuiCurves == other.useGuiCurves && feather == other.feather &&
+               evaluateIfEqual == other.evaluateIfEqual &&
+               transform.a == other.transform.a && transform.b == other.transform.b && transform.c == other.transform.c &&
+               transform.d == other.transform.d && transform.e == other.transform.e && transform.f == other.transform.f &&
+               transform.g == other.transform.g && transform.h == other.transform.h && transform.i == other.transform.i;
+    }
+};
+
+/**
+ * @brief The polygon obtained by flattening a Bezier, one list of points per segment, and its bounding box.
+ * Flattened polygons are shared by the tiles of a render, the RoD computation and the overlay, and never modified once computed.
+ **/
+struct BezierFlattenedPolygon
+{
+    BezierFlattenedPolygonKey key;
+    std::list<std::list<ParametricPoint> > segments;
+    RectD bbox;
+};
+
+typedef boost::shared_ptr<const BezierFlattenedPolygon> BezierFlattenedPolygonPtr;
+
 struct BezierPrivate
 {
     BezierCPs points; //< the control points of the curve
@@ -414,6 +460,10 @@ struct BezierPrivate
     mutable QMutex guiCopyMutex;
     bool mustCopyGui;
 
+    // Most recently used first
+    mutable QMutex flattenedPolygonsMutex;
+    mutable std::list<BezierFlattenedPolygonPtr> flattenedPolygons;
+
     BezierPrivate(bool isOpenBezier)
         : points()
         , featherPoints()
@@ -426,7 +476,46 @@ struct BezierPrivate
         , isOpenBezier(isOpenBezier)
         , guiCopyMutex()
         , mustCopyGui(false)
+        , flattenedPolygonsMutex()
+        , flattenedPolygons()
+    {
+    }
+
+    BezierFlattenedPolygonPtr findFlattenedPolygon(const BezierFlattenedPolygonKey& key) const
+    {
+        QMutexLocker k(&flattenedPolygonsMutex);
+
+        for (std::list<BezierFlattenedPolygonPtr>::iterator it = flattenedPolygons.begin(); it != flattenedPolygons.end(); ++it) {
+            if ( (*it)->key == key ) {
+                BezierFlattenedPolygonPtr ret = *it;
+                if ( it != flattenedPolygons.begin() ) {
+                    flattenedPolygons.erase(it);
+                    flattenedPolygons.push_front(ret);
+                }
+
+                return ret;
+            }
+        }
+
+        return BezierFlattenedPolygonPtr();
+    }
+
+    void insertFlattenedPolygon(const BezierFlattenedPolygonPtr& polygon) const
     {
+        QMutexLocker k(&flattenedPolygonsMutex);
+
+        // Polygons of an older shape will never be used again
+        for (std::list<BezierFlattenedPolygonPtr>::iterator it = flattenedPolygons.begin(); it != flattenedPolygons.end();) {
+            if ( (*it)->key.shapeAge != polygon->key.shapeAge ) {
+                it = flattenedPolygons.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        flattenedPolygons.push_front(polygon);
+        if ( (int)flattenedPolygons.size() > BEZIER_FLATTENED_POLYGONS_CACHE_SIZE ) {
+            flattenedPolygons.pop_back();
+        }
     }
 
     void setMustCopyGuiBezier(bool copy)
@@ -786,6 +875,9 @@ public:
     //Used to prevent 2 threads from writing the same image in the rotocontext
     mutable QReadWriteLock cacheAccessMutex;
 
+    //Incremented whenever the shape of the item changes, used to invalidate the polygons computed from it
+    QAtomicInt shapeAge;
+
     RotoDrawableItemPrivate(bool isPaintingNode)
         : effectNode()
         , mergeNode()
@@ -834,6 +926,7 @@ public:
         , timeOffsetMode()
         , knobs()
         , cacheAccessMutex()
+        , shapeAge()
     {
         opacity = boost::make_shared<KnobDouble>((KnobHolder*)NULL, tr(kRotoOpacityParamLabel), 1, true);
         opacity->setHintToolTip( tr(kRotoOpacityHint) );
@@ -2230,6 +2323,23 @@ public:
                                unsigned int mipmapLevel);
     static void renderBezier(cairo_t* cr, const Bezier* bezier, double opacity, double time, double startTime, double endTime, double mbFrameStep, unsigned int mipmapLevel);
     static void renderFeather(const Bezier * bezier, double time, unsigned int mipmapLevel, double shapeColor[3], double opacity, double featherDist, double fallOff, cairo_pattern_t * mesh);
+
+    /**
+     * @brief Computes the quads of the feather of the bezier: each of them is rendered as a Coons patch fading from the
+     * contour of the shape to the feather polygon extruded by featherDist.
+     **/
+    static void computeFeatherQuads(const Bezier * bezier, double time, unsigned int mipmapLevel, double featherDist, std::vector<RotoFeatherQuad>* quads);
+
+    /**
+     * @brief Returns the geometry of the bezier at the given motion blur sample, as rendered by the RotoShapeRasterizer
+     **/
+    static void buildShapeSample(const Bezier * bezier, double time, unsigned int mipmapLevel, RotoShapeSample* sample);
+
+    /**
+     * @brief Renders the mask of the bezier with its motion blur into the roi of the image using the RotoShapeRasterizer.
+     * This is equivalent to renderBezier followed by the conversion of the cairo surface to the image.
+     **/
+    static void rasterizeBezier(const Bezier * bezier, const RectI & roi, double shapeColor[3], double opacity, double time, double startTime, double endTime, double mbFrameStep, unsigned int mipmapLevel, bool inverted, Image* image);
     static void renderFeather_cairo(const std::list<RotoFeatherVertex>& vertices, double shapeColor[3],  double fallOff, cairo_pattern_t * mesh);
     static void renderInternalShape_cairo(const std::list<RotoTriangles>& triangles,
                                           const std::list<RotoTriangleFans>& fans,
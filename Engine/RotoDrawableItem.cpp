@@ -658,6 +658,7 @@ RotoDrawableItem::rotoKnobChanged(const KnobIPtr& knob,
 void
 RotoDrawableItem::incrementNodesAge()
 {
+    incrementShapeAge();
     if ( getContext()->getNode()->getApp()->getProject()->isLoadingProject() ) {
         return;
     }
@@ -675,6 +676,18 @@ RotoDrawableItem::incrementNodesAge()
     }
 }
 
+void
+RotoDrawableItem::incrementShapeAge()
+{
+    _imp->shapeAge.ref();
+}
+
+int
+RotoDrawableItem::getShapeAge() const
+{
+    return (int)_imp->shapeAge;
+}
+
 NodePtr
 RotoDrawableItem::getEffectNode() const
 {
@@ -83,8 +83,19 @@ public:
 
     void setNodesThreadSafetyForRotopainting();
 
+    /**
+     * @brief Increments the age of the nodes of the item so that their renders are invalidated.
+     * This also increments the shape age.
+     **/
     void incrementNodesAge();
 
+    /**
+     * @brief The shape age is incremented whenever the control points of the item change, including
+     * the GUI-only curves used while interacting. Polygons computed from the shape are only valid for a given age.
+     **/
+    void incrementShapeAge();
+    int getShapeAge() const;
+
     void refreshNodesConnections();
 
     virtual void clone(const RotoItem*  other) OVERRIDE;
@@ -1747,9 +1747,10 @@ RotoPaint::drawOverlay(double time,
                 //            }
 
                 std::list<ParametricPoint > points;
+                // The number of points is adapted to the curvature so that straight segments are cheap to draw
                 isBezier->evaluateAtTime_DeCasteljau(true, time, 0,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                                                     100,
+                                                     -1,
 #else
                                                      1,
 #endif
@@ -1783,7 +1784,7 @@ RotoPaint::drawOverlay(double time,
                     ///Draw feather only if visible (button is toggled in the user interface)
                     isBezier->evaluateFeatherPointsAtTime_DeCasteljau(true, time, 0,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                                                                      100,
+                                                                      -1,
 #else
                                                                       1,
 #endif
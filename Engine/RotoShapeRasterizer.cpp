@@ -0,0 +1,673 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoShapeRasterizer.h"
+
+#include <algorithm> // min, max, fill, copy
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <boost/bind.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#include "Engine/Image.h"
+#include "Engine/RectD.h"
+
+// Number of rows rendered by each parallel task
+#define ROTO_RASTERIZER_BAND_HEIGHT 64
+
+// Number of entries of the table giving the opacity of the feather from the normalized distance to the shape
+#define ROTO_RASTERIZER_FALLOFF_LUT_SIZE 1024
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// An edge of the contour, oriented from low y to high y
+struct RotoContourEdge
+{
+    double x0, y0, y1;
+    double dxdy;
+    int winding;
+};
+
+struct RotoPreparedSample
+{
+    std::vector<RotoContourEdge> edges;
+    RectD contourBbox;
+    std::vector<RotoFeatherQuad> quads;
+    std::vector<RectD> quadsBbox;
+
+    // Pixels touched by the contour and the feather
+    RectI bbox;
+
+    // Opacity of the feather given the normalized position between the opaque and transparent edges of a quad
+    std::vector<float> fallOffLut;
+};
+
+// Position along the sides of a feather quad given the parameter of the Coons patch.
+// The sides are straight lines whose control points are placed according to the fall-off, as in RotoContextPrivate::renderFeather
+static double
+fallOffCurve(double u,
+             double c1,
+             double c2)
+{
+    double v = 1. - u;
+
+    return 3. * c1 * u * v * v + 3. * c2 * u * u * v + u * u * u;
+}
+
+static void
+computeFallOffLut(double fallOff,
+                  std::vector<float>* lut)
+{
+    double fallOffInverse = 1. / fallOff;
+    double c1 = fallOffInverse / (fallOff * 2. + fallOffInverse);
+    double c2 = 2. * fallOffInverse / (fallOff + 2. * fallOffInverse);
+
+    lut->resize(ROTO_RASTERIZER_FALLOFF_LUT_SIZE + 1);
+    for (int i = 0; i <= ROTO_RASTERIZER_FALLOFF_LUT_SIZE; ++i) {
+        double s = (double)i / ROTO_RASTERIZER_FALLOFF_LUT_SIZE;
+        // The curve is monotonic since 0 <= c1 <= c2 <= 1
+        double lo = 0., hi = 1.;
+        for (int it = 0; it < 32; ++it) {
+            double mid = (lo + hi) / 2.;
+            if (fallOffCurve(mid, c1, c2) < s) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        // The color of the patch is interpolated linearly in parameter space, from opaque to transparent
+        (*lut)[i] = (float)( 1. - (lo + hi) / 2. );
+    }
+}
+
+static inline float
+lookupFallOff(const std::vector<float>& lut,
+              double s)
+{
+    double f = std::max( 0., std::min(1., s) ) * ROTO_RASTERIZER_FALLOFF_LUT_SIZE;
+    int i = std::min( (int)f, ROTO_RASTERIZER_FALLOFF_LUT_SIZE - 1 );
+    double t = f - i;
+
+    return (float)( lut[i] * (1. - t) + lut[i + 1] * t );
+}
+
+static inline double
+cross2(double ax,
+       double ay,
+       double bx,
+       double by)
+{
+    return ax * by - ay * bx;
+}
+
+// Finds the coordinates (s,v) of p in the bilinear quad, s going from the opaque edge (p0,p3) to the transparent edge (p1,p2).
+// Returns false if p is outside of the quad.
+static bool
+inverseBilinear(const RotoFeatherQuad& q,
+                double px,
+                double py,
+                double* s)
+{
+    double ex = q.p1.x - q.p0.x, ey = q.p1.y - q.p0.y;
+    double fx = q.p3.x - q.p0.x, fy = q.p3.y - q.p0.y;
+    double gx = q.p0.x - q.p1.x + q.p2.x - q.p3.x, gy = q.p0.y - q.p1.y + q.p2.y - q.p3.y;
+    double hx = px - q.p0.x, hy = py - q.p0.y;
+    double k2 = cross2(gx, gy, fx, fy);
+    double k1 = cross2(ex, ey, fx, fy) + cross2(hx, hy, gx, gy);
+    double k0 = cross2(hx, hy, ex, ey);
+    double candidates[2];
+    int nCandidates = 0;
+
+    if (std::fabs(k2) < 1e-10) {
+        if (std::fabs(k1) < 1e-10) {
+            return false;
+        }
+        candidates[nCandidates++] = -k0 / k1;
+    } else {
+        double w = k1 * k1 - 4. * k0 * k2;
+        if (w < 0.) {
+            return false;
+        }
+        w = std::sqrt(w);
+        candidates[nCandidates++] = (-k1 - w) / (2. * k2);
+        candidates[nCandidates++] = (-k1 + w) / (2. * k2);
+    }
+
+    for (int i = 0; i < nCandidates; ++i) {
+        double v = candidates[i];
+        if ( (v < 0.) || (v > 1.) ) {
+            continue;
+        }
+        double dx = ex + gx * v;
+        double dy = ey + gy * v;
+        double u;
+        if (std::fabs(dx) > std::fabs(dy)) {
+            u = (hx - fx * v) / dx;
+        } else if (dy != 0.) {
+            u = (hy - fy * v) / dy;
+        } else {
+            continue;
+        }
+        if ( (u >= 0.) && (u <= 1.) ) {
+            *s = u;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+prepareSample(const RotoShapeSample& sample,
+              RotoPreparedSample* prepared)
+{
+    prepared->contourBbox.setupInfinity();
+    std::size_t nPoints = sample.contour.size();
+    for (std::size_t i = 0; i < nPoints; ++i) {
+        const Point& a = sample.contour[i];
+        const Point& b = sample.contour[(i + 1) % nPoints];
+        prepared->contourBbox.x1 = std::min(prepared->contourBbox.x1, a.x);
+        prepared->contourBbox.x2 = std::max(prepared->contourBbox.x2, a.x);
+        prepared->contourBbox.y1 = std::min(prepared->contourBbox.y1, a.y);
+        prepared->contourBbox.y2 = std::max(prepared->contourBbox.y2, a.y);
+        if (a.y == b.y) {
+            // Horizontal edges never cross a scanline
+            continue;
+        }
+        RotoContourEdge e;
+        if (a.y < b.y) {
+            e.x0 = a.x;
+            e.y0 = a.y;
+            e.y1 = b.y;
+            e.winding = 1;
+        } else {
+            e.x0 = b.x;
+            e.y0 = b.y;
+            e.y1 = a.y;
+            e.winding = -1;
+        }
+        e.dxdy = (b.x - a.x) / (b.y - a.y);
+        prepared->edges.push_back(e);
+    }
+
+    prepared->quads = sample.feather;
+    prepared->quadsBbox.resize( sample.feather.size() );
+    for (std::size_t i = 0; i < sample.feather.size(); ++i) {
+        const RotoFeatherQuad& q = sample.feather[i];
+        RectD& bbox = prepared->quadsBbox[i];
+        bbox.x1 = std::min( std::min(q.p0.x, q.p1.x), std::min(q.p2.x, q.p3.x) );
+        bbox.x2 = std::max( std::max(q.p0.x, q.p1.x), std::max(q.p2.x, q.p3.x) );
+        bbox.y1 = std::min( std::min(q.p0.y, q.p1.y), std::min(q.p2.y, q.p3.y) );
+        bbox.y2 = std::max( std::max(q.p0.y, q.p1.y), std::max(q.p2.y, q.p3.y) );
+    }
+    if ( !sample.feather.empty() ) {
+        computeFallOffLut(sample.fallOff, &prepared->fallOffLut);
+    }
+
+    RectD bbox = prepared->contourBbox;
+    for (std::size_t i = 0; i < prepared->quadsBbox.size(); ++i) {
+        bbox.merge(prepared->quadsBbox[i]);
+    }
+    if ( (nPoints == 0) && prepared->quadsBbox.empty() ) {
+        prepared->bbox.clear();
+    } else {
+        prepared->bbox.x1 = (int)std::floor(bbox.x1) - 1;
+        prepared->bbox.y1 = (int)std::floor(bbox.y1) - 1;
+        prepared->bbox.x2 = (int)std::ceil(bbox.x2) + 1;
+        prepared->bbox.y2 = (int)std::ceil(bbox.y2) + 1;
+    }
+}
+
+// Adds to the row of cell deltas the area covered by the part of an edge inside one row of pixels, going from x = xa to x = xb
+// over a signed height h. The coverage of a pixel is the sum of the deltas of the cells up to it.
+static void
+accumulateEdgeArea(double xa,
+                   double xb,
+                   double h,
+                   int rowX1,
+                   std::vector<double>* cells)
+{
+    int nCells = (int)cells->size();
+    double xl = std::min(xa, xb);
+    double xr = std::max(xa, xb);
+
+    if (xr - xl < 1e-9) {
+        // Vertical within the row: the pixel containing the edge gets the part on its right, the next pixel the rest
+        double px = (xl + xr) / 2. - rowX1;
+        int i = std::max( 0, std::min( (int)std::floor(px), nCells - 2 ) );
+        double f = std::max( 0., std::min(1., px - i) );
+        (*cells)[i] += h * (1. - f);
+        (*cells)[i + 1] += h * f;
+
+        return;
+    }
+
+    double hPerUnit = h / (xr - xl);
+    int first = (int)std::floor(xl);
+    int last = std::max( first, (int)std::ceil(xr) - 1 );
+    for (int x = first; x <= last; ++x) {
+        double xs = std::max(xl, (double)x);
+        double xe = std::min(xr, x + 1.);
+        if (xe <= xs) {
+            continue;
+        }
+        // The piece of edge in this column is a trapezoid: the pixel gets the area on the right of the piece
+        double ph = (xe - xs) * hPerUnit;
+        double f = (xs + xe) / 2. - x;
+        int i = std::max( 0, std::min(x - rowX1, nCells - 2) );
+        (*cells)[i] += ph * (1. - f);
+        (*cells)[i + 1] += ph * f;
+    }
+}
+
+// Computes for the pixels of the rect the area covered by the contour, clamped to 1 (non-zero winding rule).
+// Each row is accumulated over the whole horizontal extent of the sample, so a pixel gets the same value
+// whatever the rect it is rendered in.
+static void
+fillContour(const RotoPreparedSample& sample,
+            const RectI& rect,
+            std::vector<float>* coverage)
+{
+    int width = rect.width();
+
+    if ( sample.edges.empty() || (sample.contourBbox.y2 < rect.y1) || (sample.contourBbox.y1 > rect.y2) ) {
+        return;
+    }
+
+    // Only keep the edges crossing the rows of the rect
+    std::vector<const RotoContourEdge*> edges;
+    for (std::size_t i = 0; i < sample.edges.size(); ++i) {
+        const RotoContourEdge& e = sample.edges[i];
+        if ( (e.y1 > rect.y1) && (e.y0 < rect.y2) ) {
+            edges.push_back(&e);
+        }
+    }
+
+    // One more cell than pixels to receive the deltas on the right of the last pixel
+    int rowX1 = sample.bbox.x1;
+    std::vector<double> cells(sample.bbox.width() + 1);
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        std::fill( cells.begin(), cells.end(), 0. );
+        bool hasEdges = false;
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            const RotoContourEdge& e = *edges[i];
+            double y0 = std::max(e.y0, (double)y);
+            double y1 = std::min(e.y1, y + 1.);
+            if (y1 <= y0) {
+                continue;
+            }
+            double xa = e.x0 + (y0 - e.y0) * e.dxdy;
+            double xb = e.x0 + (y1 - e.y0) * e.dxdy;
+            accumulateEdgeArea(xa, xb, (y1 - y0) * e.winding, rowX1, &cells);
+            hasEdges = true;
+        }
+        if (!hasEdges) {
+            continue;
+        }
+
+        float* row = &(*coverage)[(y - rect.y1) * width];
+        double winding = 0.;
+        for (int x = rowX1; x < rect.x2; ++x) {
+            winding += cells[x - rowX1];
+            if (x >= rect.x1) {
+                row[x - rect.x1] = (float)std::min( 1., std::fabs(winding) );
+            }
+        }
+    }
+} // fillContour
+
+// Composites the feather quads over each other in mesh, for the pixels of the rect
+static void
+renderFeather(const RotoPreparedSample& sample,
+              const RectI& rect,
+              std::vector<float>* mesh)
+{
+    int width = rect.width();
+
+    for (std::size_t i = 0; i < sample.quads.size(); ++i) {
+        const RectD& bbox = sample.quadsBbox[i];
+        int x1 = std::max( rect.x1, (int)std::floor(bbox.x1) );
+        int x2 = std::min( rect.x2, (int)std::ceil(bbox.x2) + 1 );
+        int y1 = std::max( rect.y1, (int)std::floor(bbox.y1) );
+        int y2 = std::min( rect.y2, (int)std::ceil(bbox.y2) + 1 );
+        if ( (x1 >= x2) || (y1 >= y2) ) {
+            continue;
+        }
+        const RotoFeatherQuad& q = sample.quads[i];
+        for (int y = y1; y < y2; ++y) {
+            float* row = &(*mesh)[(y - rect.y1) * width];
+            for (int x = x1; x < x2; ++x) {
+                double s;
+                if ( !inverseBilinear(q, x + 0.5, y + 0.5, &s) ) {
+                    continue;
+                }
+                float a = lookupFallOff(sample.fallOffLut, s);
+                float& dst = row[x - rect.x1];
+                dst = a + dst * (1.f - a);
+            }
+        }
+    }
+}
+
+// Renders the mask of a single sample for the pixels of rect into fill, using mesh as scratch for the feather
+static void
+renderSample(const RotoPreparedSample& sample,
+             const RectI& rect,
+             std::vector<float>* fill,
+             std::vector<float>* mesh)
+{
+    std::size_t nPixels = (std::size_t)rect.width() * rect.height();
+
+    fill->assign(nPixels, 0.f);
+    fillContour(sample, rect, fill);
+    mesh->assign(nPixels, 0.f);
+    renderFeather(sample, rect, mesh);
+    for (std::size_t i = 0; i < nPixels; ++i) {
+        // The feather mesh is used both as the source and the mask, hence the square.
+        // It is composited over the filled shape, so it only shows outside of it.
+        float feather = (*mesh)[i] * (*mesh)[i];
+        float& dst = (*fill)[i];
+        dst = std::min(1.f, dst + feather * (1.f - dst) );
+    }
+}
+
+// A rowStride of 0 writes the same coverage row on every row of rect
+template <typename PIX, int maxValue, int dstNComps>
+static void
+writeCoverageToImage(const float* coverage,
+                     std::size_t rowStride,
+                     const RectI& rect,
+                     const double shapeColor[3],
+                     double opacity,
+                     bool useOpacity,
+                     bool inverted,
+                     Image* image)
+{
+    Image::WriteAccess acc = image->getWriteRights();
+    double colorScale = useOpacity ? opacity : 1.;
+    float r = (float)(shapeColor[0] * colorScale * maxValue);
+    float g = (float)(shapeColor[1] * colorScale * maxValue);
+    float b = (float)(shapeColor[2] * colorScale * maxValue);
+    float a = (float)(colorScale * maxValue);
+    // Round integer formats to the nearest value
+    float offset = (maxValue == 1) ? 0.f : 0.5f;
+    int width = rect.width();
+
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        PIX* dstPix = (PIX*)acc.pixelAt(rect.x1, y);
+        assert(dstPix);
+        const float* srcPix = coverage + (y - rect.y1) * rowStride;
+        for (int x = 0; x < width; ++x, dstPix += dstNComps) {
+            float v = inverted ? 1.f - srcPix[x] : srcPix[x];
+            switch (dstNComps) {
+            case 4:
+                dstPix[0] = PIX(v * r + offset);
+                dstPix[1] = PIX(v * g + offset);
+                dstPix[2] = PIX(v * b + offset);
+                dstPix[3] = PIX(v * a + offset);
+                break;
+            case 1:
+                dstPix[0] = PIX(v * a + offset);
+                break;
+            case 3:
+                dstPix[0] = PIX(v * r + offset);
+                dstPix[1] = PIX(v * g + offset);
+                dstPix[2] = PIX(v * b + offset);
+                break;
+            case 2:
+                dstPix[0] = PIX(v * r + offset);
+                dstPix[1] = PIX(v * g + offset);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+template <typename PIX, int maxValue>
+static void
+writeCoverageToImageForDepth(const float* coverage,
+                             std::size_t rowStride,
+                             const RectI& rect,
+                             const double shapeColor[3],
+                             double opacity,
+                             bool useOpacity,
+                             bool inverted,
+                             Image* image)
+{
+    if ( rect.isNull() ) {
+        return;
+    }
+    switch ( image->getComponentsCount() ) {
+    case 1:
+        writeCoverageToImage<PIX, maxValue, 1>(coverage, rowStride, rect, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case 2:
+        writeCoverageToImage<PIX, maxValue, 2>(coverage, rowStride, rect, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case 3:
+        writeCoverageToImage<PIX, maxValue, 3>(coverage, rowStride, rect, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case 4:
+        writeCoverageToImage<PIX, maxValue, 4>(coverage, rowStride, rect, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    default:
+        break;
+    }
+}
+
+// Writes the mask of a band that is only covered by rect: the pixels of the band outside of rect are empty.
+template <typename PIX, int maxValue>
+static void
+writeBandToImageForDepth(const std::vector<float>& coverage,
+                         const RectI& rect,
+                         const RectI& band,
+                         const double shapeColor[3],
+                         double opacity,
+                         bool useOpacity,
+                         bool inverted,
+                         Image* image)
+{
+    std::vector<float> empty(band.width(), 0.f);
+
+    if ( rect.isNull() ) {
+        writeCoverageToImageForDepth<PIX, maxValue>(&empty.front(), 0, band, shapeColor, opacity, useOpacity, inverted, image);
+
+        return;
+    }
+    // Rows above and below rect, then the pixels on its left and right
+    writeCoverageToImageForDepth<PIX, maxValue>(&empty.front(), 0, RectI(band.x1, band.y1, band.x2, rect.y1), shapeColor, opacity, useOpacity, inverted, image);
+    writeCoverageToImageForDepth<PIX, maxValue>(&empty.front(), 0, RectI(band.x1, rect.y2, band.x2, band.y2), shapeColor, opacity, useOpacity, inverted, image);
+    writeCoverageToImageForDepth<PIX, maxValue>(&empty.front(), 0, RectI(band.x1, rect.y1, rect.x1, rect.y2), shapeColor, opacity, useOpacity, inverted, image);
+    writeCoverageToImageForDepth<PIX, maxValue>(&empty.front(), 0, RectI(rect.x2, rect.y1, band.x2, rect.y2), shapeColor, opacity, useOpacity, inverted, image);
+    writeCoverageToImageForDepth<PIX, maxValue>(&coverage.front(), rect.width(), rect, shapeColor, opacity, useOpacity, inverted, image);
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+struct RotoShapeRasterizerPrivate
+{
+    std::vector<RotoPreparedSample> samples;
+
+    RotoShapeRasterizerPrivate()
+        : samples()
+    {
+    }
+};
+
+RotoShapeRasterizer::RotoShapeRasterizer(const std::list<RotoShapeSample>& samples)
+    : _imp( new RotoShapeRasterizerPrivate() )
+{
+    _imp->samples.resize( samples.size() );
+    std::size_t i = 0;
+    for (std::list<RotoShapeSample>::const_iterator it = samples.begin(); it != samples.end(); ++it, ++i) {
+        prepareSample(*it, &_imp->samples[i]);
+    }
+}
+
+RotoShapeRasterizer::~RotoShapeRasterizer()
+{
+}
+
+void
+RotoShapeRasterizer::renderCoverage(const RectI& rect,
+                                    float* coverage,
+                                    std::size_t rowStride) const
+{
+    if ( rect.isNull() ) {
+        return;
+    }
+    int width = rect.width();
+    std::vector<float> mesh;
+    std::vector<float> fill;
+
+    if (_imp->samples.size() == 1) {
+        // Without motion blur the sample is written straight to the output
+        for (int y = 0; y < rect.height(); ++y) {
+            std::fill(coverage + y * rowStride, coverage + y * rowStride + width, 0.f);
+        }
+        const RotoPreparedSample& sample = _imp->samples.front();
+        RectI sampleRect;
+        if ( !sample.bbox.intersect(rect, &sampleRect) ) {
+            return;
+        }
+        renderSample(sample, sampleRect, &fill, &mesh);
+        int sampleWidth = sampleRect.width();
+        for (int y = 0; y < sampleRect.height(); ++y) {
+            const float* srcPix = &fill[(std::size_t)y * sampleWidth];
+            std::copy( srcPix, srcPix + sampleWidth, coverage + (sampleRect.y1 - rect.y1 + y) * rowStride + (sampleRect.x1 - rect.x1) );
+        }
+
+        return;
+    }
+
+    std::vector<float> accum( (std::size_t)width * rect.height(), 0.f );
+    for (std::size_t i = 0; i < _imp->samples.size(); ++i) {
+        const RotoPreparedSample& sample = _imp->samples[i];
+        // Samples that do not touch the rect only add zeroes to the accumulation buffer
+        RectI sampleRect;
+        if ( !sample.bbox.intersect(rect, &sampleRect) ) {
+            continue;
+        }
+        renderSample(sample, sampleRect, &fill, &mesh);
+        int sampleWidth = sampleRect.width();
+        for (int y = 0; y < sampleRect.height(); ++y) {
+            const float* srcPix = &fill[(std::size_t)y * sampleWidth];
+            float* dstPix = &accum[(std::size_t)(sampleRect.y1 - rect.y1 + y) * width + (sampleRect.x1 - rect.x1)];
+            for (int x = 0; x < sampleWidth; ++x) {
+                dstPix[x] += srcPix[x];
+            }
+        }
+    }
+
+    // The mask is the average of the motion blur samples
+    float scale = _imp->samples.empty() ? 0.f : 1.f / _imp->samples.size();
+    for (int y = 0; y < rect.height(); ++y) {
+        const float* srcPix = &accum[(std::size_t)y * width];
+        float* dstPix = coverage + y * rowStride;
+        for (int x = 0; x < width; ++x) {
+            dstPix[x] = std::min(1.f, srcPix[x] * scale);
+        }
+    }
+}
+
+void
+RotoShapeRasterizer::renderBand(const RectI& band,
+                                const double shapeColor[3],
+                                double opacity,
+                                bool useOpacity,
+                                bool inverted,
+                                Image* image) const
+{
+    std::vector<float> coverage;
+    RectI rect;
+
+    if (_imp->samples.size() == 1) {
+        // Without motion blur, only render the pixels touched by the sample and write them straight to the image
+        std::vector<float> mesh;
+        const RotoPreparedSample& sample = _imp->samples.front();
+        if ( sample.bbox.intersect(band, &rect) ) {
+            renderSample(sample, rect, &coverage, &mesh);
+        }
+    } else {
+        rect = band;
+        coverage.resize( (std::size_t)band.width() * band.height() );
+        renderCoverage( band, &coverage.front(), band.width() );
+    }
+
+    switch ( image->getBitDepth() ) {
+    case eImageBitDepthFloat:
+        writeBandToImageForDepth<float, 1>(coverage, rect, band, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case eImageBitDepthByte:
+        writeBandToImageForDepth<unsigned char, 255>(coverage, rect, band, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case eImageBitDepthShort:
+        writeBandToImageForDepth<unsigned short, 65535>(coverage, rect, band, shapeColor, opacity, useOpacity, inverted, image);
+        break;
+    case eImageBitDepthHalf:
+    case eImageBitDepthNone:
+        assert(false);
+        break;
+    }
+}
+
+void
+RotoShapeRasterizer::renderToImage(const RectI& roi,
+                                   const double shapeColor[3],
+                                   double opacity,
+                                   bool useOpacity,
+                                   bool inverted,
+                                   Image* image) const
+{
+    RectI rect;
+
+    if ( !roi.intersect(image->getBounds(), &rect) ) {
+        return;
+    }
+
+    std::vector<RectI> bands;
+    for (int y = rect.y1; y < rect.y2; y += ROTO_RASTERIZER_BAND_HEIGHT) {
+        bands.push_back( RectI( rect.x1, y, rect.x2, std::min(y + ROTO_RASTERIZER_BAND_HEIGHT, rect.y2) ) );
+    }
+
+    if (bands.size() == 1) {
+        renderBand(bands.front(), shapeColor, opacity, useOpacity, inverted, image);
+    } else {
+        // Bands do not share rows so they can be written concurrently
+        QtConcurrent::blockingMap( bands, boost::bind(&RotoShapeRasterizer::renderBand, this, _1, shapeColor, opacity, useOpacity, inverted, image) );
+    }
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_RotoShapeRasterizer_h
+#define Engine_RotoShapeRasterizer_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef> // std::size_t
+#include <list>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/RectI.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief A quad of the feather of a roto shape. p0 and p3 are on the contour of the shape, where the
+ * feather is opaque. p1 and p2 are the corresponding points extruded by the feather distance, where the feather is transparent.
+ **/
+struct RotoFeatherQuad
+{
+    Point p0, p1, p2, p3;
+};
+
+/**
+ * @brief The geometry of a closed roto shape at one motion blur sample, in pixel coordinates at the mipmap level of the render.
+ **/
+struct RotoShapeSample
+{
+    // Flattened contour, filled with the non-zero winding rule
+    std::vector<Point> contour;
+    std::vector<RotoFeatherQuad> feather;
+    // Fall-off of the feather: 1 is linear, lower values make the feather fade faster near the shape
+    double fallOff;
+
+    RotoShapeSample()
+        : contour()
+        , feather()
+        , fallOff(1.)
+    {
+    }
+};
+
+/**
+ * @brief Scanline rasterizer of roto shapes that renders directly into Natron images.
+ * Each sample produces the mask of the cairo renderer (fill of the contour, then the feather mesh applied as its own mask),
+ * except that the contour is anti-aliased: each pixel gets the exact area covered by the polygon, whereas the cairo
+ * renderer fills it without anti-aliasing. Motion blur samples are averaged in an accumulation buffer; without motion blur
+ * the single sample is rendered over its bounding box only and written straight to the output.
+ * The output image is split in bands of rows that are rendered in parallel, each band only touching its own rows.
+ * The feather is evaluated analytically from the Coons patch formulation used by cairo
+ * instead of tessellating the patches.
+ **/
+struct RotoShapeRasterizerPrivate;
+class RotoShapeRasterizer
+{
+public:
+
+    RotoShapeRasterizer(const std::list<RotoShapeSample>& samples);
+
+    ~RotoShapeRasterizer();
+
+    /**
+     * @brief Computes the mask of the shape in [0,1] for the pixels of rect, row by row (the first row of the buffer is rect.y1).
+     **/
+    void renderCoverage(const RectI& rect, float* coverage, std::size_t rowStride) const;
+
+    /**
+     * @brief Renders the mask into the roi of the image, in parallel. Color channels are multiplied by shapeColor,
+     * and if useOpacity is true all channels are multiplied by opacity.
+     * The image must be 8-bit, 16-bit or float.
+     **/
+    void renderToImage(const RectI& roi,
+                       const double shapeColor[3],
+                       double opacity,
+                       bool useOpacity,
+                       bool inverted,
+                       Image* image) const;
+
+private:
+
+    void renderBand(const RectI& band,
+                    const double shapeColor[3],
+                    double opacity,
+                    bool useOpacity,
+                    bool inverted,
+                    Image* image) const;
+
+    boost::scoped_ptr<RotoShapeRasterizerPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_RotoShapeRasterizer_h
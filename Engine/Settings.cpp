@@ -327,6 +327,29 @@ Settings::initializeKnobsThreading()
     _nThreadsPerEffect->disableSlider();
     _threadingPage->addKnob(_nThreadsPerEffect);
 
+    _numaAwareRendering = AppManager::createKnob<KnobBool>( this, tr("NUMA-aware rendering") );
+    _numaAwareRendering->setName("numaAwareRendering");
+    _numaAwareRendering->setHintToolTip( tr("On machines with several processor sockets (NUMA nodes), when checked each parallel frame render "
+                                            "is pinned to the processors of one node, the threads of the thread-pool working for it run on "
+                                            "the same node and the images it allocates are placed in the memory of that node. "
+                                            "This avoids reading pixels through the interconnect between sockets. "
+                                            "When rendering from the command line, the memory used on each node is reported at the end of the render.\n"
+                                            "This has no effect on machines with a single node and is only supported on Linux.") );
+    _threadingPage->addKnob(_numaAwareRendering);
+
+    _nWriterIOThreads = AppManager::createKnob<KnobInt>( this, tr("Number of writer I/O threads (-1=\"disabled\", 0=\"guess\")") );
+    _nWriterIOThreads->setName("nWriterIOThreads");
+    _nWriterIOThreads->setHintToolTip( tr("Controls how many threads encode and write frames to disk when rendering with a Write node. "
+                                          "When enabled, render threads only render the input of the Write node and hand the images "
+                                          "to a bounded queue so that the next frames can be rendered while the previous ones are being written. "
+                                          "Writers that require frames in order (e.g: movie files) always use a single I/O thread.\n"
+                                          "-1: Disabled, each render thread writes the frame it rendered \n"
+                                          "0: Use a default number of I/O threads") );
+    _nWriterIOThreads->setMinimum(-1);
+    _nWriterIOThreads->setDisplayMinimum(-1);
+    _nWriterIOThreads->disableSlider();
+    _threadingPage->addKnob(_nWriterIOThreads);
+
     _renderInSeparateProcess = AppManager::createKnob<KnobBool>( this, tr("Render in a separate process") );
     _renderInSeparateProcess->setName("renderNewProcess");
     _renderInSeparateProcess->setHintToolTip( tr("If true, %1 will render frames to disk in "
@@ -1111,9 +1134,20 @@ Settings::initializeKnobsViewers()
     autoProxyChoices.push_back(ChoiceOption("16", "",""));
     autoProxyChoices.push_back(ChoiceOption("32", "",""));
     _autoProxyLevel->populateChoices(autoProxyChoices);
-
+    _autoProxyLevel->setAddNewLine(false);
     _viewersTab->addKnob(_autoProxyLevel);
 
+    _autoProxyTargetLatency = AppManager::createKnob<KnobInt>( this, tr("Auto-proxy target render time (ms)") );
+    _autoProxyTargetLatency->setName("autoProxyTargetLatency");
+    _autoProxyTargetLatency->disableSlider();
+    _autoProxyTargetLatency->setMinimum(0);
+    _autoProxyTargetLatency->setMaximum(10000);
+    _autoProxyTargetLatency->setHintToolTip( tr("When the auto-proxy is enabled, the proxy level is chosen from the time the recent "
+                                                "renders of the viewer took, so that renders done while scrubbing the timeline or "
+                                                "editing a parameter take about this time. The proxy level never goes above the "
+                                                "auto-proxy level. When set to 0, the auto-proxy level is always used.") );
+    _viewersTab->addKnob(_autoProxyTargetLatency);
+
     _maximumNodeViewerUIOpened = AppManager::createKnob<KnobInt>( this, tr("Max. opened node viewer interface") );
     _maximumNodeViewerUIOpened->setName("maxNodeUiOpened");
     _maximumNodeViewerUIOpened->setMinimum(1);
@@ -1251,6 +1285,18 @@ Settings::initializeKnobsCaching()
     _unreachableRAMLabel->setAsLabel();
     _cachingTab->addKnob(_unreachableRAMLabel);
 
+    _readPrefetchCachePercent = AppManager::createKnob<KnobInt>( this, tr("Read prefetch budget (% of RAM cache, 0=\"disabled\")") );
+    _readPrefetchCachePercent->setName("readPrefetchCachePercent");
+    _readPrefetchCachePercent->disableSlider();
+    _readPrefetchCachePercent->setMinimum(0);
+    _readPrefetchCachePercent->setMaximum(100);
+    _readPrefetchCachePercent->setHintToolTip( tr("During playback and renders on disk, %1 decodes the frames of the Read nodes "
+                                                  "ahead of the render in background threads, so that file reading and decompression "
+                                                  "are no longer on the critical path of every frame. "
+                                                  "This setting controls the share of the RAM cache that frames decoded ahead may use. "
+                                                  "Set it to 0 to disable decoding ahead.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
+    _cachingTab->addKnob(_readPrefetchCachePercent);
+
     _maxViewerDiskCacheGB = AppManager::createKnob<KnobInt>( this, tr("Maximum playback disk cache size (GiB)") );
     _maxViewerDiskCacheGB->setName("maxViewerDiskCache");
     _maxViewerDiskCacheGB->disableSlider();
@@ -1450,6 +1496,8 @@ Settings::setDefaultValues()
 #endif
     _useThreadPool->setDefaultValue(true);
     _nThreadsPerEffect->setDefaultValue(0);
+    _numaAwareRendering->setDefaultValue(false);
+    _nWriterIOThreads->setDefaultValue(0);
     _renderInSeparateProcess->setDefaultValue(false, 0);
     _queueRenders->setDefaultValue(false);
 
@@ -1502,6 +1550,7 @@ Settings::setDefaultValues()
     _aggressiveCaching->setDefaultValue(false);
     _maxRAMPercent->setDefaultValue(50, 0);
     _unreachableRAMPercent->setDefaultValue(5);
+    _readPrefetchCachePercent->setDefaultValue(10);
     _maxViewerDiskCacheGB->setDefaultValue(5, 0);
     _maxDiskCacheNodeGB->setDefaultValue(10, 0);
     //_diskCachePath
@@ -1522,6 +1571,7 @@ Settings::setDefaultValues()
     _autoWipe->setDefaultValue(true);
     _autoProxyWhenScrubbingTimeline->setDefaultValue(true);
     _autoProxyLevel->setDefaultValue(1);
+    _autoProxyTargetLatency->setDefaultValue(100);
     _maximumNodeViewerUIOpened->setDefaultValue(2);
     _viewerKeys->setDefaultValue(true);
 
@@ -2314,6 +2364,7 @@ Settings::onKnobValueChanged(KnobI* k,
         appPTR->toggleAutoHideGraphInputs();
     } else if ( k == _autoProxyWhenScrubbingTimeline.get() ) {
         _autoProxyLevel->setSecret( !_autoProxyWhenScrubbingTimeline->getValue() );
+        _autoProxyTargetLatency->setSecret( !_autoProxyWhenScrubbingTimeline->getValue() );
     } else if ( !_restoringSettings &&
                 ( ( k == _sunkenColor.get() ) ||
                   ( k == _baseColor.get() ) ||
@@ -2459,6 +2510,12 @@ Settings::getAutoProxyMipMapLevel() const
     return (unsigned int)_autoProxyLevel->getValue() + 1;
 }
 
+int
+Settings::getAutoProxyTargetLatency() const
+{
+    return _autoProxyTargetLatency->getValue();
+}
+
 int
 Settings::getMaxOpenedNodesViewerContext() const
 {
@@ -2518,6 +2575,24 @@ Settings::getNumberOfThreadsPerEffect() const
     return _nThreadsPerEffect->getValue();
 }
 
+double
+Settings::getReadPrefetchCachePercent() const
+{
+    return (double)_readPrefetchCachePercent->getValue() / 100.;
+}
+
+bool
+Settings::isNumaAwareRenderingEnabled() const
+{
+    return _numaAwareRendering->getValue();
+}
+
+int
+Settings::getNumberOfWriterIOThreads() const
+{
+    return _nWriterIOThreads->getValue();
+}
+
 int
 Settings::getNumberOfThreads() const
 {
@@ -113,6 +113,8 @@ public:
 
     double getUnreachableRamPercent() const;
 
+    double getReadPrefetchCachePercent() const;
+
     bool getColorPickerLinear() const;
 
     int getNumberOfThreads() const;
@@ -125,6 +127,10 @@ public:
 
     int getNumberOfThreadsPerEffect() const;
 
+    bool isNumaAwareRenderingEnabled() const;
+
+    int getNumberOfWriterIOThreads() const;
+
     bool useGlobalThreadPool() const;
 
     void setUseGlobalThreadPool(bool use);
@@ -248,6 +254,7 @@ public:
     bool isAutoWipeEnabled() const;
     bool isAutoProxyEnabled() const;
     unsigned int getAutoProxyMipMapLevel() const;
+    int getAutoProxyTargetLatency() const;
     int getMaxOpenedNodesViewerContext() const;
     bool isViewerKeysEnabled() const;
     ///////////////////////////////////////////////////////
@@ -436,6 +443,8 @@ private:
     KnobIntPtr _numberOfParallelRenders;
     KnobBoolPtr _useThreadPool;
     KnobIntPtr _nThreadsPerEffect;
+    KnobBoolPtr _numaAwareRendering;
+    KnobIntPtr _nWriterIOThreads;
     KnobBoolPtr _renderInSeparateProcess;
     KnobBoolPtr _queueRenders;
 
@@ -510,6 +519,9 @@ private:
     KnobIntPtr _unreachableRAMPercent;
     KnobStringPtr _unreachableRAMLabel;
 
+    ///The share of the RAM cache that frames decoded ahead of the render by the ReadNodePrefetcher may use
+    KnobIntPtr _readPrefetchCachePercent;
+
     ///The total disk space allowed for all Natron's caches
     KnobIntPtr _maxViewerDiskCacheGB;
     KnobIntPtr _maxDiskCacheNodeGB;
@@ -526,6 +538,7 @@ private:
     KnobBoolPtr _autoWipe;
     KnobBoolPtr _autoProxyWhenScrubbingTimeline;
     KnobChoicePtr _autoProxyLevel;
+    KnobIntPtr _autoProxyTargetLatency;
     KnobIntPtr _maximumNodeViewerUIOpened;
     KnobBoolPtr _viewerKeys;
 
@@ -29,6 +29,7 @@
 #include <cassert>
 #include <stdexcept>
 
+#include "Engine/NumaInfo.h"
 #include "Engine/OfxClipInstance.h"
 #include "Engine/OfxHost.h"
 #include "Engine/OfxParamInstance.h"
@@ -80,6 +81,11 @@ copyAbortInfo(QThread* fromThread,
         fromAbortable->getAbortInfo(&isRenderResponseToUserInteraction, &abortInfo, &treeRoot);
         toAbortable->setAbortInfo(isRenderResponseToUserInteraction, abortInfo, treeRoot);
     }
+
+    // Threads processing tiles on behalf of a render thread bound to a NUMA node run on the same node
+    if ( toThread == QThread::currentThread() ) {
+        inheritNumaNodeFromThread(fromThread);
+    }
 }
 
 void
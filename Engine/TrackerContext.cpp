@@ -25,6 +25,7 @@
 
 #include "TrackerContext.h"
 
+#include <algorithm> // min
 #include <set>
 #include <sstream> // stringstream
 
@@ -32,6 +33,7 @@ CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QWaitCondition>
 #include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QCoreApplication>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
@@ -54,6 +56,9 @@ CLANG_DIAG_ON(uninitialized)
 
 #define NATRON_TRACKER_REPORT_PROGRESS_DELTA_MS 200
 
+// Number of frames each marker may track on its own before the results of all markers are gathered
+#define NATRON_TRACKER_PIPELINE_FRAMES 8
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -214,9 +219,17 @@ TrackerContext::inputChanged(int inputNb)
         setFromPointsToInputRod();
         fromPointsSetOnceKnob->setValue(true);
     }
+    // The images of the previous input are never requested again
+    clearFrameAccessorCache();
     s_onNodeInputChanged(inputNb);
 }
 
+void
+TrackerContext::clearFrameAccessorCache()
+{
+    _imp->frameAccessorCache->clear();
+}
+
 std::string
 TrackerContext::generateUniqueTrackName(const std::string& baseName)
 {
@@ -1671,6 +1684,12 @@ TrackArgs::getLibMVAutoTrack() const
     return _imp->libmvAutotrack;
 }
 
+const TrackerFrameAccessorPtr&
+TrackArgs::getFrameAccessor() const
+{
+    return _imp->fa;
+}
+
 void
 TrackArgs::getEnabledChannels(bool* r,
                               bool* g,
@@ -1713,6 +1732,100 @@ TrackArgs::getRedrawAreasNeeded(int time,
     }
 }
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Shared state of the markers tracked in a window of frames. Each marker tracks the frames of the window
+ * in sequence without waiting for the other markers, so that a slow marker does not stall the others and
+ * image fetches for later frames overlap with tracking of earlier frames.
+ * As when all markers were tracked frame by frame, no marker tracks a frame after a frame that all markers failed to track:
+ * a marker that failed on a frame waits until another marker succeeded on it before going on.
+ * The frames are identified by their index from the start of the track.
+ **/
+class TrackFramesState
+{
+    mutable QMutex _lock;
+    QWaitCondition _frameDone;
+
+    // For each frame the number of markers that did not finish tracking it yet
+    std::vector<int> _pending;
+
+    // For each frame whether at least one marker successfully tracked it
+    std::vector<char> _succeeded;
+
+    // Index of the first frame that all markers failed to track, or -1
+    int _stopIndex;
+
+    bool _aborted;
+
+public:
+
+    TrackFramesState(int numFrames,
+                     int numTracks)
+        : _lock()
+        , _frameDone()
+        , _pending(numFrames, numTracks)
+        , _succeeded(numFrames, 0)
+        , _stopIndex(-1)
+        , _aborted(false)
+    {
+    }
+
+    void setResult(int frameIndex,
+                   bool success)
+    {
+        QMutexLocker k(&_lock);
+
+        assert(frameIndex >= 0 && frameIndex < (int)_pending.size() && _pending[frameIndex] > 0);
+        --_pending[frameIndex];
+        if (success) {
+            _succeeded[frameIndex] = 1;
+        } else if ( (_pending[frameIndex] == 0) && !_succeeded[frameIndex] && ( (_stopIndex == -1) || (frameIndex < _stopIndex) ) ) {
+            _stopIndex = frameIndex;
+        }
+        _frameDone.wakeAll();
+    }
+
+    /**
+     * @brief Blocks until a marker successfully tracked the frame, in which case true is returned, or until all markers
+     * failed to track it or tracking was aborted, in which case false is returned.
+     **/
+    bool waitForSuccess(int frameIndex)
+    {
+        QMutexLocker k(&_lock);
+
+        if ( _succeeded[frameIndex] || (_pending[frameIndex] == 0) || _aborted ) {
+            return _succeeded[frameIndex] && !_aborted;
+        }
+
+        // The markers this one waits for may not be started yet: let the pool start another thread while this one sleeps
+        QThreadPool::globalInstance()->releaseThread();
+        while ( !_succeeded[frameIndex] && (_pending[frameIndex] > 0) && !_aborted ) {
+            _frameDone.wait(&_lock);
+        }
+        QThreadPool::globalInstance()->reserveThread();
+
+        return _succeeded[frameIndex] && !_aborted;
+    }
+
+    void abort()
+    {
+        QMutexLocker k(&_lock);
+
+        _aborted = true;
+        _frameDone.wakeAll();
+    }
+
+    int getStopIndex() const
+    {
+        QMutexLocker k(&_lock);
+
+        return _stopIndex;
+    }
+};
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct TrackSchedulerPrivate
 {
     TrackerParamsProvider* paramsProvider;
@@ -1736,6 +1849,17 @@ struct TrackSchedulerPrivate
      * @param time The time at which to track. The reference frame is held in the args and can be different for each track
      */
     static bool trackStepFunctor(int trackIndex, const TrackArgs& args, int time);
+
+    /*
+     * @brief Tracks the frames of index [firstIndex, lastIndex) for one marker, until all markers failed on a frame or the scheduler is aborted.
+     * A frame is only tracked if at least one marker successfully tracked the previous frame.
+     */
+    static void trackFramesFunctor(int trackIndex,
+                                   const TrackArgs& args,
+                                   TrackFramesState* state,
+                                   int firstIndex,
+                                   int lastIndex,
+                                   const TrackScheduler* scheduler);
 };
 
 TrackScheduler::TrackScheduler(TrackerParamsProvider* paramsProvider,
@@ -1783,6 +1907,33 @@ TrackSchedulerPrivate::trackStepFunctor(int trackIndex,
     return ret;
 }
 
+void
+TrackSchedulerPrivate::trackFramesFunctor(int trackIndex,
+                                          const TrackArgs& args,
+                                          TrackFramesState* state,
+                                          int firstIndex,
+                                          int lastIndex,
+                                          const TrackScheduler* scheduler)
+{
+    // A marker at a frame only depends on the same marker at the previous frame, so each marker can advance on its own
+    // as long as it succeeds
+    for (int i = firstIndex; i < lastIndex; ++i) {
+        if ( scheduler->isBeingAborted() ) {
+            // Wake up the markers waiting for this one
+            state->abort();
+
+            return;
+        }
+        int time = args.getStart() + i * args.getStep();
+        bool ret = trackStepFunctor(trackIndex, args, time);
+        state->setResult(i, ret);
+        // Tracking stops at the first frame that all markers failed to track
+        if ( !ret && !state->waitForSuccess(i) ) {
+            return;
+        }
+    }
+}
+
 NATRON_NAMESPACE_ANONYMOUS_ENTER
 
 class IsTrackingFlagSetter_RAII
@@ -1883,37 +2034,39 @@ TrackScheduler::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
         }
 
 
-        while (cur != end) {
-            ///Launch parallel thread for each track using the global thread pool
-            QFuture<bool> future = QtConcurrent::mapped( trackIndexes,
-                                                         boost::bind(&TrackSchedulerPrivate::trackStepFunctor,
-                                                                     _1,
-                                                                     *args,
-                                                                     cur) );
+        int numFrames = 0;
+        if (cur != end) {
+            numFrames = ( std::abs(end - start) + std::abs(frameStep) - 1 ) / std::abs(frameStep);
+        }
+        TrackFramesState framesState(numFrames, numTracks);
+        int frameIndex = 0;
+
+        while (frameIndex < numFrames) {
+            ///Launch parallel thread for each track using the global thread pool. Each track advances
+            ///independently over a window of frames and the viewer and progress are updated once per window.
+            int windowEnd = std::min(frameIndex + NATRON_TRACKER_PIPELINE_FRAMES, numFrames);
+            QFuture<void> future = QtConcurrent::map( trackIndexes,
+                                                      boost::bind(&TrackSchedulerPrivate::trackFramesFunctor,
+                                                                  _1,
+                                                                  *args,
+                                                                  &framesState,
+                                                                  frameIndex,
+                                                                  windowEnd,
+                                                                  this) );
             future.waitForFinished();
 
-            allTrackFailed = true;
-            for (QFuture<bool>::const_iterator it = future.begin(); it != future.end(); ++it) {
-                if ( (*it) ) {
-                    allTrackFailed = false;
-                    break;
-                }
-            }
-
-
-
-            lastValidFrame = cur;
-
-
+            int stopIndex = framesState.getStopIndex();
+            allTrackFailed = stopIndex != -1;
 
             // We don't have any successful track, stop
             if (allTrackFailed) {
+                lastValidFrame = start + stopIndex * frameStep;
                 break;
             }
 
-
-
-            cur += frameStep;
+            lastValidFrame = start + (windowEnd - 1) * frameStep;
+            frameIndex = windowEnd;
+            cur = start + frameIndex * frameStep;
 
             double progress;
             if (frameStep > 0) {
@@ -1931,7 +2084,7 @@ TrackScheduler::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
                 double dt =  now.tv_sec  - lastProgressUpdateTime.tv_sec +
                             (now.tv_usec - lastProgressUpdateTime.tv_usec) * 1e-6f;
                 dt *= 1000; // switch to MS
-                enoughTimePassedToReportProgress = dt > NATRON_TRACKER_REPORT_PROGRESS_DELTA_MS;
+                enoughTimePassedToReportProgress = dt > NATRON_TRACKER_REPORT_PROGRESS_DELTA_MS || frameIndex == numFrames;
                 if (enoughTimePassedToReportProgress) {
                     lastProgressUpdateTime = now;
                 }
@@ -1957,7 +2110,7 @@ TrackScheduler::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
             }
 
             if (enoughTimePassedToReportProgress && reportProgress && effect) {
-                ///Notify we progressed of 1 frame
+                ///Notify we progressed of a window of frames
                 Q_EMIT trackingProgress(progress);
             }
 
@@ -1966,8 +2119,12 @@ TrackScheduler::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
             if ( (state == eThreadStateAborted) || (state == eThreadStateStopped) ) {
                 break;
             }
-        } // while (cur != end) {
+        } // while (frameIndex < numFrames) {
     } // IsTrackingFlagSetter_RAII
+
+    // Do not render frames that will not be tracked. The images already converted are kept for the next passes.
+    args->getFrameAccessor()->endTracking();
+
     TrackerContext* isContext = dynamic_cast<TrackerContext*>(_imp->paramsProvider);
     if (isContext) {
         isContext->solveTransformParams();
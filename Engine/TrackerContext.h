@@ -286,6 +286,11 @@ public:
 
     void inputChanged(int inputNb);
 
+    /**
+     * @brief Frees the images of the input converted for tracking, which are otherwise kept across track operations
+     **/
+    void clearFrameAccessorCache();
+
     bool knobChanged(KnobI* k,
                      ValueChangedReasonEnum reason,
                      ViewSpec view,
@@ -477,6 +482,8 @@ public:
     const std::vector<TrackMarkerAndOptionsPtr>& getTracks() const;
     mv::AutoTrackPtr getLibMVAutoTrack() const;
 
+    const TrackerFrameAccessorPtr& getFrameAccessor() const;
+
     void getEnabledChannels(bool* r, bool* g, bool* b) const;
 
     void getRedrawAreasNeeded(int time, std::list<RectD>* canonicalRects) const;
@@ -110,6 +110,7 @@ TrackerContextPrivate::TrackerContextPrivate(TrackerContext* publicInterface,
     , beginSelectionCounter(0)
     , selectionRecursion(0)
     , scheduler(_publicInterface, node)
+    , frameAccessorCache( new TrackerFrameAccessorCache(NATRON_TRACKER_FRAME_CACHE_MAX_BYTES) )
 {
     EffectInstancePtr effect = node->getEffectInstance();
     //needs to be blocking, otherwise the progressUpdate() call could be made before startProgress
@@ -1172,8 +1173,11 @@ TrackerContext::trackMarkers(const std::list<TrackMarkerPtr>& markers,
 
     bool autoKeyingOnEnabledParamEnabled = _imp->autoKeyEnabled.lock()->getValue();
     
-    /// The accessor and its cache is local to a track operation, it is wiped once the whole sequence track is finished.
-    TrackerFrameAccessorPtr accessor( new TrackerFrameAccessor(this, enabledChannels, formatHeight) );
+    /// The accessor is local to a track operation but its cache is shared by all track operations: images are keyed
+    /// by the hash of the input so they are only re-rendered when the input changes.
+    TrackerFrameAccessorPtr accessor( new TrackerFrameAccessor(this, _imp->frameAccessorCache, enabledChannels, formatHeight) );
+    // Render the next frame while the current one is tracked
+    accessor->setPrefetchStep(frameStep);
     mv::AutoTrackPtr trackContext( new mv::AutoTrack( accessor.get() ) );
     std::vector<TrackMarkerAndOptionsPtr> trackAndOptions;
     mv::TrackRegionOptions mvOptions;
@@ -1864,7 +1868,8 @@ TrackerContextPrivate::computeTransformParamsFromTracksAtTime(double refTime,
                                                               int jitterPeriod,
                                                               bool jitterAdd,
                                                               bool robustModel,
-                                                              const std::vector<TrackMarkerPtr>& allMarkers)
+                                                              const std::vector<TrackMarkerPtr>& allMarkers,
+                                                              const TransformDataMapPtr& previousResults)
 {
 
     RectD rodRef = getInputRoDAtTime(refTime);
@@ -1886,14 +1891,30 @@ TrackerContextPrivate::computeTransformParamsFromTracksAtTime(double refTime,
     data.time = time;
     data.valid = true;
     assert( !markers.empty() );
-    std::vector<Point> x1, x2;
-    extractSortedPointsFromMarkers(refTime, time, markers, jitterPeriod, jitterAdd, center.lock(), &x1, &x2);
+    SolverInputs& inputs = data.inputs;
+    extractSortedPointsFromMarkers(refTime, time, markers, jitterPeriod, jitterAdd, center.lock(), &inputs.x1, &inputs.x2);
+    const std::vector<Point>& x1 = inputs.x1;
+    const std::vector<Point>& x2 = inputs.x2;
     assert( x1.size() == x2.size() );
     if ( x1.empty() ) {
         data.valid = false;
 
         return data;
     }
+    inputs.w1 = w1;
+    inputs.h1 = h1;
+    inputs.w2 = w2;
+    inputs.h2 = h2;
+    inputs.refTime = refTime;
+    inputs.robustModel = robustModel;
+
+    // Only solve again if the markers affecting this frame changed
+    if (previousResults) {
+        TransformDataMap::const_iterator found = previousResults->find(time);
+        if ( ( found != previousResults->end() ) && (found->second.inputs == inputs) ) {
+            return found->second;
+        }
+    }
     if (refTime == time) {
         data.hasRotationAndScale = x1.size() > 1;
         data.translation.x = data.translation.y = data.rotation = 0;
@@ -1926,7 +1947,8 @@ TrackerContextPrivate::computeCornerPinParamsFromTracksAtTime(double refTime,
                                                               int jitterPeriod,
                                                               bool jitterAdd,
                                                               bool robustModel,
-                                                              const std::vector<TrackMarkerPtr>& allMarkers)
+                                                              const std::vector<TrackMarkerPtr>& allMarkers,
+                                                              const CornerPinDataMapPtr& previousResults)
 {
     RectD rodRef = getInputRoDAtTime(refTime);
     RectD rodTime = getInputRoDAtTime(time);
@@ -1948,14 +1970,30 @@ TrackerContextPrivate::computeCornerPinParamsFromTracksAtTime(double refTime,
     data.time = time;
     data.valid = true;
     assert( !markers.empty() );
-    std::vector<Point> x1, x2;
-    extractSortedPointsFromMarkers(refTime, time, markers, jitterPeriod, jitterAdd, KnobDoublePtr(), &x1, &x2);
+    SolverInputs& inputs = data.inputs;
+    extractSortedPointsFromMarkers(refTime, time, markers, jitterPeriod, jitterAdd, KnobDoublePtr(), &inputs.x1, &inputs.x2);
+    const std::vector<Point>& x1 = inputs.x1;
+    const std::vector<Point>& x2 = inputs.x2;
     assert( x1.size() == x2.size() );
     if ( x1.empty() ) {
         data.valid = false;
 
         return data;
     }
+    inputs.w1 = w1;
+    inputs.h1 = h1;
+    inputs.w2 = w2;
+    inputs.h2 = h2;
+    inputs.refTime = refTime;
+    inputs.robustModel = robustModel;
+
+    // Only solve again if the markers affecting this frame changed
+    if (previousResults) {
+        CornerPinDataMap::const_iterator found = previousResults->find(time);
+        if ( ( found != previousResults->end() ) && (found->second.inputs == inputs) ) {
+            return found->second;
+        }
+    }
     if (refTime == time) {
         data.h.setIdentity();
         data.nbEnabledPoints = 4;
@@ -2241,11 +2279,15 @@ TrackerContextPrivate::computeCornerParamsFromTracksEnd(double refTime,
 {
     // Make sure we get only valid results
     QList<CornerPinData> validResults;
+    boost::shared_ptr<CornerPinDataMap> solvedFrames( new CornerPinDataMap() );
     for (QList<CornerPinData>::const_iterator it = results.begin(); it != results.end(); ++it) {
+        solvedFrames->insert( std::make_pair(it->time, *it) );
         if (it->valid) {
             validResults.push_back(*it);
         }
     }
+    // Keep the results so that the next solve only recomputes frames whose inputs changed
+    lastCornerPinResults = solvedFrames;
 
 
     // Get all knobs that we are going to write to and block any value changes on them
@@ -2389,23 +2431,21 @@ TrackerContextPrivate::computeCornerParamsFromTracks()
     lastSolveRequest.cpWatcher.reset( new QFutureWatcher<TrackerContextPrivate::CornerPinData>() );
     QObject::connect( lastSolveRequest.cpWatcher.get(), SIGNAL(finished()), this, SLOT(onCornerPinSolverWatcherFinished()) );
     QObject::connect( lastSolveRequest.cpWatcher.get(), SIGNAL(progressValueChanged(int)), this, SLOT(onCornerPinSolverWatcherProgress(int)) );
-    lastSolveRequest.cpWatcher->setFuture( QtConcurrent::mapped( lastSolveRequest.keyframes, boost::bind(&TrackerContextPrivate::computeCornerPinParamsFromTracksAtTime, this, lastSolveRequest.refTime, _1, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers) ) );
+    lastSolveRequest.cpWatcher->setFuture( QtConcurrent::mapped( lastSolveRequest.keyframes, boost::bind(&TrackerContextPrivate::computeCornerPinParamsFromTracksAtTime, this, lastSolveRequest.refTime, _1, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers, lastCornerPinResults) ) );
 #else
     NodePtr thisNode = node.lock();
-    QList<CornerPinData> validResults;
+    QList<CornerPinData> results;
     {
         int nKeys = (int)lastSolveRequest.keyframes.size();
         int keyIndex = 0;
         for (std::set<double>::const_iterator it = lastSolveRequest.keyframes.begin(); it != lastSolveRequest.keyframes.end(); ++it, ++keyIndex) {
-            CornerPinData data = computeCornerPinParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers);
-            if (data.valid) {
-                validResults.push_back(data);
-            }
+            CornerPinData data = computeCornerPinParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers, lastCornerPinResults);
+            results.push_back(data);
             double progress = (keyIndex + 1) / (double)nKeys;
             thisNode->getApp()->progressUpdate(thisNode, progress);
         }
     }
-    computeCornerParamsFromTracksEnd(lastSolveRequest.refTime, lastSolveRequest.maxFittingError, validResults);
+    computeCornerParamsFromTracksEnd(lastSolveRequest.refTime, lastSolveRequest.maxFittingError, results);
 #endif
 } // TrackerContext::computeCornerParamsFromTracks
 
@@ -2454,11 +2494,15 @@ TrackerContextPrivate::computeTransformParamsFromTracksEnd(double refTime,
                                                            const QList<TransformData>& results)
 {
     QList<TransformData> validResults;
+    boost::shared_ptr<TransformDataMap> solvedFrames( new TransformDataMap() );
     for (QList<TransformData>::const_iterator it = results.begin(); it != results.end(); ++it) {
+        solvedFrames->insert( std::make_pair(it->time, *it) );
         if (it->valid) {
             validResults.push_back(*it);
         }
     }
+    // Keep the results so that the next solve only recomputes frames whose inputs changed
+    lastTransformResults = solvedFrames;
 
 
     KnobIntPtr smoothKnob = smoothTransform.lock();
@@ -2591,23 +2635,21 @@ TrackerContextPrivate::computeTransformParamsFromTracks()
     lastSolveRequest.tWatcher.reset( new QFutureWatcher<TrackerContextPrivate::TransformData>() );
     QObject::connect( lastSolveRequest.tWatcher.get(), SIGNAL(finished()), this, SLOT(onTransformSolverWatcherFinished()) );
     QObject::connect( lastSolveRequest.tWatcher.get(), SIGNAL(progressValueChanged(int)), this, SLOT(onTransformSolverWatcherProgress(int)) );
-    lastSolveRequest.tWatcher->setFuture( QtConcurrent::mapped( lastSolveRequest.keyframes, boost::bind(&TrackerContextPrivate::computeTransformParamsFromTracksAtTime, this, lastSolveRequest.refTime, _1, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers) ) );
+    lastSolveRequest.tWatcher->setFuture( QtConcurrent::mapped( lastSolveRequest.keyframes, boost::bind(&TrackerContextPrivate::computeTransformParamsFromTracksAtTime, this, lastSolveRequest.refTime, _1, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers, lastTransformResults) ) );
 #else
     NodePtr thisNode = node.lock();
-    QList<TransformData> validResults;
+    QList<TransformData> results;
     {
         int nKeys = lastSolveRequest.keyframes.size();
         int keyIndex = 0;
         for (std::set<double>::const_iterator it = lastSolveRequest.keyframes.begin(); it != lastSolveRequest.keyframes.end(); ++it, ++keyIndex) {
-            TransformData data = computeTransformParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers);
-            if (data.valid) {
-                validResults.push_back(data);
-            }
+            TransformData data = computeTransformParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, lastSolveRequest.allMarkers, lastTransformResults);
+            results.push_back(data);
             double progress = (keyIndex + 1) / (double)nKeys;
             thisNode->getApp()->progressUpdate(thisNode, progress);
         }
     }
-    computeTransformParamsFromTracksEnd(lastSolveRequest.refTime, lastSolveRequest.maxFittingError, validResults);
+    computeTransformParamsFromTracksEnd(lastSolveRequest.refTime, lastSolveRequest.maxFittingError, results);
 #endif
 } // TrackerContextPrivate::computeTransformParamsFromTracks
 
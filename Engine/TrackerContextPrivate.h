@@ -31,6 +31,8 @@
 #include "TrackerContext.h"
 
 #include <list>
+#include <map>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/utility.hpp>
@@ -440,6 +442,55 @@ public:
     int beginSelectionCounter;
     int selectionRecursion;
     TrackScheduler scheduler;
+
+    // Images of the tracker input converted for LibMV, shared by all markers and track operations
+    TrackerFrameAccessorCachePtr frameAccessorCache;
+    /*
+     * @brief The correspondences and input sizes given to the solver at a frame. Results of a previous solve
+     * are reused for frames whose inputs did not change.
+     */
+    struct SolverInputs
+    {
+        SolverInputs()
+            : x1()
+            , x2()
+            , w1(0)
+            , h1(0)
+            , w2(0)
+            , h2(0)
+            , refTime(0.)
+            , robustModel(false)
+        {
+        }
+
+        bool operator==(const SolverInputs& other) const
+        {
+            return w1 == other.w1 && h1 == other.h1 && w2 == other.w2 && h2 == other.h2 &&
+                   refTime == other.refTime && robustModel == other.robustModel &&
+                   pointsEqual(x1, other.x1) && pointsEqual(x2, other.x2);
+        }
+
+        static bool pointsEqual(const std::vector<Point>& a,
+                                const std::vector<Point>& b)
+        {
+            if ( a.size() != b.size() ) {
+                return false;
+            }
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                if ( (a[i].x != b[i].x) || (a[i].y != b[i].y) ) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        std::vector<Point> x1, x2;
+        int w1, h1, w2, h2;
+        double refTime;
+        bool robustModel;
+    };
+
     struct TransformData
     {
         TransformData()
@@ -460,6 +511,7 @@ public:
         double time;
         bool valid;
         double rms;
+        SolverInputs inputs;
     };
 
     struct CornerPinData
@@ -478,8 +530,15 @@ public:
         double time;
         bool valid;
         double rms;
+        SolverInputs inputs;
     };
 
+    // Results of the last solve by frame. A new map is created by each solve so that solver threads can keep reading the previous one.
+    typedef std::map<double, TransformData> TransformDataMap;
+    typedef boost::shared_ptr<const TransformDataMap> TransformDataMapPtr;
+    typedef std::map<double, CornerPinData> CornerPinDataMap;
+    typedef boost::shared_ptr<const CornerPinDataMap> CornerPinDataMapPtr;
+
     typedef boost::shared_ptr<QFutureWatcher<CornerPinData> > CornerPinSolverWatcher;
     typedef boost::shared_ptr<QFutureWatcher<TransformData> > TransformSolverWatcher;
 
@@ -497,6 +556,8 @@ public:
     };
 
     SolveRequest lastSolveRequest;
+    TransformDataMapPtr lastTransformResults;
+    CornerPinDataMapPtr lastCornerPinResults;
 
 
     TrackerContextPrivate(TrackerContext* publicInterface,
@@ -646,19 +707,25 @@ public:
                                                std::vector<Point>* x2);
 
 
+    /*
+     * @brief Solves the transform at the given time. If previousResults holds a result at this time computed from the same inputs,
+     * it is returned without running the solver.
+     */
     TransformData computeTransformParamsFromTracksAtTime(double refTime,
                                                          double time,
                                                          int jitterPeriod,
                                                          bool jitterAdd,
                                                          bool robustModel,
-                                                         const std::vector<TrackMarkerPtr>& allMarkers);
+                                                         const std::vector<TrackMarkerPtr>& allMarkers,
+                                                         const TransformDataMapPtr& previousResults);
 
     CornerPinData computeCornerPinParamsFromTracksAtTime(double refTime,
                                                          double time,
                                                          int jitterPeriod,
                                                          bool jitterAdd,
                                                          bool robustModel,
-                                                         const std::vector<TrackMarkerPtr>& allMarkers);
+                                                         const std::vector<TrackMarkerPtr>& allMarkers,
+                                                         const CornerPinDataMapPtr& previousResults);
 
 
     void resetTransformParamsAnimation();
@@ -25,6 +25,12 @@
 
 #include "TrackerFrameAccessor.h"
 
+#include <algorithm> // min
+#include <cstring> // memcpy
+#include <list>
+#include <map>
+
+#include <boost/make_shared.hpp>
 #include <boost/utility.hpp>
 
 GCC_DIAG_OFF(unused-function)
@@ -36,24 +42,36 @@ GCC_DIAG_ON(unused-function)
 GCC_DIAG_ON(unused-parameter)
 
 #include <QtCore/QDebug>
+#include <QtCore/QMutex>
+#include <QtConcurrentRun> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/AbortableRenderInfo.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/MemoryInfo.h"
 #include "Engine/Project.h"
 #include "Engine/TimeLine.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
 #include "Engine/Node.h"
+#include "Engine/Settings.h"
+#include "Engine/TLSHolder.h"
 #include "Engine/TrackerContext.h"
 
 NATRON_NAMESPACE_ENTER
 
+// Regions requested by LibMV are enlarged to multiples of this size so that the search windows of close markers share their images
+#define NATRON_TRACKER_FRAME_CACHE_TILE_SIZE 128
+
 namespace  {
 struct FrameAccessorCacheKey
 {
+    U64 inputHash;
     int frame;
     int mipMapLevel;
     mv::FrameAccessor::InputMode mode;
+    // Bits of the enabled channels
+    int channels;
 };
 
 struct CacheKey_compare_less
@@ -76,7 +94,13 @@ struct CacheKey_compare_less
                 } else if ( (int)lhs.mode > (int)rhs.mode ) {
                     return false;
                 } else {
-                    return false;
+                    if (lhs.channels < rhs.channels) {
+                        return true;
+                    } else if (lhs.channels > rhs.channels) {
+                        return false;
+                    } else {
+                        return lhs.inputHash < rhs.inputHash;
+                    }
                 }
             }
         }
@@ -116,20 +140,25 @@ typedef boost::shared_ptr<MvFloatImage> MvFloatImagePtr;
 
 struct FrameAccessorCacheEntry
 {
+    FrameAccessorCacheKey key;
     MvFloatImagePtr image;
 
-    // If null, this is the full image
+    // The region that was requested: the image covers its intersection with the source image
+    RectI requestedRoI;
     RectI bounds;
-    unsigned int referenceCount;
+    std::size_t size;
 };
 
-typedef std::multimap<FrameAccessorCacheKey, FrameAccessorCacheEntry, CacheKey_compare_less > FrameAccessorCache;
-
+// Entries in least recently used order
+typedef std::list<FrameAccessorCacheEntry> FrameAccessorCacheEntries;
+typedef std::multimap<FrameAccessorCacheKey, FrameAccessorCacheEntries::iterator, CacheKey_compare_less > FrameAccessorCacheIndex;
 
-template <bool doR, bool doG, bool doB>
 void
 natronImageToLibMvFloatImageForChannels(const Image* source,
                                         const RectI& roi,
+                                        float rWeight,
+                                        float gWeight,
+                                        float bWeight,
                                         MvFloatImage& mvImg)
 {
     //mvImg is expected to have its bounds equal to roi
@@ -138,93 +167,279 @@ natronImageToLibMvFloatImageForChannels(const Image* source,
     unsigned int compsCount = source->getComponentsCount();
 
     assert(compsCount == 3);
-    unsigned int srcRowElements = source->getRowElements();
+    Q_UNUSED(compsCount);
 
     assert( source->getBounds().contains(roi) );
-    const float* src_pixels = (const float*)racc.pixelAt(roi.x1, roi.y1);
-    assert(src_pixels);
     float* dst_pixels = mvImg.Data();
     assert(dst_pixels);
     //LibMV images have their origin in the top left hand corner
 
-    // It's important to rescale the resultappropriately so that e.g. if only
-    // blue is selected, it's not zeroed out.
-    float scale = (doR ? 0.2126f : 0.0f) +
-                  (doG ? 0.7152f : 0.0f) +
-                  (doB ? 0.0722f : 0.0f);
     int h = roi.height();
     int w = roi.width();
-    for ( int y = 0; y < h; ++y,
-          src_pixels += (srcRowElements - compsCount * w) ) {
-        for (int x = 0; x < w; ++x,
-             src_pixels += compsCount,
-             ++dst_pixels) {
-            /// Apply luminance conversion while we copy the image
-            /// This code is taken from DisableChannelsTransform::run in libmv/autotrack/autotrack.cc
-            *dst_pixels = ( 0.2126f * (doR ? src_pixels[0] : 0.0f) +
-                            0.7152f * (doG ? src_pixels[1] : 0.0f) +
-                            0.0722f * (doB ? src_pixels[2] : 0.0f) ) / scale;
+    for (int y = 0; y < h; ++y, dst_pixels += w) {
+        const float* src_pixels = (const float*)racc.pixelAt(roi.x1, roi.y1 + y);
+        assert(src_pixels);
+        // Branch-free loop with constant weights, so that the compiler can vectorize it
+        for (int x = 0; x < w; ++x) {
+            dst_pixels[x] = rWeight * src_pixels[x * 3] + gWeight * src_pixels[x * 3 + 1] + bWeight * src_pixels[x * 3 + 2];
         }
     }
 }
 
 static void
-natronImageToLibMvFloatImage(bool enabledChannels[3],
+natronImageToLibMvFloatImage(const bool enabledChannels[3],
                              const Image* source,
                              const RectI& roi,
                              MvFloatImage& mvImg)
 {
-    if (enabledChannels[0]) {
-        if (enabledChannels[1]) {
-            if (enabledChannels[2]) {
-                natronImageToLibMvFloatImageForChannels<true, true, true>(source, roi, mvImg);
-            } else {
-                natronImageToLibMvFloatImageForChannels<true, true, false>(source, roi, mvImg);
-            }
-        } else {
-            if (enabledChannels[2]) {
-                natronImageToLibMvFloatImageForChannels<true, false, true>(source, roi, mvImg);
-            } else {
-                natronImageToLibMvFloatImageForChannels<true, false, false>(source, roi, mvImg);
+    /// Apply luminance conversion while we copy the image
+    /// The coefficients are taken from DisableChannelsTransform::run in libmv/autotrack/autotrack.cc
+    float r = enabledChannels[0] ? 0.2126f : 0.f;
+    float g = enabledChannels[1] ? 0.7152f : 0.f;
+    float b = enabledChannels[2] ? 0.0722f : 0.f;
+
+    // It's important to rescale the result appropriately so that e.g. if only
+    // blue is selected, it's not zeroed out.
+    float scale = r + g + b;
+
+    if (scale > 0.f) {
+        r /= scale;
+        g /= scale;
+        b /= scale;
+    }
+    natronImageToLibMvFloatImageForChannels(source, roi, r, g, b, mvImg);
+}
+
+// Copies the region of the cached image to a new image of the size of the region, filled with zeroes outside of the cached bounds
+static MvFloatImagePtr
+extractRegion(const MvFloatImage& cached,
+              const RectI& cachedBounds,
+              const RectI& region)
+{
+    MvFloatImagePtr image = boost::make_shared<MvFloatImage>( region.height(), region.width() );
+    RectI intersection;
+
+    if ( !region.intersect(cachedBounds, &intersection) ) {
+        image->Fill(0.f);
+
+        return image;
+    }
+    if (intersection != region) {
+        image->Fill(0.f);
+    }
+    const float* src = cached.Data();
+    float* dst = image->Data();
+    for (int y = intersection.y1; y < intersection.y2; ++y) {
+        std::memcpy( dst + (std::size_t)(y - region.y1) * region.width() + (intersection.x1 - region.x1),
+                     src + (std::size_t)(y - cachedBounds.y1) * cachedBounds.width() + (intersection.x1 - cachedBounds.x1),
+                     intersection.width() * sizeof(float) );
+    }
+
+    return image;
+}
+
+static int
+floorToTile(int x)
+{
+    return x >= 0 ? (x / NATRON_TRACKER_FRAME_CACHE_TILE_SIZE) * NATRON_TRACKER_FRAME_CACHE_TILE_SIZE : -( (-x + NATRON_TRACKER_FRAME_CACHE_TILE_SIZE - 1) / NATRON_TRACKER_FRAME_CACHE_TILE_SIZE ) * NATRON_TRACKER_FRAME_CACHE_TILE_SIZE;
+}
+
+static int
+ceilToTile(int x)
+{
+    return -floorToTile(-x);
+}
+} // anon namespace
+
+struct TrackerFrameAccessorCachePrivate
+{
+    std::size_t maxBytes;
+    mutable QMutex lock;
+    FrameAccessorCacheEntries entries;
+    FrameAccessorCacheIndex index;
+    std::size_t bytes;
+
+    // Hash of the input of the last image stored
+    U64 inputHash;
+
+    TrackerFrameAccessorCachePrivate(std::size_t maxBytes)
+        : maxBytes(maxBytes)
+        , lock()
+        , entries()
+        , index()
+        , bytes(0)
+        , inputHash(0)
+    {
+    }
+
+    /**
+     * @brief Returns the size the cache may use: the images of the tracker count in the memory budget of the application,
+     * so they only use what the image caches leave.
+     **/
+    std::size_t getMaxBytes() const
+    {
+        U64 budget = (U64)( getSystemTotalRAM() * appPTR->getCurrentSettings()->getRamMaximumPercent() );
+        U64 used = appPTR->getCachesTotalMemorySize();
+        U64 available = budget > used ? budget - used : 0;
+
+        return (std::size_t)std::min( (U64)maxBytes, available );
+    }
+
+    // Must be called with lock held
+    FrameAccessorCacheEntries::iterator find(const FrameAccessorCacheKey& key,
+                                             const RectI& roi)
+    {
+        std::pair<FrameAccessorCacheIndex::iterator, FrameAccessorCacheIndex::iterator> range = index.equal_range(key);
+        for (FrameAccessorCacheIndex::iterator it = range.first; it != range.second; ++it) {
+            const RectI& bounds = it->second->requestedRoI;
+            if ( (roi.x1 >= bounds.x1) && (roi.x2 <= bounds.x2) && (roi.y1 >= bounds.y1) && (roi.y2 <= bounds.y2) ) {
+                return it->second;
             }
         }
-    } else {
-        if (enabledChannels[1]) {
-            if (enabledChannels[2]) {
-                natronImageToLibMvFloatImageForChannels<false, true, true>(source, roi, mvImg);
-            } else {
-                natronImageToLibMvFloatImageForChannels<false, true, false>(source, roi, mvImg);
+
+        return entries.end();
+    }
+
+    /**
+     * @brief Returns the image enclosing roi and its bounds, or NULL if there is none.
+     * The image stays valid even if it is evicted from the cache while in use.
+     **/
+    MvFloatImagePtr get(const FrameAccessorCacheKey& key,
+                        const RectI& roi,
+                        RectI* bounds)
+    {
+        QMutexLocker k(&lock);
+        FrameAccessorCacheEntries::iterator found = find(key, roi);
+
+        if ( found == entries.end() ) {
+            return MvFloatImagePtr();
+        }
+        // Mark as most recently used
+        entries.splice(entries.end(), entries, found);
+        *bounds = found->bounds;
+
+        return found->image;
+    }
+
+    bool contains(const FrameAccessorCacheKey& key,
+                  const RectI& roi)
+    {
+        QMutexLocker k(&lock);
+
+        return find(key, roi) != entries.end();
+    }
+
+    void insert(const FrameAccessorCacheEntry& entry)
+    {
+        std::size_t limit = getMaxBytes();
+        QMutexLocker k(&lock);
+
+        // Another thread may have rendered the same region in the meantime
+        if ( find(entry.key, entry.requestedRoI) != entries.end() ) {
+            return;
+        }
+
+        // The input changed: the images of the previous input are never requested again
+        if (entry.key.inputHash != inputHash) {
+            FrameAccessorCacheEntries::iterator it = entries.begin();
+            while ( it != entries.end() ) {
+                FrameAccessorCacheEntries::iterator next = it;
+                ++next;
+                if (it->key.inputHash != entry.key.inputHash) {
+                    remove(it);
+                }
+                it = next;
             }
-        } else {
-            if (enabledChannels[2]) {
-                natronImageToLibMvFloatImageForChannels<false, false, true>(source, roi, mvImg);
-            } else {
-                natronImageToLibMvFloatImageForChannels<false, false, false>(source, roi, mvImg);
+            inputHash = entry.key.inputHash;
+        }
+
+        FrameAccessorCacheEntries::iterator it = entries.insert(entries.end(), entry);
+        index.insert( std::make_pair(entry.key, it) );
+        bytes += entry.size;
+
+        // Remove the least recently used images until the cache fits in its limit
+        while ( bytes > limit && entries.size() > 1 ) {
+            remove( entries.begin() );
+        }
+    }
+
+    // Must be called with lock held
+    void remove(FrameAccessorCacheEntries::iterator it)
+    {
+        std::pair<FrameAccessorCacheIndex::iterator, FrameAccessorCacheIndex::iterator> range = index.equal_range(it->key);
+        for (FrameAccessorCacheIndex::iterator it2 = range.first; it2 != range.second; ++it2) {
+            if (it2->second == it) {
+                index.erase(it2);
+                break;
             }
         }
+        bytes -= it->size;
+        entries.erase(it);
     }
+};
+
+TrackerFrameAccessorCache::TrackerFrameAccessorCache(std::size_t maxBytes)
+    : _imp( new TrackerFrameAccessorCachePrivate(maxBytes) )
+{
 }
-} // anon namespace
 
+TrackerFrameAccessorCache::~TrackerFrameAccessorCache()
+{
+}
+
+std::size_t
+TrackerFrameAccessorCache::getMemoryUsage() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->bytes;
+}
+
+void
+TrackerFrameAccessorCache::clear()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->entries.clear();
+    _imp->index.clear();
+    _imp->bytes = 0;
+}
 
 struct TrackerFrameAccessorPrivate
 {
     const TrackerContext* context;
     NodePtr trackerInput;
-    mutable QMutex cacheMutex;
-    FrameAccessorCache cache;
+    TrackerFrameAccessorCachePtr cache;
     bool enabledChannels[3];
     int formatHeight;
 
+    // Images returned to LibMV and not released yet
+    QMutex imagesMutex;
+    std::map<const MvFloatImage*, MvFloatImagePtr> images;
+
+    // Protects prefetchStep, prefetchFuture and prefetchAbortInfo
+    QMutex prefetchMutex;
+    int prefetchStep;
+    QFuture<void> prefetchFuture;
+
+    // Aborts the render of the background prefetch
+    AbortableRenderInfoPtr prefetchAbortInfo;
+
     TrackerFrameAccessorPrivate(const TrackerContext* context,
+                                const TrackerFrameAccessorCachePtr& cache,
                                 bool enabledChannels[3],
                                 int formatHeight)
         : context(context)
         , trackerInput()
-        , cacheMutex()
-        , cache()
+        , cache(cache)
         , enabledChannels()
         , formatHeight(formatHeight)
+        , imagesMutex()
+        , images()
+        , prefetchMutex()
+        , prefetchStep(0)
+        , prefetchFuture()
+        , prefetchAbortInfo()
     {
         trackerInput = context->getNode()->getInput(0);
         assert(trackerInput);
@@ -232,131 +447,81 @@ struct TrackerFrameAccessorPrivate
             this->enabledChannels[i] = enabledChannels[i];
         }
     }
-};
 
-TrackerFrameAccessor::TrackerFrameAccessor(const TrackerContext* context,
-                                           bool enabledChannels[3],
-                                           int formatHeight)
-    : mv::FrameAccessor()
-    , _imp( new TrackerFrameAccessorPrivate(context, enabledChannels, formatHeight) )
-{
-}
-
-TrackerFrameAccessor::~TrackerFrameAccessor()
-{
-}
-
-void
-TrackerFrameAccessor::getEnabledChannels(bool* r,
-                                         bool* g,
-                                         bool* b) const
-{
-    *r = _imp->enabledChannels[0];
-    *g = _imp->enabledChannels[1];
-    *b = _imp->enabledChannels[2];
-}
+    FrameAccessorCacheKey makeKey(int frame,
+                                  int downscale) const
+    {
+        FrameAccessorCacheKey key;
 
-double
-TrackerFrameAccessor::invertYCoordinate(double yIn,
-                                        double formatHeight)
-{
-    return formatHeight - 1 - yIn;
-}
+        key.inputHash = trackerInput ? trackerInput->getHashValue() : 0;
+        key.frame = frame;
+        key.mipMapLevel = downscale;
+        key.mode = mv::FrameAccessor::MONO;
+        key.channels = (enabledChannels[0] ? 1 : 0) | (enabledChannels[1] ? 2 : 0) | (enabledChannels[2] ? 4 : 0);
 
-void
-TrackerFrameAccessor::convertLibMVRegionToRectI(const mv::Region& region,
-                                                int /*formatHeight*/,
-                                                RectI* roi)
-{
-    roi->x1 = region.min(0);
-    roi->x2 = region.max(0);
-    roi->y1 = region.min(1);
-    //roi->y1 = invertYCoordinate(region.max(1), formatHeight);
-    roi->y2 = region.max(1);
-    //roi->y2 = invertYCoordinate(region.min(1), formatHeight);
-}
+        return key;
+    }
 
-/*
- * @brief This is called by LibMV to retrieve an image either for reference or as search frame.
- */
-mv::FrameAccessor::Key
-TrackerFrameAccessor::GetImage(int /*clip*/,
-                               int frame,
-                               mv::FrameAccessor::InputMode input_mode,
-                               int downscale,            // Downscale by 2^downscale.
-                               const mv::Region* region,     // Get full image if NULL.
-                               const mv::FrameAccessor::Transform* /*transform*/, // May be NULL.
-                               mv::FloatImage** destination)
-{
-    // Since libmv only uses MONO images for now we have only optimized for this case, remove and handle properly
-    // other case(s) when they get integrated into libmv.
-    assert(input_mode == mv::FrameAccessor::MONO);
+    /**
+     * @brief Renders the input of the tracker in the given roi and converts it for LibMV. If roi is null, the full image is rendered.
+     * Returns an entry with a null image on failure.
+     **/
+    FrameAccessorCacheEntry renderImage(int frame,
+                                        int downscale,
+                                        const RectI& roi,
+                                        const AbortableRenderInfoPtr& abortInfo);
 
+    // Must be called with prefetchMutex held
+    void cancelPrefetch();
 
-    FrameAccessorCacheKey key;
-    key.frame = frame;
-    key.mipMapLevel = downscale;
-    key.mode = input_mode;
+    void startPrefetch(TrackerFrameAccessor* accessor,
+                       int frame,
+                       int downscale,
+                       const RectI& roi);
+};
 
-    /*
-       Check if a frame exists in the cache with matching key and bounds enclosing the given region
-     */
-    RectI roi;
-    if (region) {
-        convertLibMVRegionToRectI(*region, _imp->formatHeight, &roi);
+FrameAccessorCacheEntry
+TrackerFrameAccessorPrivate::renderImage(int frame,
+                                         int downscale,
+                                         const RectI& requestedRoI,
+                                         const AbortableRenderInfoPtr& abortInfo)
+{
+    FrameAccessorCacheEntry entry;
 
-        QMutexLocker k(&_imp->cacheMutex);
-        std::pair<FrameAccessorCache::iterator, FrameAccessorCache::iterator> range = _imp->cache.equal_range(key);
-        for (FrameAccessorCache::iterator it = range.first; it != range.second; ++it) {
-            if ( (roi.x1 >= it->second.bounds.x1) && (roi.x2 <= it->second.bounds.x2) &&
-                 ( roi.y1 >= it->second.bounds.y1) && ( roi.y2 <= it->second.bounds.y2) ) {
-#ifdef TRACE_LIB_MV
-                qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Found cached image at frame" << frame << "with RoI x1="
-                         << region->min(0) << "y1=" << region->max(1) << "x2=" << region->max(0) << "y2=" << region->min(1);
-#endif
-                // LibMV is kinda dumb on this we must necessarily copy the data either via CopyFrom or the
-                // assignment constructor:
-                // EDIT: fixed libmv
-                *destination = it->second.image.get();
-                //destination->CopyFrom<float>(*it->second.image);
-                ++it->second.referenceCount;
-
-                return (mv::FrameAccessor::Key)it->second.image.get();
-            }
-        }
-    }
+    entry.key = makeKey(frame, downscale);
+    entry.size = 0;
 
     EffectInstancePtr effect;
-    if (_imp->trackerInput) {
-        effect = _imp->trackerInput->getEffectInstance();
+    if (trackerInput) {
+        effect = trackerInput->getEffectInstance();
     }
     if (!effect) {
-        return (mv::FrameAccessor::Key)0;
+        return entry;
     }
 
     // Not in accessor cache, call renderRoI
     RenderScale scale;
     scale.y = scale.x = Image::getScaleFromMipMapLevel( (unsigned int)downscale );
 
-
+    RectI roi = requestedRoI;
     RectD precomputedRoD;
-    if (!region) {
+    if ( roi.isNull() ) {
         bool isProjectFormat;
-        StatusEnum stat = effect->getRegionOfDefinition_public(_imp->trackerInput->getHashValue(), frame, scale, ViewIdx(0), &precomputedRoD, &isProjectFormat);
+        StatusEnum stat = effect->getRegionOfDefinition_public(trackerInput->getHashValue(), frame, scale, ViewIdx(0), &precomputedRoD, &isProjectFormat);
         if (stat == eStatusFailed) {
-            return (mv::FrameAccessor::Key)0;
+            return entry;
         }
         double par = effect->getAspectRatio(-1);
         precomputedRoD.toPixelEnclosing( (unsigned int)downscale, par, &roi );
     }
+    entry.requestedRoI = roi;
 
     std::list<ImagePlaneDesc> components;
     components.push_back( ImagePlaneDesc::getRGBComponents() );
 
-    NodePtr node = _imp->context->getNode();
+    NodePtr node = context->getNode();
     const bool isRenderUserInteraction = true;
     const bool isSequentialRender = false;
-    AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(false, 0);
     AbortableThread* isAbortable = dynamic_cast<AbortableThread*>( QThread::currentThread() );
     if (isAbortable) {
         isAbortable->setAbortInfo( isRenderUserInteraction, abortInfo, node->getEffectInstance() );
@@ -383,7 +548,7 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
                                         components,
                                         eImageBitDepthFloat,
                                         true,
-                                        _imp->context->getNode()->getEffectInstance().get(),
+                                        node->getEffectInstance().get(),
                                         eStorageModeRAM /*returnOpenGLTex*/,
                                         frame);
     std::map<ImagePlaneDesc, ImagePtr> planes;
@@ -394,7 +559,7 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
                  << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2;
 #endif
 
-        return (mv::FrameAccessor::Key)0;
+        return entry;
     }
 
     assert( !planes.empty() );
@@ -407,7 +572,7 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
                  << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2 << ")";
 #endif
 
-        return (mv::FrameAccessor::Key)0;
+        return entry;
     }
 
 #ifdef TRACE_LIB_MV
@@ -418,49 +583,210 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
     /*
        Copy the Natron image to the LivMV float image
      */
-    FrameAccessorCacheEntry entry;
     entry.image = boost::make_shared<MvFloatImage>( intersectedRoI.height(), intersectedRoI.width() );
     entry.bounds = intersectedRoI;
-    entry.referenceCount = 1;
-    natronImageToLibMvFloatImage(_imp->enabledChannels,
+    entry.size = (std::size_t)intersectedRoI.area() * sizeof(float);
+    natronImageToLibMvFloatImage(enabledChannels,
                                  sourceImage.get(),
                                  intersectedRoI,
                                  *entry.image);
+
     // we ignore the transform parameter and do it in natronImageToLibMvFloatImage instead
 
-    *destination = entry.image.get();
-    //destination->CopyFrom<float>(*entry.image);
+    return entry;
+} // TrackerFrameAccessorPrivate::renderImage
 
-    //insert into the cache
-    {
-        QMutexLocker k(&_imp->cacheMutex);
-        _imp->cache.insert( std::make_pair(key, entry) );
+TrackerFrameAccessor::TrackerFrameAccessor(const TrackerContext* context,
+                                           const TrackerFrameAccessorCachePtr& cache,
+                                           bool enabledChannels[3],
+                                           int formatHeight)
+    : mv::FrameAccessor()
+    , _imp( new TrackerFrameAccessorPrivate(context, cache, enabledChannels, formatHeight) )
+{
+}
+
+TrackerFrameAccessor::~TrackerFrameAccessor()
+{
+    // The prefetch thread uses this object
+    QMutexLocker k(&_imp->prefetchMutex);
+
+    _imp->cancelPrefetch();
+}
+
+void
+TrackerFrameAccessorPrivate::cancelPrefetch()
+{
+    if (prefetchAbortInfo) {
+        prefetchAbortInfo->setAborted();
+    }
+    prefetchFuture.waitForFinished();
+    prefetchAbortInfo.reset();
+}
+
+void
+TrackerFrameAccessor::endTracking()
+{
+    QMutexLocker k(&_imp->prefetchMutex);
+
+    _imp->prefetchStep = 0;
+    _imp->cancelPrefetch();
+}
+
+void
+TrackerFrameAccessor::getEnabledChannels(bool* r,
+                                         bool* g,
+                                         bool* b) const
+{
+    *r = _imp->enabledChannels[0];
+    *g = _imp->enabledChannels[1];
+    *b = _imp->enabledChannels[2];
+}
+
+void
+TrackerFrameAccessor::setPrefetchStep(int frameStep)
+{
+    QMutexLocker k(&_imp->prefetchMutex);
+
+    _imp->prefetchStep = frameStep;
+}
+
+double
+TrackerFrameAccessor::invertYCoordinate(double yIn,
+                                        double formatHeight)
+{
+    return formatHeight - 1 - yIn;
+}
+
+void
+TrackerFrameAccessor::convertLibMVRegionToRectI(const mv::Region& region,
+                                                int /*formatHeight*/,
+                                                RectI* roi)
+{
+    roi->x1 = region.min(0);
+    roi->x2 = region.max(0);
+    roi->y1 = region.min(1);
+    //roi->y1 = invertYCoordinate(region.max(1), formatHeight);
+    roi->y2 = region.max(1);
+    //roi->y2 = invertYCoordinate(region.min(1), formatHeight);
+}
+
+void
+TrackerFrameAccessor::prefetchImage(int frame,
+                                    int downscale,
+                                    const RectI& roi,
+                                    AbortableRenderInfoPtr abortInfo)
+{
+    FrameAccessorCacheEntry entry = _imp->renderImage(frame, downscale, roi, abortInfo);
+
+    appPTR->getAppTLS()->cleanupTLSForThread();
+    if ( entry.image && !abortInfo->isAborted() ) {
+        _imp->cache->_imp->insert(entry);
+    }
+}
+
+void
+TrackerFrameAccessorPrivate::startPrefetch(TrackerFrameAccessor* accessor,
+                                           int frame,
+                                           int downscale,
+                                           const RectI& roi)
+{
+    QMutexLocker k(&prefetchMutex);
+
+    // Only one frame is rendered ahead at a time
+    if ( (prefetchStep == 0) || !prefetchFuture.isFinished() ) {
+        return;
+    }
+    int nextFrame = frame + prefetchStep;
+    if ( cache->_imp->contains(makeKey(nextFrame, downscale), roi) ) {
+        return;
     }
+    // The render can be aborted when the track operation ends
+    prefetchAbortInfo = AbortableRenderInfo::create(true, 0);
+    prefetchFuture = QtConcurrent::run(accessor, &TrackerFrameAccessor::prefetchImage, nextFrame, downscale, roi, prefetchAbortInfo);
+}
+
+/*
+ * @brief This is called by LibMV to retrieve an image either for reference or as search frame.
+ */
+mv::FrameAccessor::Key
+TrackerFrameAccessor::GetImage(int /*clip*/,
+                               int frame,
+                               mv::FrameAccessor::InputMode input_mode,
+                               int downscale,            // Downscale by 2^downscale.
+                               const mv::Region* region,     // Get full image if NULL.
+                               const mv::FrameAccessor::Transform* /*transform*/, // May be NULL.
+                               mv::FloatImage** destination)
+{
+    // Since libmv only uses MONO images for now we have only optimized for this case, remove and handle properly
+    // other case(s) when they get integrated into libmv.
+    assert(input_mode == mv::FrameAccessor::MONO);
+    Q_UNUSED(input_mode);
+
+    FrameAccessorCacheKey key = _imp->makeKey(frame, downscale);
+    TrackerFrameAccessorCachePrivate* cache = _imp->cache->_imp.get();
+
+    /*
+       Check if a frame exists in the cache with matching key and bounds enclosing the given region.
+       LibMV expects the image to start exactly at the region, so the region is copied out of the cached image.
+     */
+    RectI regionRoI, cacheRoI;
+    MvFloatImagePtr cachedImage;
+    RectI cachedBounds;
+    if (region) {
+        convertLibMVRegionToRectI(*region, _imp->formatHeight, &regionRoI);
+        cachedImage = cache->get(key, regionRoI, &cachedBounds);
 #ifdef TRACE_LIB_MV
-    qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Rendered frame" << frame << "with RoI x1="
-             << intersectedRoI.x1 << "y1=" << intersectedRoI.y1 << "x2=" << intersectedRoI.x2 << "y2=" << intersectedRoI.y2;
+        if (cachedImage) {
+            qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Found cached image at frame" << frame << "with RoI x1="
+                     << region->min(0) << "y1=" << region->max(1) << "x2=" << region->max(0) << "y2=" << region->min(1);
+        }
 #endif
+        // Render a larger area so that other markers in the same area can use it
+        cacheRoI.x1 = floorToTile(regionRoI.x1);
+        cacheRoI.y1 = floorToTile(regionRoI.y1);
+        cacheRoI.x2 = ceilToTile(regionRoI.x2);
+        cacheRoI.y2 = ceilToTile(regionRoI.y2);
+    }
 
-    return (mv::FrameAccessor::Key)entry.image.get();
+    if (!cachedImage) {
+        FrameAccessorCacheEntry entry = _imp->renderImage( frame, downscale, cacheRoI, AbortableRenderInfo::create(false, 0) );
+        if (!entry.image) {
+            return (mv::FrameAccessor::Key)0;
+        }
+        cache->insert(entry);
+        cachedImage = entry.image;
+        cachedBounds = entry.bounds;
+        if (!region) {
+            regionRoI = entry.bounds;
+        }
+#ifdef TRACE_LIB_MV
+        qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Rendered frame" << frame << "with RoI x1="
+                 << entry.bounds.x1 << "y1=" << entry.bounds.y1 << "x2=" << entry.bounds.x2 << "y2=" << entry.bounds.y2;
+#endif
+    }
+
+    // Render the same area on the next frame while this one is being tracked
+    if (region) {
+        _imp->startPrefetch(this, frame, downscale, cacheRoI);
+    }
+
+    MvFloatImagePtr image = extractRegion(*cachedImage, cachedBounds, regionRoI);
+    {
+        QMutexLocker k(&_imp->imagesMutex);
+        _imp->images.insert( std::make_pair(image.get(), image) );
+    }
+    *destination = image.get();
+
+    return (mv::FrameAccessor::Key)image.get();
 } // TrackerFrameAccessor::GetImage
 
 
 void
 TrackerFrameAccessor::ReleaseImage(Key key)
 {
-    MvFloatImage* imgKey = (MvFloatImage*)key;
-    QMutexLocker k(&_imp->cacheMutex);
+    QMutexLocker k(&_imp->imagesMutex);
 
-    for (FrameAccessorCache::iterator it = _imp->cache.begin(); it != _imp->cache.end(); ++it) {
-        if (it->second.image.get() == imgKey) {
-            --it->second.referenceCount;
-            if (!it->second.referenceCount) {
-                _imp->cache.erase(it);
-
-                return;
-            }
-        }
-    }
+    _imp->images.erase( (const MvFloatImage*)key );
 }
 
 /*
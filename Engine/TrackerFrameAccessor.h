@@ -28,6 +28,8 @@
 
 #include "Global/Macros.h"
 
+#include <cstddef> // std::size_t
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
 #endif
@@ -36,9 +38,47 @@
 
 #include <libmv/autotrack/frame_accessor.h>
 
+// Maximum size of the images kept by the TrackerFrameAccessorCache of a tracker once they are released by LibMV.
+// The cache never uses more than what the image caches leave of the memory budget of the application.
+#define NATRON_TRACKER_FRAME_CACHE_MAX_BYTES (512 * 1024 * 1024)
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief Cache of the images converted for LibMV, for each frame and pyramid level.
+ * It is owned by the TrackerContext and shared by all the markers and all the tracking passes (forward, backward, refine...),
+ * so that a frame is rendered and converted only once as long as its input does not change.
+ * Images are keyed by the hash of the input: images rendered with another hash are removed as soon as an image of the
+ * current input is stored. The cache is emptied when the input is reconnected or the node is deactivated.
+ * Images that are not used by LibMV anymore are evicted in least recently used order once the cache exceeds its maximum size,
+ * or the part of the application memory budget left by the image caches.
+ **/
+struct TrackerFrameAccessorCachePrivate;
+class TrackerFrameAccessorCache
+{
+public:
+
+    TrackerFrameAccessorCache(std::size_t maxBytes);
+
+    ~TrackerFrameAccessorCache();
+
+    /**
+     * @brief Returns the memory used by the cached images, in bytes
+     **/
+    std::size_t getMemoryUsage() const;
+
+    /**
+     * @brief Removes all images that are not used by LibMV
+     **/
+    void clear();
+
+private:
+
+    friend class TrackerFrameAccessor;
+
+    boost::scoped_ptr<TrackerFrameAccessorCachePrivate> _imp;
+};
+
 struct TrackerFrameAccessorPrivate;
 class TrackerFrameAccessor
     : public mv::FrameAccessor
@@ -46,6 +86,7 @@ class TrackerFrameAccessor
 public:
 
     TrackerFrameAccessor(const TrackerContext* context,
+                         const TrackerFrameAccessorCachePtr& cache,
                          bool enabledChannels[3],
                          int formatHeight);
 
@@ -54,6 +95,18 @@ public:
 
     void getEnabledChannels(bool* r, bool* g, bool* b) const;
 
+    /**
+     * @brief If non zero, each time an image is requested, the same region of the image frameStep frames later
+     * is rendered in the background so that it is ready when the marker is tracked on the next frame.
+     **/
+    void setPrefetchStep(int frameStep);
+
+    /**
+     * @brief Aborts and waits for the render of the next frame in the background. The images of the cache are kept
+     * for the next track operations. Called when the track operation ends or is aborted.
+     **/
+    void endTracking();
+
 
     // Get a possibly-filtered version of a frame of a video. Downscale will
     // cause the input image to get downscaled by 2^downscale for pyramid access.
@@ -101,6 +154,8 @@ public:
 
 private:
 
+    void prefetchImage(int frame, int downscale, const RectI& roi, AbortableRenderInfoPtr abortInfo);
+
     boost::scoped_ptr<TrackerFrameAccessorPrivate> _imp;
 };
 
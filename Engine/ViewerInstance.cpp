@@ -104,6 +104,78 @@ struct MinMaxVal {
     double max;
 };
 
+typedef std::pair<double, RectI> DistanceToFocusAndTile;
+
+struct DistanceToFocusAndTile_Compare
+{
+    bool operator() (const DistanceToFocusAndTile& lhs,
+                     const DistanceToFocusAndTile& rhs) const
+    {
+        return lhs.first < rhs.first;
+    }
+};
+
+/**
+ * @brief Splits the tiles that are not rendered yet in groups so that the tiles closest to the focus point
+ * (in pixel coordinates) are rendered and displayed first. The first group has minTilesPerGroup tiles and each group
+ * is twice as large as the previous one, which bounds the number of passes.
+ * For each group, renderRects receives the bounding box of all the tiles rendered so far, clipped to the roi: the images
+ * of the previous groups are in the cache so only the new tiles are rendered, and the image returned covers all of them.
+ * The last group renders the whole roi. Nothing is returned if everything fits in the first group.
+ **/
+void
+computeProgressiveTileGroups(const std::list<UpdateViewerParams::CachedTile>& tiles,
+                             const RectI& roi,
+                             double focusX,
+                             double focusY,
+                             int minTilesPerGroup,
+                             std::vector<RectI>* renderRects,
+                             std::vector<std::vector<RectI> >* tileGroups)
+{
+    std::vector<DistanceToFocusAndTile> sortedTiles;
+    for (std::list<UpdateViewerParams::CachedTile>::const_iterator it = tiles.begin(); it != tiles.end(); ++it) {
+        if (it->ramBuffer) {
+            continue;
+        }
+        double dx = (it->rectRounded.x1 + it->rectRounded.x2) / 2. - focusX;
+        double dy = (it->rectRounded.y1 + it->rectRounded.y2) / 2. - focusY;
+        sortedTiles.push_back( std::make_pair(dx * dx + dy * dy, it->rectRounded) );
+    }
+    if ( (int)sortedTiles.size() <= minTilesPerGroup ) {
+        return;
+    }
+
+    // Keep the raster order for tiles at the same distance
+    std::stable_sort( sortedTiles.begin(), sortedTiles.end(), DistanceToFocusAndTile_Compare() );
+
+    RectI renderedBbox;
+    std::size_t groupSize = minTilesPerGroup;
+    std::vector<RectI> group;
+    for (std::size_t i = 0; i < sortedTiles.size(); ++i) {
+        const RectI& tile = sortedTiles[i].second;
+        if ( renderedBbox.isNull() ) {
+            renderedBbox = tile;
+        } else {
+            renderedBbox.merge(tile);
+        }
+        group.push_back(tile);
+
+        const bool isLastTile = i == sortedTiles.size() - 1;
+        if ( !isLastTile && (group.size() < groupSize) ) {
+            continue;
+        }
+        // The last group renders the whole roi, as a non progressive render would
+        RectI renderRect = roi;
+        if ( !isLastTile && !renderedBbox.intersect(roi, &renderRect) ) {
+            continue;
+        }
+        renderRects->push_back(renderRect);
+        tileGroups->push_back(group);
+        group.clear();
+        groupSize *= 2;
+    }
+} // computeProgressiveTileGroups
+
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 static void scaleToTexture8bits(const RectI& roi,
@@ -181,6 +253,7 @@ ViewerInstance::ViewerInstance(NodePtr node)
 
     QObject::connect( this, SIGNAL(disconnectTextureRequest(int,bool)), this, SLOT(executeDisconnectTextureRequestOnMainThread(int,bool)) );
     QObject::connect( _imp.get(), SIGNAL(mustRedrawViewer()), this, SLOT(redrawViewer()) );
+    QObject::connect( _imp.get(), SIGNAL(progressiveTilesRendered(UpdateViewerParamsPtr)), _imp.get(), SLOT(onProgressiveTilesRendered(UpdateViewerParamsPtr)), Qt::QueuedConnection );
     QObject::connect( this, SIGNAL(s_callRedrawOnMainThread()), this, SLOT(redrawViewer()) );
 }
 
@@ -884,6 +957,17 @@ ViewerInstance::setupMinimalUpdateViewerParams(const SequenceTime time,
             }
         }
         outArgs->mipMapLevelWithDraft = (unsigned int)std::max( (int)outArgs->mipmapLevelWithoutDraft, (int)autoProxyLevel );
+
+        // Pick the highest resolution whose estimated render time meets the target, the auto-proxy level being the lowest resolution allowed
+        int targetLatency = appPTR->getCurrentSettings()->getAutoProxyTargetLatency();
+        if (targetLatency > 0) {
+            outArgs->mipMapLevelWithDraft = _imp->getLatencyTargetedMipMapLevel(textureIndex,
+                                                                                outArgs->activeInputToRender,
+                                                                                targetLatency,
+                                                                                outArgs->mipmapLevelWithoutDraft,
+                                                                                outArgs->mipMapLevelWithDraft,
+                                                                                outArgs->mipMapLevelWithDraft);
+        }
     }
 
 
@@ -1364,6 +1448,10 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
             return eViewerRenderRetCodeRender;
         }
     }
+
+    // Measures the render time for the auto-proxy
+    TimeLapse renderTimer;
+
     AbortableThread* isAbortable = dynamic_cast<AbortableThread*>( QThread::currentThread() );
     if (isAbortable) {
         isAbortable->setAbortInfo( !isSequentialRender, inArgs.params->abortInfo, getNode()->getEffectInstance() );
@@ -1487,15 +1575,37 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
 
     EffectInstance::NotifyInputNRenderingStarted_RAII inputNIsRendering_RAII(getNode().get(), inArgs.activeInputIndex);
     std::vector<RectI> splitRoi;
+    // For a single frame rendered in the texture cache, the tiles are rendered in groups so that the ones closest
+    // to where the user is looking are displayed first. Each group is uploaded as soon as it is ready.
+    // This is not done with auto-contrast, which needs the whole RoI to compute a single gain and offset.
+    std::vector<std::vector<RectI> > progressiveTileGroups;
     if (inArgs.isDoingPartialUpdates) {
         for (std::list<UpdateViewerParams::CachedTile>::iterator it = inArgs.params->tiles.begin(); it != inArgs.params->tiles.end(); ++it) {
             splitRoi.push_back(it->rect);
         }
     } else {
-        /*
-           Just render 1 tile
-         */
-        splitRoi.push_back(roi);
+        if (useTextureCache && !isSequentialRender && !singleThreaded && !inArgs.autoContrast) {
+            double focusX = (roi.x1 + roi.x2) / 2.;
+            double focusY = (roi.y1 + roi.y2) / 2.;
+            if (_imp->uiContext) {
+                // Canonical to pixel coordinates at the mipmap level of the render
+                const double scale = Image::getScaleFromMipMapLevel(inArgs.params->mipMapLevel);
+                _imp->uiContext->getRenderFocusPoint(&focusX, &focusY);
+                focusX = focusX * scale / inArgs.params->pixelAspectRatio;
+                focusY = focusY * scale;
+            }
+            computeProgressiveTileGroups(inArgs.params->tiles, roi, focusX, focusY, std::max(1, appPTR->getMaxThreadCount()), &splitRoi, &progressiveTileGroups);
+            if (progressiveTileGroups.size() < 2) {
+                splitRoi.clear();
+                progressiveTileGroups.clear();
+            }
+        }
+        if ( splitRoi.empty() ) {
+            /*
+               Just render 1 tile
+             */
+            splitRoi.push_back(roi);
+        }
     }
 
 
@@ -1774,6 +1884,12 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
             }
             std::string inputToRenderName = inArgs.activeInputToRender->getNode()->getScriptName_mt_safe();
             for (std::list<UpdateViewerParams::CachedTile>::iterator it = updateParams->tiles.begin(); it != updateParams->tiles.end(); ++it) {
+                // In a progressive render, only convert the tiles of the current group that were not done by a previous pass
+                if ( !progressiveTileGroups.empty() && !it->isCached &&
+                     ( it->ramBuffer ||
+                       ( std::find(progressiveTileGroups[rectIndex].begin(), progressiveTileGroups[rectIndex].end(), it->rectRounded) == progressiveTileGroups[rectIndex].end() ) ) ) {
+                    continue;
+                }
                 if (it->isCached) {
                     assert(it->ramBuffer);
                 } else {
@@ -1898,7 +2014,9 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
             }
         } else {
             bool runInCurrentThread = QThreadPool::globalInstance()->activeThreadCount() >= QThreadPool::globalInstance()->maxThreadCount();
-            if ( !runInCurrentThread && (splitRoi.size() > 1) ) {
+            // Partial updates render many small rectangles, whereas progressive passes are split so that each one is
+            // rendered by all the threads
+            if ( !runInCurrentThread && (splitRoi.size() > 1) && progressiveTileGroups.empty() ) {
                 runInCurrentThread = true;
             }
 
@@ -1983,6 +2101,24 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
         if ( colorImage && stats && stats->isInDepthProfilingEnabled() ) {
             stats->addRenderInfosForNode( getNode(), NodePtr(), colorImage->getComponents().getChannelsLabel(), viewerRenderRoI, viewerRenderTimeRecorder->getTimeSinceCreation() );
         }
+
+        // Send the tiles of the progressive render done so far to the viewer, unless the render is no longer needed
+        if ( !progressiveTileGroups.empty() && (rectIndex + 1 < progressiveTileGroups.size()) ) {
+            if ( inArgs.activeInputToRender->aborted() ||
+                 ( inArgs.activeInputToRender->getHash() != inArgs.activeInputHash ) ||
+                 ( inArgs.params->time != getTimeline()->currentFrame() ) ) {
+                return eViewerRenderRetCodeRedraw;
+            }
+            UpdateViewerParamsPtr progressParams = boost::make_shared<UpdateViewerParams>(*updateParams);
+            progressParams->mustFreeRamBuffer = false;
+            progressParams->tiles.clear();
+            for (std::list<UpdateViewerParams::CachedTile>::const_iterator it = updateParams->tiles.begin(); it != updateParams->tiles.end(); ++it) {
+                if (it->ramBuffer) {
+                    progressParams->tiles.push_back(*it);
+                }
+            }
+            _imp->notifyProgressiveTilesRendered(progressParams);
+        }
     } // for (std::vector<RectI>::iterator rect = splitRoi.begin(); rect != splitRoi.end(), ++rect) {
 
 
@@ -1996,6 +2132,10 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
         return eViewerRenderRetCodeRedraw;
     }
 
+    if (!isSequentialRender) {
+        _imp->recordRenderLatency(inArgs.params->textureIndex, inArgs.activeInputToRender, renderTimer.getTimeSinceCreation() * 1000., roi, inArgs.params->roi, inArgs.params->mipMapLevel);
+    }
+
     return eViewerRenderRetCodeRender;
 } // renderViewer_internal
 
@@ -2029,18 +2169,58 @@ ViewerInstance::updateViewer(UpdateViewerParamsPtr & frame)
     _imp->updateViewer( boost::dynamic_pointer_cast<UpdateViewerParams>(frame) );
 }
 
+static bool
+isImageConstantOverRect(const ImageConstPtr& image,
+                        const RectI& rect)
+{
+    return image->isConstant() && image->getBounds().contains(rect);
+}
+
 void
 renderFunctor(const RectI& roi,
               const RenderViewerArgs & args,
               ViewerInstance* viewer,
               UpdateViewerParams::CachedTile tile)
 {
+    // If the input is constant over the rows to convert, they are all the same: convert only the first row and copy it.
+    // Note that 8-bit textures are dithered the same way on all rows in that case.
+    const RectI rowsRect = args.renderOnlyRoI ? roi : tile.rect;
+    const bool replicateFirstRow = rowsRect.height() > 1 &&
+                                   isImageConstantOverRect(args.inputImage, rowsRect) &&
+                                   ( !args.matteImage || isImageConstantOverRect(args.matteImage, rowsRect) );
+    RectI convertRoI = roi;
+    if (replicateFirstRow) {
+        if (args.renderOnlyRoI) {
+            convertRoI.y2 = convertRoI.y1 + 1;
+        } else {
+            tile.rect.y2 = tile.rect.y1 + 1;
+        }
+    }
+
+    std::size_t pixelSize, rowSize;
     if ( (args.bitDepth == eImageBitDepthFloat) ) {
         // image is stored as linear, the OpenGL shader with do gamma/sRGB/Rec709 decompression, as well as gain and offset
-        scaleToTexture32bits(roi, args, tile, (float*)tile.ramBuffer);
+        scaleToTexture32bits(convertRoI, args, tile, (float*)tile.ramBuffer);
+        pixelSize = 4 * sizeof(float);
+        rowSize = args.renderOnlyRoI ? tile.rect.width() * pixelSize : args.tileRowElements * sizeof(float);
     } else {
         // texture is stored as sRGB/Rec709 compressed 8-bit RGBA
-        scaleToTexture8bits(roi, args, viewer, tile, (U32*)tile.ramBuffer);
+        scaleToTexture8bits(convertRoI, args, viewer, tile, (U32*)tile.ramBuffer);
+        pixelSize = sizeof(U32);
+        rowSize = args.renderOnlyRoI ? tile.rect.width() * pixelSize : args.tileRowElements * sizeof(U32);
+    }
+
+    if (replicateFirstRow) {
+        unsigned char* firstRow;
+        if (args.renderOnlyRoI) {
+            firstRow = tile.ramBuffer + (rowsRect.y1 - tile.rect.y1) * rowSize + (rowsRect.x1 - tile.rect.x1) * pixelSize;
+        } else {
+            firstRow = tile.ramBuffer + (rowsRect.y1 - tile.rectRounded.y1) * rowSize + (rowsRect.x1 - tile.rectRounded.x1) * pixelSize;
+        }
+        unsigned char* dstRow = firstRow + rowSize;
+        for (int y = rowsRect.y1 + 1; y < rowsRect.y2; ++y, dstRow += rowSize) {
+            std::memcpy(dstRow, firstRow, rowsRect.width() * pixelSize);
+        }
     }
 }
 
@@ -2135,13 +2315,115 @@ findAutoContrastVminVmax_generic(const ImagePtr inputImage,
     return MinMaxVal(localVmin, localVmax);
 } // findAutoContrastVminVmax_generic
 
+template <int nComps>
+inline void
+getAutoContrastPixel(const float* pix,
+                     float* r,
+                     float* g,
+                     float* b,
+                     float* a)
+{
+    switch (nComps) {
+    case 4:
+        *r = pix[0];
+        *g = pix[1];
+        *b = pix[2];
+        *a = pix[3];
+        break;
+    case 3:
+        *r = pix[0];
+        *g = pix[1];
+        *b = pix[2];
+        *a = 1.f;
+        break;
+    case 2:
+        *r = pix[0];
+        *g = pix[1];
+        *b = 0.f;
+        *a = 1.f;
+        break;
+    case 1:
+        *a = pix[0];
+        *r = *g = *b = 0.f;
+        break;
+    default:
+        *r = *g = *b = *a = 0.f;
+    }
+}
+
+template <int nComps, DisplayChannelsEnum channels>
+MinMaxVal
+findAutoContrastVminVmax_internal(const ImagePtr inputImage,
+                                  const RectI & rect)
+{
+    float localVmin = std::numeric_limits<float>::infinity();
+    float localVmax = -std::numeric_limits<float>::infinity();
+    Image::ReadAccess acc = inputImage->getReadRights();
+    const int width = rect.width();
+
+    for (int y = rect.bottom(); y < rect.top(); ++y) {
+        const float* src_pixels = (const float*)acc.pixelAt(rect.left(), y);
+        // The channels are known at compile time and the loop has no branch, so that the compiler can vectorize it
+        for (int x = 0; x < width; ++x, src_pixels += nComps) {
+            float r, g, b, a;
+            getAutoContrastPixel<nComps>(src_pixels, &r, &g, &b, &a);
+
+            float mini, maxi;
+            switch (channels) {
+            case eDisplayChannelsRGB:
+                mini = std::min(std::min(r, g), b);
+                maxi = std::max(std::max(r, g), b);
+                break;
+            case eDisplayChannelsY:
+                mini = 0.299f * r + 0.587f * g + 0.114f * b;
+                maxi = mini;
+                break;
+            case eDisplayChannelsR:
+                mini = maxi = r;
+                break;
+            case eDisplayChannelsG:
+                mini = maxi = g;
+                break;
+            case eDisplayChannelsB:
+                mini = maxi = b;
+                break;
+            case eDisplayChannelsA:
+                mini = maxi = a;
+                break;
+            default:
+                mini = maxi = 0.f;
+                break;
+            }
+            localVmin = mini < localVmin ? mini : localVmin;
+            localVmax = maxi > localVmax ? maxi : localVmax;
+        }
+    }
+
+    return MinMaxVal(localVmin, localVmax);
+}
+
 template <int nComps>
 MinMaxVal
 findAutoContrastVminVmax_internal(const ImagePtr inputImage,
                                   DisplayChannelsEnum channels,
                                   const RectI & rect)
 {
-    return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+    switch (channels) {
+    case eDisplayChannelsRGB:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsRGB>(inputImage, rect);
+    case eDisplayChannelsY:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsY>(inputImage, rect);
+    case eDisplayChannelsR:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsR>(inputImage, rect);
+    case eDisplayChannelsG:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsG>(inputImage, rect);
+    case eDisplayChannelsB:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsB>(inputImage, rect);
+    case eDisplayChannelsA:
+        return findAutoContrastVminVmax_internal<nComps, eDisplayChannelsA>(inputImage, rect);
+    default:
+        return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+    }
 }
 
 MinMaxVal
@@ -2151,14 +2433,23 @@ findAutoContrastVminVmax(const ImagePtr inputImage,
 {
     int nComps = inputImage->getComponents().getNumComponents();
 
+    RectI pixelsRect = rect;
+    if ( inputImage->isConstant() && rect.intersect(inputImage->getBounds(), &pixelsRect) ) {
+        // All pixels have the same value: look at only one of them
+        pixelsRect.x2 = pixelsRect.x1 + 1;
+        pixelsRect.y2 = pixelsRect.y1 + 1;
+    }
+
     if (nComps == 4) {
-        return findAutoContrastVminVmax_internal<4>(inputImage, channels, rect);
+        return findAutoContrastVminVmax_internal<4>(inputImage, channels, pixelsRect);
     } else if (nComps == 3) {
-        return findAutoContrastVminVmax_internal<3>(inputImage, channels, rect);
+        return findAutoContrastVminVmax_internal<3>(inputImage, channels, pixelsRect);
+    } else if (nComps == 2) {
+        return findAutoContrastVminVmax_internal<2>(inputImage, channels, pixelsRect);
     } else if (nComps == 1) {
-        return findAutoContrastVminVmax_internal<1>(inputImage, channels, rect);
+        return findAutoContrastVminVmax_internal<1>(inputImage, channels, pixelsRect);
     } else {
-        return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+        return findAutoContrastVminVmax_generic(inputImage, nComps, channels, pixelsRect);
     }
 } // findAutoContrastVminVmax
 
@@ -2989,6 +3280,69 @@ ViewerInstance::ViewerInstancePrivate::updateViewer(UpdateViewerParamsPtr params
     //    updateViewerCond.wakeOne();
 } // ViewerInstance::ViewerInstancePrivate::updateViewer
 
+void
+ViewerInstance::ViewerInstancePrivate::onProgressiveTilesRendered(UpdateViewerParamsPtr params)
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+
+    // A more recent render may have been displayed since these tiles were sent
+    if ( !uiContext || !checkAgeNoUpdate( params->textureIndex, params->abortInfo->getRenderAge() ) ) {
+        return;
+    }
+    updateViewer(params);
+    redrawViewer();
+}
+
+void
+ViewerInstance::ViewerInstancePrivate::recordRenderLatency(int texIndex,
+                                                           const EffectInstancePtr& input,
+                                                           double msecs,
+                                                           const RectI& renderedRoI,
+                                                           const RectI& viewerRoI,
+                                                           unsigned int mipMapLevel)
+{
+    if ( renderedRoI.isNull() || (msecs <= 0.) ) {
+        return;
+    }
+    const double msPerPixel = msecs / (double)renderedRoI.area();
+    // The number of pixels is divided by 4 at each mipmap level
+    const double pixelsAtFullRes = (double)viewerRoI.area() * (double)( 1 << (2 * mipMapLevel) );
+
+    QMutexLocker k(&autoProxyMutex);
+    if ( (autoProxyMsPerPixel[texIndex] == 0.) || (autoProxyInput[texIndex].lock() != input) ) {
+        autoProxyInput[texIndex] = input;
+        autoProxyMsPerPixel[texIndex] = msPerPixel;
+    } else {
+        // Smooth the variations between renders while still following quickly a change of the cost of the tree
+        autoProxyMsPerPixel[texIndex] = (autoProxyMsPerPixel[texIndex] + msPerPixel) / 2.;
+    }
+    autoProxyViewerPixels[texIndex] = pixelsAtFullRes;
+}
+
+unsigned int
+ViewerInstance::ViewerInstancePrivate::getLatencyTargetedMipMapLevel(int texIndex,
+                                                                     const EffectInstancePtr& input,
+                                                                     double targetMsecs,
+                                                                     unsigned int minLevel,
+                                                                     unsigned int maxLevel,
+                                                                     unsigned int defaultLevel) const
+{
+    QMutexLocker k(&autoProxyMutex);
+
+    if ( (autoProxyMsPerPixel[texIndex] == 0.) || (autoProxyInput[texIndex].lock() != input) ) {
+        return defaultLevel;
+    }
+    double estimatedMsecs = autoProxyMsPerPixel[texIndex] * autoProxyViewerPixels[texIndex] / (double)( 1 << (2 * minLevel) );
+    unsigned int level = minLevel;
+    while ( (level < maxLevel) && (estimatedMsecs > targetMsecs) ) {
+        ++level;
+        estimatedMsecs /= 4.;
+    }
+
+    return level;
+}
+
 bool
 ViewerInstance::isInputOptional(int n) const
 {
@@ -154,8 +154,14 @@ public:
         , renderAgeMutex()
         , renderAge()
         , displayAge()
+        , autoProxyMutex()
+        , autoProxyInput()
+        , autoProxyMsPerPixel()
+        , autoProxyViewerPixels()
     {
         for (int i = 0; i < 2; ++i) {
+            autoProxyMsPerPixel[i] = 0.;
+            autoProxyViewerPixels[i] = 0.;
             forceRender[i] = false;
             renderAge[i] = 1;
             displayAge[i] = 0;
@@ -169,6 +175,11 @@ public:
         Q_EMIT mustRedrawViewer();
     }
 
+    void notifyProgressiveTilesRendered(const UpdateViewerParamsPtr& params)
+    {
+        Q_EMIT progressiveTilesRendered(params);
+    }
+
 public:
 
     virtual void lock(const FrameEntryPtr& entry) OVERRIDE FINAL
@@ -350,6 +361,29 @@ public:
         }
     }
 
+    /**
+     * @brief Records the time taken by a render of the viewer that was not fully cached, to estimate
+     * the render time at other proxy levels. renderedRoI is the portion that was rendered and viewerRoI
+     * the portion of the image visible in the viewer, both at the given mipmap level.
+     **/
+    void recordRenderLatency(int texIndex,
+                             const EffectInstancePtr& input,
+                             double msecs,
+                             const RectI& renderedRoI,
+                             const RectI& viewerRoI,
+                             unsigned int mipMapLevel);
+
+    /**
+     * @brief Returns the lowest mipmap level in [minLevel, maxLevel] whose estimated render time is below targetMsecs,
+     * or defaultLevel if no render of this input was recorded yet.
+     **/
+    unsigned int getLatencyTargetedMipMapLevel(int texIndex,
+                                               const EffectInstancePtr& input,
+                                               double targetMsecs,
+                                               unsigned int minLevel,
+                                               unsigned int maxLevel,
+                                               unsigned int defaultLevel) const;
+
 public Q_SLOTS:
 
     /**
@@ -358,10 +392,18 @@ public Q_SLOTS:
      **/
     void updateViewer(UpdateViewerParamsPtr params);
 
+    /**
+     * @brief Slot called internally by renderViewer_internal() when a group of tiles of a progressive render is ready,
+     * to upload it before the rest of the frame is rendered. Do not call this yourself.
+     **/
+    void onProgressiveTilesRendered(UpdateViewerParamsPtr params);
+
 Q_SIGNALS:
 
     void mustRedrawViewer();
 
+    void progressiveTilesRendered(UpdateViewerParamsPtr params);
+
 public:
     const ViewerInstance* const instance;
     OpenGLViewerI* uiContext; // written in the main thread before render thread creation, accessed from render thread
@@ -424,6 +466,12 @@ public:
     //A priority list recording the ongoing renders. This is used for abortable renders (i.e: when moving a slider or scrubbing the timeline)
     //The purpose of this is to always at least keep 1 active render (non abortable) and abort more recent renders that do no longer make sense
     OnGoingRenders currentRenderAges[2];
+
+    // Render cost measured on the recent renders, used to choose the auto-proxy level
+    mutable QMutex autoProxyMutex; // protects autoProxyInput autoProxyMsPerPixel autoProxyViewerPixels
+    EffectInstanceWPtr autoProxyInput[2]; // the input the cost was measured for
+    double autoProxyMsPerPixel[2]; // moving average of the render time per pixel, 0 if unknown
+    double autoProxyViewerPixels[2]; // number of pixels visible in the viewer at full resolution
 };
 
 NATRON_NAMESPACE_EXIT
@@ -106,6 +106,15 @@ typedef OfxRangeD RangeD;
 
 #define kBgProcessServerCreatedShort "--bg_server_created"
 
+///these are used between the render coordinator (NatronRenderer -j) and its render worker processes
+#define kRenderWorkerReadyShort "-y"
+
+#define kRenderWorkerErrorShort "-x"
+
+#define kRenderWorkerChunkShort "-k"
+
+#define kRenderWorkerQuitShort "-q"
+
 //Increment this to wipe all disk cache structure and ensure that the user has a clean cache when starting the next version of Natron
 #define NATRON_CACHE_VERSION 4
 #define kNatronCacheVersionSettingsKey "NatronCacheVersionSettingsKey"
@@ -106,6 +106,10 @@ namespace NATRON_PYTHON_NAMESPACE { }
 
 #define NATRON_PROJECT_ENV_VAR_MAX_RECURSION 100
 #define NATRON_MAX_CACHE_FILES_OPENED 20000
+#define NATRON_DISKCACHE_NODE_DATA_FILE_EXT "ntdc"
+#define NATRON_DISKCACHE_NODE_INDEX_FILE_EXT "ntdi"
+#define NATRON_DISKCACHE_NODE_LOCK_FILE_EXT "ntdl"
+#define NATRON_DISKCACHE_NODE_STORAGE_DIR "DiskCacheNodes"
 #define NATRON_CUSTOM_HTML_TAG_START "<" NATRON_APPLICATION_NAME ">"
 #define NATRON_CUSTOM_HTML_TAG_END "</" NATRON_APPLICATION_NAME ">"
 
@@ -113,6 +117,9 @@ namespace NATRON_PYTHON_NAMESPACE { }
 #define NATRON_FILE_DIALOG_PREVIEW_READER_NAME "Natron_File_Dialog_Preview_Provider_Reader"
 #define NATRON_FILE_DIALOG_PREVIEW_VIEWER_NAME "Natron_File_Dialog_Preview_Provider_Viewer"
 
+// Maximum number of directory entries kept in the file dialog directory listings cache
+#define NATRON_FILE_DIALOG_LISTINGS_CACHE_MAX_ENTRIES 5000
+
 //////////////////////////////////////////Natron version/////////////////////////////////////////////
 
 // The currently maintained Natron versions
@@ -201,6 +208,9 @@ namespace NATRON_PYTHON_NAMESPACE { }
 #define NATRON_BREAKPAD_PIPE_ARG "breakpad_pipe_path"
 #define NATRON_BREAKPAD_COM_PIPE_ARG "breakpad_com_pipe_path"
 
+// Passed by the render coordinator (NatronRenderer --workers) to the worker processes it launches
+#define NATRON_RENDER_WORKER_ARG "render-worker"
+
 #define NATRON_NATRON_TO_BREAKPAD_EXISTENCE_CHECK "-e"
 #define NATRON_NATRON_TO_BREAKPAD_EXISTENCE_CHECK_ACK "-eack"
 
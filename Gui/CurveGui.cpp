@@ -27,6 +27,7 @@
 
 #include <cmath>
 #include <algorithm> // min, max
+#include <limits>
 #include <stdexcept>
 
 #include <QtCore/QThread>
@@ -47,6 +48,39 @@
 
 NATRON_NAMESPACE_ENTER
 
+struct CurveGuiDrawCache
+{
+    // The curve the keyframes were copied from and its revision at that time
+    CurvePtr curve;
+    U64 revision;
+    KeyFrameSet keyframes;
+
+    // The view the vertices were computed for
+    bool verticesValid;
+    QPointF btmLeft, topRight;
+    int width, height;
+
+    // Visible part of the curve, drawn as a line strip
+    std::vector<float> lineVertices;
+
+    // Visible keyframes, at most one marker per pixel
+    std::vector<float> keyVertices;
+
+    CurveGuiDrawCache()
+        : curve()
+        , revision(0)
+        , keyframes()
+        , verticesValid(false)
+        , btmLeft()
+        , topRight()
+        , width(0)
+        , height(0)
+        , lineVertices()
+        , keyVertices()
+    {
+    }
+};
+
 CurveGui::CurveGui(CurveWidget *curveWidget,
                    CurvePtr curve,
                    const QString & name,
@@ -59,6 +93,7 @@ CurveGui::CurveGui(CurveWidget *curveWidget,
     , _thickness(thickness)
     , _visible(false)
     , _selected(false)
+    , _drawCache( new CurveGuiDrawCache() )
 {
     // always running in the main thread
     assert( qApp && qApp->thread() == QThread::currentThread() );
@@ -247,12 +282,19 @@ CurveGui::getInternalCurve() const
     return _internalCurve;
 }
 
+/**
+ * @brief Keeps the vertices of the line strip that are visible in the view.
+ * Vertices that are out of the view are skipped, except the one preceding a visible vertex which is pushed far away
+ * vertically, so that the line enters the view with the right slope.
+ **/
 static void
-drawLineStrip(const std::vector<float>& vertices,
+clipLineStrip(const std::vector<float>& vertices,
               const QPointF& btmLeft,
-              const QPointF& topRight)
+              const QPointF& topRight,
+              std::vector<float>* visibleVertices)
 {
-    glBegin(GL_LINE_STRIP);
+    visibleVertices->clear();
+    visibleVertices->reserve( vertices.size() );
 
     bool prevVisible = true;
     bool prevTooAbove = false;
@@ -276,17 +318,140 @@ drawLineStrip(const std::vector<float>& vertices,
             //At least draw the previous point otherwise this will draw a line between the last previous point and this point
             //Draw them 10000 units further so that we're sure we don't see half of a pixel of a line remaining
             if (previousWasTooAbove) {
-                glVertex2f(vertices[i - 2], vertices[i - 1] + 100000);
+                visibleVertices->push_back(vertices[i - 2]);
+                visibleVertices->push_back(vertices[i - 1] + 100000);
             } else if (previousWasTooBelow) {
-                glVertex2f(vertices[i - 2], vertices[i - 1] - 100000);
+                visibleVertices->push_back(vertices[i - 2]);
+                visibleVertices->push_back(vertices[i - 1] - 100000);
             }
         }
-        glVertex2f(vertices[i], vertices[i + 1]);
+        visibleVertices->push_back(vertices[i]);
+        visibleVertices->push_back(vertices[i + 1]);
     }
+}
 
-    glEnd();
+/**
+ * @brief Draws 2D vertices (x, y pairs) from a client-side vertex array in a single call.
+ **/
+static void
+drawVertexArray(GLenum mode,
+                const std::vector<float>& vertices)
+{
+    if ( vertices.empty() ) {
+        return;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, &vertices.front());
+    glDrawArrays(mode, 0, (GLsizei)(vertices.size() / 2));
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+void
+CurveGui::computeCurveVertices(const KeyFrameSet & keyframes,
+                               const QPointF & btmLeft,
+                               const QPointF & topRight,
+                               std::vector<float>* lineVertices,
+                               std::vector<float>* keyVertices)
+{
+    lineVertices->clear();
+    keyVertices->clear();
+    if ( keyframes.empty() ) {
+        return;
+    }
+
+    BezierCPCurveGui* isBezier = dynamic_cast<BezierCPCurveGui*>(this);
+    CurvePtr curve;
+    bool isPeriodic = false;
+    std::pair<double,double> parametricRange = std::make_pair(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+    if (!isBezier) {
+        curve = getInternalCurve();
+        isPeriodic = curve->isCurvePeriodic();
+        parametricRange = curve->getXRange();
+    }
+
+    const double widgetWidth = _curveWidget->width();
+    std::vector<float> vertices;
+    // The times at which the curve must be evaluated and the index of the corresponding y in vertices
+    std::vector<double> sampleTimes;
+    std::vector<std::size_t> sampleIndices;
+
+    try {
+        double x1 = 0;
+        double x2;
+        bool isX1AKey = false;
+        KeyFrame x1Key;
+        KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
+
+        // First compute where to sample the curve, the positions do not depend on the values of the curve
+        while ( x1 < (widgetWidth - 1) ) {
+            double x;
+            if (!isX1AKey) {
+                x = _curveWidget->toZoomCoordinates(x1, 0).x();
+                sampleTimes.push_back(x);
+                sampleIndices.push_back(vertices.size() + 1);
+                vertices.push_back( (float)x );
+                vertices.push_back(0.f);
+            } else {
+                x = x1Key.getTime();
+                vertices.push_back( (float)x );
+                vertices.push_back( (float)x1Key.getValue() );
+            }
+
+            nextPointForSegment(x, keyframes, isPeriodic, parametricRange.first, parametricRange.second,  &lastUpperIt, &x2, &x1Key, &isX1AKey);
+            x1 = x2;
+        }
+        //also add the last point
+        {
+            double x = _curveWidget->toZoomCoordinates(x1, 0).x();
+            sampleTimes.push_back(x);
+            sampleIndices.push_back(vertices.size() + 1);
+            vertices.push_back( (float)x );
+            vertices.push_back(0.f);
+        }
+
+        // Then evaluate the curve at all these times at once
+        std::vector<double> values;
+        if (curve) {
+            curve->getValuesAt(sampleTimes, false, &values);
+        } else {
+            values.resize( sampleTimes.size() );
+            for (std::size_t i = 0; i < sampleTimes.size(); ++i) {
+                values[i] = evaluate(false, sampleTimes[i]);
+            }
+        }
+        assert( values.size() == sampleIndices.size() );
+        for (std::size_t i = 0; i < sampleIndices.size(); ++i) {
+            vertices[sampleIndices[i]] = (float)values[i];
+        }
+    } catch (...) {
+        vertices.clear();
+    }
+
+    clipLineStrip(vertices, btmLeft, topRight, lineVertices);
+
+    // Keyframe markers: when zoomed out, many keyframes fall on the same pixel, only draw the first one
+    const double pixelWidth = ( topRight.x() - btmLeft.x() ) / std::max(_curveWidget->width() - 1, 1);
+    const double pixelHeight = ( topRight.y() - btmLeft.y() ) / std::max(_curveWidget->height() - 1, 1);
+    bool hasPrevMarker = false;
+    double prevMarkerX = 0., prevMarkerY = 0.;
+    for (KeyFrameSet::const_iterator it = keyframes.lower_bound( KeyFrame(btmLeft.x(), 0.) );
+         it != keyframes.end() && it->getTime() <= topRight.x(); ++it) {
+        const double x = it->getTime();
+        const double y = it->getValue();
+        if ( ( y < btmLeft.y() ) || ( y > topRight.y() ) ) {
+            continue;
+        }
+        if ( hasPrevMarker && (x - prevMarkerX < pixelWidth) && (std::abs(y - prevMarkerY) < pixelHeight) ) {
+            continue;
+        }
+        keyVertices->push_back( (float)x );
+        keyVertices->push_back( (float)y );
+        hasPrevMarker = true;
+        prevMarkerX = x;
+        prevMarkerY = y;
+    }
+} // computeCurveVertices
+
 void
 CurveGui::drawCurve(int curveIndex,
                     int curvesCount)
@@ -300,11 +465,8 @@ CurveGui::drawCurve(int curveIndex,
 
     assert( QGLContext::currentContext() == _curveWidget->context() );
 
-    std::vector<float> vertices, exprVertices;
-    double x1 = 0;
-    double x2;
+    std::vector<float> exprVertices;
     const double widgetWidth = _curveWidget->width();
-    KeyFrameSet keyframes;
     BezierCPCurveGui* isBezier = dynamic_cast<BezierCPCurveGui*>(this);
     KnobCurveGui* isKnobCurve = dynamic_cast<KnobCurveGui*>(this);
     bool hasDrawnExpr = false;
@@ -315,7 +477,7 @@ CurveGui::drawCurve(int curveIndex,
         expr = knob->getExpression( isKnobCurve->getDimension() );
         if ( !expr.empty() ) {
             //we have no choice but to evaluate the expression at each time
-            for (int i = x1; i < widgetWidth; ++i) {
+            for (int i = 0; i < widgetWidth; ++i) {
                 double x = _curveWidget->toZoomCoordinates(i, 0).x();;
                 double y = knob->getValueAtWithExpression( x, ViewIdx(0), isKnobCurve->getDimension() );
                 exprVertices.push_back(x);
@@ -324,54 +486,42 @@ CurveGui::drawCurve(int curveIndex,
             hasDrawnExpr = true;
         }
     }
-    bool isPeriodic = false;
-    std::pair<double,double> parametricRange = std::make_pair(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+
+    // The keyframes are only copied from the curve when it has changed since the last repaint.
+    // Bezier keyframes have no revision, they are fetched each time.
+    bool keyframesChanged = true;
     if (isBezier) {
-        std::set<double> keys;
-        isBezier->getBezier()->getKeyframeTimes(&keys);
-        int i = 0;
-        for (std::set<double>::iterator it = keys.begin(); it != keys.end(); ++it, ++i) {
-            keyframes.insert( KeyFrame(*it, i) );
-        }
+        _drawCache->curve.reset();
+        _drawCache->keyframes = getKeyFrames();
     } else {
-        keyframes = getInternalCurve()->getKeyFrames_mt_safe();
-        isPeriodic = getInternalCurve()->isCurvePeriodic();
-        parametricRange = getInternalCurve()->getXRange();
-    }
-    if ( !keyframes.empty() ) {
-        try {
-            bool isX1AKey = false;
-            KeyFrame x1Key;
-            KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
-
-            while ( x1 < (widgetWidth - 1) ) {
-                double x, y;
-                if (!isX1AKey) {
-                    x = _curveWidget->toZoomCoordinates(x1, 0).x();
-                    y = evaluate(false, x);
-                } else {
-                    x = x1Key.getTime();
-                    y = x1Key.getValue();
-                }
-
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
-                nextPointForSegment(x, keyframes, isPeriodic, parametricRange.first, parametricRange.second,  &lastUpperIt, &x2, &x1Key, &isX1AKey);
-                x1 = x2;
-            }
-            //also add the last point
-            {
-                double x = _curveWidget->toZoomCoordinates(x1, 0).x();
-                double y = evaluate(false, x);
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
-            }
-        } catch (...) {
+        CurvePtr curve = getInternalCurve();
+        // Read the revision before the keyframes: if the curve changes in-between, the next repaint will fetch them again
+        U64 revision = curve->getRevision();
+        if ( (_drawCache->curve == curve) && (_drawCache->revision == revision) ) {
+            keyframesChanged = false;
+        } else {
+            _drawCache->curve = curve;
+            _drawCache->revision = revision;
+            _drawCache->keyframes = curve->getKeyFrames_mt_safe();
         }
     }
+    const KeyFrameSet & keyframes = _drawCache->keyframes;
 
     QPointF btmLeft = _curveWidget->toZoomCoordinates(0, _curveWidget->height() - 1);
     QPointF topRight = _curveWidget->toZoomCoordinates(_curveWidget->width() - 1, 0);
+
+    // The vertices depend on the curve and on the view
+    if ( keyframesChanged || !_drawCache->verticesValid ||
+         ( _drawCache->btmLeft != btmLeft ) || ( _drawCache->topRight != topRight ) ||
+         ( _drawCache->width != _curveWidget->width() ) || ( _drawCache->height != _curveWidget->height() ) ) {
+        computeCurveVertices(keyframes, btmLeft, topRight, &_drawCache->lineVertices, &_drawCache->keyVertices);
+        _drawCache->verticesValid = true;
+        _drawCache->btmLeft = btmLeft;
+        _drawCache->topRight = topRight;
+        _drawCache->width = _curveWidget->width();
+        _drawCache->height = _curveWidget->height();
+    }
+
     const QColor & curveColor = _selected ?  _curveWidget->getSelectedCurveColor() : _color;
 
     {
@@ -412,11 +562,13 @@ CurveGui::drawCurve(int curveIndex,
         glLineWidth(1.5);
         glCheckError();
         if (hasDrawnExpr) {
-            drawLineStrip(exprVertices, btmLeft, topRight);
+            std::vector<float> visibleExprVertices;
+            clipLineStrip(exprVertices, btmLeft, topRight, &visibleExprVertices);
+            drawVertexArray(GL_LINE_STRIP, visibleExprVertices);
             glLineStipple(2, 0xAAAA);
             glEnable(GL_LINE_STIPPLE);
         }
-        drawLineStrip(vertices, btmLeft, topRight);
+        drawVertexArray(GL_LINE_STRIP, _drawCache->lineVertices);
         if (hasDrawnExpr) {
             glDisable(GL_LINE_STIPPLE);
         }
@@ -440,54 +592,51 @@ CurveGui::drawCurve(int curveIndex,
         if ( ( textX >= btmLeft.x() ) && ( textX <= topRight.x() ) && ( textY >= btmLeft.y() ) && ( textY <= topRight.y() ) ) {
             _curveWidget->renderText( textX, textY, _name, _color, _curveWidget->getFont() );
         }
-        glColor4f( curveColor.redF(), curveColor.greenF(), curveColor.blueF(), curveColor.alphaF() );
 
         //draw keyframes
         glPointSize(7.f);
         glEnable(GL_POINT_SMOOTH);
 
+        glColor4f( _color.redF(), _color.greenF(), _color.blueF(), _color.alphaF() );
+        drawVertexArray(GL_POINTS, _drawCache->keyVertices);
+        glCheckErrorIgnoreOSXBug();
+
+        //draw the selected keyframes over the others, in white
         const SelectedKeys & selectedKeyFrames = _curveWidget->getSelectedKeyFrames();
-        SelectedKeys::const_iterator selectedKeyFramesIt;
         SelectedKeys::const_iterator foundCurveSelected = selectedKeyFrames.end();
-        for (selectedKeyFramesIt = selectedKeyFrames.begin(); selectedKeyFramesIt != selectedKeyFrames.end(); ++selectedKeyFramesIt) {
+        for (SelectedKeys::const_iterator selectedKeyFramesIt = selectedKeyFrames.begin(); selectedKeyFramesIt != selectedKeyFrames.end(); ++selectedKeyFramesIt) {
             if (selectedKeyFramesIt->first.get() == this) {
                 foundCurveSelected = selectedKeyFramesIt;
                 break;
             }
         }
-
-        //bool isCurveSelected = foundCurveSelected != selectedKeyFrames.end();
-
-        for (KeyFrameSet::const_iterator k = keyframes.begin(); k != keyframes.end(); ++k) {
+        const bool singleKey = selectedKeyFrames.size() == 1 && selectedKeyFrames.begin()->second.size() == 1;
+        std::list<KeyPtr> noSelectedKeys;
+        const std::list<KeyPtr> & selectedKeys = foundCurveSelected != selectedKeyFrames.end() ? foundCurveSelected->second : noSelectedKeys;
+        for (std::list<KeyPtr>::const_iterator it2 = selectedKeys.begin(); it2 != selectedKeys.end(); ++it2) {
+            const KeyPtr & isSelected = *it2;
+            if (isSelected->curve.get() != this) {
+                continue;
+            }
+            KeyFrameSet::const_iterator k = keyframes.find( KeyFrame(isSelected->key.getTime(), 0.) );
+            if ( k == keyframes.end() ) {
+                continue;
+            }
             const KeyFrame & key = (*k);
 
             if ( ( key.getTime() < btmLeft.x() ) || ( key.getTime() > topRight.x() ) || ( key.getValue() < btmLeft.y() ) || ( key.getValue() > topRight.y() ) ) {
                 continue;
             }
 
-            glColor4f( _color.redF(), _color.greenF(), _color.blueF(), _color.alphaF() );
-
-            //if the key is selected change its color to white
-            KeyPtr isSelected;
-            if ( foundCurveSelected != selectedKeyFrames.end() ) {
-                for (std::list<KeyPtr>::const_iterator it2 = foundCurveSelected->second.begin();
-                     it2 != foundCurveSelected->second.end(); ++it2) {
-                    if ( ( (*it2)->key.getTime() == key.getTime() ) && ( (*it2)->curve.get() == this ) ) {
-                        isSelected = *it2;
-                        glColor4f(1.f, 1.f, 1.f, 1.f);
-                        break;
-                    }
-                }
-            }
-
             double x = key.getTime();
             double y = key.getValue();
+            glColor4f(1.f, 1.f, 1.f, 1.f);
             glBegin(GL_POINTS);
             glVertex2f(x, y);
             glEnd();
             glCheckErrorIgnoreOSXBug();
 
-            if ( !isBezier && isSelected && (key.getInterpolation() != eKeyframeTypeConstant) ) {
+            if ( !isBezier && (key.getInterpolation() != eKeyframeTypeConstant) ) {
                 QFontMetrics m( _curveWidget->getFont() );
 
 
@@ -507,7 +656,6 @@ CurveGui::drawCurve(int curveIndex,
                     glDisable(GL_LINE_STIPPLE);
                 }
 
-                bool singleKey = selectedKeyFrames.size() == 1 && selectedKeyFrames.begin()->second.size() == 1;
                 if (singleKey) { //if one keyframe, also draw the coordinates
                     double rounding = ipow(10, CURVEWIDGET_DERIVATIVE_ROUND_PRECISION);
                     QString leftDerivStr = QString::fromUtf8("l: %1").arg(std::floor( (key.getLeftDerivative() * rounding) + 0.5 ) / rounding);
@@ -541,8 +689,8 @@ CurveGui::drawCurve(int curveIndex,
                 glVertex2f( isSelected->leftTan.first, isSelected->leftTan.second );
                 glVertex2f( isSelected->rightTan.first, isSelected->rightTan.second );
                 glEnd();
-            } // if ( !isBezier && ( isSelected != selectedKeyFrames.end() ) && (key.getInterpolation() != eKeyframeTypeConstant) ) {
-        } // for (KeyFrameSet::const_iterator k = keyframes.begin(); k != keyframes.end(); ++k) {
+            } // if ( !isBezier && (key.getInterpolation() != eKeyframeTypeConstant) ) {
+        } // for (std::list<KeyPtr>::const_iterator it2 = selectedKeys.begin(); it2 != selectedKeys.end(); ++it2) {
     } // GLProtectAttrib(GL_HINT_BIT | GL_ENABLE_BIT | GL_LINE_BIT | GL_COLOR_BUFFER_BIT | GL_POINT_BIT | GL_CURRENT_BIT);
 
     glCheckError();
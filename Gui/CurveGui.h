@@ -31,6 +31,7 @@
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #endif
 
 CLANG_DIAG_OFF(deprecated)
@@ -47,6 +48,7 @@ CLANG_DIAG_ON(uninitialized)
 
 NATRON_NAMESPACE_ENTER
 
+struct CurveGuiDrawCache;
 class CurveGui
     : public QObject
 {
@@ -147,6 +149,16 @@ private:
                              KeyFrame* key,
                              bool* isKey );
 
+    /**
+     * @brief Samples the curve across the widget and fills the vertices of the line strip and of the keyframe markers
+     * that are visible in the view, in curve coordinates.
+     **/
+    void computeCurveVertices(const KeyFrameSet & keyframes,
+                              const QPointF & btmLeft,
+                              const QPointF & topRight,
+                              std::vector<float>* lineVertices,
+                              std::vector<float>* keyVertices);
+
 protected:
 
     CurvePtr _internalCurve; ///ptr to the internal curve
@@ -159,6 +171,7 @@ private:
     int _thickness; /// its thickness
     bool _visible; /// should we draw this curve ?
     bool _selected; /// is this curve selected
+    boost::scoped_ptr<CurveGuiDrawCache> _drawCache; /// vertices drawn by drawCurve(), kept between repaints
 };
 
 typedef std::list<CurveGuiPtr> Curves;
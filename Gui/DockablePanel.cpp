@@ -472,6 +472,13 @@ DockablePanel::useScrollAreaForTabs() const
     return _imp->_useScrollAreasForTabs;
 }
 
+bool
+DockablePanel::createPagesWidgetsLazily() const
+{
+    // Pages are only made current through the tab widget, which calls setCurrentPage()
+    return _imp->_tabWidget != 0;
+}
+
 QWidget*
 DockablePanel::createKnobHorizontalFieldContainer(QWidget* parent) const
 {
@@ -155,6 +155,7 @@ public:
     virtual void refreshTabWidgetMaxHeight() OVERRIDE FINAL;
     virtual bool isPagingEnabled() const OVERRIDE FINAL;
     virtual bool useScrollAreaForTabs() const OVERRIDE FINAL;
+    virtual bool createPagesWidgetsLazily() const OVERRIDE FINAL;
     virtual void onKnobsInitialized() OVERRIDE FINAL;
 
     virtual void setPyPlugUIEnabled(bool enabled);
@@ -124,6 +124,35 @@ NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 ////////////////////////// DopeSheetView //////////////////////////
 
+/**
+ * @brief The keyframe quads of a node, gathered in one vertex array per texture so that each texture is drawn in a single call.
+ **/
+struct DSKeyframeQuads
+{
+    std::vector<float> vertices[KF_TEXTURES_COUNT];
+    std::vector<float> texCoords[KF_TEXTURES_COUNT];
+
+    // The keyframes next to which the selected time must be written
+    std::list<RectD> timeLabelRects;
+};
+
+/**
+ * @brief A copy of the keyframes of a curve, kept between repaints until the curve changes.
+ **/
+struct DSCurveKeyFrames
+{
+    CurveWPtr curve;
+    U64 revision;
+    KeyFrameSet keyframes;
+
+    DSCurveKeyFrames()
+        : curve()
+        , revision(0)
+        , keyframes()
+    {
+    }
+};
+
 class DopeSheetViewPrivate
 {
     Q_DECLARE_TR_FUNCTIONS(DopeSheetView)
@@ -217,11 +246,23 @@ public:
     void drawRange(const DSNodePtr &dsNode) const;
     void drawKeyframes(const DSNodePtr &dsNode) const;
 
-    void drawTexturedKeyframe(DopeSheetViewPrivate::KeyframeTexture textureType,
-                              bool drawTime,
-                              double time,
-                              const QColor& textColor,
-                              const RectD &rect) const;
+    const KeyFrameSet& getCurveKeyFrames(const CurvePtr& curve) const;
+
+    bool rowIsOnScreen(const QRect& rowRect) const;
+
+    void appendMasterKeyframeQuads(const std::map<double, bool>& keytimes,
+                                   double rowCenterYWidget,
+                                   bool hasSingleKfTimeSelected,
+                                   DSKeyframeQuads* quads) const;
+
+    void appendKeyframeQuad(DopeSheetViewPrivate::KeyframeTexture textureType,
+                            bool drawTime,
+                            const RectD &rect,
+                            DSKeyframeQuads* quads) const;
+
+    void drawKeyframeQuads(const DSKeyframeQuads& quads,
+                           double time,
+                           const QColor& textColor) const;
 
     void drawGroupOverlay(const DSNodePtr &dsNode, const DSNodePtr &group) const;
 
@@ -284,6 +325,9 @@ public:
     // for textures
     GLuint kfTexturesIDs[KF_TEXTURES_COUNT];
 
+    // keyframes of the drawn curves
+    mutable std::map<Curve*, DSCurveKeyFrames> curvesKeyFrames;
+
     // for navigating
     ZoomContext zoomContext;
     bool zoomOrPannedSinceLastFit;
@@ -325,6 +369,7 @@ DopeSheetViewPrivate::DopeSheetViewPrivate(DopeSheetView *qq)
     , font( new QFont(appFont, appFontSize) )
     , textRenderer()
     , kfTexturesIDs()
+    , curvesKeyFrames()
     , zoomContext()
     , zoomOrPannedSinceLastFit(false)
     , selectionRect()
@@ -979,6 +1024,15 @@ DopeSheetViewPrivate::drawRows() const
 
     DSTreeItemNodeMap treeItemsAndDSNodes = model->getItemNodeMap();
 
+    // Forget the keyframes of the curves that were deleted
+    for (std::map<Curve*, DSCurveKeyFrames>::iterator it = curvesKeyFrames.begin(); it != curvesKeyFrames.end();) {
+        if ( it->second.curve.expired() ) {
+            curvesKeyFrames.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
     // Perform drawing
     {
         GLProtectAttrib a(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT);
@@ -1247,7 +1301,8 @@ DopeSheetViewPrivate::drawRange(const DSNodePtr &dsNode) const
 /**
  * @brief DopeSheetViewPrivate::drawKeyframes
  *
- *
+ * The keyframes are gathered in one vertex array per texture and drawn at the end, with one draw call per texture.
+ * When zoomed out, keyframes of a row that fall within the same pixel with the same texture are drawn only once.
  */
 void
 DopeSheetViewPrivate::drawKeyframes(const DSNodePtr &dsNode) const
@@ -1260,186 +1315,254 @@ DopeSheetViewPrivate::drawKeyframes(const DSNodePtr &dsNode) const
     QColor selectionColor;
     selectionColor.setRgbF(selectionColorRGB[0], selectionColorRGB[1], selectionColorRGB[2]);
 
-    // Perform drawing
-    {
-        GLProtectAttrib a(GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT);
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        const DSTreeItemKnobMap& knobItems = dsNode->getItemKnobMap();
-        double kfTimeSelected;
-        int hasSingleKfTimeSelected = model->getSelectionModel()->hasSingleKeyFrameTimeSelected(&kfTimeSelected);
-        std::map<double, bool> nodeKeytimes;
-        std::map<DSKnob *, std::map<double, bool> > knobsKeytimes;
+    const double pixelWidth = zoomContext.screenPixelWidth();
+    DSKeyframeQuads quads;
 
-        for (DSTreeItemKnobMap::const_iterator it = knobItems.begin();
-             it != knobItems.end();
-             ++it) {
-            DSKnobPtr dsKnob = (*it).second;
-            QTreeWidgetItem *knobTreeItem = dsKnob->getTreeItem();
+    const DSTreeItemKnobMap& knobItems = dsNode->getItemKnobMap();
+    double kfTimeSelected;
+    int hasSingleKfTimeSelected = model->getSelectionModel()->hasSingleKeyFrameTimeSelected(&kfTimeSelected);
+    std::map<double, bool> nodeKeytimes;
+    std::map<DSKnob *, std::map<double, bool> > knobsKeytimes;
 
-            // The knob is no longer animated
-            if ( knobTreeItem->isHidden() ) {
-                continue;
+    // The selected keyframe times of each knob row, so that the selection is not searched for each keyframe
+    std::map<DSKnob *, std::set<double> > selectedKeytimes;
+    {
+        DopeSheetKeyPtrList selectedKeys;
+        std::vector<DSNodePtr> selectedNodes;
+        model->getSelectionModel()->getCurrentSelection(&selectedKeys, &selectedNodes);
+        for (DopeSheetKeyPtrList::const_iterator it = selectedKeys.begin(); it != selectedKeys.end(); ++it) {
+            DSKnobPtr knobContext = (*it)->context.lock();
+            if (knobContext) {
+                selectedKeytimes[knobContext.get()].insert( (*it)->key.getTime() );
             }
+        }
+    }
 
-            int dim = dsKnob->getDimension();
+    for (DSTreeItemKnobMap::const_iterator it = knobItems.begin();
+         it != knobItems.end();
+         ++it) {
+        DSKnobPtr dsKnob = (*it).second;
+        QTreeWidgetItem *knobTreeItem = dsKnob->getTreeItem();
 
-            if (dim == -1) {
-                continue;
-            }
+        // The knob is no longer animated
+        if ( knobTreeItem->isHidden() ) {
+            continue;
+        }
 
-            KeyFrameSet keyframes = dsKnob->getKnobGui()->getCurve(ViewIdx(0), dim)->getKeyFrames_mt_safe();
+        int dim = dsKnob->getDimension();
 
-            for (KeyFrameSet::const_iterator kIt = keyframes.begin();
-                 kIt != keyframes.end();
-                 ++kIt) {
-                KeyFrame kf = (*kIt);
-                double keyTime = kf.getTime();
+        if (dim == -1) {
+            continue;
+        }
 
-                // Clip keyframes horizontally //TODO Clip vertically too
-                if ( ( keyTime < zoomContext.left() ) || ( keyTime > zoomContext.right() ) ) {
-                    continue;
-                }
+        const KeyFrameSet& keyframes = getCurveKeyFrames( dsKnob->getKnobGui()->getCurve(ViewIdx(0), dim) );
 
-                double rowCenterYWidget = hierarchyView->visualItemRect( dsKnob->getTreeItem() ).center().y();
-                RectD zoomKfRect = getKeyFrameBoundingRectZoomCoords(keyTime, rowCenterYWidget);
-                bool kfSelected = model->getSelectionModel()->keyframeIsSelected(dsKnob, kf);
+        // Draw keyframe in the knob dim row only if it's visible
+        const QRect rowRect = hierarchyView->visualItemRect(knobTreeItem);
+        const bool drawInDimRow = hierarchyView->itemIsVisibleFromOutside(knobTreeItem) && rowIsOnScreen(rowRect);
+        const double rowCenterYWidget = rowRect.center().y();
+        DSKnobPtr rootDSKnob = model->mapNameItemToDSKnob( knobTreeItem->parent() );
+        std::map<double, bool>* knobTimes = rootDSKnob ? &knobsKeytimes[rootDSKnob.get()] : 0;
+        const std::set<double>& knobSelectedTimes = selectedKeytimes[dsKnob.get()];
 
-                // Draw keyframe in the knob dim row only if it's visible
-                bool drawInDimRow = hierarchyView->itemIsVisibleFromOutside(knobTreeItem);
+        DopeSheetViewPrivate::KeyframeTexture lastTexType = DopeSheetViewPrivate::kfTextureNone;
+        double lastDrawnTime = 0.;
 
-                if (drawInDimRow) {
-                    DopeSheetViewPrivate::KeyframeTexture texType = kfTextureFromKeyframeType( kf.getInterpolation(),
-                                                                                               kfSelected || selectionRect.intersects(zoomKfRect) );
+        // Clip keyframes horizontally
+        KeyFrameSet::const_iterator kEnd = keyframes.upper_bound( KeyFrame(zoomContext.right(), 0.) );
+        for (KeyFrameSet::const_iterator kIt = keyframes.lower_bound( KeyFrame(zoomContext.left(), 0.) );
+             kIt != kEnd;
+             ++kIt) {
+            const KeyFrame& kf = (*kIt);
+            double keyTime = kf.getTime();
+            bool kfSelected = knobSelectedTimes.find(keyTime) != knobSelectedTimes.end();
 
-                    if (texType != DopeSheetViewPrivate::kfTextureNone) {
-                        drawTexturedKeyframe(texType, hasSingleKfTimeSelected && kfSelected,
-                                             kfTimeSelected, selectionColor, zoomKfRect);
-                    }
+            if (drawInDimRow) {
+                RectD zoomKfRect = getKeyFrameBoundingRectZoomCoords(keyTime, rowCenterYWidget);
+                DopeSheetViewPrivate::KeyframeTexture texType = kfTextureFromKeyframeType( kf.getInterpolation(),
+                                                                                           kfSelected || selectionRect.intersects(zoomKfRect) );
+
+                if ( (texType != DopeSheetViewPrivate::kfTextureNone) &&
+                     ( (texType != lastTexType) || (keyTime - lastDrawnTime >= pixelWidth) ) ) {
+                    appendKeyframeQuad(texType, hasSingleKfTimeSelected && kfSelected, zoomKfRect, &quads);
+                    lastTexType = texType;
+                    lastDrawnTime = keyTime;
                 }
+            }
 
-                // Fill the knob times map
-                {
-                    DSKnobPtr rootDSKnob = model->mapNameItemToDSKnob( knobTreeItem->parent() );
-                    if (rootDSKnob) {
-                        assert(rootDSKnob);
-                        const std::map<double, bool>& map = knobsKeytimes[rootDSKnob.get()];
-                        bool knobTimeExists = ( map.find(keyTime) != map.end() );
-
-                        if (!knobTimeExists) {
-                            knobsKeytimes[rootDSKnob.get()][keyTime] = kfSelected;
-                        } else {
-                            bool knobTimeIsSelected = knobsKeytimes[rootDSKnob.get()][keyTime];
-
-                            if (!knobTimeIsSelected && kfSelected) {
-                                knobsKeytimes[rootDSKnob.get()][keyTime] = true;
-                            }
-                        }
-                    }
+            // Fill the knob times map
+            if (knobTimes) {
+                std::pair<std::map<double, bool>::iterator, bool> ret = knobTimes->insert( std::make_pair(keyTime, kfSelected) );
+                if (!ret.second && kfSelected) {
+                    ret.first->second = true;
                 }
+            }
 
-                // Fill the node times map
-                bool nodeTimeExists = ( nodeKeytimes.find(keyTime) != nodeKeytimes.end() );
-
-                if (!nodeTimeExists) {
-                    nodeKeytimes[keyTime] = kfSelected;
-                } else {
-                    bool nodeTimeIsSelected = nodeKeytimes[keyTime];
-
-                    if (!nodeTimeIsSelected && kfSelected) {
-                        nodeKeytimes[keyTime] = true;
-                    }
+            // Fill the node times map
+            {
+                std::pair<std::map<double, bool>::iterator, bool> ret = nodeKeytimes.insert( std::make_pair(keyTime, kfSelected) );
+                if (!ret.second && kfSelected) {
+                    ret.first->second = true;
                 }
             }
         }
+    }
 
-        // Draw master keys in knob root section
-        for (std::map<DSKnob *, std::map<double, bool> >::const_iterator it = knobsKeytimes.begin();
-             it != knobsKeytimes.end();
-             ++it) {
-            QTreeWidgetItem *knobRootItem = (*it).first->getTreeItem();
-            std::map<double, bool> knobTimes = (*it).second;
-
-            for (std::map<double, bool>::const_iterator mIt = knobTimes.begin();
-                 mIt != knobTimes.end();
-                 ++mIt) {
-                double time = (*mIt).first;
-                bool drawSelected = (*mIt).second;
-                bool drawInKnobRootRow = hierarchyView->itemIsVisibleFromOutside(knobRootItem);
-
-                if (drawInKnobRootRow) {
-                    double newCenterY = hierarchyView->visualItemRect(knobRootItem).center().y();
-                    RectD zoomKfRect = getKeyFrameBoundingRectZoomCoords(time, newCenterY);
-                    DopeSheetViewPrivate::KeyframeTexture textureType = (drawSelected)
-                                                                        ? DopeSheetViewPrivate::kfTextureMasterSelected
-                                                                        : DopeSheetViewPrivate::kfTextureMaster;
-
-                    drawTexturedKeyframe(textureType, hasSingleKfTimeSelected && drawSelected,
-                                         kfTimeSelected, selectionColor, zoomKfRect);
-                }
-            }
+    // Draw master keys in knob root section
+    for (std::map<DSKnob *, std::map<double, bool> >::const_iterator it = knobsKeytimes.begin();
+         it != knobsKeytimes.end();
+         ++it) {
+        QTreeWidgetItem *knobRootItem = (*it).first->getTreeItem();
+        const QRect rowRect = hierarchyView->visualItemRect(knobRootItem);
+        bool drawInKnobRootRow = hierarchyView->itemIsVisibleFromOutside(knobRootItem) && rowIsOnScreen(rowRect);
+
+        if (drawInKnobRootRow) {
+            appendMasterKeyframeQuads( (*it).second, rowRect.center().y(), hasSingleKfTimeSelected, &quads );
         }
+    }
 
-        // Draw master keys in node section
-        for (std::map<double, bool>::const_iterator it = nodeKeytimes.begin();
-             it != nodeKeytimes.end();
-             ++it) {
-            double time = (*it).first;
-            bool drawSelected = (*it).second;
-            QTreeWidgetItem *nodeItem = dsNode->getTreeItem();
-            bool drawInNodeRow = hierarchyView->itemIsVisibleFromOutside(nodeItem);
-
-            if (drawInNodeRow) {
-                double newCenterY = hierarchyView->visualItemRect(nodeItem).center().y();
-                RectD zoomKfRect = getKeyFrameBoundingRectZoomCoords(time, newCenterY);
-                DopeSheetViewPrivate::KeyframeTexture textureType = (drawSelected)
-                                                                    ? DopeSheetViewPrivate::kfTextureMasterSelected
-                                                                    : DopeSheetViewPrivate::kfTextureMaster;
-
-                drawTexturedKeyframe(textureType, hasSingleKfTimeSelected && drawSelected,
-                                     kfTimeSelected, selectionColor, zoomKfRect);
-            }
+    // Draw master keys in node section
+    {
+        QTreeWidgetItem *nodeItem = dsNode->getTreeItem();
+        const QRect rowRect = hierarchyView->visualItemRect(nodeItem);
+        bool drawInNodeRow = hierarchyView->itemIsVisibleFromOutside(nodeItem) && rowIsOnScreen(rowRect);
+
+        if (drawInNodeRow) {
+            appendMasterKeyframeQuads( nodeKeytimes, rowRect.center().y(), hasSingleKfTimeSelected, &quads );
         }
     }
+
+    // Perform drawing
+    drawKeyframeQuads(quads, kfTimeSelected, selectionColor);
 } // DopeSheetViewPrivate::drawKeyframes
 
+const KeyFrameSet&
+DopeSheetViewPrivate::getCurveKeyFrames(const CurvePtr& curve) const
+{
+    DSCurveKeyFrames& cached = curvesKeyFrames[curve.get()];
+
+    // Read the revision before the keyframes: if the curve changes in-between, the next repaint will fetch them again
+    U64 revision = curve->getRevision();
+    if ( (cached.curve.lock() != curve) || (cached.revision != revision) ) {
+        cached.curve = curve;
+        cached.revision = revision;
+        cached.keyframes = curve->getKeyFrames_mt_safe();
+    }
+
+    return cached.keyframes;
+}
+
+bool
+DopeSheetViewPrivate::rowIsOnScreen(const QRect& rowRect) const
+{
+    return ( rowRect.bottom() >= 0 ) && ( rowRect.top() <= q_ptr->height() );
+}
+
 void
-DopeSheetViewPrivate::drawTexturedKeyframe(DopeSheetViewPrivate::KeyframeTexture textureType,
-                                           bool drawTime,
-                                           double time,
-                                           const QColor& textColor,
-                                           const RectD &rect) const
+DopeSheetViewPrivate::appendMasterKeyframeQuads(const std::map<double, bool>& keytimes,
+                                                double rowCenterYWidget,
+                                                bool hasSingleKfTimeSelected,
+                                                DSKeyframeQuads* quads) const
 {
-    GLProtectAttrib a(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_TRANSFORM_BIT);
-    GLProtectMatrix pr(GL_MODELVIEW);
+    const double pixelWidth = zoomContext.screenPixelWidth();
+    DopeSheetViewPrivate::KeyframeTexture lastTexType = DopeSheetViewPrivate::kfTextureNone;
+    double lastDrawnTime = 0.;
 
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, kfTexturesIDs[textureType]);
+    for (std::map<double, bool>::const_iterator it = keytimes.begin();
+         it != keytimes.end();
+         ++it) {
+        double time = (*it).first;
+        bool drawSelected = (*it).second;
+        DopeSheetViewPrivate::KeyframeTexture textureType = (drawSelected)
+                                                            ? DopeSheetViewPrivate::kfTextureMasterSelected
+                                                            : DopeSheetViewPrivate::kfTextureMaster;
 
-    glBegin(GL_POLYGON);
-    glTexCoord2f(0.0f, 1.0f);
-    glVertex2f( rect.left(), rect.top() );
-    glTexCoord2f(0.0f, 0.0f);
-    glVertex2f( rect.left(), rect.bottom() );
-    glTexCoord2f(1.0f, 0.0f);
-    glVertex2f( rect.right(), rect.bottom() );
-    glTexCoord2f(1.0f, 1.0f);
-    glVertex2f( rect.right(), rect.top() );
-    glEnd();
+        if ( (textureType == lastTexType) && (time - lastDrawnTime < pixelWidth) ) {
+            continue;
+        }
+        lastTexType = textureType;
+        lastDrawnTime = time;
 
-    glColor4f(1, 1, 1, 1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+        RectD zoomKfRect = getKeyFrameBoundingRectZoomCoords(time, rowCenterYWidget);
+        appendKeyframeQuad(textureType, hasSingleKfTimeSelected && drawSelected, zoomKfRect, quads);
+    }
+}
 
-    glDisable(GL_TEXTURE_2D);
+void
+DopeSheetViewPrivate::appendKeyframeQuad(DopeSheetViewPrivate::KeyframeTexture textureType,
+                                         bool drawTime,
+                                         const RectD &rect,
+                                         DSKeyframeQuads* quads) const
+{
+    assert(textureType >= 0 && textureType < KF_TEXTURES_COUNT);
+
+    std::vector<float>& vertices = quads->vertices[textureType];
+    vertices.push_back( rect.left() );
+    vertices.push_back( rect.top() );
+    vertices.push_back( rect.left() );
+    vertices.push_back( rect.bottom() );
+    vertices.push_back( rect.right() );
+    vertices.push_back( rect.bottom() );
+    vertices.push_back( rect.right() );
+    vertices.push_back( rect.top() );
+
+    std::vector<float>& texCoords = quads->texCoords[textureType];
+    texCoords.push_back(0.f);
+    texCoords.push_back(1.f);
+    texCoords.push_back(0.f);
+    texCoords.push_back(0.f);
+    texCoords.push_back(1.f);
+    texCoords.push_back(0.f);
+    texCoords.push_back(1.f);
+    texCoords.push_back(1.f);
 
     if (drawTime) {
+        quads->timeLabelRects.push_back(rect);
+    }
+}
+
+void
+DopeSheetViewPrivate::drawKeyframeQuads(const DSKeyframeQuads& quads,
+                                        double time,
+                                        const QColor& textColor) const
+{
+    {
+        GLProtectAttrib a(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_TRANSFORM_BIT);
+        GLProtectMatrix pr(GL_MODELVIEW);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_TEXTURE_2D);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+        for (int i = 0; i < KF_TEXTURES_COUNT; ++i) {
+            const std::vector<float>& vertices = quads.vertices[i];
+            if ( vertices.empty() ) {
+                continue;
+            }
+            glBindTexture(GL_TEXTURE_2D, kfTexturesIDs[i]);
+            glVertexPointer(2, GL_FLOAT, 0, &vertices.front());
+            glTexCoordPointer(2, GL_FLOAT, 0, &quads.texCoords[i].front());
+            glDrawArrays(GL_QUADS, 0, (GLsizei)(vertices.size() / 2));
+        }
+
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glColor4f(1, 1, 1, 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    if ( !quads.timeLabelRects.empty() ) {
         QString text = QString::number(time);
-        QPointF p = zoomContext.toWidgetCoordinates( rect.right(), rect.bottom() );
-        p.rx() += 3;
-        p = zoomContext.toZoomCoordinates( p.x(), p.y() );
-        renderText(p.x(), p.y(), text, textColor, *font);
+        for (std::list<RectD>::const_iterator it = quads.timeLabelRects.begin(); it != quads.timeLabelRects.end(); ++it) {
+            QPointF p = zoomContext.toWidgetCoordinates( it->right(), it->bottom() );
+            p.rx() += 3;
+            p = zoomContext.toZoomCoordinates( p.x(), p.y() );
+            renderText(p.x(), p.y(), text, textColor, *font);
+        }
     }
 }
 
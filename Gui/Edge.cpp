@@ -33,11 +33,13 @@
 #include <QPainter>
 #include <QApplication>
 #include <QGraphicsScene>
+#include <QStyleOptionGraphicsItem>
 
 #include "Gui/NodeGui.h"
 #include "Gui/NodeGraph.h"
 #include "Gui/NodeGraphTextItem.h"
 #include "Gui/GuiApplicationManager.h"
+#include "Gui/GuiDefines.h"
 #include "Engine/Node.h"
 #include "Engine/Image.h"
 #include "Engine/Settings.h"
@@ -746,7 +748,7 @@ Edge::isNearbyBendPoint(const QPointF & scenePoint)
 
 void
 Edge::paint(QPainter *painter,
-            const QStyleOptionGraphicsItem * /*options*/,
+            const QStyleOptionGraphicsItem *options,
             QWidget * /*parent*/)
 {
     bool antialias = appPTR->getCurrentSettings()->isNodeGraphAntiAliasingEnabled();
@@ -786,6 +788,17 @@ Edge::paint(QPainter *painter,
         }
     }
     myPen.setColor(color);
+
+    // When zoomed out on a large graph, draw a plain line: the arrow head, dashes and bend point are too small to be seen
+    if ( options->levelOfDetailFromTransform( painter->worldTransform() ) < NATRON_NODEGRAPH_SIMPLIFIED_DRAWING_LOD ) {
+        myPen.setStyle(Qt::SolidLine);
+        painter->setPen(myPen);
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->drawLine( line() );
+
+        return;
+    }
+
     painter->setPen(myPen);
 
 
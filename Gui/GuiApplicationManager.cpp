@@ -1118,9 +1118,10 @@ GuiApplicationManager::getKnobClipBoard(KnobClipBoardType *type,
 
 void
 GuiApplicationManager::appendTaskToPreviewThread(const NodeGuiPtr& node,
-                                                 double time)
+                                                 double time,
+                                                 bool force)
 {
-    _imp->previewRenderThread.appendToQueue(node, time);
+    _imp->previewRenderThread.appendToQueue(node, time, force);
 }
 
 int
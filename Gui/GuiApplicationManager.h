@@ -190,7 +190,11 @@ public:
 
     bool handleImageFileOpenRequest(const std::string& imageFile);
 
-    void appendTaskToPreviewThread(const NodeGuiPtr& node, double time);
+    /**
+     * @brief Requests the preview of the node at the given time. Unless force is true, the preview may be taken from
+     * the previews already computed for the same node hash and time.
+     **/
+    void appendTaskToPreviewThread(const NodeGuiPtr& node, double time, bool force);
 
     int getDocumentationServerPort();
 
@@ -41,11 +41,14 @@
 
 #define NATRON_PREVIEW_WIDTH 64
 #define NATRON_PREVIEW_HEIGHT 38
+#define NATRON_PREVIEW_CACHE_MAX_ENTRIES 512 // previews kept by the preview thread, indexed by node hash and time
+#define NATRON_PREVIEW_PLAYBACK_POLL_MS 100 // interval at which the preview thread checks whether the playback stopped
 
 #define NODE_WIDTH 80
 #define NODE_HEIGHT 30
 
 #define NATRON_WHEEL_ZOOM_PER_DELTA 1.00152 // 120 wheel deltas (one click on a standard wheel mouse) is x1.2
+#define NATRON_NODEGRAPH_SIMPLIFIED_DRAWING_LOD 0.4 // below this zoom level the node graph draws plain node boxes and edges
 //#define NATRON_FONT "Helvetica"
 //#define NATRON_FONT_ALT "Times"
 #define NATRON_FONT "Droid Sans"
@@ -145,7 +145,9 @@ KnobGui::removeGui()
             _imp->descriptionLabel = 0;
         }
     }
-    removeSpecificGui();
+    if (_imp->widgetCreated) {
+        removeSpecificGui();
+    }
     _imp->guiRemoved = true;
 }
 
@@ -238,13 +240,15 @@ KnobGui::createGUI(QWidget* fieldContainer,
         layout->addWidget(_imp->customInteract);
     } else {
         createWidget(layout);
-        onHasModificationsChanged();
-        updateToolTip();
     }
 
-
     _imp->widgetCreated = true;
 
+    if (!_imp->customInteract) {
+        onHasModificationsChanged();
+        updateToolTip();
+    }
+
     for (int i = 0; i < knob->getDimension(); ++i) {
         onExprChanged(i);
 
@@ -260,6 +264,10 @@ KnobGui::createGUI(QWidget* fieldContainer,
 void
 KnobGui::updateGuiInternal(int dimension)
 {
+    // The widgets of the knobs in a page that was never shown are not created yet: createGUI() refreshes them
+    if (!_imp->widgetCreated || _imp->guiRemoved) {
+        return;
+    }
     if (!_imp->customInteract) {
         updateGUI(dimension);
     } else {
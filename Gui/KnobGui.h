@@ -210,7 +210,7 @@ public:
             Q_EMIT keyFrameSet();
         }
         if (refreshGui) {
-            updateGUI(dimension);
+            updateGuiInternal(dimension);
         }
 
         return (int)ret;
@@ -238,7 +238,7 @@ public:
             setKeyframeMarkerOnTimeline( newKey->getTime() );
         }
         if (refreshGui) {
-            updateGUI(dimension);
+            updateGuiInternal(dimension);
         }
 
         return ( (addedKey != KnobHelper::eValueChangedReturnCodeNoKeyframeAdded) &&
@@ -464,6 +464,12 @@ protected:
      * The dimension is either -1 indicating that all dimensions should be updated or the dimension index.
      **/
     virtual void updateGUI(int dimension) = 0;
+
+    /**
+     * @brief Calls updateGUI(), or updates the custom interact, only if the widgets were created.
+     * This must be used instead of calling updateGUI() directly.
+     **/
+    void updateGuiInternal(int dimension);
     virtual void addRightClickMenuEntries(QMenu* /*menu*/) {}
 
     virtual void reflectModificationsState() {}
@@ -472,8 +478,6 @@ private:
 
     void refreshKnobWarningIndicatorVisibility();
 
-    void updateGuiInternal(int dimension);
-
     void copyToClipBoard(KnobClipBoardType type, int dimension) const;
 
     void pasteClipBoard(int targetDimension);
@@ -268,7 +268,7 @@ KnobGui::onRemoveAnimationActionTriggered()
     pushUndoCommand( new RemoveKeysCommand(getGui()->getCurveEditor()->getCurveWidget(),
                                            toRemove) );
     //refresh the gui so it doesn't indicate the parameter is animated anymore
-    updateGUI(dim);
+    updateGuiInternal(dim);
 }
 
 void
@@ -443,7 +443,7 @@ KnobGui::removeKeyFrame(double time,
     if ( !knob->getIsSecret() ) {
         knob->getHolder()->getApp()->removeKeyFrameIndicator(time);
     }
-    updateGUI(dimension);
+    updateGuiInternal(dimension);
 }
 
 void
@@ -491,7 +491,7 @@ KnobGui::removeKeyframes(const std::vector<KeyFrame>& keys,
        }*/
 
     Q_EMIT keyFrameRemoved();
-    updateGUI(dimension);
+    updateGuiInternal(dimension);
 }
 
 QString
@@ -625,7 +625,9 @@ void
 KnobGui::hide()
 {
     if (!_imp->customInteract) {
-        _hide();
+        if (_imp->widgetCreated) {
+            _hide();
+        }
     } else {
         _imp->customInteract->hide();
     }
@@ -683,7 +685,9 @@ KnobGui::show(int /*index*/)
         return;
     }
     if (!_imp->customInteract) {
-        _show();
+        if (_imp->widgetCreated) {
+            _show();
+        }
     } else {
         _imp->customInteract->show();
     }
@@ -755,7 +759,7 @@ KnobGui::setEnabledSlot()
     if ( !getGui() ) {
         return;
     }
-    if (!_imp->customInteract) {
+    if (!_imp->customInteract && _imp->widgetCreated) {
         setEnabled();
     }
     KnobIPtr knob = getKnob();
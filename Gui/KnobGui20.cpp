@@ -477,7 +477,7 @@ KnobGui::onSetValueUsingUndoStack(const Variant & v,
 void
 KnobGui::onSetDirty(bool d)
 {
-    if (!_imp->customInteract) {
+    if (!_imp->customInteract && _imp->widgetCreated) {
         setDirty(d);
     }
 }
@@ -734,7 +734,8 @@ void
 KnobGui::onAnimationLevelChanged(ViewSpec /*idx*/,
                                  int dimension)
 {
-    if (!_imp->customInteract) {
+    // createGUI() reflects the animation level when the widgets are created
+    if (!_imp->customInteract && _imp->widgetCreated) {
         KnobIPtr knob = getKnob();
         int dim = knob->getDimension();
         for (int i = 0; i < dim; ++i) {
@@ -760,6 +761,9 @@ KnobGui::onAppendParamEditChanged(int reason,
 void
 KnobGui::onFrozenChanged(bool frozen)
 {
+    if (!_imp->widgetCreated) {
+        return;
+    }
     KnobIPtr knob = getKnob();
     KnobButton* isBtn = dynamic_cast<KnobButton*>( knob.get() );
 
@@ -855,9 +859,13 @@ KnobGui::onExprChanged(int dimension)
     }
     KnobIPtr knob = getKnob();
     std::string exp = knob->getExpression(dimension);
-    reflectExpressionState( dimension, !exp.empty() );
+    if (_imp->widgetCreated) {
+        reflectExpressionState( dimension, !exp.empty() );
+    }
     if ( exp.empty() ) {
-        reflectAnimationLevel( dimension, knob->getAnimationLevel(dimension) );
+        if (_imp->widgetCreated) {
+            reflectAnimationLevel( dimension, knob->getAnimationLevel(dimension) );
+        }
     } else {
         NodeSettingsPanel* isNodeSettings = dynamic_cast<NodeSettingsPanel*>(_imp->container);
         if (isNodeSettings) {
@@ -899,8 +907,12 @@ KnobGui::onExprChanged(int dimension)
         }
         Q_EMIT expressionChanged();
     }
+    // createGUI() calls this function again once the widgets are created
+    if (!_imp->widgetCreated) {
+        return;
+    }
     onHelpChanged();
-    updateGUI(dimension);
+    updateGuiInternal(dimension);
 } // KnobGui::onExprChanged
 
 void
@@ -909,7 +921,9 @@ KnobGui::onHelpChanged()
     if (_imp->descriptionLabel) {
         _imp->descriptionLabel->setToolTip( toolTip() );
     }
-    updateToolTip();
+    if (_imp->widgetCreated) {
+        updateToolTip();
+    }
 }
 
 void
@@ -922,7 +936,9 @@ KnobGui::onHasModificationsChanged()
         bool hasModif = getKnob()->hasModifications();
         _imp->descriptionLabel->setAltered(!hasModif);
     }
-    reflectModificationsState();
+    if (_imp->widgetCreated) {
+        reflectModificationsState();
+    }
 }
 
 void
@@ -946,7 +962,7 @@ KnobGui::onLabelChanged()
             _imp->descriptionLabel->show();
         }
         onLabelChangedInternal();
-    } else {
+    } else if (_imp->widgetCreated) {
         onLabelChangedInternal();
     }
 }
@@ -954,7 +970,9 @@ KnobGui::onLabelChanged()
 void
 KnobGui::onDimensionNameChanged(int dimension)
 {
-    refreshDimensionName(dimension);
+    if (_imp->widgetCreated) {
+        refreshDimensionName(dimension);
+    }
 }
 
 NATRON_NAMESPACE_EXIT
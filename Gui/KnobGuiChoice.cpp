@@ -261,7 +261,7 @@ void
 KnobGuiChoice::onEntryAppended()
 {
     KnobChoicePtr knob = _knob.lock();
-    if (!knob) {
+    if (!knob || !_comboBox) {
         return;
     }
 
@@ -276,7 +276,7 @@ KnobGuiChoice::onEntryAppended()
 
     }
 
-    updateGUI(0);
+    updateGuiInternal(0);
 }
 
 void
@@ -289,6 +289,10 @@ KnobGuiChoice::onEntriesReset()
 void
 KnobGuiChoice::onEntriesPopulated()
 {
+    // The combobox is filled when it is created
+    if (!_comboBox) {
+        return;
+    }
     KnobChoicePtr knob = _knob.lock();
 
     _comboBox->clear();
@@ -305,7 +309,7 @@ KnobGuiChoice::onEntriesPopulated()
         _comboBox->addItemNew();
     }
     
-    updateGUI(0);
+    updateGuiInternal(0);
 }
 
 void
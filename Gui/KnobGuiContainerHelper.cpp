@@ -210,6 +210,7 @@ void
 KnobGuiContainerHelper::setCurrentPage(const KnobPageGuiPtr& curPage)
 {
     _imp->currentPage = curPage;
+    createPageKnobWidgets(curPage);
     _imp->refreshPagesEnabledness();
 }
 
@@ -267,6 +268,8 @@ KnobGuiContainerHelper::getOrCreatePage(const KnobPagePtr& page)
     pageGui->pageKnob = page;
     pageGui->groupAsTab = 0;
     pageGui->gridLayout = tabLayout;
+    // The first page is the one shown when the container is created, the others are filled when they become current
+    pageGui->knobWidgetsCreated = _imp->pages.empty() || !createPagesWidgetsLazily();
 
     KnobSignalSlotHandlerPtr handler = page->getSignalSlotHandler();
     QObject::connect( handler.get(), SIGNAL(labelChanged()), _imp->signals.get(), SLOT(onPageLabelChangedInternally()) );
@@ -488,6 +491,25 @@ KnobGuiContainerHelper::initializeKnobVector(const KnobsVec& knobs)
     refreshTabWidgetMaxHeight();
 }
 
+void
+KnobGuiContainerHelper::createPageKnobWidgets(const KnobPageGuiPtr& page)
+{
+    if (!page || page->knobWidgetsCreated) {
+        return;
+    }
+    page->knobWidgetsCreated = true;
+
+    KnobPagePtr pageKnob = page->pageKnob.lock();
+    if (!pageKnob) {
+        return;
+    }
+
+    // The KnobGui already exist, this only creates their widgets in the layout of the page
+    KnobsVec children = pageKnob->getChildren();
+    initializeKnobVectorInternal(children, 0);
+    refreshTabWidgetMaxHeight();
+}
+
 static void
 workAroundGridLayoutBug(QGridLayout* layout)
 {
@@ -563,6 +585,31 @@ KnobGuiContainerHelper::findKnobGuiOrCreate(const KnobIPtr & knob,
         return KnobGuiPtr();
     }
 
+    // If the page of this knob was never made current, only create the KnobGui so that the curve editor
+    // and the dope sheet can use it: its widgets are created by createPageKnobWidgets()
+    KnobPagePtr topLevelPage = knob->getTopLevelPage();
+    KnobPageGuiPtr topLevelPageGui = topLevelPage ? getOrCreatePage(topLevelPage) : KnobPageGuiPtr();
+    if ( topLevelPageGui && !topLevelPageGui->knobWidgetsCreated ) {
+        KnobGuiPtr ret;
+        // Groups set as tabs have no widget of their own, their KnobGui is created along with their tab
+        if ( !isGroup || !isGroup->isTab() ) {
+            bool existed = _imp->findKnobGui(knob) != _imp->knobsMap.end();
+            ret = _imp->createKnobGui(knob);
+            if (ret && !existed) {
+                ret->setEnabledSlot();
+                ret->setSecret();
+            }
+        }
+        if (isGroup) {
+            KnobsVec children = isGroup->getChildren();
+            for (KnobsVec::const_iterator it = children.begin(); it != children.end(); ++it) {
+                findKnobGuiOrCreate( *it, true, 0, 0, KnobsVec() );
+            }
+        }
+
+        return ret;
+    }
+
     // Create the actual knob gui object
     KnobGuiPtr ret = _imp->createKnobGui(knob);
     if (!ret) {
@@ -58,6 +58,7 @@ public:
     TabGroup* groupAsTab; //< to gather group knobs that are set as a tab
     KnobPageWPtr pageKnob;
     QGridLayout* gridLayout;
+    bool knobWidgetsCreated; //< false until the widgets of the knobs in this page are created, @see KnobGuiContainerHelper::createPagesWidgetsLazily()
 
     KnobPageGui()
         : tab(0)
@@ -65,6 +66,7 @@ public:
         , groupAsTab(0)
         , pageKnob()
         , gridLayout(0)
+        , knobWidgetsCreated(true)
     {
     }
 };
@@ -201,6 +203,15 @@ public:
         return false;
     }
 
+    /**
+     * @brief Returns whether the widgets of the knobs in a page should only be created the first time the page becomes current.
+     * The KnobGui of all knobs are still created upfront so that the curve editor and the dope sheet can display their animation.
+     **/
+    virtual bool createPagesWidgetsLazily() const
+    {
+        return false;
+    }
+
     //// Overridden from DockablePanelI
 
     /**
@@ -342,6 +353,8 @@ private:
 
     void initializeKnobVectorInternal(const KnobsVec& siblingsVec, KnobsVec* regularKnobsVec);
 
+    void createPageKnobWidgets(const KnobPageGuiPtr& page);
+
     void recreateKnobsInternal(const KnobPageGuiPtr& curPage, bool restorePageIndex);
 
     void onDeleteCurCmdLater();
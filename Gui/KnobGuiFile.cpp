@@ -177,7 +177,9 @@ KnobGuiFile::open_file()
         pathWhereToOpen = QString::fromUtf8( path.c_str() );
     }
 
-    SequenceFileDialog dialog( _lineEdit->parentWidget(), filters, knob->isInputImageFile(),
+    // The widgets of the knob may not be created yet if its page was never shown
+    QWidget* dialogParent = _lineEdit ? _lineEdit->parentWidget() : getGui();
+    SequenceFileDialog dialog( dialogParent, filters, knob->isInputImageFile(),
                                SequenceFileDialog::eFileDialogModeOpen, pathWhereToOpen.toStdString(), getGui(), true);
 
     if ( dialog.exec() ) {
@@ -576,9 +578,10 @@ KnobGuiOutputFile::open_file(bool openSequence)
         appPTR->getSupportedWriterFileFormats(&filters);
     }
 
-    SequenceFileDialog dialog( _lineEdit->parentWidget(), filters, openSequence, SequenceFileDialog::eFileDialogModeSave, _lastOpened.toStdString(), getGui(), true);
+    QWidget* dialogParent = _lineEdit ? _lineEdit->parentWidget() : getGui();
+    SequenceFileDialog dialog( dialogParent, filters, openSequence, SequenceFileDialog::eFileDialogModeSave, _lastOpened.toStdString(), getGui(), true);
     if ( dialog.exec() ) {
-        std::string oldPattern = _lineEdit->text().toStdString();
+        std::string oldPattern = knob->getValue();
         std::string newPattern = dialog.filesToSave();
         updateLastOpened( QString::fromUtf8( SequenceParsing::removePath(oldPattern).c_str() ) );
 
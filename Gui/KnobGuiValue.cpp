@@ -570,8 +570,8 @@ KnobGuiValue::onRectangleFormatButtonClicked()
             _imp->spinBoxes[3].second->setText( QString::fromUtf8("t") );
         }
     }
-    updateGUI(2);
-    updateGUI(3);
+    updateGuiInternal(2);
+    updateGuiInternal(3);
 }
 
 void
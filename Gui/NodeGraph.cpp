@@ -138,6 +138,10 @@ NodeGraph::NodeGraph(Gui* gui,
     _imp->_cacheSizeText->setVisible(false);
 
     QObject::connect( &_imp->refreshRenderStateTimer, SIGNAL(timeout()), this, SLOT(onRefreshNodesRenderStateTimerTimeout()) );
+
+    _imp->refreshNavigatorTimer.setSingleShot(true);
+    _imp->refreshNavigatorTimer.setInterval(NATRON_NAVIGATOR_REFRESH_DELAY_MS);
+    QObject::connect( &_imp->refreshNavigatorTimer, SIGNAL(timeout()), this, SLOT(onRefreshNavigatorTimerTimeout()) );
     _imp->refreshRenderStateTimer.start(NATRON_NODES_RENDER_STATE_REFRESH_INTERVAL_MS);
 
     QObject::connect( &_imp->_refreshCacheTextTimer, SIGNAL(timeout()), this, SLOT(updateCacheSizeText()) );
@@ -225,6 +229,46 @@ NodeGraph::isDoingNavigatorRender() const
     return _imp->isDoingPreviewRender;
 }
 
+bool
+NodeGraph::isEdgesRefreshDeferred() const
+{
+    return _imp->edgesRefreshDeferred;
+}
+
+void
+NodeGraph::deferEdgesRefresh(const NodeGuiPtr& node)
+{
+    assert(_imp->edgesRefreshDeferred);
+    _imp->nodesWithDeferredEdges.insert(node);
+
+    NodePtr internalNode = node->getNode();
+    if (!internalNode) {
+        return;
+    }
+    const NodesWList & outputs = internalNode->getGuiOutputs();
+    for (NodesWList::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+        NodePtr output = it->lock();
+        if (!output) {
+            continue;
+        }
+        NodeGuiPtr outputGui = boost::dynamic_pointer_cast<NodeGui>( output->getNodeGui() );
+        if (outputGui) {
+            _imp->nodesWithDeferredEdges.insert(outputGui);
+        }
+    }
+}
+
+void
+NodeGraph::onRefreshNavigatorTimerTimeout()
+{
+    updateNavigator();
+
+    // The view stopped moving: compute the previews of the nodes that came into view
+    for (NodesGuiList::iterator it = _imp->_nodes.begin(); it != _imp->_nodes.end(); ++it) {
+        (*it)->computePendingPreview();
+    }
+}
+
 const std::list<NodeGuiPtr> &
 NodeGraph::getSelectedNodes() const
 {
@@ -312,7 +356,8 @@ NodeGraph::paintEvent(QPaintEvent* e)
         QPointF navTopLeftScene = mapToScene(navTopLeftWidget);
 
         _imp->_navigator->refreshPosition(navTopLeftScene, navWidth, navHeight);
-        updateNavigator();
+        // Restarting the timer coalesces the navigator renders of a continuous pan or zoom
+        _imp->refreshNavigatorTimer.start();
         _imp->_refreshOverlays = false;
     }
     QGraphicsView::paintEvent(e);
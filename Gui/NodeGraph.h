@@ -174,6 +174,13 @@ public:
 
     bool isDoingNavigatorRender() const;
 
+    /**
+     * @brief True while nodes are being dragged: instead of refreshing their edges each time a node moves,
+     * moved nodes call deferEdgesRefresh() and the edges are refreshed once all nodes have moved.
+     **/
+    bool isEdgesRefreshDeferred() const;
+    void deferEdgesRefresh(const NodeGuiPtr& node);
+
 public Q_SLOTS:
 
     void deleteSelection();
@@ -246,6 +253,8 @@ public Q_SLOTS:
 
     void onAutoScrollTimerTriggered();
 
+    void onRefreshNavigatorTimerTimeout();
+
 private:
 
     void showNodePanel(bool casIsCtrl, bool casIsShift, NodeGui* nearbyNode);
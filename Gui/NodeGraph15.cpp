@@ -221,6 +221,11 @@ NodeGraph::mouseReleaseEvent(QMouseEvent* e)
             }
             if ( (_imp->_deltaSinceMousePress.x() != 0) || (_imp->_deltaSinceMousePress.y() != 0) ) {
                 pushUndoCommand( new MoveMultipleNodesCommand( nodesToMove, _imp->_deltaSinceMousePress.x(), _imp->_deltaSinceMousePress.y() ) );
+
+                // The stacking order is not refreshed while dragging, see NodeGui::refreshPositionEnd
+                for (NodesGuiList::iterator it = nodesToMove.begin(); it != nodesToMove.end(); ++it) {
+                    (*it)->refreshStackOrder();
+                }
             }
 
             ///now if there was a hint displayed, use it to actually make connections.
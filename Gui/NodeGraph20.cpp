@@ -330,7 +330,8 @@ NodeGraph::moveSelectedNodesBy(bool shiftdown,
     double dyScene = newPos.y() - lastMousePosScene.y();
 
 
-    //Move all nodes
+    //Move all nodes, refreshing the edges of each moved node only once
+    _imp->edgesRefreshDeferred = true;
     bool deltaSet = false;
     for (std::set<NodeGuiPtr>::iterator it = nodesToMove.begin();
          it != nodesToMove.end(); ++it) {
@@ -351,6 +352,7 @@ NodeGraph::moveSelectedNodesBy(bool shiftdown,
             deltaSet = true;
         }
     }
+    _imp->refreshDeferredEdges();
 
     if (!deltaSet) {
         _imp->_deltaSinceMousePress.rx() += dxScene;
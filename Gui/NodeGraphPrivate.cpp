@@ -94,6 +94,10 @@ NodeGraphPrivate::NodeGraphPrivate(NodeGraph* p,
     , lastSelectedViewer(0)
     , isDoingPreviewRender(false)
     , autoScrollTimer()
+    , refreshRenderStateTimer()
+    , refreshNavigatorTimer()
+    , edgesRefreshDeferred(false)
+    , nodesWithDeferredEdges()
 {
     appPTR->getIcon(NATRON_PIXMAP_LOCKED, &unlockIcon);
 }
@@ -65,6 +65,7 @@ CLANG_DIAG_ON(uninitialized)
 ///These are percentages of the size of the NodeGraph in widget coordinates.
 #define NATRON_NAVIGATOR_BASE_HEIGHT 0.2
 #define NATRON_NAVIGATOR_BASE_WIDTH 0.2
+#define NATRON_NAVIGATOR_REFRESH_DELAY_MS 150
 
 #define NATRON_SCENE_MAX 1e6
 #define NATRON_SCENE_MIN 0
@@ -213,6 +214,13 @@ public:
     QTimer autoScrollTimer;
     QTimer refreshRenderStateTimer;
 
+    // Rendering the navigator renders the whole graph: while panning or zooming it is only refreshed once the view stops moving
+    QTimer refreshNavigatorTimer;
+
+    // While nodes are dragged, the edges of the moved nodes and of their outputs are refreshed once per move
+    bool edgesRefreshDeferred;
+    std::set<NodeGuiPtr> nodesWithDeferredEdges;
+
 
     NodeGraphPrivate(NodeGraph* p,
                      const NodeCollectionPtr& group);
@@ -261,6 +269,8 @@ public:
     void toggleSelectedNodesEnabled();
 
     void getNodeSet(const NodesGuiList& nodeList, std::set<NodeGuiPtr>& nodeSet);
+
+    void refreshDeferredEdges();
 };
 
 NATRON_NAMESPACE_EXIT
@@ -354,6 +354,18 @@ NodeGraphPrivate::getNodeSet(const NodesGuiList& nodeList, std::set<NodeGuiPtr>&
     }
 }
 
+void
+NodeGraphPrivate::refreshDeferredEdges()
+{
+    edgesRefreshDeferred = false;
+
+    std::set<NodeGuiPtr> nodes;
+    nodes.swap(nodesWithDeferredEdges);
+    for (std::set<NodeGuiPtr>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        (*it)->refreshEdges();
+    }
+}
+
 void
 NodeGraphPrivate::toggleSelectedNodesEnabled()
 {
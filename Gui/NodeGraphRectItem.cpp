@@ -27,6 +27,9 @@
 #include "NodeGraphRectItem.h"
 
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include "Gui/GuiDefines.h"
 
 NATRON_NAMESPACE_ENTER
 
@@ -38,11 +41,17 @@ NodeGraphRectItem::NodeGraphRectItem(QGraphicsItem *parent,
 }
 
 void
-NodeGraphRectItem::paint(QPainter *painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
+NodeGraphRectItem::paint(QPainter *painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/)
 {
     painter->setPen(pen());
     painter->setBrush(brush());
-    painter->drawRoundedRect(rect(), _cornerRadiusPx, _cornerRadiusPx);
+    // When zoomed out the corners are not visible: draw a plain box, which is much cheaper with many nodes
+    if ( option->levelOfDetailFromTransform( painter->worldTransform() ) < NATRON_NODEGRAPH_SIMPLIFIED_DRAWING_LOD ) {
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->drawRect( rect() );
+    } else {
+        painter->drawRoundedRect(rect(), _cornerRadiusPx, _cornerRadiusPx);
+    }
 }
 
 NATRON_NAMESPACE_EXIT
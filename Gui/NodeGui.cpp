@@ -170,6 +170,12 @@ NodeGui::NodeGui(QGraphicsItem *parent)
     , _previewData( NATRON_PREVIEW_HEIGHT * NATRON_PREVIEW_WIDTH * sizeof(unsigned int) )
     , _previewW(NATRON_PREVIEW_WIDTH)
     , _previewH(NATRON_PREVIEW_HEIGHT)
+    , _previewHash(0)
+    , _previewTime(0)
+    , _previewIsValid(false)
+    , _previewPending(false)
+    , _pendingPreviewTime(0)
+    , _pendingPreviewForced(false)
     , _persistentMessage(NULL)
     , _stateIndicator(NULL)
     , _mergeHintActive(false)
@@ -249,7 +255,8 @@ NodeGui::initialize(NodeGraph* dag,
     QObject::connect( internalNode.get(), SIGNAL(inputEdgeLabelChanged(int, QString)), this, SLOT(onInputLabelChanged(int,QString)) );
     QObject::connect( internalNode.get(), SIGNAL(inputVisibilityChanged(int)), this, SLOT(onInputVisibilityChanged(int)) );
     QObject::connect( this, SIGNAL(previewImageComputed()), this, SLOT(onPreviewImageComputed()) );
-    setCacheMode(DeviceCoordinateCache);
+    // No item cache: the node paints nothing itself (see paint()), its child items do and they are not part of its cache.
+    // The cache only cost one pixmap per node, re-allocated at each zoom change.
 
     OutputEffectInstance* isOutput = dynamic_cast<OutputEffectInstance*>( internalNode->getEffectInstance().get() );
     if (isOutput) {
@@ -1010,29 +1017,42 @@ NodeGui::refreshPositionEnd(double x,
                             double y)
 {
     setPos(x, y);
-    if (_graph) {
-        QRectF bbox = mapRectToScene( boundingRect() );
-        const NodesGuiList & allNodes = _graph->getAllActiveNodes();
+    if ( _graph && _graph->isEdgesRefreshDeferred() ) {
+        // Nodes are being dragged: the graph refreshes the edges once all nodes have moved,
+        // and the stacking order when the drag ends
+        _graph->deferEdgesRefresh( shared_from_this() );
+    } else {
+        refreshStackOrder();
+        refreshEdges();
+        NodePtr node = getNode();
+        if (node) {
+            const NodesWList & outputs = node->getGuiOutputs();
 
-        for (NodesGuiList::const_iterator it = allNodes.begin(); it != allNodes.end(); ++it) {
-            if ( (*it)->isVisible() && (it->get() != this) && (*it)->intersects(bbox) ) {
-                setAboveItem( it->get() );
+            for (NodesWList::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+                NodePtr output = it->lock();
+                if (output) {
+                    output->doRefreshEdgesGUI();
+                }
             }
         }
     }
-    refreshEdges();
-    NodePtr node = getNode();
-    if (node) {
-        const NodesWList & outputs = node->getGuiOutputs();
+    Q_EMIT positionChanged(x, y);
+}
 
-        for (NodesWList::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
-            NodePtr output = it->lock();
-            if (output) {
-                output->doRefreshEdgesGUI();
-            }
+void
+NodeGui::refreshStackOrder()
+{
+    if (!_graph) {
+        return;
+    }
+    QRectF bbox = mapRectToScene( boundingRect() );
+    const NodesGuiList & allNodes = _graph->getAllActiveNodes();
+
+    for (NodesGuiList::const_iterator it = allNodes.begin(); it != allNodes.end(); ++it) {
+        if ( (*it)->isVisible() && (it->get() != this) && (*it)->intersects(bbox) ) {
+            setAboveItem( it->get() );
         }
     }
-    Q_EMIT positionChanged(x, y);
 }
 
 void
@@ -1303,10 +1323,7 @@ NodeGui::updatePreviewImage(double time)
         }
 
         ensurePreviewCreated();
-
-        NodeGuiPtr thisShared = shared_from_this();
-        assert(thisShared);
-        appPTR->appendTaskToPreviewThread(thisShared, time);
+        requestPreview(time, false);
     }
 }
 
@@ -1325,10 +1342,68 @@ NodeGui::forceComputePreview(double time)
         }
 
         ensurePreviewCreated();
-        NodeGuiPtr thisShared = shared_from_this();
-        assert(thisShared);
-        appPTR->appendTaskToPreviewThread(thisShared, time);
+        requestPreview(time, true);
+    }
+}
+
+bool
+NodeGui::isPreviewOnScreen() const
+{
+    if ( !_graph || !_graph->isVisible() ) {
+        return false;
+    }
+
+    return sceneBoundingRect().intersects( _graph->visibleSceneRect() );
+}
+
+void
+NodeGui::requestPreview(double time,
+                        bool force)
+{
+    // Nodes out of the view get their preview when they are scrolled into view, see computePendingPreview()
+    if ( !isPreviewOnScreen() ) {
+        _pendingPreviewForced = _pendingPreviewForced || force;
+        _pendingPreviewTime = time;
+        _previewPending = true;
+
+        return;
+    }
+    force = force || _pendingPreviewForced;
+    _previewPending = false;
+    _pendingPreviewForced = false;
+
+    NodePtr node = getNode();
+    if (!node) {
+        return;
+    }
+    if (!force) {
+        // Nothing to do if the preview displayed was made for the same state of the node at the same time
+        U64 nodeHash = node->getHashValue();
+        QMutexLocker k(&_previewDataMutex);
+        if ( _previewIsValid && (_previewHash == nodeHash) && (_previewTime == time) ) {
+            return;
+        }
+    }
+
+    NodeGuiPtr thisShared = shared_from_this();
+    assert(thisShared);
+    appPTR->appendTaskToPreviewThread(thisShared, time, force);
+}
+
+void
+NodeGui::computePendingPreview()
+{
+    if ( !_previewPending || !isPreviewOnScreen() ) {
+        return;
+    }
+    NodePtr node = getNode();
+    if ( !node || !node->isActivated() || !node->isPreviewEnabled() ) {
+        _previewPending = false;
+        _pendingPreviewForced = false;
+
+        return;
     }
+    requestPreview(_pendingPreviewTime, false);
 }
 
 void
@@ -1360,13 +1435,19 @@ NodeGui::onPreviewImageComputed()
 void
 NodeGui::copyPreviewImageBuffer(const std::vector<unsigned int>& data,
                                 int width,
-                                int height)
+                                int height,
+                                bool isComplete,
+                                U64 nodeHash,
+                                double time)
 {
     {
         QMutexLocker k(&_previewDataMutex);
         _previewData = data;
         _previewW = width;
         _previewH = height;
+        _previewHash = nodeHash;
+        _previewTime = time;
+        _previewIsValid = isComplete;
     }
     Q_EMIT previewImageComputed();
 }
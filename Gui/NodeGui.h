@@ -399,7 +399,17 @@ public:
                                        unsigned int version) OVERRIDE FINAL;
     virtual void onIdentityStateChanged(int inputNb) OVERRIDE FINAL;
 
-    void copyPreviewImageBuffer(const std::vector<unsigned int>& data, int width, int height);
+    /**
+     * @brief Called by the preview thread with the preview of the node made for the given node hash and time.
+     * isComplete is false if the preview could not be rendered, in which case it will be requested again.
+     **/
+    void copyPreviewImageBuffer(const std::vector<unsigned int>& data, int width, int height, bool isComplete, U64 nodeHash, double time);
+
+    /**
+     * @brief If a preview was requested while the node was out of the view of the node graph and the node
+     * is now visible, compute it.
+     **/
+    void computePendingPreview();
 
     void onKnobExpressionChanged(const KnobGui* knob);
 
@@ -483,6 +493,11 @@ public Q_SLOTS:
 
     void refreshEdges();
 
+    /**
+     * @brief Puts this node above the nodes it overlaps
+     **/
+    void refreshStackOrder();
+
     /**
      * @brief Specific for the Viewer to  have inputs that are not used in A or B be dashed
      **/
@@ -572,6 +587,10 @@ private:
 
     void ensurePreviewCreated();
 
+    bool isPreviewOnScreen() const;
+
+    void requestPreview(double time, bool force);
+
     void setAboveItem(QGraphicsItem* item);
 
     void populateMenu();
@@ -612,6 +631,14 @@ private:
     mutable QMutex _previewDataMutex;
     std::vector<unsigned int> _previewData;
     int _previewW, _previewH;
+    // The node hash and time of the preview displayed, protected by _previewDataMutex
+    U64 _previewHash;
+    double _previewTime;
+    bool _previewIsValid;
+    // The preview requested while the node was out of the view
+    bool _previewPending;
+    double _pendingPreviewTime;
+    bool _pendingPreviewForced;
     QGraphicsSimpleTextItem* _persistentMessage;
     NodeGraphRectItem* _stateIndicator;
     bool _mergeHintActive;
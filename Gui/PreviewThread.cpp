@@ -26,6 +26,7 @@
 #include "PreviewThread.h"
 
 #include <list>
+#include <map>
 #include <vector>
 #include <stdexcept>
 #include <cstring> // for std::memcpy, std::memset
@@ -36,7 +37,10 @@
 #include "Gui/GuiDefines.h"
 #include "Gui/NodeGui.h"
 
+#include "Engine/AppInstance.h"
 #include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/ViewerInstance.h"
 
 
 NATRON_NAMESPACE_ENTER
@@ -48,11 +52,13 @@ public:
 
     double time;
     NodeGuiWPtr node;
+    U64 requestID;
 
     ComputePreviewRequest()
         : GenericThreadStartArgs()
         , time(0)
         , node()
+        , requestID(0)
     {}
 
     virtual ~ComputePreviewRequest()
@@ -62,16 +68,218 @@ public:
 
 typedef boost::shared_ptr<ComputePreviewRequest> ComputePreviewRequestPtr;
 
+/**
+ * @brief Identifies a preview: the node and its hash identify what the node renders.
+ * The node is held by a weak pointer, which are ordered by their shared state: a new node allocated at the address
+ * of a deleted one never matches the previews of the deleted node.
+ **/
+struct PreviewKey
+{
+    NodeWPtr node;
+    U64 nodeHash;
+    double time;
+
+    PreviewKey(const NodePtr& n,
+               U64 hash,
+               double t)
+        : node(n)
+        , nodeHash(hash)
+        , time(t)
+    {
+    }
+
+    bool operator<(const PreviewKey& other) const
+    {
+        if (node < other.node) {
+            return true;
+        }
+        if (other.node < node) {
+            return false;
+        }
+        if (nodeHash != other.nodeHash) {
+            return nodeHash < other.nodeHash;
+        }
+
+        return time < other.time;
+    }
+};
+
+struct CachedPreview
+{
+    std::vector<unsigned int> data;
+    int width, height;
+
+    // Position in PreviewThreadPrivate::cacheUsage
+    std::list<PreviewKey>::iterator usageIt;
+};
+
+/**
+ * @brief The last preview requested for a node. Requests superseded before they were processed are dropped.
+ **/
+struct PendingPreview
+{
+    U64 requestID;
+
+    // True if any of the requests made since the last one processed was forced
+    bool force;
+
+    PendingPreview()
+        : requestID(0)
+        , force(false)
+    {
+    }
+};
+
 struct PreviewThreadPrivate
 {
     std::vector<unsigned int> data;
 
+    // Previews already computed, only accessed by the preview thread
+    std::map<PreviewKey, CachedPreview> cache;
+
+    // Keys of the cache from the least to the most recently used
+    std::list<PreviewKey> cacheUsage;
+
+    // The last preview requested for each node, protected by requestsMutex
+    QMutex requestsMutex;
+    std::map<NodeGuiWPtr, PendingPreview> lastRequests;
+    U64 requestsCounter;
+
+    bool priorityLowered;
+
     PreviewThreadPrivate()
         : data( NATRON_PREVIEW_HEIGHT * NATRON_PREVIEW_WIDTH * sizeof(unsigned int) )
+        , cache()
+        , cacheUsage()
+        , requestsMutex()
+        , lastRequests()
+        , requestsCounter(0)
+        , priorityLowered(false)
     {
     }
+
+    /**
+     * @brief Returns true if the request is the last one made for its node, in which case it is removed from
+     * the pending requests and force is set to whether any of the requests coalesced into it was forced.
+     **/
+    bool takeLastRequest(const NodeGuiWPtr& node, U64 requestID, bool* force);
+
+    /**
+     * @brief Returns true if a request was made for the node after the one being processed, in which case
+     * the newer request is forced if force is true.
+     **/
+    bool coalesceIntoNewerRequest(const NodeGuiWPtr& node, bool force);
+
+    bool getCachedPreview(const PreviewKey& key, int* width, int* height);
+
+    void insertCachedPreview(const PreviewKey& key, int width, int height);
 };
 
+bool
+PreviewThreadPrivate::takeLastRequest(const NodeGuiWPtr& node,
+                                      U64 requestID,
+                                      bool* force)
+{
+    QMutexLocker k(&requestsMutex);
+    std::map<NodeGuiWPtr, PendingPreview>::iterator found = lastRequests.find(node);
+
+    if ( (found == lastRequests.end()) || (found->second.requestID != requestID) ) {
+        // Another preview was requested for this node since, even at the same time: the node may have changed
+        return false;
+    }
+    *force = found->second.force;
+    lastRequests.erase(found);
+
+    return true;
+}
+
+bool
+PreviewThreadPrivate::coalesceIntoNewerRequest(const NodeGuiWPtr& node,
+                                               bool force)
+{
+    QMutexLocker k(&requestsMutex);
+    std::map<NodeGuiWPtr, PendingPreview>::iterator found = lastRequests.find(node);
+
+    if ( found == lastRequests.end() ) {
+        return false;
+    }
+    found->second.force = found->second.force || force;
+
+    return true;
+}
+
+
+bool
+PreviewThreadPrivate::getCachedPreview(const PreviewKey& key,
+                                       int* width,
+                                       int* height)
+{
+    std::map<PreviewKey, CachedPreview>::iterator found = cache.find(key);
+
+    if ( found == cache.end() ) {
+        return false;
+    }
+    data = found->second.data;
+    *width = found->second.width;
+    *height = found->second.height;
+    cacheUsage.splice( cacheUsage.end(), cacheUsage, found->second.usageIt );
+
+    return true;
+}
+
+void
+PreviewThreadPrivate::insertCachedPreview(const PreviewKey& key,
+                                          int width,
+                                          int height)
+{
+    std::map<PreviewKey, CachedPreview>::iterator found = cache.find(key);
+
+    if ( found != cache.end() ) {
+        cacheUsage.erase(found->second.usageIt);
+        cache.erase(found);
+    }
+    // Forget the previews of the nodes that were deleted
+    for (std::list<PreviewKey>::iterator it = cacheUsage.begin(); it != cacheUsage.end();) {
+        if ( it->node.expired() ) {
+            cache.erase(*it);
+            it = cacheUsage.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while ( !cacheUsage.empty() && (cache.size() >= NATRON_PREVIEW_CACHE_MAX_ENTRIES) ) {
+        cache.erase( cacheUsage.front() );
+        cacheUsage.pop_front();
+    }
+
+    CachedPreview& entry = cache[key];
+    entry.data = data;
+    entry.width = width;
+    entry.height = height;
+    entry.usageIt = cacheUsage.insert(cacheUsage.end(), key);
+}
+
+/**
+ * @brief Returns true if a viewer of the project is playing: previews are deferred until the playback stops.
+ **/
+static bool
+isViewerPlaybackActive(const AppInstanceWPtr& weakApp)
+{
+    AppInstancePtr app = weakApp.lock();
+    if (!app) {
+        return false;
+    }
+    std::list<ViewerInstance*> viewers;
+    app->getProject()->getViewers(&viewers);
+    for (std::list<ViewerInstance*>::iterator it = viewers.begin(); it != viewers.end(); ++it) {
+        if ( (*it)->isDoingSequentialRender() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 PreviewThread::PreviewThread()
     : GenericSchedulerThread()
     , _imp( new PreviewThreadPrivate() )
@@ -87,12 +295,21 @@ PreviewThread::~PreviewThread()
 
 void
 PreviewThread::appendToQueue(const NodeGuiPtr& node,
-                             double time)
+                             double time,
+                             bool force)
 {
     ComputePreviewRequestPtr r = boost::make_shared<ComputePreviewRequest>();
 
     r->node = node;
     r->time = time;
+    {
+        QMutexLocker k(&_imp->requestsMutex);
+        PendingPreview& pending = _imp->lastRequests[node];
+        // A forced request superseded by a regular one must still bypass the caches
+        pending.force = pending.force || force;
+        pending.requestID = ++_imp->requestsCounter;
+        r->requestID = pending.requestID;
+    }
     startTask(r);
 }
 
@@ -104,28 +321,73 @@ PreviewThread::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
     assert(args);
 
 
+    if (!_imp->priorityLowered) {
+        // Previews must never compete with the threads rendering the viewers
+        setPriority(QThread::LowestPriority);
+        _imp->priorityLowered = true;
+    }
+
+    bool force = false;
+    if ( !_imp->takeLastRequest(args->node, args->requestID, &force) ) {
+        return eThreadStateActive;
+    }
+
+    // Previews must not slow down the playback: wait for it to stop, the previews requested in the meantime
+    // are queued after this one. The node is not held meanwhile so that it can be deleted.
+    AppInstanceWPtr app;
+    {
+        NodeGuiPtr node = args->node.lock();
+        NodePtr internalNode = node ? node->getNode() : NodePtr();
+        if (!internalNode) {
+            return eThreadStateActive;
+        }
+        app = internalNode->getApp();
+    }
+    if ( isViewerPlaybackActive(app) ) {
+        do {
+            msleep(NATRON_PREVIEW_PLAYBACK_POLL_MS);
+            ThreadStateEnum state = resolveState();
+            if (state != eThreadStateActive) {
+                return state;
+            }
+        } while ( isViewerPlaybackActive(app) );
+
+        if ( _imp->coalesceIntoNewerRequest(args->node, force) ) {
+            // The node was requested again during the playback, only compute the last request
+            return eThreadStateActive;
+        }
+    }
+
     NodeGuiPtr node = args->node.lock();
-    if (node) {
+    NodePtr internalNode = node ? node->getNode() : NodePtr();
+    if (internalNode) {
         ///Mark this thread as running
         appPTR->fetchAndAddNRunningThreads(1);
 
         //process the request if valid
         int w = NATRON_PREVIEW_WIDTH;
         int h = NATRON_PREVIEW_HEIGHT;
+        U64 nodeHash = internalNode->getHashValue();
+        PreviewKey key(internalNode, nodeHash, args->time);
 
-        //set buffer to 0
+        if ( !force && _imp->getCachedPreview(key, &w, &h) ) {
+            node->copyPreviewImageBuffer(_imp->data, w, h, true, nodeHash, args->time);
+        } else {
+            //set buffer to 0
 #ifndef __NATRON_WIN32__
-        std::memset( &_imp->data.front(), 0, _imp->data.size() * sizeof(unsigned int) );
+            std::memset( &_imp->data.front(), 0, _imp->data.size() * sizeof(unsigned int) );
 #else
-        for (std::size_t i = 0; i < _imp->data.size(); ++i) {
-            _imp->data[i] = qRgba(0, 0, 0, 255);
-        }
+            for (std::size_t i = 0; i < _imp->data.size(); ++i) {
+                _imp->data[i] = qRgba(0, 0, 0, 255);
+            }
 #endif
-        NodePtr internalNode = node->getNode();
-        if (internalNode) {
             bool ok = internalNode->makePreviewImage( args->time, &w, &h, &_imp->data.front() );
-            Q_UNUSED(ok);
-            node->copyPreviewImageBuffer(_imp->data, w, h);
+            // If the node changed while rendering, the preview may not correspond to nodeHash
+            ok = ok && internalNode->getHashValue() == nodeHash;
+            if (ok) {
+                _imp->insertCachedPreview(key, w, h);
+            }
+            node->copyPreviewImageBuffer(_imp->data, w, h, ok, nodeHash, args->time);
         }
 
         ///Unmark this thread as running
@@ -51,7 +51,12 @@ public:
 
     virtual ~PreviewThread();
 
-    void appendToQueue(const NodeGuiPtr& node, double time);
+    /**
+     * @brief Requests the preview of the node at the given time. Only the most recent request of a node is processed.
+     * If force is false, a preview computed earlier for the same node hash and time is reused.
+     * While a viewer is playing back, the request is computed once the playback stops.
+     **/
+    void appendToQueue(const NodeGuiPtr& node, double time, bool force);
 
 private:
 
@@ -25,6 +25,7 @@
 
 #include "RenderStatsDialog.h"
 
+#include <algorithm> // max
 #include <bitset>
 #include <stdexcept>
 
@@ -65,8 +66,9 @@
 #define COL_NB_CACHE_HIT 13
 #define COL_NB_CACHE_HIT_DOWNSCALED 14
 #define COL_NB_CACHE_MISS 15
+#define COL_ABORT_LATENCY 16
 
-#define NUM_COLS 16
+#define NUM_COLS 17
 
 NATRON_NAMESPACE_ENTER
 
@@ -77,6 +79,8 @@ enum ItemsRoleEnum
     eItemsRoleIdentityTilesInfo = 102,
     eItemsRoleRenderedTilesNb = 103,
     eItemsRoleRenderedTilesInfo = 104,
+    eItemsRoleAbortLatency = 105,
+    eItemsRoleAbortedRendersNb = 106,
 };
 
 struct RowInfo
@@ -111,6 +115,9 @@ struct StatRowsCompare
         case COL_TIME:
 
             return lhs.item->data( (int)eItemsRoleTime ).toDouble() < rhs.item->data( (int)eItemsRoleTime ).toDouble();
+        case COL_ABORT_LATENCY:
+
+            return lhs.item->data( (int)eItemsRoleAbortLatency ).toDouble() < rhs.item->data( (int)eItemsRoleAbortLatency ).toDouble();
         default:
 
             return lhs.item->text() < rhs.item->text();
@@ -646,6 +653,46 @@ public:
                 }
             }
         }
+        {
+            TableItem* item = 0;
+            double maxLatency = 0;
+            int nbAborted = 0;
+            if (exists) {
+                item = view->item(row, COL_ABORT_LATENCY);
+                if (item) {
+                    maxLatency = item->data( (int)eItemsRoleAbortLatency ).toDouble();
+                    nbAborted = item->data( (int)eItemsRoleAbortedRendersNb ).toInt();
+                }
+            } else {
+                item = new TableItem;
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The longest time the node kept rendering after its render was aborted, "
+                                                                       "and the number of aborted renders.\n"
+                                                                       "A node with a high latency does not check "
+                                                                       "often enough whether it should stop, which makes the viewer slow to react."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(tt);
+                item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            assert(item);
+            if (item) {
+                maxLatency = std::max( maxLatency, stats.getMaxAbortLatency() );
+                nbAborted += stats.getNbAbortedRenders();
+
+                QString str;
+                if (nbAborted > 0) {
+                    str = tr("%1 (%2 aborted)").arg( Timer::printAsTime(maxLatency, false) ).arg(nbAborted);
+                }
+                if (nodeUi) {
+                    item->setTextColor(Qt::black);
+                    item->setBackgroundColor(c);
+                }
+                item->setData( (int)eItemsRoleAbortLatency, maxLatency );
+                item->setData( (int)eItemsRoleAbortedRendersNb, nbAborted );
+                item->setText(str);
+                if (!exists) {
+                    view->setItem(row, COL_ABORT_LATENCY, item);
+                }
+            }
+        }
         if (!exists) {
             rows.push_back(node);
         }
@@ -891,7 +938,8 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
         << tr("Rendered Planes")
         << tr("Cache Hits")
         << tr("Cache Hits Higher Scale")
-        << tr("Cache Misses");
+        << tr("Cache Misses")
+        << tr("Abort Latency");
 
     _imp->view->setColumnCount( dimensionNames.size() );
     _imp->view->setHorizontalHeaderLabels(dimensionNames);
@@ -965,6 +1013,7 @@ RenderStatsDialog::refreshAdvancedColsVisibility()
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT_DOWNSCALED, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_MISS, !checked);
+    _imp->view->setColumnHidden(COL_ABORT_LATENCY, !checked);
 }
 
 void
@@ -1567,7 +1567,7 @@ RotoGui::drawOverlays(double time,
                 }
 
                 std::list< Point > points;
-                isBezier->evaluateAtTime_DeCasteljau(true, time, 0, 100, &points, NULL);
+                isBezier->evaluateAtTime_DeCasteljau(true, time, 0, -1, &points, NULL);
 
                 bool locked = (*it)->isLockedRecursive();
                 double curveColor[4];
@@ -1595,7 +1595,7 @@ RotoGui::drawOverlays(double time,
 
                 if ( isFeatherVisible() ) {
                     ///Draw feather only if visible (button is toggled in the user interface)
-                    isBezier->evaluateFeatherPointsAtTime_DeCasteljau(true, time, 0, 100, true, &featherPoints, &featherBBox);
+                    isBezier->evaluateFeatherPointsAtTime_DeCasteljau(true, time, 0, -1, true, &featherPoints, &featherBBox);
 
                     if ( !featherPoints.empty() ) {
                         glLineStipple(2, 0xAAAA);
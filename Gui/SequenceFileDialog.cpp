@@ -76,6 +76,7 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 #endif
 #include <QtCore/QDebug>
 #include <QtCore/QEvent>
+#include <QtCore/QHash>
 #include <QtCore/QMimeData>
 #include <QtConcurrentRun> // QtCore on Qt4, QtConcurrent on Qt5
 #include <QtCore/QSettings>
@@ -2797,6 +2798,9 @@ SequenceFileDialog::fileSequencesFromFilesList(const QStringList & files,
 {
     std::vector<SequenceParsing::SequenceFromFilesPtr> sequences;
 
+    ///The sequences indexed by their files path without digits: a file only needs to be tried against the sequences of its bucket
+    QHash<QString, std::vector<SequenceParsing::SequenceFromFilesPtr> > sequencesBuckets;
+
     for (int i = 0; i < files.size(); ++i) {
         SequenceParsing::FileNameContent fileContent( files.at(i).toStdString() );
 
@@ -2805,9 +2809,10 @@ SequenceFileDialog::fileSequencesFromFilesList(const QStringList & files,
         }
 
         bool found = false;
+        std::vector<SequenceParsing::SequenceFromFilesPtr>& bucket = sequencesBuckets[FileSystemModel::getSequenceBucketKey( files.at(i) )];
 
-        for (U32 j = 0; j < sequences.size(); ++j) {
-            if ( sequences[j]->tryInsertFile(fileContent) ) {
+        for (U32 j = 0; j < bucket.size(); ++j) {
+            if ( bucket[j]->tryInsertFile(fileContent) ) {
                 found = true;
                 break;
             }
@@ -2815,6 +2820,7 @@ SequenceFileDialog::fileSequencesFromFilesList(const QStringList & files,
         if (!found) {
             SequenceParsing::SequenceFromFilesPtr seq( new SequenceParsing::SequenceFromFiles(fileContent, false) );
             sequences.push_back(seq);
+            bucket.push_back(seq);
         }
     }
 
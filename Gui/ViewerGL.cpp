@@ -2166,6 +2166,8 @@ ViewerGL::penMotionInternal(int x,
         zoomPos = _imp->zoomCtx.toZoomCoordinates(x, y);
         zoomScreenPixelWidth = _imp->zoomCtx.screenPixelWidth();
         zoomScreenPixelHeight = _imp->zoomCtx.screenPixelHeight();
+        _imp->lastCursorZoomPos = zoomPos;
+        _imp->cursorInViewer = true;
     }
 
     updateInfoWidgetColorPicker( zoomPos, QPoint(x, y) );
@@ -3174,6 +3176,10 @@ ViewerGL::leaveEvent(QEvent* e)
     }
     _imp->infoViewer[0]->hideMouseInfo();
     _imp->infoViewer[1]->hideMouseInfo();
+    {
+        QMutexLocker l(&_imp->zoomCtxMutex);
+        _imp->cursorInViewer = false;
+    }
     QGLWidget::leaveEvent(e);
 }
 
@@ -3581,6 +3587,22 @@ ViewerGL::getUserRegionOfInterest() const
     return _imp->userRoI;
 }
 
+void
+ViewerGL::getRenderFocusPoint(double* x,
+                              double* y) const
+{
+    // MT-SAFE
+    QMutexLocker l(&_imp->zoomCtxMutex);
+
+    if (_imp->cursorInViewer) {
+        *x = _imp->lastCursorZoomPos.x();
+        *y = _imp->lastCursorZoomPos.y();
+    } else {
+        *x = ( _imp->zoomCtx.left() + _imp->zoomCtx.right() ) / 2.;
+        *y = ( _imp->zoomCtx.bottom() + _imp->zoomCtx.top() ) / 2.;
+    }
+}
+
 void
 ViewerGL::setUserRoI(const RectD & r)
 {
@@ -308,6 +308,7 @@ public:
 
     virtual bool isUserRegionOfInterestEnabled() const OVERRIDE FINAL;
     virtual RectD getUserRegionOfInterest() const OVERRIDE FINAL;
+    virtual void getRenderFocusPoint(double* x, double* y) const OVERRIDE FINAL;
 
     void setUserRoI(const RectD & r);
 
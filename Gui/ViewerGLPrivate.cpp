@@ -104,6 +104,8 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
     , buildUserRoIOnNextPress(false)
     , draggedUserRoI()
     , zoomCtx()   // protected by mutex
+    , lastCursorZoomPos()   // protected by mutex
+    , cursorInViewer(false)   // protected by mutex
     , clipToDisplayWindow(true)   // protected by mutex
     , wipeControlsMutex()
     , mixAmount(1.)   // protected by mutex
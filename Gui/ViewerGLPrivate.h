@@ -207,6 +207,8 @@ struct ViewerGL::Implementation
     RectD draggedUserRoI;
     ZoomContext zoomCtx; /*!< All zoom related variables are packed into this object. */
     mutable QMutex zoomCtxMutex; /// protectx zoomCtx*
+    QPointF lastCursorZoomPos; /// last position of the cursor over the viewer in canonical coords, protected by zoomCtxMutex
+    bool cursorInViewer; /// protected by zoomCtxMutex
     QMutex clipToDisplayWindowMutex;
     bool clipToDisplayWindow;
     mutable QMutex wipeControlsMutex;
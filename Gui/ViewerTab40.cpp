@@ -857,7 +857,7 @@ ViewerTab::refreshLayerAndAlphaChannelComboBox()
 
     QString layerCurChoice = _imp->layerChoice->getCurrentIndexText();
     QString alphaCurChoice = _imp->alphaChannelChoice->getCurrentIndexText();
-    std::set<ImagePlaneDesc> components;
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare> components;
     _imp->getComponentsAvailabel(&components);
 
     _imp->layerChoice->clear();
@@ -866,13 +866,13 @@ ViewerTab::refreshLayerAndAlphaChannelComboBox()
     _imp->layerChoice->addItem( QString::fromUtf8("-") );
     _imp->alphaChannelChoice->addItem( QString::fromUtf8("-") );
 
-    std::set<ImagePlaneDesc>::iterator foundColorIt = components.end();
-    std::set<ImagePlaneDesc>::iterator foundOtherIt = components.end();
-    std::set<ImagePlaneDesc>::iterator foundCurIt = components.end();
-    std::set<ImagePlaneDesc>::iterator foundCurAlphaIt = components.end();
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator foundColorIt = components.end();
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator foundOtherIt = components.end();
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator foundCurIt = components.end();
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator foundCurAlphaIt = components.end();
     std::string foundAlphaChannel;
 
-    for (std::set<ImagePlaneDesc>::iterator it = components.begin(); it != components.end(); ++it) {
+    for (std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator it = components.begin(); it != components.end(); ++it) {
 
         ChoiceOption option = it->getPlaneOption();
         _imp->layerChoice->addItem(QString::fromUtf8(option.label.c_str()));
@@ -992,7 +992,7 @@ ViewerTab::refreshLayerAndAlphaChannelComboBox()
 void
 ViewerTab::onAlphaChannelComboChanged(int index)
 {
-    std::set<ImagePlaneDesc> components;
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare> components;
 
     _imp->getComponentsAvailabel(&components);
 
@@ -1001,7 +1001,7 @@ ViewerTab::onAlphaChannelComboChanged(int index)
         _imp->currentAlphaLayerChoice = _imp->alphaChannelChoice->getCurrentIndexText();
     }
     int i = 1; // because of the "-" choice
-    for (std::set<ImagePlaneDesc>::iterator it = components.begin(); it != components.end(); ++it) {
+    for (std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator it = components.begin(); it != components.end(); ++it) {
         const std::vector<std::string>& channels = it->getChannels();
         if ( index >= ( (int)channels.size() + i ) ) {
             i += channels.size();
@@ -1021,7 +1021,7 @@ ViewerTab::onAlphaChannelComboChanged(int index)
 void
 ViewerTab::onLayerComboChanged(int index)
 {
-    std::set<ImagePlaneDesc> components;
+    std::set<ImagePlaneDesc, ImagePlaneDescIDCompare> components;
 
     _imp->getComponentsAvailabel(&components);
     {
@@ -1035,7 +1035,7 @@ ViewerTab::onLayerComboChanged(int index)
     }
     int i = 1; // because of the "-" choice
     int chanCount = 1; // because of the "-" choice
-    for (std::set<ImagePlaneDesc>::iterator it = components.begin(); it != components.end(); ++it, ++i) {
+    for (std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>::iterator it = components.begin(); it != components.end(); ++it, ++i) {
         chanCount += it->getChannels().size();
         if (i == index) {
             _imp->viewerNode->setActiveLayer(*it, true);
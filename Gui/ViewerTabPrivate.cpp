@@ -359,7 +359,7 @@ ViewerTabPrivate::getTimeTransform(double time,
 #endif // ifdef NATRON_TRANSFORM_AFFECTS_OVERLAYS
 
 void
-ViewerTabPrivate::getComponentsAvailabel(std::set<ImagePlaneDesc>* comps) const
+ViewerTabPrivate::getComponentsAvailabel(std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>* comps) const
 {
     int activeInputIdx[2];
 
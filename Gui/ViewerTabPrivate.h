@@ -218,7 +218,7 @@ struct ViewerTabPrivate
 
 #endif
 
-    void getComponentsAvailabel(std::set<ImagePlaneDesc>* comps) const;
+    void getComponentsAvailabel(std::set<ImagePlaneDesc, ImagePlaneDescIDCompare>* comps) const;
 
     std::list<PluginViewerContext>::iterator findActiveNodeContextForPlugin(const std::string& pluginID);
 
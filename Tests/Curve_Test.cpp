@@ -125,3 +125,35 @@ TEST(Curve, Basic)
 }
 
 
+
+TEST(Curve, ValuesAtAndRevision)
+{
+    Curve c;
+    U64 revision = c.getRevision();
+
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(0., 10.) ) );
+    EXPECT_NE( revision, c.getRevision() );
+    revision = c.getRevision();
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(10., 20.) ) );
+    EXPECT_NE( revision, c.getRevision() );
+    revision = c.getRevision();
+
+    // reading the curve does not change it
+    std::vector<double> times;
+    for (int i = -5; i <= 15; ++i) {
+        times.push_back(i * 0.75);
+    }
+    std::vector<double> values;
+    c.getValuesAt(times, false, &values);
+    ASSERT_EQ( times.size(), values.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i], false), values[i] );
+    }
+    EXPECT_EQ( revision, c.getRevision() );
+
+    c.removeKeyFrameWithTime(10.);
+    EXPECT_NE( revision, c.getRevision() );
+    revision = c.getRevision();
+    c.clearKeyFrames();
+    EXPECT_NE( revision, c.getRevision() );
+}
@@ -0,0 +1,412 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QAtomicInt>
+
+#include "BaseTest.h"
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/DiskCacheNode.h"
+#include "Engine/DiskCacheNodeStorage.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/LibraryBinary.h"
+#include "Engine/Node.h"
+#include "Engine/Plugin.h"
+#include "Engine/Project.h"
+#include "Engine/ViewIdx.h"
+
+#define PLUGINID_TEST_RENDER_COUNTER "net.sf.natron.test.RenderCounter"
+
+NATRON_NAMESPACE_USING
+
+static std::string
+getTestStoragePath()
+{
+    return ( QDir::tempPath() + QString::fromUtf8("/DiskCacheNodeStorage_Test") ).toStdString();
+}
+
+static DiskCacheNodeStorageKey
+makeKey(U64 nodeHash,
+        double time)
+{
+    DiskCacheNodeStorageKey key;
+
+    key.nodeHash = nodeHash;
+    key.time = time;
+    key.nComps = 4;
+
+    return key;
+}
+
+static U64
+getDataFileSize(const std::string& path)
+{
+    return QFileInfo( QString::fromUtf8( path.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_DATA_FILE_EXT) ).size();
+}
+
+static std::vector<float>
+makeImage(const RectI& bounds,
+          float seed)
+{
+    std::vector<float> pixels(bounds.area() * 4);
+
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = seed + (float)(i % 97);
+    }
+
+    return pixels;
+}
+
+TEST(DiskCacheNodeStorage,
+     ReopenAndRead)
+{
+    std::string path = getTestStoragePath();
+    DiskCacheNodeStorage::removeFiles(path);
+
+    RectI bounds(0, 0, 64, 32);
+    std::vector<float> image = makeImage(bounds, 1.f);
+    std::vector<float> compressedImage(bounds.area() * 4, 0.5f);
+    {
+        DiskCacheNodeStorage storage(path);
+        ASSERT_TRUE( storage.put(makeKey(1, 10.), bounds, &image[0], bounds.width() * 4, false, 1 << 30) );
+        ASSERT_TRUE( storage.put(makeKey(1, 11.), bounds, &compressedImage[0], bounds.width() * 4, true, 1 << 30) );
+        EXPECT_LT( storage.getSize(), (U64)image.size() * sizeof(float) * 2 ) << "The constant image should be compressed";
+    }
+
+    // The images are found again in another session
+    DiskCacheNodeStorage storage(path);
+    std::vector<float> read(image.size(), 0.f);
+    ASSERT_TRUE( storage.get(makeKey(1, 10.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_TRUE(read == image);
+    ASSERT_TRUE( storage.get(makeKey(1, 11.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_TRUE(read == compressedImage);
+
+    // Reading a portion of the image
+    RectI roi(8, 4, 16, 12);
+    std::vector<float> portion(roi.area() * 4, 0.f);
+    ASSERT_TRUE( storage.get(makeKey(1, 10.), roi, &portion[0], roi.width() * 4) );
+    EXPECT_EQ( image[(4 * bounds.width() + 8) * 4], portion[0] );
+
+    // Another node hash or a larger area is not in the storage
+    EXPECT_FALSE( storage.get(makeKey(2, 10.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_FALSE( storage.get(makeKey(1, 10.), RectI(0, 0, 65, 32), &read[0], bounds.width() * 4) );
+
+    storage.clear();
+    EXPECT_FALSE( storage.get(makeKey(1, 10.), bounds, &read[0], bounds.width() * 4) );
+    DiskCacheNodeStorage::removeFiles(path);
+}
+
+TEST(DiskCacheNodeStorage,
+     MaximumSize)
+{
+    std::string path = getTestStoragePath();
+    DiskCacheNodeStorage::removeFiles(path);
+
+    RectI bounds(0, 0, 16, 16);
+    std::vector<float> image = makeImage(bounds, 2.f);
+    const U64 imageSize = image.size() * sizeof(float);
+    DiskCacheNodeStorage storage(path);
+
+    ASSERT_TRUE( storage.put(makeKey(1, 1.), bounds, &image[0], bounds.width() * 4, false, imageSize * 2) );
+    ASSERT_TRUE( storage.put(makeKey(1, 2.), bounds, &image[0], bounds.width() * 4, false, imageSize * 2) );
+
+    // The storage is full of images of the same node hash
+    EXPECT_FALSE( storage.put(makeKey(1, 3.), bounds, &image[0], bounds.width() * 4, false, imageSize * 2) );
+
+    // Images of a previous node hash are removed to make room
+    ASSERT_TRUE( storage.put(makeKey(2, 1.), bounds, &image[0], bounds.width() * 4, false, imageSize * 2) );
+    EXPECT_EQ(imageSize, storage.getSize());
+
+    std::vector<float> read(image.size(), 0.f);
+    EXPECT_FALSE( storage.get(makeKey(1, 1.), bounds, &read[0], bounds.width() * 4) );
+    ASSERT_TRUE( storage.get(makeKey(2, 1.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_TRUE(read == image);
+    DiskCacheNodeStorage::removeFiles(path);
+}
+
+TEST(DiskCacheNodeStorage,
+     FileSizeIsBounded)
+{
+    std::string path = getTestStoragePath();
+    DiskCacheNodeStorage::removeFiles(path);
+
+    RectI bounds(0, 0, 16, 16);
+    const U64 imageSize = bounds.area() * 4 * sizeof(float);
+    const U64 maxSize = imageSize * 3;
+    DiskCacheNodeStorage storage(path);
+
+    // Replacing the same image over and over reclaims the space of the replaced images
+    std::vector<float> image;
+    for (int i = 0; i < 10; ++i) {
+        image = makeImage(bounds, (float)i);
+        ASSERT_TRUE( storage.put(makeKey(1, 1.), bounds, &image[0], bounds.width() * 4, false, maxSize) );
+        EXPECT_LE(getDataFileSize(path), maxSize);
+    }
+    EXPECT_EQ(imageSize, storage.getSize());
+
+    std::vector<float> read(image.size(), 0.f);
+    ASSERT_TRUE( storage.get(makeKey(1, 1.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_TRUE(read == image);
+
+    // The file shrinks when images are removed
+    ASSERT_TRUE( storage.put(makeKey(1, 2.), bounds, &image[0], bounds.width() * 4, false, maxSize) );
+    storage.removeEntriesWithDifferentHash(2);
+    EXPECT_EQ( (U64)0, storage.getSize() );
+    EXPECT_EQ( (U64)0, getDataFileSize(path) );
+    DiskCacheNodeStorage::removeFiles(path);
+}
+
+TEST(DiskCacheNodeStorage,
+     MoveFiles)
+{
+    std::string path = getTestStoragePath();
+    std::string newPath = path + "_moved";
+    DiskCacheNodeStorage::removeFiles(path);
+    DiskCacheNodeStorage::removeFiles(newPath);
+
+    RectI bounds(0, 0, 16, 16);
+    std::vector<float> image = makeImage(bounds, 3.f);
+    std::vector<float> read(image.size(), 0.f);
+    {
+        DiskCacheNodeStorage storage(path);
+        ASSERT_TRUE( storage.put(makeKey(1, 1.), bounds, &image[0], bounds.width() * 4, false, 1 << 30) );
+        ASSERT_TRUE( storage.moveFiles(newPath) );
+        EXPECT_EQ( newPath, storage.getFilePath() );
+        EXPECT_FALSE( QFile::exists( QString::fromUtf8( path.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_DATA_FILE_EXT) ) );
+
+        // The storage is still usable after the move
+        ASSERT_TRUE( storage.get(makeKey(1, 1.), bounds, &read[0], bounds.width() * 4) );
+        EXPECT_TRUE(read == image);
+        ASSERT_TRUE( storage.put(makeKey(1, 2.), bounds, &image[0], bounds.width() * 4, false, 1 << 30) );
+    }
+
+    // The images are found at the new path in another session
+    DiskCacheNodeStorage storage(newPath);
+    std::fill(read.begin(), read.end(), 0.f);
+    ASSERT_TRUE( storage.get(makeKey(1, 2.), bounds, &read[0], bounds.width() * 4) );
+    EXPECT_TRUE(read == image);
+    EXPECT_TRUE( storage.contains( makeKey(1, 1.), RectI(0, 0, 8, 8) ) );
+    EXPECT_FALSE( storage.contains( makeKey(1, 3.), RectI(0, 0, 8, 8) ) );
+    DiskCacheNodeStorage::removeFiles(newPath);
+}
+
+TEST(DiskCacheNodeStorage,
+     Locking)
+{
+    std::string path = getTestStoragePath();
+    std::string temporaryPath = path + "_temporary";
+    DiskCacheNodeStorage::removeFiles(path);
+
+    {
+        DiskCacheNodeStorage storage(path);
+
+        // Another storage of the same files, from this process or another one, must not write them
+        EXPECT_THROW( DiskCacheNodeStorage other(path), std::runtime_error );
+        EXPECT_FALSE( DiskCacheNodeStorage::removeFiles(path) );
+        EXPECT_FALSE( DiskCacheNodeStorage::renameFiles(path, path + "_moved") );
+    }
+
+    // The lock is released with the storage
+    {
+        DiskCacheNodeStorage storage(path);
+    }
+    EXPECT_TRUE( DiskCacheNodeStorage::removeFiles(path) );
+
+    // A temporary storage removes its files
+    RectI bounds(0, 0, 16, 16);
+    std::vector<float> image = makeImage(bounds, 4.f);
+    const QString temporaryDataFilePath = QString::fromUtf8( temporaryPath.c_str() ) + QString::fromUtf8("." NATRON_DISKCACHE_NODE_DATA_FILE_EXT);
+    {
+        DiskCacheNodeStorage storage(temporaryPath, true);
+        ASSERT_TRUE( storage.put(makeKey(1, 1.), bounds, &image[0], bounds.width() * 4, false, 1 << 30) );
+        EXPECT_TRUE( QFile::exists(temporaryDataFilePath) );
+    }
+    EXPECT_FALSE( QFile::exists(temporaryDataFilePath) );
+}
+
+/**
+ * @brief Copies its input and counts how many times it rendered
+ **/
+class RenderCounterEffect
+    : public EffectInstance
+{
+public:
+
+    static QAtomicInt renderCount;
+
+    static EffectInstance* BuildEffect(NodePtr n)
+    {
+        return new RenderCounterEffect(n);
+    }
+
+    RenderCounterEffect(NodePtr node)
+        : EffectInstance(node)
+    {
+        setSupportsRenderScaleMaybe(eSupportsYes);
+    }
+
+    virtual int getMajorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN { return 1; }
+
+    virtual int getMinorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN { return 0; }
+
+    virtual int getNInputs() const OVERRIDE FINAL WARN_UNUSED_RETURN { return 1; }
+
+    virtual bool isInputOptional(int /*inputNb*/) const OVERRIDE FINAL WARN_UNUSED_RETURN { return false; }
+
+    virtual std::string getPluginID() const OVERRIDE FINAL WARN_UNUSED_RETURN { return PLUGINID_TEST_RENDER_COUNTER; }
+
+    virtual std::string getPluginLabel() const OVERRIDE FINAL WARN_UNUSED_RETURN { return "RenderCounter"; }
+
+    virtual std::string getPluginDescription() const OVERRIDE FINAL WARN_UNUSED_RETURN { return std::string(); }
+
+    virtual void getPluginGrouping(std::list<std::string>* grouping) const OVERRIDE FINAL
+    {
+        grouping->push_back(PLUGIN_GROUP_OTHER);
+    }
+
+    virtual void addAcceptedComponents(int /*inputNb*/,
+                                       std::list<ImagePlaneDesc>* comps) OVERRIDE FINAL
+    {
+        comps->push_back( ImagePlaneDesc::getRGBAComponents() );
+        comps->push_back( ImagePlaneDesc::getRGBComponents() );
+        comps->push_back( ImagePlaneDesc::getAlphaComponents() );
+    }
+
+    virtual void addSupportedBitDepth(std::list<ImageBitDepthEnum>* depths) const OVERRIDE FINAL
+    {
+        depths->push_back(eImageBitDepthFloat);
+    }
+
+    virtual RenderSafetyEnum renderThreadSafety() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return eRenderSafetyFullySafe;
+    }
+
+    virtual bool supportsTiles() const OVERRIDE FINAL WARN_UNUSED_RETURN { return false; }
+
+    virtual bool supportsMultiResolution() const OVERRIDE FINAL WARN_UNUSED_RETURN { return true; }
+
+private:
+
+    virtual StatusEnum render(const RenderActionArgs& args) OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        renderCount.ref();
+        for (std::list<std::pair<ImagePlaneDesc, ImagePtr> >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it) {
+            RectI roiPixel;
+            ImagePtr srcImg = getImage(0, args.time, args.originalScale, args.view, NULL, &it->first, false /*mapToClipPrefs*/, true /*dontUpscale*/, eStorageModeRAM /*useOpenGL*/, 0 /*textureDepth*/,  &roiPixel);
+            if (!srcImg) {
+                return eStatusFailed;
+            }
+            it->second->pasteFrom( *srcImg, args.roi, false );
+        }
+
+        return eStatusOK;
+    }
+};
+
+QAtomicInt RenderCounterEffect::renderCount(0);
+
+static void
+renderDiskCacheNode(const NodePtr& diskCache)
+{
+    std::list<AppInstance::RenderWork> works;
+    AppInstance::RenderWork w;
+
+    w.writer = dynamic_cast<OutputEffectInstance*>( diskCache->getEffectInstance().get() );
+    assert(w.writer);
+    w.firstFrame = INT_MIN;
+    w.lastFrame = INT_MAX;
+    w.frameStep = 1;
+    w.useRenderStats = false;
+    works.push_back(w);
+    diskCache->getApp()->startWritersRendering(false, works);
+}
+
+///A frame found in the storage of a DiskCache node must not render the nodes upstream
+TEST_F(BaseTest, DiskCacheSkipsUpstreamRender)
+{
+    if ( !appPTR->getPluginBinary(QString::fromUtf8(PLUGINID_TEST_RENDER_COUNTER), -1, -1, false) ) {
+        std::map<std::string, void (*)()> functions;
+        functions.insert( std::make_pair("BuildEffect", ( void (*)() ) & RenderCounterEffect::BuildEffect) );
+        appPTR->registerPlugin(QString(), QStringList( QString::fromUtf8(PLUGIN_GROUP_OTHER) ), QString::fromUtf8(PLUGINID_TEST_RENDER_COUNTER),
+                               QString::fromUtf8("RenderCounter"), QString(), QStringList(), false, false, new LibraryBinary(functions), false, 1, 0, false);
+    }
+
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr counter = createNode( QString::fromUtf8(PLUGINID_TEST_RENDER_COUNTER) );
+    NodePtr diskCache = createNode( QString::fromUtf8(PLUGINID_NATRON_DISKCACHE) );
+    ASSERT_TRUE( bool(generator) && bool(counter) && bool(diskCache) );
+
+    KnobIPtr frameRange = getApp()->getProject()->getKnobByName("frameRange");
+    ASSERT_TRUE( bool(frameRange) );
+    KnobInt* frameRangeKnob = dynamic_cast<KnobInt*>( frameRange.get() );
+    ASSERT_TRUE(frameRangeKnob);
+    frameRangeKnob->setValue(1, ViewSpec::all(), 0);
+    frameRangeKnob->setValue(1, ViewSpec::all(), 1);
+
+    // Cache the project frame range
+    KnobChoice* diskCacheRange = dynamic_cast<KnobChoice*>( diskCache->getKnobByName("frameRange").get() );
+    ASSERT_TRUE(diskCacheRange);
+    diskCacheRange->setValue(1);
+
+    connectNodes(generator, counter, 0, true);
+    connectNodes(counter, diskCache, 0, true);
+
+    DiskCacheNode* diskCacheEffect = dynamic_cast<DiskCacheNode*>( diskCache->getEffectInstance().get() );
+    ASSERT_TRUE(diskCacheEffect);
+    diskCacheEffect->clearStorage();
+
+    RenderCounterEffect::renderCount.fetchAndStoreRelaxed(0);
+    renderDiskCacheNode(diskCache);
+    const int firstRenderCount = (int)RenderCounterEffect::renderCount;
+    EXPECT_GT(firstRenderCount, 0);
+
+    // The images of the node cache would also prevent the upstream render: only the storage is left
+    appPTR->clearNodeCache();
+    renderDiskCacheNode(diskCache);
+    EXPECT_EQ( firstRenderCount, (int)RenderCounterEffect::renderCount ) << "The frame should have been read from the storage";
+
+    // Without the storage, the upstream nodes render again
+    diskCacheEffect->clearStorage();
+    appPTR->clearNodeCache();
+    renderDiskCacheNode(diskCache);
+    EXPECT_GT( (int)RenderCounterEffect::renderCount, firstRenderCount );
+
+    diskCacheEffect->clearStorage();
+}
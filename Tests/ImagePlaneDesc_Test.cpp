@@ -0,0 +1,145 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <QtCore/QString>
+
+#include <gtest/gtest.h>
+
+#include "Engine/Hash64.h"
+#include "Engine/ImagePlaneDesc.h"
+
+NATRON_NAMESPACE_USING
+
+static const char* testComps[3] = {"X", "Y", "Z"};
+
+static U64
+getPlaneHash(const ImagePlaneDesc& plane)
+{
+    Hash64 hash;
+
+    plane.appendToHash(&hash);
+    hash.computeHash();
+
+    return hash.value();
+}
+
+TEST(ImagePlaneDesc, Interning) {
+    ImagePlaneDesc a("TestInterning", "Interning", "", testComps, 3);
+    ImagePlaneDesc b("TestInterning", "Interning", "", testComps, 3);
+
+    // Both refer to the same layout
+    EXPECT_EQ( &a.getPlaneID(), &b.getPlaneID() );
+    EXPECT_EQ( &a.getChannels(), &b.getChannels() );
+    EXPECT_EQ( "XYZ", a.getChannelsLabel() );
+
+    ImagePlaneDesc c(a);
+    EXPECT_EQ( &a.getPlaneID(), &c.getPlaneID() );
+    c = ImagePlaneDesc::getRGBAComponents();
+    EXPECT_EQ( &ImagePlaneDesc::getRGBAComponents().getPlaneID(), &c.getPlaneID() );
+    EXPECT_TRUE( c.isColorPlane() );
+    EXPECT_FALSE( a.isColorPlane() );
+
+    // The default plane is "none"
+    ImagePlaneDesc none;
+    EXPECT_FALSE(none);
+    EXPECT_EQ( ImagePlaneDesc::getNoneComponents(), none );
+}
+
+TEST(ImagePlaneDesc, Equality) {
+    ImagePlaneDesc a("TestEquality", "Equality", "", testComps, 3);
+    ImagePlaneDesc otherLabels("TestEquality", "OtherLabel", "OtherChannels", testComps, 3);
+    ImagePlaneDesc fewerChannels("TestEquality", "Equality", "", testComps, 2);
+    ImagePlaneDesc otherID("TestEquality2", "Equality", "", testComps, 3);
+
+    // Planes are equal if they have the same ID and number of channels
+    EXPECT_TRUE(a == otherLabels);
+    EXPECT_FALSE(a != otherLabels);
+    EXPECT_FALSE(a == fewerChannels);
+    EXPECT_FALSE(a == otherID);
+
+    EXPECT_TRUE( ImagePlaneDesc::getRGBComponents() != ImagePlaneDesc::getRGBAComponents() );
+    EXPECT_TRUE( ImagePlaneDesc::getRGBAComponents() == ImagePlaneDesc::mapNCompsToColorPlane(4) );
+}
+
+TEST(ImagePlaneDesc, Ordering) {
+    ImagePlaneDesc a("TestOrderingB", "B", "", testComps, 3);
+    ImagePlaneDesc b("TestOrderingA", "A", "", testComps, 3);
+    ImagePlaneDesc aOtherLabel("TestOrderingB", "OtherLabel", "", testComps, 3);
+
+    // Strict weak ordering on the plane ID
+    EXPECT_FALSE(a < a);
+    EXPECT_TRUE( (a < b) != (b < a) );
+    EXPECT_FALSE(a < aOtherLabel);
+    EXPECT_FALSE(aOtherLabel < a);
+
+    std::map<ImagePlaneDesc, int> planes;
+    planes[a] = 1;
+    planes[b] = 2;
+    planes[aOtherLabel] = 3;
+    EXPECT_EQ( 2, (int)planes.size() );
+    EXPECT_EQ( 3, planes[a] );
+
+    // Lists displayed to the user are sorted by plane ID
+    EXPECT_TRUE( ImagePlaneDescIDCompare()(b, a) );
+    EXPECT_FALSE( ImagePlaneDescIDCompare()(a, b) );
+}
+
+TEST(ImagePlaneDesc, Hash) {
+    ImagePlaneDesc a("TestHash", "Hash", "", testComps, 3);
+    ImagePlaneDesc otherLabels("TestHash", "OtherLabel", "OtherChannels", testComps, 3);
+    ImagePlaneDesc fewerChannels("TestHash", "Hash", "", testComps, 2);
+
+    // The hash is the one of the plane ID followed by the channels, as cache keys computed it before interning
+    Hash64 expected;
+    Hash64_appendQString( &expected, QString::fromUtf8("TestHash") );
+    for (int i = 0; i < 3; ++i) {
+        Hash64_appendQString( &expected, QString::fromUtf8(testComps[i]) );
+    }
+    expected.computeHash();
+
+    EXPECT_EQ( expected.value(), getPlaneHash(a) );
+    EXPECT_EQ( getPlaneHash(a), getPlaneHash(otherLabels) );
+    EXPECT_NE( getPlaneHash(a), getPlaneHash(fewerChannels) );
+}
+
+TEST(ImagePlaneDesc, OFXPlaneStrings) {
+    // More planes than the decoded OpenFX strings that are remembered
+    for (int i = 0; i < 2000; ++i) {
+        std::stringstream ss;
+        ss << "TestOFX" << i;
+        ImagePlaneDesc plane(ss.str(), "", "", testComps, 3);
+        std::string ofxPlane = ImagePlaneDesc::mapPlaneToOFXPlaneString(plane);
+        ImagePlaneDesc decoded = ImagePlaneDesc::mapOFXPlaneStringToPlane(ofxPlane);
+        EXPECT_TRUE(decoded == plane);
+        EXPECT_EQ( &plane.getPlaneLabel(), &decoded.getPlaneLabel() );
+    }
+}
@@ -25,6 +25,7 @@
 
 #include "Global/Macros.h"
 
+#include <bitset>
 #include <cstring>
 #include <gtest/gtest.h>
 
@@ -160,3 +161,141 @@ TEST(ImageKeyTest, Difference) {
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+
+TEST(ImageTest, Constant) {
+    RectI bounds(0, 0, 64, 32);
+    RectD rod(0, 0, 64, 32);
+    Image img(ImagePlaneDesc::getRGBAComponents(), rod, bounds, 0, 1., eImageBitDepthFloat,
+              eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, true);
+
+    ///filling the whole image makes it constant
+    img.fill(bounds, 0.25f, 0.5f, 0.75f, 1.f);
+    ASSERT_TRUE( img.isConstant() );
+    float pixel[4];
+    ASSERT_TRUE( img.getConstantPixel( (unsigned char*)pixel ) );
+    EXPECT_EQ(0.25f, pixel[0]);
+    EXPECT_EQ(1.f, pixel[3]);
+
+    ///downscaling a constant image yields a constant image with the same value
+    RectI halfBounds(0, 0, 32, 16);
+    Image half(ImagePlaneDesc::getRGBAComponents(), rod, halfBounds, 1, 1., eImageBitDepthFloat,
+               eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+    img.downscaleMipMap(rod, bounds, 0, 1, false, &half);
+    ASSERT_TRUE( half.isConstant() );
+    {
+        Image::ReadAccess acc(&half);
+        const float* p = (const float*)acc.pixelAt(31, 15);
+        EXPECT_EQ(0.5f, p[1]);
+    }
+
+    ///converting a constant image writes the converted value everywhere
+    Image alpha(ImagePlaneDesc::getAlphaComponents(), rod, bounds, 0, 1., eImageBitDepthByte,
+                eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+    img.convertToFormat(bounds, eViewerColorSpaceLinear, eViewerColorSpaceLinear, 3, false, false, &alpha);
+    ASSERT_TRUE( alpha.isConstant() );
+    {
+        Image::ReadAccess acc(&alpha);
+        EXPECT_EQ( 255, *(const unsigned char*)acc.pixelAt(63, 31) );
+    }
+
+    ///writing to the pixels clears the constant state, which may be detected again
+    {
+        Image::WriteAccess acc(&img);
+        float* p = (float*)acc.pixelAt(10, 10);
+        p[0] = 0.f;
+    }
+    ASSERT_FALSE( img.isConstant() );
+    img.markForRendered(bounds);
+    ASSERT_FALSE( img.detectConstant() );
+    img.fill(RectI(10, 10, 11, 11), 0.25f, 0.5f, 0.75f, 1.f);
+    ASSERT_TRUE( img.detectConstant() );
+}
+
+// Fills the image with a pattern that differs for each pixel and channel
+template <typename PIX, int maxValue>
+static void
+fillMaskMixTestImage(Image* img,
+                     int seed)
+{
+    const RectI& bounds = img->getBounds();
+    int nComps = (int)img->getComponentsCount();
+    Image::WriteAccess acc(img);
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        PIX* p = (PIX*)acc.pixelAt(bounds.x1, y);
+        for (int x = bounds.x1; x < bounds.x2; ++x) {
+            for (int c = 0; c < nComps; ++c, ++p) {
+                int v = (x * 7 + y * 13 + c * 31 + seed * 17) % 256;
+                *p = (PIX)(maxValue == 1 ? v / 255.f : v * (maxValue / 255));
+            }
+        }
+    }
+}
+
+template <typename PIX, int maxValue>
+static void
+testCopyUnProcessedChannelsAndApplyMaskMix(ImageBitDepthEnum depth)
+{
+    const ImagePlaneDesc* components[4] = {
+        &ImagePlaneDesc::getAlphaComponents(), &ImagePlaneDesc::getXYComponents(),
+        &ImagePlaneDesc::getRGBComponents(), &ImagePlaneDesc::getRGBAComponents()
+    };
+    RectD rod(0, 0, 48, 32);
+    RectI bounds(0, 0, 48, 32);
+    // The original image and the mask only cover part of the rendered area
+    RectI originalBounds(8, 0, 48, 32);
+    RectI maskBounds(0, 4, 40, 32);
+    RectI roi(3, 2, 45, 30);
+
+    Image mask(ImagePlaneDesc::getAlphaComponents(), rod, maskBounds, 0, 1., depth,
+               eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+    fillMaskMixTestImage<PIX, maxValue>(&mask, 3);
+
+    for (int dstComps = 0; dstComps < 4; ++dstComps) {
+        for (int srcComps = 0; srcComps < 4; ++srcComps) {
+            ImagePtr original( new Image(*components[srcComps], rod, originalBounds, 0, 1., depth,
+                                         eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false) );
+            fillMaskMixTestImage<PIX, maxValue>(original.get(), 2);
+
+            for (int processed = 0; processed < 16; ++processed) {
+                std::bitset<4> processChannels(processed);
+                for (int maskCase = 0; maskCase < 3; ++maskCase) {
+                    const bool masked = maskCase != 0;
+                    const bool maskInvert = maskCase == 2;
+                    const float mixes[2] = { 1.f, 0.3f };
+                    for (int m = 0; m < 2; ++m) {
+                        Image expected(*components[dstComps], rod, bounds, 0, 1., depth,
+                                       eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+                        Image fused(*components[dstComps], rod, bounds, 0, 1., depth,
+                                    eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+                        fillMaskMixTestImage<PIX, maxValue>(&expected, 1);
+                        fillMaskMixTestImage<PIX, maxValue>(&fused, 1);
+
+                        expected.copyUnProcessedChannels(roi, eImagePremultiplicationOpaque, eImagePremultiplicationOpaque,
+                                                         processChannels, original, true);
+                        expected.applyMaskMix(roi, masked ? &mask : 0, original.get(), masked, maskInvert, mixes[m]);
+                        fused.copyUnProcessedChannelsAndApplyMaskMix(roi, eImagePremultiplicationOpaque, eImagePremultiplicationOpaque,
+                                                                     processChannels, original, true,
+                                                                     masked ? &mask : 0, masked, maskInvert, mixes[m]);
+
+                        Image::ReadAccess expectedAcc(&expected);
+                        Image::ReadAccess fusedAcc(&fused);
+                        std::size_t rowBytes = bounds.width() * expected.getComponentsCount() * sizeof(PIX);
+                        for (int y = bounds.y1; y < bounds.y2; ++y) {
+                            ASSERT_EQ( 0, std::memcmp(expectedAcc.pixelAt(bounds.x1, y), fusedAcc.pixelAt(bounds.x1, y), rowBytes) )
+                                << "dst components " << dstComps + 1 << ", src components " << srcComps + 1
+                                << ", processed channels " << processed << ", mask case " << maskCase << ", mix " << mixes[m] << ", row " << y;
+                        }
+                    }
+                }
+            }
+        }
+    }
+} // testCopyUnProcessedChannelsAndApplyMaskMix
+
+///The fused copy of the unprocessed channels and mask mix must give exactly the same result as the two separate passes
+TEST(ImageTest, CopyUnProcessedChannelsAndApplyMaskMix) {
+    testCopyUnProcessedChannelsAndApplyMaskMix<float, 1>(eImageBitDepthFloat);
+    testCopyUnProcessedChannelsAndApplyMaskMix<unsigned char, 255>(eImageBitDepthByte);
+    testCopyUnProcessedChannelsAndApplyMaskMix<unsigned short, 65535>(eImageBitDepthShort);
+}
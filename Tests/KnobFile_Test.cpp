@@ -33,6 +33,8 @@
 #include "Engine/FileSystemModel.h"
 #include "Engine/StandardPaths.h"
 
+#include "Gui/SequenceFileDialog.h"
+
 #include <SequenceParsing.h>
 
 NATRON_NAMESPACE_USING
@@ -627,3 +629,62 @@ TEST(SequenceFromFiles, ComplexTest) {
         EXPECT_TRUE(sequence.generateValidSequencePattern() == "/Users/Test/#####.jpg");
     }
 }
+
+TEST(SequenceFromFiles, BucketedGrouping) {
+    // Files of a sequence only differ by their digits
+    EXPECT_EQ( QString::fromUtf8("/Users/Test#/shot#_v#.#.exr"), FileSystemModel::getSequenceBucketKey( QString::fromUtf8("/Users/Test2/shot010_v2.0001.exr") ) );
+    EXPECT_EQ( FileSystemModel::getSequenceBucketKey( QString::fromUtf8("img9.jpg") ), FileSystemModel::getSequenceBucketKey( QString::fromUtf8("img0010.jpg") ) );
+    EXPECT_NE( FileSystemModel::getSequenceBucketKey( QString::fromUtf8("img9.jpg") ), FileSystemModel::getSequenceBucketKey( QString::fromUtf8("img9.png") ) );
+
+    // Interleave the files of several sequences and single files
+    QStringList files;
+    for (int i = 1; i <= 10; ++i) {
+        QString number = QString::number(i);
+        while (number.size() < 3) {
+            number.prepend( QLatin1Char('0') );
+        }
+        files << QString::fromUtf8("/Users/Test/a") + number + QString::fromUtf8(".jpg");
+        files << QString::fromUtf8("/Users/Test/left.") + number + QString::fromUtf8(".jpg");
+        files << QString::fromUtf8("/Users/Test/right.") + number + QString::fromUtf8(".jpg");
+        files << QString::fromUtf8("/Users/Test/a") + number + QString::fromUtf8(".txt");
+        files << QString::fromUtf8("/Users/Test/shot_v2.") + number + QString::fromUtf8(".jpg");
+        files << QString::fromUtf8("/Users/Test/shot_v3.") + number + QString::fromUtf8(".jpg");
+    }
+    files << QString::fromUtf8("/Users/Test/single.jpg");
+    files << QString::fromUtf8("/Users/Test2/a001.jpg");
+
+    QStringList supportedFileTypes;
+    supportedFileTypes << QString::fromUtf8("jpg");
+    std::vector<SequenceFromFilesPtr> sequences = SequenceFileDialog::fileSequencesFromFilesList(files, supportedFileTypes);
+
+    // The sequences are in the order of their first file
+    ASSERT_LE( 5, (int)sequences.size() );
+    EXPECT_EQ( "/Users/Test/a###.jpg", sequences[0]->generateValidSequencePattern() );
+    EXPECT_EQ( 10, (int)sequences[0]->getFrameIndexes().size() );
+    EXPECT_EQ( "/Users/Test/left.###.jpg", sequences[1]->generateValidSequencePattern() );
+    EXPECT_EQ( 10, (int)sequences[1]->getFrameIndexes().size() );
+    EXPECT_EQ( "/Users/Test/right.###.jpg", sequences[2]->generateValidSequencePattern() );
+    EXPECT_EQ( 10, (int)sequences[2]->getFrameIndexes().size() );
+    EXPECT_EQ( "/Users/Test2/a001.jpg", sequences.back()->generateValidSequencePattern() );
+
+    // Same grouping as trying each file against all the sequences found so far
+    std::vector<SequenceFromFilesPtr> expected;
+    for (int i = 0; i < files.size(); ++i) {
+        FileNameContent fileContent( files.at(i).toStdString() );
+        if ( fileContent.getExtension() != "jpg" ) {
+            continue;
+        }
+        bool found = false;
+        for (std::size_t j = 0; j < expected.size() && !found; ++j) {
+            found = expected[j]->tryInsertFile(fileContent);
+        }
+        if (!found) {
+            expected.push_back( SequenceFromFilesPtr( new SequenceFromFiles(fileContent, false) ) );
+        }
+    }
+    ASSERT_EQ( expected.size(), sequences.size() );
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ( expected[i]->generateValidSequencePattern(), sequences[i]->generateValidSequencePattern() );
+        EXPECT_EQ( expected[i]->getFrameIndexes().size(), sequences[i]->getFrameIndexes().size() );
+    }
+}
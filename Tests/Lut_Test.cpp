@@ -26,8 +26,10 @@
 #include "Global/Macros.h"
 
 #include <cstdlib>
+#include <vector>
 #include <gtest/gtest.h>
 #include "Engine/Lut.h"
+#include "Engine/RectI.h"
 
 NATRON_NAMESPACE_USING
 using namespace NATRON_NAMESPACE::Color;
@@ -52,3 +54,95 @@ TEST(Lut, IntConversions) {
         EXPECT_EQ( i, uint8xxToChar( charToUint8xx(i) ) );
     }
 }
+
+// The packed conversions are split in bands of rows converted in parallel: check them against the per-pixel conversions
+TEST(Lut, PackedShortConversions) {
+    const Lut* lut = LutManager::sRGBLut();
+    const int w = 300, h = 300;
+    RectI bounds(0, 0, w, h);
+    std::vector<float> linear(w * h * 4);
+
+    for (std::size_t i = 0; i < linear.size(); ++i) {
+        linear[i] = (float)( std::rand() % 1001 ) / 1000.f;
+    }
+    std::vector<unsigned short> shorts(w * h * 4);
+    lut->to_short_packed(&shorts[0], &linear[0], bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, false, true);
+    for (int y = 0; y < h; ++y) {
+        // the output rows are flipped
+        const float* src = &linear[y * w * 4];
+        const unsigned short* dst = &shorts[(h - y - 1) * w * 4];
+        for (int x = 0; x < w; ++x, src += 4, dst += 4) {
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_EQ( lut->toColorSpaceUint16FromLinearFloatFast(src[c] * src[3]), dst[c] );
+            }
+            EXPECT_EQ( floatToInt<65536>(src[3]), dst[3] );
+        }
+    }
+
+    std::vector<float> back(w * h * 3);
+    lut->from_short_packed(&back[0], &shorts[0], bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGB, false, false);
+    for (int y = 0; y < h; ++y) {
+        const unsigned short* src = &shorts[y * w * 4];
+        const float* dst = &back[y * w * 3];
+        for (int x = 0; x < w; ++x, src += 4, dst += 3) {
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_EQ( lut->fromColorSpaceUint16ToLinearFloatFast(src[c]), dst[c] );
+            }
+        }
+    }
+}
+
+TEST(Lut, PackedByteConversions) {
+    const Lut* lut = LutManager::sRGBLut();
+    const int w = 300, h = 300;
+    RectI bounds(0, 0, w, h);
+    std::vector<unsigned char> bytes(w * h * 3);
+
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = (unsigned char)(std::rand() % 256);
+    }
+    std::vector<float> linear(w * h * 4);
+    lut->from_byte_packed(&linear[0], &bytes[0], bounds, bounds, bounds, ePixelPackingRGB, ePixelPackingRGBA, false, false);
+    for (std::size_t i = 0; i < (std::size_t)w * h; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_EQ( lut->fromColorSpaceUint8ToLinearFloatFast(bytes[i * 3 + c]), linear[i * 4 + c] );
+        }
+        EXPECT_EQ( 1.f, linear[i * 4 + 3] );
+    }
+
+    // 8-bit values converted to linear and back are unchanged, error diffusion only affects the values in-between
+    std::vector<unsigned char> bytesBack(w * h * 3);
+    lut->to_byte_packed(&bytesBack[0], &linear[0], bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGB, false, false);
+    for (std::size_t i = 0; i < (std::size_t)w * h; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            // to_byte_packed flips the rows twice when invertY is false
+            EXPECT_EQ( bytes[i * 3 + c], bytesBack[i * 3 + c] );
+        }
+    }
+}
+
+// The error diffusion of each row must not depend on the band of rows it is converted with
+TEST(Lut, PackedByteErrorDiffusionIsDeterministic) {
+    const Lut* lut = LutManager::sRGBLut();
+    const int w = 300, h = 300;
+    RectI bounds(0, 0, w, h);
+    std::vector<float> linear(w * h * 4);
+
+    for (std::size_t i = 0; i < linear.size(); ++i) {
+        linear[i] = (float)( std::rand() % 100001 ) / 100000.f;
+    }
+    std::vector<unsigned char> bytes(w * h * 4);
+    lut->to_byte_packed(&bytes[0], &linear[0], bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, false, false);
+
+    std::vector<unsigned char> bytesAgain(w * h * 4);
+    lut->to_byte_packed(&bytesAgain[0], &linear[0], bounds, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, false, false);
+    EXPECT_TRUE(bytes == bytesAgain);
+
+    // converting the rows one at a time does not go through the parallel bands
+    std::vector<unsigned char> bytesPerRow(w * h * 4);
+    for (int y = 0; y < h; ++y) {
+        RectI row(0, y, w, y + 1);
+        lut->to_byte_packed(&bytesPerRow[0], &linear[0], row, bounds, bounds, ePixelPackingRGBA, ePixelPackingRGBA, false, false);
+    }
+    EXPECT_TRUE(bytes == bytesPerRow);
+}
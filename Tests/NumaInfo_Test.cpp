@@ -0,0 +1,228 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm> // max, min, min_element
+#include <iostream>
+#include <vector>
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <QtCore/QThread>
+
+#include "Engine/CacheEntry.h"
+#include "Engine/NumaInfo.h"
+#include "Engine/Timer.h"
+
+// Size of the image allocated by each thread of the benchmark (4 channels of 1024x1024 floats = 16MB)
+#define NUMA_BENCHMARK_N_FLOATS (4 * 1024 * 1024)
+
+// Number of times each thread reads its image
+#define NUMA_BENCHMARK_N_PASSES 16
+
+NATRON_NAMESPACE_USING
+
+TEST(NumaInfo,
+     Topology)
+{
+    ASSERT_GE(getNumaNodesCount(), 1);
+    ASSERT_EQ(getCurrentThreadNumaNode(), -1) << "Threads are not bound unless asked";
+
+    std::vector<NumaNodeMemoryUsage> usage;
+    getNumaNodesMemoryUsage(&usage);
+    ASSERT_EQ( (int)usage.size(), getNumaNodesCount() );
+}
+
+TEST(NumaInfo,
+     MemoryAccounting)
+{
+    if ( !bindCurrentThreadToNumaNode(0) ) {
+        // Thread placement is not supported on this system
+        return;
+    }
+    ASSERT_EQ(getCurrentThreadNumaNode(), 0);
+
+    std::vector<NumaNodeMemoryUsage> before, during, after;
+    getNumaNodesMemoryUsage(&before);
+    {
+        RamBuffer<float> buffer;
+        buffer.resize(NUMA_BENCHMARK_N_FLOATS);
+        getNumaNodesMemoryUsage(&during);
+        ASSERT_EQ(during[0].current, before[0].current + NUMA_BENCHMARK_N_FLOATS * sizeof(float));
+        ASSERT_GE(during[0].peak, during[0].current);
+
+        // The memory stays accounted to the node it was allocated on, even if the buffer is freed by another thread
+        unbindCurrentThreadFromNumaNode();
+        ASSERT_EQ(getCurrentThreadNumaNode(), -1);
+    }
+    getNumaNodesMemoryUsage(&after);
+    ASSERT_EQ(after[0].current, before[0].current);
+}
+
+#if defined(__linux__)
+TEST(NumaInfo,
+     UnbindRestoresProcessAffinity)
+{
+    cpu_set_t before;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(before), &before), 0);
+    if ( !bindCurrentThreadToNumaNode(0) ) {
+        return;
+    }
+    // Binding again to the same node is a no-op
+    ASSERT_TRUE( bindCurrentThreadToNumaNode(0) );
+    // This is the main thread: the affinity restored must not be read from it while it is bound
+    unbindCurrentThreadFromNumaNode();
+
+    cpu_set_t after;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+    ASSERT_TRUE( CPU_EQUAL(&before, &after) );
+}
+
+#endif
+
+static void
+fillBenchmarkImage(RamBuffer<float>* buffer)
+{
+    buffer->resize(NUMA_BENCHMARK_N_FLOATS);
+    float* data = buffer->getData();
+    for (int i = 0; i < NUMA_BENCHMARK_N_FLOATS; ++i) {
+        data[i] = (float)(i % 256) / 255.f;
+    }
+}
+
+// Simulates the processing of a frame: reads an image several times. The image is either given, in which case it was
+// allocated and first written by another thread, or allocated and written by this thread after it was bound to its node.
+class NumaBenchmarkThread
+    : public QThread
+{
+public:
+
+    NumaBenchmarkThread(int numaNode,
+                        RamBuffer<float>* image)
+        : QThread()
+        , numaNode(numaNode)
+        , image(image)
+        , sum(0)
+        , readTime(0)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        if (numaNode != -1) {
+            bindCurrentThreadToNumaNode(numaNode);
+        }
+        RamBuffer<float> localImage;
+        if (!image) {
+            // First touch by this thread: the pages are placed on its node
+            fillBenchmarkImage(&localImage);
+        }
+        const float* data = image ? image->getData() : localImage.getData();
+
+        TimeLapse timer;
+        double total = 0.;
+        for (int pass = 0; pass < NUMA_BENCHMARK_N_PASSES; ++pass) {
+            for (int i = 0; i < NUMA_BENCHMARK_N_FLOATS; ++i) {
+                total += data[i];
+            }
+        }
+        readTime = timer.getTimeElapsedReset();
+        sum = total;
+        localImage.clear();
+        if (numaNode != -1) {
+            unbindCurrentThreadFromNumaNode();
+        }
+    }
+
+    int numaNode;
+    RamBuffer<float>* image;
+    double sum;
+    double readTime;
+};
+
+// Returns the read throughput in MB/s of as many simulated frame renders as there are cores.
+// In both modes the threads are bound to the least loaded node, like the parallel renders of the scheduler.
+// By default the images are allocated and first written by a single thread bound to node 0, as when an image is
+// allocated by another thread than the one processing it: on a multi-node machine most threads then read remote memory.
+// When numaAware is true, each thread allocates and first writes its image itself, so its pages are local.
+static double
+runNumaBenchmark(bool numaAware,
+                 double* sum)
+{
+    int nThreads = std::max(1, QThread::idealThreadCount() );
+    int nNodes = getNumaNodesCount();
+    std::vector<int> nThreadsPerNode(nNodes, 0);
+    std::vector<RamBuffer<float>*> images(nThreads, (RamBuffer<float>*)0);
+
+    if (!numaAware) {
+        bool bound = bindCurrentThreadToNumaNode(0);
+        for (int i = 0; i < nThreads; ++i) {
+            images[i] = new RamBuffer<float>();
+            fillBenchmarkImage(images[i]);
+        }
+        if (bound) {
+            unbindCurrentThreadFromNumaNode();
+        }
+    }
+
+    std::vector<NumaBenchmarkThread*> threads;
+    for (int i = 0; i < nThreads; ++i) {
+        int node = std::min_element( nThreadsPerNode.begin(), nThreadsPerNode.end() ) - nThreadsPerNode.begin();
+        ++nThreadsPerNode[node];
+        threads.push_back( new NumaBenchmarkThread(node, images[i]) );
+        threads.back()->start();
+    }
+    *sum = 0;
+    double maxReadTime = 0.;
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->wait();
+        *sum += threads[i]->sum;
+        maxReadTime = std::max(maxReadTime, threads[i]->readTime);
+        delete threads[i];
+        delete images[i];
+    }
+    double nBytes = (double)nThreads * NUMA_BENCHMARK_N_FLOATS * sizeof(float) * NUMA_BENCHMARK_N_PASSES;
+
+    return maxReadTime > 0 ? nBytes / (1024. * 1024.) / maxReadTime : 0.;
+}
+
+TEST(NumaInfo,
+     Benchmark)
+{
+    double defaultSum, numaSum;
+    double defaultThroughput = runNumaBenchmark(false, &defaultSum);
+    double numaThroughput = runNumaBenchmark(true, &numaSum);
+
+    std::cout << "NUMA benchmark (" << getNumaNodesCount() << " node(s), " << QThread::idealThreadCount() << " thread(s)): "
+              << "images first touched on node 0 " << defaultThroughput << " MB/s, "
+              << "images first touched by the reading thread " << numaThroughput << " MB/s" << std::endl;
+
+    // The placement of threads and memory must not change the result
+    ASSERT_EQ(defaultSum, numaSum);
+}
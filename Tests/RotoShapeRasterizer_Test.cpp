@@ -0,0 +1,453 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ * Copyright (C) 2018-2020 The Natron developers
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm> // min
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <vector>
+#include <gtest/gtest.h>
+
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <boost/bind.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#include <cairo/cairo.h>
+
+#include "Engine/RotoShapeRasterizer.h"
+#include "Engine/Timer.h"
+
+NATRON_NAMESPACE_USING
+
+// Builds a closed star-like shape centered on (cx,cy) with its feather quads, as RotoContextPrivate::computeFeatherQuads does
+static RotoShapeSample
+makeStarSample(double cx,
+               double cy,
+               double radius,
+               double wobble,
+               int nBranches,
+               int nPoints,
+               double featherDist,
+               double fallOff)
+{
+    RotoShapeSample sample;
+    std::vector<Point> extruded;
+
+    sample.fallOff = fallOff;
+    for (int i = 0; i < nPoints; ++i) {
+        double a = 2. * M_PI * i / nPoints;
+        double r = radius * ( 1. + wobble * std::cos(nBranches * a) );
+        Point p, e;
+        p.x = cx + r * std::cos(a);
+        p.y = cy + r * std::sin(a);
+        e.x = cx + (r + featherDist) * std::cos(a);
+        e.y = cy + (r + featherDist) * std::sin(a);
+        sample.contour.push_back(p);
+        extruded.push_back(e);
+    }
+    if (featherDist != 0) {
+        for (int i = 0; i < nPoints; ++i) {
+            int prev = (i + nPoints - 1) % nPoints;
+            RotoFeatherQuad q;
+            q.p0 = sample.contour[prev];
+            q.p1 = extruded[prev];
+            q.p2 = extruded[i];
+            q.p3 = sample.contour[i];
+            sample.feather.push_back(q);
+        }
+    }
+
+    return sample;
+}
+
+// Renders a motion blur sample the way RotoContextPrivate::renderBezier does. Natron renders with CAIRO_ANTIALIAS_NONE,
+// CAIRO_ANTIALIAS_DEFAULT fills the contour with anti-aliasing like the RotoShapeRasterizer does.
+static void
+renderSampleWithCairo(const RotoShapeSample& sample,
+                      const RectI& rect,
+                      cairo_antialias_t antialias,
+                      std::vector<float>* coverage)
+{
+    cairo_surface_t* surface = cairo_image_surface_create( CAIRO_FORMAT_A8, rect.width(), rect.height() );
+
+    cairo_surface_set_device_offset(surface, -rect.x1, -rect.y1);
+    cairo_t* cr = cairo_create(surface);
+    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+    cairo_set_antialias(cr, antialias);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    cairo_new_path(cr);
+
+    cairo_pattern_t* mesh = cairo_pattern_create_mesh();
+    double fallOff = sample.fallOff;
+    double fallOffInverse = 1. / fallOff;
+    for (std::size_t i = 0; i < sample.feather.size(); ++i) {
+        const RotoFeatherQuad& q = sample.feather[i];
+        Point p0p1, p1p0, p2p3, p3p2;
+        p0p1.x = (q.p0.x * fallOff * 2. + fallOffInverse * q.p1.x) / (fallOff * 2. + fallOffInverse);
+        p0p1.y = (q.p0.y * fallOff * 2. + fallOffInverse * q.p1.y) / (fallOff * 2. + fallOffInverse);
+        p1p0.x = (q.p0.x * fallOff + 2. * fallOffInverse * q.p1.x) / (fallOff + 2. * fallOffInverse);
+        p1p0.y = (q.p0.y * fallOff + 2. * fallOffInverse * q.p1.y) / (fallOff + 2. * fallOffInverse);
+        p2p3.x = (q.p3.x * fallOff + 2. * fallOffInverse * q.p2.x) / (fallOff + 2. * fallOffInverse);
+        p2p3.y = (q.p3.y * fallOff + 2. * fallOffInverse * q.p2.y) / (fallOff + 2. * fallOffInverse);
+        p3p2.x = (q.p3.x * fallOff * 2. + fallOffInverse * q.p2.x) / (fallOff * 2. + fallOffInverse);
+        p3p2.y = (q.p3.y * fallOff * 2. + fallOffInverse * q.p2.y) / (fallOff * 2. + fallOffInverse);
+
+        cairo_mesh_pattern_begin_patch(mesh);
+        cairo_mesh_pattern_move_to(mesh, q.p0.x, q.p0.y);
+        cairo_mesh_pattern_curve_to(mesh, p0p1.x, p0p1.y, p1p0.x, p1p0.y, q.p1.x, q.p1.y);
+        cairo_mesh_pattern_line_to(mesh, q.p2.x, q.p2.y);
+        cairo_mesh_pattern_curve_to(mesh, p2p3.x, p2p3.y, p3p2.x, p3p2.y, q.p3.x, q.p3.y);
+        cairo_mesh_pattern_line_to(mesh, q.p0.x, q.p0.y);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 0, 1., 1., 1., 1.);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 1, 1., 1., 1., 0.);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 2, 1., 1., 1., 0.);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 3, 1., 1., 1., 1.);
+        cairo_mesh_pattern_end_patch(mesh);
+    }
+
+    cairo_set_source_rgba(cr, 1, 1, 1, 1);
+    cairo_move_to(cr, sample.contour[0].x, sample.contour[0].y);
+    for (std::size_t i = 1; i < sample.contour.size(); ++i) {
+        cairo_line_to(cr, sample.contour[i].x, sample.contour[i].y);
+    }
+    cairo_close_path(cr);
+    cairo_fill(cr);
+
+    if ( !sample.feather.empty() ) {
+        cairo_set_source(cr, mesh);
+        cairo_mask(cr, mesh);
+    }
+    cairo_pattern_destroy(mesh);
+
+    cairo_surface_flush(surface);
+    const unsigned char* data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    coverage->resize( (std::size_t)rect.width() * rect.height() );
+    for (int y = 0; y < rect.height(); ++y) {
+        for (int x = 0; x < rect.width(); ++x) {
+            (*coverage)[y * rect.width() + x] = data[y * stride + x] / 255.f;
+        }
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+}
+
+// Averages the motion blur samples rendered by cairo
+static void
+renderWithCairo(const std::list<RotoShapeSample>& samples,
+                const RectI& rect,
+                cairo_antialias_t antialias,
+                std::vector<float>* coverage)
+{
+    coverage->assign( (std::size_t)rect.width() * rect.height(), 0.f );
+    std::vector<float> sampleCoverage;
+    for (std::list<RotoShapeSample>::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+        renderSampleWithCairo(*it, rect, antialias, &sampleCoverage);
+        for (std::size_t i = 0; i < coverage->size(); ++i) {
+            (*coverage)[i] += sampleCoverage[i] / samples.size();
+        }
+    }
+}
+
+static void
+compareWithCairo(const std::list<RotoShapeSample>& samples,
+                 const RectI& rect)
+{
+    RotoShapeRasterizer rasterizer(samples);
+    std::vector<float> native( (std::size_t)rect.width() * rect.height() );
+
+    rasterizer.renderCoverage( rect, &native.front(), rect.width() );
+
+    std::vector<float> reference;
+    renderWithCairo(samples, rect, CAIRO_ANTIALIAS_DEFAULT, &reference);
+
+    double sumDiff = 0.;
+    std::size_t nLargeDiffs = 0;
+    for (std::size_t i = 0; i < native.size(); ++i) {
+        ASSERT_GE(native[i], 0.f);
+        ASSERT_LE(native[i], 1.f);
+        double diff = std::fabs(native[i] - reference[i]);
+        sumDiff += diff;
+        if (diff > 0.1) {
+            ++nLargeDiffs;
+        }
+    }
+    // Only pixels on the edges of the shape may differ, because cairo tessellates the feather patches
+    EXPECT_LT(sumDiff / native.size(), 0.005);
+    EXPECT_LT( nLargeDiffs, native.size() / 200 );
+}
+
+TEST(RotoShapeRasterizer,
+     NoFeather)
+{
+    std::list<RotoShapeSample> samples;
+
+    samples.push_back( makeStarSample(128., 128., 80., 0.3, 5, 200, 0., 1.) );
+    compareWithCairo( samples, RectI(0, 0, 256, 256) );
+
+    RotoShapeRasterizer rasterizer(samples);
+    float center;
+    rasterizer.renderCoverage(RectI(128, 128, 129, 129), &center, 1);
+    EXPECT_EQ(center, 1.f);
+    float corner;
+    rasterizer.renderCoverage(RectI(0, 0, 1, 1), &corner, 1);
+    EXPECT_EQ(corner, 0.f);
+}
+
+TEST(RotoShapeRasterizer,
+     AreaCoverage)
+{
+    // The triangle below the diagonal of the square [0,4]x[0,4]
+    RotoShapeSample triangle;
+    Point p;
+
+    p.x = 0.; p.y = 0.;
+    triangle.contour.push_back(p);
+    p.x = 4.; p.y = 0.;
+    triangle.contour.push_back(p);
+    p.x = 4.; p.y = 4.;
+    triangle.contour.push_back(p);
+
+    std::list<RotoShapeSample> samples;
+    samples.push_back(triangle);
+    RectI rect(0, 0, 4, 4);
+    std::vector<float> coverage( rect.area() );
+    RotoShapeRasterizer(samples).renderCoverage( rect, &coverage.front(), rect.width() );
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            // Pixels crossed by the diagonal are half covered
+            float expected = (x > y) ? 1.f : (x == y) ? 0.5f : 0.f;
+            EXPECT_EQ(expected, coverage[y * 4 + x]) << "x=" << x << " y=" << y;
+        }
+    }
+
+    // A rectangle whose vertical sides cross the pixels, in both orientations
+    for (int reversed = 0; reversed < 2; ++reversed) {
+        RotoShapeSample rectangle;
+        const double xs[4] = { 10.25, 20.75, 20.75, 10.25 };
+        const double ys[4] = { 10., 10., 20., 20. };
+        for (int i = 0; i < 4; ++i) {
+            int j = reversed ? 3 - i : i;
+            p.x = xs[j];
+            p.y = ys[j];
+            rectangle.contour.push_back(p);
+        }
+        samples.clear();
+        samples.push_back(rectangle);
+        RectI row(8, 15, 23, 16);
+        std::vector<float> rowCoverage( row.area() );
+        RotoShapeRasterizer(samples).renderCoverage( row, &rowCoverage.front(), row.width() );
+        EXPECT_EQ(0.f, rowCoverage[9 - row.x1]);
+        EXPECT_EQ(0.75f, rowCoverage[10 - row.x1]);
+        EXPECT_EQ(1.f, rowCoverage[15 - row.x1]);
+        EXPECT_EQ(0.75f, rowCoverage[20 - row.x1]);
+        EXPECT_EQ(0.f, rowCoverage[21 - row.x1]);
+    }
+}
+
+TEST(RotoShapeRasterizer,
+     Feather)
+{
+    for (int i = 0; i < 3; ++i) {
+        const double fallOffs[3] = { 0.3, 1., 3. };
+        std::list<RotoShapeSample> samples;
+        samples.push_back( makeStarSample(128., 128., 60., 0.2, 3, 300, 40., fallOffs[i]) );
+        compareWithCairo( samples, RectI(0, 0, 256, 256) );
+    }
+}
+
+// Compares a single sample with the configuration used by Natron, where cairo fills the contour without anti-aliasing.
+// cairo then sets the pixels crossed by the contour to 0 or 1 depending on whether their center is inside the shape,
+// whereas the rasterizer sets them to the area covered by the shape: on those edge pixels the difference is
+// min(area, 1 - area) for a straight edge, that is 0.25 on average. Their mean difference must stay below 0.35,
+// which a contour shifted by half a pixel would exceed. All the other pixels must match as with anti-aliasing.
+static void
+compareWithCairoNoAntialiasing(const RotoShapeSample& sample,
+                               const RectI& rect)
+{
+    std::list<RotoShapeSample> samples;
+
+    samples.push_back(sample);
+    std::vector<float> native( (std::size_t)rect.width() * rect.height() );
+    RotoShapeRasterizer(samples).renderCoverage( rect, &native.front(), rect.width() );
+
+    std::vector<float> reference;
+    renderWithCairo(samples, rect, CAIRO_ANTIALIAS_NONE, &reference);
+
+    // The pixels crossed by the contour are the ones partially covered by the shape without its feather
+    RotoShapeSample contourOnly = sample;
+    contourOnly.feather.clear();
+    samples.clear();
+    samples.push_back(contourOnly);
+    std::vector<float> fill( native.size() );
+    RotoShapeRasterizer(samples).renderCoverage( rect, &fill.front(), rect.width() );
+
+    double sumEdgeDiff = 0., sumDiff = 0.;
+    std::size_t nEdgePixels = 0, nLargeDiffs = 0;
+    for (std::size_t i = 0; i < native.size(); ++i) {
+        double diff = std::fabs(native[i] - reference[i]);
+        if ( (fill[i] > 0.f) && (fill[i] < 1.f) ) {
+            sumEdgeDiff += diff;
+            ++nEdgePixels;
+        } else {
+            sumDiff += diff;
+            if (diff > 0.1) {
+                ++nLargeDiffs;
+            }
+        }
+    }
+    ASSERT_GT(nEdgePixels, 0u);
+    EXPECT_LT(sumEdgeDiff / nEdgePixels, 0.35);
+    EXPECT_LT(sumDiff / native.size(), 0.005);
+    EXPECT_LT( nLargeDiffs, native.size() / 200 );
+}
+
+TEST(RotoShapeRasterizer,
+     NoAntialiasing)
+{
+    compareWithCairoNoAntialiasing( makeStarSample(128., 128., 80., 0.3, 5, 200, 0., 1.), RectI(0, 0, 256, 256) );
+    compareWithCairoNoAntialiasing( makeStarSample(128., 128., 60., 0.2, 3, 300, 40., 1.), RectI(0, 0, 256, 256) );
+}
+
+TEST(RotoShapeRasterizer,
+     MotionBlur)
+{
+    std::list<RotoShapeSample> samples;
+
+    for (int t = 0; t < 5; ++t) {
+        samples.push_back( makeStarSample(100. + t * 10., 128., 60., 0.2, 4, 300, 20., 1.) );
+    }
+    compareWithCairo( samples, RectI(0, 0, 256, 256) );
+}
+
+TEST(RotoShapeRasterizer,
+     MotionBlurAccumulation)
+{
+    RotoShapeSample sample = makeStarSample(64., 64., 30., 0.2, 4, 100, 10., 1.);
+    std::list<RotoShapeSample> single, repeated, shifted;
+
+    single.push_back(sample);
+    repeated.push_back(sample);
+    repeated.push_back(sample);
+    // A sample outside of the rendered area only contributes zeroes
+    shifted.push_back(sample);
+    shifted.push_back( makeStarSample(1000., 64., 30., 0.2, 4, 100, 10., 1.) );
+
+    RectI rect(0, 0, 128, 128);
+    std::vector<float> singleCoverage(rect.area()), repeatedCoverage(rect.area()), shiftedCoverage(rect.area());
+    RotoShapeRasterizer(single).renderCoverage( rect, &singleCoverage.front(), rect.width() );
+    RotoShapeRasterizer(repeated).renderCoverage( rect, &repeatedCoverage.front(), rect.width() );
+    RotoShapeRasterizer(shifted).renderCoverage( rect, &shiftedCoverage.front(), rect.width() );
+    for (std::size_t i = 0; i < singleCoverage.size(); ++i) {
+        ASSERT_FLOAT_EQ(singleCoverage[i], repeatedCoverage[i]);
+        ASSERT_FLOAT_EQ(singleCoverage[i] / 2.f, shiftedCoverage[i]);
+    }
+}
+
+TEST(RotoShapeRasterizer,
+     Tiles)
+{
+    std::list<RotoShapeSample> samples;
+
+    samples.push_back( makeStarSample(128., 128., 60., 0.2, 3, 300, 40., 0.5) );
+    RotoShapeRasterizer rasterizer(samples);
+
+    // Rendering tiles separately must give exactly the same result as rendering the whole image
+    RectI rect(0, 0, 256, 256);
+    std::vector<float> full( (std::size_t)rect.width() * rect.height() );
+    rasterizer.renderCoverage( rect, &full.front(), rect.width() );
+    std::vector<float> tiled( full.size() );
+    for (int y = 0; y < rect.height(); y += 37) {
+        for (int x = 0; x < rect.width(); x += 53) {
+            RectI tile( x, y, std::min(x + 53, rect.x2), std::min(y + 37, rect.y2) );
+            rasterizer.renderCoverage( tile, &tiled[y * rect.width() + x], rect.width() );
+        }
+    }
+    for (std::size_t i = 0; i < full.size(); ++i) {
+        ASSERT_EQ(full[i], tiled[i]);
+    }
+}
+
+// Renders a band of rows of the benchmark image
+struct RotoBenchmarkBand
+{
+    RectI rect;
+    float* coverage;
+};
+
+static void
+renderBenchmarkBand(const RotoShapeRasterizer* rasterizer,
+                    int rowStride,
+                    RotoBenchmarkBand& band)
+{
+    rasterizer->renderCoverage(band.rect, band.coverage, rowStride);
+}
+
+TEST(RotoShapeRasterizer,
+     Benchmark)
+{
+    // A complex shape with a large feather, as a 4K roto mask
+    std::list<RotoShapeSample> samples;
+
+    samples.push_back( makeStarSample(2048., 1080., 900., 0.15, 40, 8000, 200., 0.7) );
+    RectI rect(0, 0, 4096, 2160);
+
+    TimeLapse timer;
+    std::vector<float> reference;
+    renderWithCairo(samples, rect, CAIRO_ANTIALIAS_DEFAULT, &reference);
+    double cairoTime = timer.getTimeElapsedReset();
+
+    RotoShapeRasterizer rasterizer(samples);
+    std::vector<float> native( (std::size_t)rect.width() * rect.height() );
+    rasterizer.renderCoverage( rect, &native.front(), rect.width() );
+    double nativeTime = timer.getTimeElapsedReset();
+
+    // Same split as RotoShapeRasterizer::renderToImage
+    std::vector<RotoBenchmarkBand> bands;
+    for (int y = rect.y1; y < rect.y2; y += 64) {
+        RotoBenchmarkBand band;
+        band.rect = RectI( rect.x1, y, rect.x2, std::min(y + 64, rect.y2) );
+        band.coverage = &native[(std::size_t)y * rect.width()];
+        bands.push_back(band);
+    }
+    timer.getTimeElapsedReset();
+    QtConcurrent::blockingMap( bands, boost::bind(&renderBenchmarkBand, &rasterizer, rect.width(), _1) );
+    double parallelTime = timer.getTimeElapsedReset();
+
+    std::cout << "Roto rasterization of a " << rect.width() << "x" << rect.height() << " mask: "
+              << "cairo " << cairoTime * 1000. << " ms, "
+              << "scanline " << nativeTime * 1000. << " ms, "
+              << "scanline in parallel bands " << parallelTime * 1000. << " ms" << std::endl;
+
+    double sumDiff = 0.;
+    for (std::size_t i = 0; i < native.size(); ++i) {
+        sumDiff += std::fabs(native[i] - reference[i]);
+    }
+    EXPECT_LT(sumDiff / native.size(), 0.005);
+}
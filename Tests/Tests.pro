@@ -46,9 +46,13 @@ SOURCES += \
     BaseTest.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
+    ImagePlaneDesc_Test.cpp \
     Lut_Test.cpp \
     KnobFile_Test.cpp \
+    NumaInfo_Test.cpp \
+    RotoShapeRasterizer_Test.cpp \
     Curve_Test.cpp \
+    DiskCacheNodeStorage_Test.cpp \
     Tracker_Test.cpp \
     wmain.cpp
 
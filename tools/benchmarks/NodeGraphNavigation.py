@@ -0,0 +1,126 @@
+# -*- coding: utf-8 -*-
+# Node graph navigation benchmark.
+#
+# Generates a large node graph and measures the time taken to redraw the node graph
+# while panning and zooming it, both zoomed in (full drawing) and zoomed out
+# (simplified drawing, see NATRON_NODEGRAPH_SIMPLIFIED_DRAWING_LOD in Gui/GuiDefines.h).
+#
+# Usage, with the Natron GUI:
+#   Natron tools/benchmarks/NodeGraphNavigation.py
+# The environment variables NATRON_BENCH_NODES (default 5000) and NATRON_BENCH_FRAMES
+# (default 100) set the number of nodes and the number of frames per measure.
+# Results are printed on the standard output and Natron quits when done.
+
+import os
+import time
+
+import NatronEngine
+import NatronGui
+
+try:
+    from PySide2.QtCore import QTimer
+    from PySide2.QtWidgets import QApplication, QGraphicsView
+except ImportError:
+    from PySide.QtCore import QTimer
+    from PySide.QtGui import QApplication, QGraphicsView
+
+NB_NODES = int( os.environ.get("NATRON_BENCH_NODES", "5000") )
+NB_FRAMES = int( os.environ.get("NATRON_BENCH_FRAMES", "100") )
+
+# Nodes per column and spacing between nodes, in scene coordinates
+COLUMN_SIZE = 50
+SPACING_X = 150
+SPACING_Y = 80
+
+
+def createGraph(app):
+    """Creates NB_NODES nodes laid out in columns, each node connected to the previous one in its column
+    and every other node also connected to the node on its left, so there are about 1.5 edges per node."""
+    pluginID = "net.sf.openfx.MergePlugin"
+    nodes = []
+    for i in range(NB_NODES):
+        node = app.createNode(pluginID)
+        if node is None:
+            # Openfx-misc is not installed, use Dots
+            pluginID = "fr.inria.built-in.Dot"
+            node = app.createNode(pluginID)
+        column = i // COLUMN_SIZE
+        row = i % COLUMN_SIZE
+        node.setPosition(column * SPACING_X, row * SPACING_Y)
+        if row > 0:
+            node.connectInput(0, nodes[i - 1])
+        if column > 0 and (i % 2) == 0 and node.getMaxInputCount() > 1:
+            node.connectInput(1, nodes[i - COLUMN_SIZE])
+        nodes.append(node)
+    return nodes
+
+
+def findNodeGraph():
+    """Returns the visible QGraphicsView with the most items, that is the node graph of the project."""
+    best = None
+    for w in QApplication.allWidgets():
+        if isinstance(w, QGraphicsView) and w.isVisible() and w.scene() is not None:
+            if best is None or len( w.scene().items() ) > len( best.scene().items() ):
+                best = w
+    return best
+
+
+def measure(view, name, step):
+    """Redraws the node graph NB_FRAMES times, calling step(view, i) before each frame,
+    and prints the average and worst frame times."""
+    times = []
+    for i in range(NB_FRAMES):
+        start = time.time()
+        step(view, i)
+        view.viewport().repaint()
+        QApplication.processEvents()
+        times.append( (time.time() - start) * 1000. )
+    times.sort()
+    print( "%-24s avg %8.2f ms  median %8.2f ms  max %8.2f ms" % ( name, sum(times) / len(times), times[len(times) // 2], times[-1] ) )
+
+
+def setZoom(view, zoom):
+    view.resetTransform()
+    view.scale(zoom, zoom)
+
+
+def runBenchmark():
+    view = findNodeGraph()
+    if view is None:
+        print("NodeGraphNavigation: could not find the node graph")
+        QApplication.quit()
+        return
+
+    width = (NB_NODES // COLUMN_SIZE + 1) * SPACING_X
+    height = COLUMN_SIZE * SPACING_Y
+
+    def pan(view, i):
+        view.centerOn( (i * width) / NB_FRAMES, height / 2. )
+
+    def zoom(view, i):
+        # Zoom in and out around the zoom level set by the measure
+        f = 1.05 if (i // 10) % 2 == 0 else 1. / 1.05
+        view.scale(f, f)
+
+    print( "NodeGraphNavigation: %d nodes, %d frames per measure" % (NB_NODES, NB_FRAMES) )
+    for (label, level) in ( ("zoomed in", 1.), ("zoomed out", 0.1) ):
+        setZoom(view, level)
+        measure(view, "pan, " + label, pan)
+        setZoom(view, level)
+        measure(view, "zoom, " + label, zoom)
+    QApplication.quit()
+
+
+def main():
+    app = NatronEngine.natron.getInstance(0)
+    if not NatronEngine.natron.isBackground():
+        start = time.time()
+        createGraph(app)
+        print( "NodeGraphNavigation: graph created in %.1f s" % (time.time() - start) )
+        # Let the GUI show the graph before measuring
+        QTimer.singleShot(2000, runBenchmark)
+    else:
+        print("NodeGraphNavigation: this benchmark requires the Natron GUI")
+
+
+main()